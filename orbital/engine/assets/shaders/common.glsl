@@ -13,6 +13,7 @@
 #define BND_UBO_Model   1
 #define BND_UBO_Lights  2
 #define BND_UBO_Shadows 3
+#define BND_SSBO_Instances 4
 
 const float PI = 3.14159265359;
 
@@ -0,0 +1,5 @@
+src:
+- key: frag
+  value: base.frag
+- key: vert
+  value: base-instanced.vert
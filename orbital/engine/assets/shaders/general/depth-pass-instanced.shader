@@ -0,0 +1,5 @@
+src:
+- key: vert
+  value: depth-pass-instanced.vert
+- key: frag
+  value: depth-only.frag
@@ -0,0 +1,29 @@
+#ifndef INSTANCING_GLSL
+#define INSTANCING_GLSL
+
+#include "common.glsl"
+
+// Per-instance transforms for instanced draws.
+// The Model buffer holds a transform that is applied on top of every instance.
+struct InstanceData {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+};
+
+layout(std430, binding=BND_SSBO_Instances) readonly buffer Instances {
+  InstanceData instances[];
+};
+
+mat4 getInstanceModelMatrix() {
+  return modelMatrix * instances[gl_InstanceID].modelMatrix;
+}
+
+mat4 getInstanceNormalMatrix() {
+  return normalMatrix * instances[gl_InstanceID].normalMatrix;
+}
+
+mat4 getInstanceMVPMatrix() {
+  return mvpMatrix * instances[gl_InstanceID].modelMatrix;
+}
+
+#endif // INSTANCING_GLSL
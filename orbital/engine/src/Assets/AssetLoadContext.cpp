@@ -49,6 +49,20 @@ namespace engine {
     return m_dependencies;
   }
 
+  Ref<Stream> AssetLoadContext::open(URI const & uri) {
+    Ref<Stream> pStream = getFileSystem()->open(uri, FileMode_ReadBinary);
+    if (pStream != nullptr) {
+      std::scoped_lock guard{m_dependencyLock};
+      m_fileDependencies.pushBack(uri);
+    }
+
+    return pStream;
+  }
+
+  Span<const URI> AssetLoadContext::getFileDependencies() const {
+    return m_fileDependencies;
+  }
+
   VirtualFileSystem * AssetLoadContext::getFileSystem() const {
     return m_pAssetManager->getFileSystem();
   }
@@ -2,6 +2,7 @@
 
 #include "core/typeindex.h"
 #include "core/URI.h"
+#include "core/Stream.h"
 #include "util/UUID.h"
 #include "util/ThreadPool.h"
 
@@ -101,12 +102,21 @@ namespace engine {
     
     bfc::Span<const AssetHandle> getDependencies() const;
 
+    /// Open a file read by the loader, other than the asset's source. For files that are not assets, e.g. an
+    /// OBJ's material library. The file is recorded as a dependency, so cached copies of the asset are not used after it changes.
+    /// @retval nullptr The file could not be opened.
+    bfc::Ref<bfc::Stream> open(bfc::URI const & uri);
+
+    /// Get the files opened with open().
+    bfc::Span<const bfc::URI> getFileDependencies() const;
+
     VirtualFileSystem *   getFileSystem() const;
     bfc::GraphicsDevice * getGraphicsDevice() const;
 
   private:
     std::mutex               m_dependencyLock;
     bfc::Vector<AssetHandle> m_dependencies;
+    bfc::Vector<bfc::URI>    m_fileDependencies;
     AssetManager *           m_pAssetManager = nullptr;
   };
 } // namespace engine
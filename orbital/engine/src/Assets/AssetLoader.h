@@ -16,6 +16,16 @@ namespace engine {
 
     /// Query if this loader can handle the URI provided.
     virtual bool handles(bfc::URI const & uri, AssetManager const * pManager) const = 0;
+
+    /// Estimate the memory used by an asset loaded by this instance, in bytes.
+    /// Used to decide when unreferenced assets are evicted.
+    virtual int64_t _sizeOf(bfc::Ref<void> const & pAsset) const = 0;
+
+    /// The version of the data produced by this loader. Part of the key of cached assets, so
+    /// increasing it stops assets cached by previous versions of the loader being used.
+    virtual int64_t version() const {
+      return 1;
+    }
   };
 
   template<typename T>
@@ -29,7 +39,17 @@ namespace engine {
       return load(uri, pContext);
     }
 
+    virtual int64_t _sizeOf(bfc::Ref<void> const & pAsset) const override final {
+      return pAsset == nullptr ? 0 : sizeOf(*(T const *)pAsset.get());
+    }
+
   public:
     virtual bfc::Ref<T> load(bfc::URI const & uri, AssetLoadContext * pContext) const = 0;
+
+    /// Estimate the memory used by `asset` in bytes.
+    /// @retval 0 The size is unknown. The asset manager still counts a fixed cost for each asset.
+    virtual int64_t sizeOf(T const & asset) const {
+      return 0;
+    }
   };
 }
@@ -20,18 +20,23 @@ using namespace bfc;
 namespace {
   struct CacheHeader {
     struct Dependency {
-      URI       uri;
-      Timestamp lastModified;
+      URI     uri;
+      Hash128 content;
     };
-    int32_t            version = 1;
-    Vector<Dependency> dependencies; ///< URIs this cache entry depends on.
+    int32_t            version = 2;
+    Vector<Dependency> dependencies; ///< Assets and files this cache entry depends on, other than the asset source.
   };
+
+  /// Key of the entry that holds the cached asset data, for the entry that holds its CacheHeader.
+  String payloadKey(String const & cacheKey) {
+    return cacheKey + ".payload";
+  }
 } // namespace
 
 namespace bfc {
   int64_t write(Stream * pStream, ::CacheHeader::Dependency const * pValue, int64_t count) {
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->write(pValue[i].uri) && pStream->write(pValue[i].lastModified)))
+      if (!(pStream->write(pValue[i].uri) && pStream->write(pValue[i].content)))
         return i;
     }
     return count;
@@ -39,7 +44,7 @@ namespace bfc {
 
   int64_t read(Stream * pStream, ::CacheHeader::Dependency * pValue, int64_t count) {
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->read(&pValue[i].uri) && pStream->read(&pValue[i].lastModified)))
+      if (!(pStream->read(&pValue[i].uri) && pStream->read(&pValue[i].content)))
         return i;
     }
     return count;
@@ -75,19 +80,27 @@ namespace engine {
     m_pFileSystem = pApp->findSubsystem<VirtualFileSystem>();
 
     registerLoader("core.meshdata", NewRef<engine::MeshDataFileLoader>());
+    registerLoader("core.meshblob", NewRef<engine::MeshBlobLoader>());
     registerLoader("core.mesh", NewRef<engine::MeshLoader>(pRendering->getDevice()));
     registerLoader("core.meshdata.material", NewRef<engine::MeshMaterialLoader>(pRendering->getDevice()));
     registerLoader("core.surface", NewRef<engine::SurfaceLoader>());
+    registerLoader("core.texturemips", NewRef<engine::TextureMipsLoader>());
     registerLoader("core.texture", NewRef<engine::Texture2DLoader>(pRendering->getDevice()));
     registerLoader("core.shader", NewRef<engine::ShaderLoader>(pRendering->getDevice()));
     registerLoader("core.skybox", NewRef<engine::SkyboxLoader>(pRendering->getDevice()));
     registerLoader("core.materialdata", NewRef<engine::MaterialFileLoader>());
     registerLoader("core.material", NewRef<engine::MaterialLoader>(pRendering->getDevice()));
     registerCache(NewRef<engine::MeshDataCache>());
-    registerCache(NewRef<engine::TextureCache>(pRendering->getDevice()));
+    registerCache(NewRef<engine::MeshBlobCache>());
+    registerCache(NewRef<engine::TextureMipsCache>());
+
+    CacheOptions cacheOptions;
+    cacheOptions.storage  = CacheStorage_Packed;
+    cacheOptions.maxBytes = 4ll * 1024 * 1024 * 1024;
+    cacheOptions.maxAge   = Timestamp::fromHours(24 * 30);
 
     m_appDataPath = pApp->getAppDataPath() / "AssetManager";
-    m_pCache      = bfc::NewRef<Cache>(m_appDataPath / "Cache");
+    m_pCache      = bfc::NewRef<Cache>(m_appDataPath / "Cache", cacheOptions);
     return true;
   }
 
@@ -115,17 +128,17 @@ namespace engine {
   }
 
   bool AssetManager::contains(AssetHandle const & handle) const {
-    std::scoped_lock guard{m_assetLock};
+    std::shared_lock guard{m_assetLock};
     return m_assetPool.isUsed(handle);
   }
 
   bool AssetManager::contains(UUID const & uuid) const {
-    std::scoped_lock guard{m_assetLock};
+    std::shared_lock guard{m_assetLock};
     return m_idToHandle.contains(uuid);
   }
 
   AssetHandle AssetManager::find(UUID const & uuid) const {
-    std::scoped_lock guard{m_assetLock};
+    std::shared_lock guard{m_assetLock};
     AssetHandle      ret;
     if (!m_idToHandle.tryGet(uuid, &ret)) {
       return {};
@@ -134,7 +147,7 @@ namespace engine {
   }
 
   AssetHandle AssetManager::find(bfc::Ref<void> const & pAsset) const {
-    std::scoped_lock guard{m_assetLock};
+    std::shared_lock guard{m_assetLock};
     AssetHandle ret;
     if (!m_ptrToHandle.tryGet(pAsset.get(), &ret)) {
       return {};
@@ -142,6 +155,16 @@ namespace engine {
     return ret;
   }
 
+  AssetHandle AssetManager::find(URI const & uri, type_index const & type) const {
+    std::optional<String> loaderID = findLoaderID(uri, type);
+    if (!loaderID.has_value()) {
+      return {};
+    }
+
+    std::shared_lock guard{m_assetLock};
+    return find_unlocked(normalize(uri), loaderID.value());
+  }
+
   AssetHandle AssetManager::add(URI const & uri, type_index const & type) {
     // Find a loader that can handle this asset.
     std::optional<String> loaderID = findLoaderID(uri, type);
@@ -162,17 +185,27 @@ namespace engine {
     bfc::Ref<IAssetLoader> pLoader = findLoader_unlocked(loaderID);
     loaderGuard.unlock();
 
-    std::scoped_lock guard{m_assetLock};
-    for (int64_t index = 0; index < m_assetPool.capacity(); ++index) {
-      if (!m_assetPool.isUsed(index)) {
-        continue;
-      }
-      Asset & asset = m_assetPool[index];
-      if (asset.loader == loaderID && asset.uri == uri) {
-        return {(uint64_t)index};
+    if (pLoader == nullptr) {
+      return {};
+    }
+
+    URI normalized = normalize(uri);
+    {
+      // Most calls find an existing asset, so check without blocking other readers first.
+      std::shared_lock readGuard{m_assetLock};
+      AssetHandle      existing = find_unlocked(normalized, loaderID);
+      if (existing != InvalidAssetHandle) {
+        return existing;
       }
     }
 
+    std::scoped_lock guard{m_assetLock};
+    // Another thread may have added the asset while the lock was released.
+    AssetHandle existing = find_unlocked(normalized, loaderID);
+    if (existing != InvalidAssetHandle) {
+      return existing;
+    }
+
     Asset newAsset;
     newAsset.loader  = loaderID;
     newAsset.uri     = uri;
@@ -180,12 +213,14 @@ namespace engine {
     newAsset.version = bfc::NewRef<uint64_t>(1);
     newAsset.type    = pLoader->assetType();
 
-    int64_t index = m_assetPool.emplace(newAsset);
-    return {(uint64_t)index};
+    AssetHandle handle = {(uint64_t)m_assetPool.emplace(newAsset)};
+    m_uriToHandle.add({String(loaderID), normalized}, handle);
+    m_typeToHandles.getOrAdd(newAsset.type).pushBack(handle);
+    return handle;
   }
 
   bfc::UUID AssetManager::uuidOf(AssetHandle const & handle) const {
-    std::unique_lock assetGuard{m_assetLock};
+    std::shared_lock assetGuard{m_assetLock};
     if (!m_assetPool.isUsed(handle)) {
       return {};
     }
@@ -194,7 +229,7 @@ namespace engine {
   }
 
   bfc::URI AssetManager::uriOf(AssetHandle const & handle) const {
-    std::unique_lock assetGuard{m_assetLock};
+    std::shared_lock assetGuard{m_assetLock};
     if (!m_assetPool.isUsed(handle)) {
       return {};
     }
@@ -226,8 +261,14 @@ namespace engine {
         return nullptr;
       }
 
-      Ref<void> pLoaded = stored.pInstance;
+      Residency & residency = m_residency.getOrAdd(stored.type);
+      Ref<void>   pLoaded   = stored.pInstance;
       if (pLoaded != nullptr) {
+        ++residency.stats.hits;
+        if (stored.cached) {
+          uncache_unlocked(handle);
+        }
+
         if (pLoadedVersion != nullptr)
           *pLoadedVersion = stored.lastVersionLoaded;
 
@@ -246,6 +287,7 @@ namespace engine {
 
       if (load) {
         stored.status = AssetStatus_Loading;
+        ++residency.stats.misses;
       } else if (wait) {
         m_assetNotifier.wait(assetGuard, [&]() { return m_assetPool[handle].status != AssetStatus_Loading; });
       } else {
@@ -253,7 +295,8 @@ namespace engine {
       }
     }
 
-    URI assetUri = m_assetPool[handle].uri;
+    URI    assetUri = m_assetPool[handle].uri;
+    String loaderID = m_assetPool[handle].loader;
 
     Ref<void> pInstance;
     if (load) {
@@ -265,26 +308,33 @@ namespace engine {
 
       AssetLoadContext context{this};
       auto             lastModified    = m_pFileSystem->lastModified(assetUri);
-      if (lastModified.has_value()) {
-        if (pCache != nullptr) {
-          Cache::Entry entry;
-          if (m_pCache->checkout(assetUri.c_str(), &entry)) {
-            BFC_LOG_INFO("AssetManager", "Reading cached asset (handle: %lld, uri: %s, type: %s)",
-                            handle.index, assetUri, pLoader->assetType().name());
-
-            auto header = bfc::read<::CacheHeader>(&entry.stream);
-            if (header.has_value()) {
-              const bool isStale = header->dependencies.find([&](::CacheHeader::Dependency const & dep) {
-                return m_pFileSystem->lastModified(dep.uri) != dep.lastModified;
-              }) != -1;
-
-              if (!isStale) {
-                pInstance = pCache->_read(&entry.stream);
-              } else {
-                entry.stream.close();
-
-                m_pCache->remove(assetUri.c_str());
-              }
+
+      // Cached assets are found by the content of their source rather than its timestamp, so the cache stays
+      // valid when files are touched or the project is checked out again.
+      std::optional<String> cacheKey;
+      if (pCache != nullptr && lastModified.has_value())
+        cacheKey = cacheKeyOf(loaderID, pLoader.get(), assetUri);
+
+      if (cacheKey.has_value()) {
+        Cache::Entry entry;
+        if (m_pCache->checkout(cacheKey.value(), &entry)) {
+          BFC_LOG_INFO("AssetManager", "Reading cached asset (handle: %lld, uri: %s, type: %s)",
+                          handle.index, assetUri, pLoader->assetType().name());
+
+          auto header = bfc::read<::CacheHeader>(entry.stream());
+          if (header.has_value()) {
+            const bool isStale = header->dependencies.find([&](::CacheHeader::Dependency const & dep) {
+              return contentHash(dep.uri) != dep.content;
+            }) != -1;
+
+            Cache::Entry payload;
+            if (!isStale && m_pCache->checkout(payloadKey(cacheKey.value()), &payload)) {
+              pInstance = pCache->_read(payload.stream());
+            } else if (isStale) {
+              entry.close();
+
+              m_pCache->remove(cacheKey.value());
+              m_pCache->remove(payloadKey(cacheKey.value()));
             }
           }
         }
@@ -295,14 +345,18 @@ namespace engine {
         pInstance = pLoader->_load(assetUri, &context);
       }
 
+      int64_t size = pInstance == nullptr ? 0 : AssetEntryCost + pLoader->_sizeOf(pInstance);
+
       assetGuard.lock();
       Asset & stored           = m_assetPool[handle];
       stored.lastVersionLoaded = loadingVersion;
       stored.pInstance         = pInstance;
       stored.status            = pInstance == nullptr ? AssetStatus_Failed : AssetStatus_Loaded;
       stored.lastModified      = lastModified;
+      stored.size              = size;
+      m_residency.getOrAdd(stored.type).stats.residentBytes += size;
 
-      bool canTryCache = !loadedFromCache && lastModified.has_value();
+      bool canTryCache = !loadedFromCache && cacheKey.has_value();
       for (AssetHandle const & dependency : context.getDependencies()) {
         m_assetPool[dependency].dependent.add(handle);
         canTryCache &= m_assetPool[dependency].lastModified.has_value();
@@ -326,25 +380,38 @@ namespace engine {
         *ppInstance = pInstance;
       }
 
-      ::CacheHeader cacheHeader;
-      cacheHeader.dependencies.pushBack({ assetUri, lastModified.value() });
+      Vector<URI> dependencyUris;
       for (AssetHandle const & dependency : context.getDependencies())
-        cacheHeader.dependencies.pushBack({ m_assetPool[dependency].uri, m_assetPool[dependency].lastModified.value() });
+        dependencyUris.pushBack(m_assetPool[dependency].uri);
+      for (URI const & file : context.getFileDependencies())
+        dependencyUris.pushBack(file);
       assetGuard.unlock();
       m_assetNotifier.notify_all();
 
       if (pInstance != nullptr) {
         if (pCache != nullptr && canTryCache) {
-          bfc::async([=, header = std::move(cacheHeader)]() {
+          bfc::async([=, key = cacheKey.value(), dependencies = std::move(dependencyUris)]() {
             BFC_LOG_INFO("AssetManager", "Caching asset (handle: %lld, uri: %s, type: %s, loader: %s)", handle.index,
-                         stored.uri, pLoader->assetType().name(), stored.loader);
-            Cache::Entry newCacheEntry = m_pCache->create();
-            newCacheEntry.stream.write(header);
-            if (pCache->_store(pInstance, &newCacheEntry.stream))
-              m_pCache->commit(assetUri.c_str(), &newCacheEntry);
-            else
+                         assetUri, pLoader->assetType().name(), loaderID);
+            ::CacheHeader header;
+            for (URI const & dependency : dependencies) {
+              std::optional<Hash128> content = contentHash(dependency);
+              if (!content.has_value())
+                return;
+              header.dependencies.pushBack({dependency, content.value()});
+            }
+
+            // The asset data is stored in its own entry, so identical data is only stored once by packed caches.
+            Cache::Entry newCacheEntry = m_pCache->create(CacheEntryFlags_None);
+            Cache::Entry newPayload    = m_pCache->create(CacheEntryFlags_Compressed);
+            newCacheEntry.stream()->write(header);
+            if (pCache->_store(pInstance, newPayload.stream())) {
+              m_pCache->commit(payloadKey(key), &newPayload);
+              m_pCache->commit(key, &newCacheEntry);
+            } else {
               BFC_LOG_WARNING("AssetManager", "Failed to write cache (handle: %lld, uri: %s, type: %s, loader: %s)",
-                              handle.index, stored.uri, pLoader->assetType().name(), stored.loader);
+                              handle.index, assetUri, pLoader->assetType().name(), loaderID);
+            }
           });
         }
       }
@@ -368,20 +435,37 @@ namespace engine {
 
   void AssetManager::loop(Application * pApp) {
     std::unique_lock assetGuard{m_assetLock};
-    for (auto& asset : m_assetPool) {
-      if (asset.pInstance.use_count() == 1) {
-        m_ptrToHandle.erase(asset.pInstance.get());
-        asset.pInstance = nullptr; // Remove the asset
-        asset.status    = AssetStatus_Unloaded;
-        *asset.version += 1;
-        BFC_LOG_INFO("AssetManager", "Unloaded asset (uri: %s, type: %s, loader: %s)", asset.uri, asset.type.name(),
-                     asset.loader);
+
+    // Move assets that are only referenced by the asset manager to the residency list.
+    for (int64_t index = 0; index < m_assetPool.capacity(); ++index) {
+      if (!m_assetPool.isUsed(index) || m_assetPool[index].pInstance == nullptr) {
+        continue;
+      }
+
+      Asset &    asset        = m_assetPool[index];
+      const bool unreferenced = asset.pInstance.use_count() == 1;
+      if (unreferenced && !asset.cached) {
+        cache_unlocked({(uint64_t)index});
+      } else if (!unreferenced && asset.cached) {
+        uncache_unlocked({(uint64_t)index});
+      }
+    }
+
+    // Unload the least recently used assets of each type that is over budget.
+    for (auto & [type, residency] : m_residency) {
+      while (residency.stats.cachedCount > 0 && (residency.budget == 0 || residency.stats.cachedBytes > residency.budget)) {
+        AssetHandle handle = residency.first;
+        Asset &     asset  = m_assetPool[handle];
+        BFC_LOG_INFO("AssetManager", "Unloaded asset (uri: %s, type: %s, loader: %s, size: %lld)", asset.uri, asset.type.name(), asset.loader,
+                     asset.size);
+        unload_unlocked(handle);
+        ++residency.stats.evictions;
       }
     }
   }
 
   bfc::Ref<uint64_t> AssetManager::getVersionReference(AssetHandle const & handle) const {
-    std::unique_lock assetGuard{m_assetLock};
+    std::shared_lock assetGuard{m_assetLock};
 
     return m_assetPool.isUsed(handle) ? m_assetPool[handle].version : nullptr;
   }
@@ -415,9 +499,40 @@ namespace engine {
     return m_pFileSystem.get();
   }
 
+  void AssetManager::setResidencyBudget(bfc::type_index const & type, int64_t bytes) {
+    std::scoped_lock guard{m_assetLock};
+    m_residency.getOrAdd(type).budget = bytes;
+  }
+
+  int64_t AssetManager::getResidencyBudget(bfc::type_index const & type) const {
+    std::shared_lock guard{m_assetLock};
+    Residency const * pResidency = m_residency.tryGet(type);
+    return pResidency == nullptr ? DefaultResidencyBudget : pResidency->budget;
+  }
+
+  AssetResidencyStats AssetManager::getResidencyStats(bfc::type_index const & type) const {
+    std::shared_lock guard{m_assetLock};
+    Residency const * pResidency = m_residency.tryGet(type);
+    return pResidency == nullptr ? AssetResidencyStats{} : pResidency->stats;
+  }
+
+  AssetResidencyStats AssetManager::getResidencyStats() const {
+    std::shared_lock    guard{m_assetLock};
+    AssetResidencyStats total;
+    for (auto & [type, residency] : m_residency) {
+      total.hits += residency.stats.hits;
+      total.misses += residency.stats.misses;
+      total.evictions += residency.stats.evictions;
+      total.residentBytes += residency.stats.residentBytes;
+      total.cachedBytes += residency.stats.cachedBytes;
+      total.cachedCount += residency.stats.cachedCount;
+    }
+    return total;
+  }
+
   bfc::Vector<AssetHandle>
   AssetManager::findHandles(std::function<bool(bfc::URI const & uri, bfc::type_index const & type, bfc::StringView const & loaderID)> const & filter) const {
-    std::unique_lock assetGuard{m_assetLock};
+    std::shared_lock assetGuard{m_assetLock};
     bfc::Vector<AssetHandle> ret;
     for (int64_t handle = 0; handle < m_assetPool.capacity(); ++handle) {
       if (!m_assetPool.isUsed(handle)) {
@@ -433,6 +548,28 @@ namespace engine {
     return ret;
   }
 
+  bfc::Vector<AssetHandle> AssetManager::findHandles(bfc::type_index const &                                                              type,
+                                                     std::function<bool(bfc::URI const & uri, bfc::StringView const & loaderID)> const & filter) const {
+    std::shared_lock assetGuard{m_assetLock};
+    bfc::Vector<AssetHandle> const * pHandles = m_typeToHandles.tryGet(type);
+    if (pHandles == nullptr) {
+      return {};
+    }
+
+    if (filter == nullptr) {
+      return *pHandles;
+    }
+
+    bfc::Vector<AssetHandle> ret;
+    for (AssetHandle const & handle : *pHandles) {
+      Asset const & asset = m_assetPool[handle];
+      if (filter(asset.uri, asset.loader))
+        ret.pushBack(handle);
+    }
+
+    return ret;
+  }
+
   Ref<IAssetLoader> AssetManager::findLoader_unlocked(StringView const & loaderID) const {
     for (int64_t i = 0; i < m_loaders.size(); ++i) {
       if (m_loaders[i].loaderID == loaderID) {
@@ -451,18 +588,126 @@ namespace engine {
     return nullptr;
   }
 
-  bool AssetManager::reload(AssetHandle const & handle, std::unique_lock<std::mutex> & lock) {
+  AssetHandle AssetManager::find_unlocked(bfc::URI const & uri, bfc::StringView const & loaderID) const {
+    AssetHandle const * pHandle = m_uriToHandle.tryGet({String(loaderID), uri});
+    return pHandle == nullptr ? InvalidAssetHandle : *pHandle;
+  }
+
+  void AssetManager::unload_unlocked(AssetHandle const & handle) {
+    Asset & asset = m_assetPool[handle];
+    if (asset.cached) {
+      uncache_unlocked(handle);
+    }
+
+    if (asset.pInstance != nullptr) {
+      m_ptrToHandle.erase(asset.pInstance.get());
+      m_residency.getOrAdd(asset.type).stats.residentBytes -= asset.size;
+    }
+
+    asset.pInstance = nullptr;
+    asset.size      = 0;
+    asset.status    = AssetStatus_Unloaded;
+    ++(*asset.version);
+  }
+
+  void AssetManager::cache_unlocked(AssetHandle const & handle) {
+    Asset &     asset     = m_assetPool[handle];
+    Residency & residency = m_residency.getOrAdd(asset.type);
+
+    asset.cached     = true;
+    asset.prevCached = residency.last;
+    asset.nextCached = InvalidAssetHandle;
+    if (residency.last != InvalidAssetHandle) {
+      m_assetPool[residency.last].nextCached = handle;
+    } else {
+      residency.first = handle;
+    }
+    residency.last = handle;
+
+    residency.stats.cachedBytes += asset.size;
+    ++residency.stats.cachedCount;
+  }
+
+  void AssetManager::uncache_unlocked(AssetHandle const & handle) {
+    Asset &     asset     = m_assetPool[handle];
+    Residency & residency = m_residency.getOrAdd(asset.type);
+
+    if (asset.prevCached != InvalidAssetHandle) {
+      m_assetPool[asset.prevCached].nextCached = asset.nextCached;
+    } else {
+      residency.first = asset.nextCached;
+    }
+
+    if (asset.nextCached != InvalidAssetHandle) {
+      m_assetPool[asset.nextCached].prevCached = asset.prevCached;
+    } else {
+      residency.last = asset.prevCached;
+    }
+
+    asset.cached     = false;
+    asset.prevCached = InvalidAssetHandle;
+    asset.nextCached = InvalidAssetHandle;
+
+    residency.stats.cachedBytes -= asset.size;
+    --residency.stats.cachedCount;
+  }
+
+  bfc::URI AssetManager::normalize(bfc::URI const & uri) {
+    // Collapse "." and ".." segments. Most URIs have none, so avoid rebuilding those.
+    StringView path = uri.pathView();
+    if (path.find("./") == npos && !path.endsWith("/.") && !path.endsWith("/..")) {
+      return uri;
+    }
+
+    return uri.withPath(Filename::getDirect(path).path());
+  }
+
+  std::optional<Hash128> AssetManager::contentHash(URI const & uri) {
+    std::optional<Timestamp> lastModified = m_pFileSystem->lastModified(uri);
+    if (!lastModified.has_value())
+      return std::nullopt;
+
+    {
+      std::scoped_lock    guard{m_contentLock};
+      ContentHash const * pKnown = m_contentHashes.tryGet(uri);
+      if (pKnown != nullptr && pKnown->lastModified == lastModified.value())
+        return pKnown->hash;
+    }
+
+    Ref<Stream> pStream = m_pFileSystem->open(uri, FileMode_ReadBinary);
+    if (pStream == nullptr)
+      return std::nullopt;
+
+    Hash128 const    hash = hashStream(pStream.get());
+    std::scoped_lock guard{m_contentLock};
+    m_contentHashes.addOrSet(uri, {lastModified.value(), hash});
+    return hash;
+  }
+
+  std::optional<String> AssetManager::cacheKeyOf(StringView const & loaderID, IAssetLoader const * pLoader, URI const & uri) {
+    std::optional<Hash128> content = contentHash(uri);
+    if (!content.has_value())
+      return std::nullopt;
+
+    // Assets of different types can be loaded from the same file, so the loader is part of the key.
+    // Loaded assets can depend on where their source is (e.g. meshes find their textures and materials next to it),
+    // so identical files at different URIs are cached separately.
+    HashWriter key;
+    key.write(String(loaderID));
+    key.write(uri.str());
+    key.write(pLoader->version());
+    key.write(content.value());
+    return key.digest().toString();
+  }
+
+  bool AssetManager::reload(AssetHandle const & handle, std::unique_lock<std::shared_mutex> & lock) {
     m_assetNotifier.wait(lock, [=]() { return !m_assetPool.isUsed(handle) || m_assetPool[handle].status != AssetStatus_Loading; });
 
     if (!m_assetPool.isUsed(handle)) {
       return false;
     }
 
-    m_ptrToHandle.erase(m_assetPool[handle].pInstance.get());
-    m_assetPool[handle].pInstance = nullptr;
-    m_assetPool[handle].status    = AssetStatus_Unloaded;
-
-    ++(*m_assetPool[handle].version);
+    unload_unlocked(handle);
 
     Vector<AssetHandle> invalid;
     for (AssetHandle const & dependent : m_assetPool[handle].dependent) {
@@ -9,10 +9,12 @@
 #include "util/ThreadPool.h"
 #include "util/UUID.h"
 #include "util/Cache.h"
+#include "util/Hash.h"
 
 #include <limits>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 
 namespace engine {
   struct AssetHandle {
@@ -32,6 +34,16 @@ namespace engine {
     AssetStatus_Failed,
   };
 
+  /// Residency counters for a type of asset.
+  struct AssetResidencyStats {
+    int64_t hits          = 0; ///< Loads that found the asset already loaded.
+    int64_t misses        = 0; ///< Loads that had to load the asset.
+    int64_t evictions     = 0; ///< Unreferenced assets unloaded to stay within the budget.
+    int64_t residentBytes = 0; ///< Estimated size of all loaded assets.
+    int64_t cachedBytes   = 0; ///< Estimated size of loaded assets that are no longer referenced.
+    int64_t cachedCount   = 0; ///< Number of loaded assets that are no longer referenced.
+  };
+
   template<typename T>
   class Asset;
 
@@ -39,6 +51,13 @@ namespace engine {
   class IAssetCache;
   class AssetManager : public Subsystem {
   public:
+    /// Default byte budget for unreferenced assets of each type.
+    inline static constexpr int64_t DefaultResidencyBudget = 64ll * 1024 * 1024;
+
+    /// Added to the estimated size of every loaded asset, so assets whose loader can't estimate
+    /// their size still count towards the budget and are eventually unloaded.
+    inline static constexpr int64_t AssetEntryCost = 1024;
+
     AssetManager();
 
     bool init(Application *pApp) override;
@@ -62,7 +81,12 @@ namespace engine {
 
     /// Find the handle of an asset by its type and uri.
     template<typename T>
-    AssetHandle find(bfc::URI const & uri) const {}
+    AssetHandle find(bfc::URI const & uri) const {
+      return find(uri, bfc::TypeID<T>());
+    }
+
+    /// Find the handle of an asset by its uri and type.
+    AssetHandle find(bfc::URI const & uri, bfc::type_index const & type) const;
 
     /// Find the handle of an asset by its pointer.
     AssetHandle find(bfc::Ref<void> const & pAsset) const;
@@ -153,13 +177,38 @@ namespace engine {
 
     VirtualFileSystem * getFileSystem() const;
 
+    /// Set the byte budget for unreferenced assets of a type.
+    /// Assets that are no longer referenced stay loaded, and are unloaded in least recently used
+    /// order once their estimated size exceeds the budget. A budget of 0 unloads them immediately.
+    void setResidencyBudget(bfc::type_index const & type, int64_t bytes);
+
+    template<typename T>
+    void setResidencyBudget(int64_t bytes) {
+      setResidencyBudget(bfc::TypeID<T>(), bytes);
+    }
+
+    int64_t getResidencyBudget(bfc::type_index const & type) const;
+
+    /// Get the residency counters for a type of asset.
+    AssetResidencyStats getResidencyStats(bfc::type_index const & type) const;
+
+    template<typename T>
+    AssetResidencyStats getResidencyStats() const {
+      return getResidencyStats(bfc::TypeID<T>());
+    }
+
+    /// Get the residency counters summed over all asset types.
+    AssetResidencyStats getResidencyStats() const;
+
     template<typename T>
     bfc::Vector<AssetHandle> findHandles(std::function<bool(bfc::URI const & uri, bfc::StringView const & loaderID)> const & filter = nullptr) const {
-      return findHandles([=](bfc::URI const & uri, bfc::type_index const & type, bfc::StringView const & loaderID) {
-        return type == bfc::TypeID<T>() && (filter == nullptr || filter(uri, loaderID));
-      });
+      return findHandles(bfc::TypeID<T>(), filter);
     }
 
+    /// Find the handles of all assets of a specific type.
+    bfc::Vector<AssetHandle> findHandles(bfc::type_index const &                                                              type,
+                                         std::function<bool(bfc::URI const & uri, bfc::StringView const & loaderID)> const & filter = nullptr) const;
+
     bfc::Vector<AssetHandle>
     findHandles(std::function<bool(bfc::URI const & uri, bfc::type_index const & type, bfc::StringView const & loaderID)> const & filter = nullptr) const;
 
@@ -168,7 +217,20 @@ namespace engine {
   private:
     bfc::Ref<IAssetLoader> findLoader_unlocked(bfc::StringView const & loaderID) const;
     bfc::Ref<IAssetCache>  findCache_unlocked(bfc::type_index const & assetType) const;
-    bool                   reload(AssetHandle const & handle, std::unique_lock<std::mutex> &lock);
+    AssetHandle            find_unlocked(bfc::URI const & uri, bfc::StringView const & loaderID) const;
+    void                   unload_unlocked(AssetHandle const & handle);
+    void                   cache_unlocked(AssetHandle const & handle);
+    void                   uncache_unlocked(AssetHandle const & handle);
+    bool                   reload(AssetHandle const & handle, std::unique_lock<std::shared_mutex> &lock);
+
+    /// Normalize a URI so that equivalent paths map to the same asset.
+    static bfc::URI normalize(bfc::URI const & uri);
+
+    /// Hash the content of a file. Hashes are reused until the file is modified.
+    std::optional<bfc::Hash128> contentHash(bfc::URI const & uri);
+
+    /// Get the cache key of an asset, from the loader, the asset's URI and the content of its source.
+    std::optional<bfc::String> cacheKeyOf(bfc::StringView const & loaderID, IAssetLoader const * pLoader, bfc::URI const & uri);
 
     struct Asset {
       AssetStatus     status = AssetStatus_Unloaded;
@@ -180,12 +242,25 @@ namespace engine {
       bfc::Ref<uint64_t> version = nullptr;
       uint64_t lastVersionLoaded = 0;
       std::optional<bfc::Timestamp> lastModified;
+      int64_t size = 0; ///< Estimated size of the loaded instance in bytes.
+
+      bool        cached = false; ///< The instance is unreferenced and in the residency list.
+      AssetHandle prevCached;     ///< Previous (less recently used) asset in the residency list.
+      AssetHandle nextCached;     ///< Next (more recently used) asset in the residency list.
 
       bfc::Vector<bfc::Pair<uint64_t *, bfc::Ref<void> *>> waiting; ///< Waiting for the load to complete
 
       bfc::Set<AssetHandle> dependent;
     };
 
+    /// Unreferenced assets of a single type, in least recently used order.
+    struct Residency {
+      int64_t             budget = DefaultResidencyBudget;
+      AssetHandle         first;
+      AssetHandle         last;
+      AssetResidencyStats stats;
+    };
+
     struct LoaderInfo {
       bfc::String            loaderID;
       bfc::Ref<IAssetLoader> pLoader;
@@ -198,13 +273,27 @@ namespace engine {
     bfc::Vector<bfc::Ref<IAssetCache>> m_caches;
     bfc::Ref<bfc::Cache>               m_pCache;
 
-    mutable std::mutex              m_assetLock;
-    mutable std::condition_variable m_assetNotifier;
+    mutable std::shared_mutex           m_assetLock;
+    mutable std::condition_variable_any m_assetNotifier;
 
     bfc::Pool<Asset>                 m_assetPool;
     bfc::Map<bfc::UUID, AssetHandle> m_idToHandle;
     bfc::Map<void*, AssetHandle>     m_ptrToHandle;
 
+    /// Assets indexed by their loader ID and normalized URI.
+    bfc::Map<bfc::Pair<bfc::String, bfc::URI>, AssetHandle> m_uriToHandle;
+    /// Assets indexed by their type.
+    bfc::Map<bfc::type_index, bfc::Vector<AssetHandle>> m_typeToHandles;
+    bfc::Map<bfc::type_index, Residency>                 m_residency;
+
+    struct ContentHash {
+      bfc::Timestamp lastModified;
+      bfc::Hash128   hash;
+    };
+
+    std::mutex                      m_contentLock;
+    bfc::Map<bfc::URI, ContentHash> m_contentHashes; ///< Content hashes of files, and when the file was hashed.
+
     bfc::Ref<VirtualFileSystem> m_pFileSystem;
   };
 
@@ -1,6 +1,7 @@
 #include "MaterialLoader.h"
 #include "AssetManager.h"
 #include "AssetLoadContext.h"
+#include "TextureLoader.h"
 
 #include "mesh/Mesh.h"
 #include "util/Scan.h"
@@ -8,6 +9,16 @@
 using namespace bfc;
 
 namespace engine {
+  int64_t estimateMaterialSize(Material const & material) {
+    int64_t size = sizeof(renderer::PBRMaterial);
+    for (graphics::TextureRef const & pTexture : material.textures) {
+      if (pTexture != nullptr) {
+        size += estimateTextureSize(*pTexture);
+      }
+    }
+    return size;
+  }
+
   Ref<MeshData::Material> MaterialFileLoader::load(URI const & uri, AssetLoadContext * pContext) const {
     auto material = pContext->getFileSystem()->deserialize<MeshData::Material>(uri);
 
@@ -24,6 +35,16 @@ namespace engine {
     return Filename::extension(uri.pathView()) == "material";
   }
 
+  int64_t MaterialFileLoader::sizeOf(MeshData::Material const & asset) const {
+    int64_t size = sizeof(MeshData::Material) + asset.getName().length();
+    size += asset.getColours().size() * (sizeof(MeshData::Material::PropertyID) + sizeof(Vec4));
+    size += asset.getValues().size() * (sizeof(MeshData::Material::PropertyID) + sizeof(double));
+    for (MeshData::Material::PropertyID const & texture : asset.getTextures()) {
+      size += sizeof(MeshData::Material::PropertyID) + sizeof(String) + asset.getTexture(texture.first, texture.second).length();
+    }
+    return size;
+  }
+
   MaterialLoader::MaterialLoader(GraphicsDevice * pDevice)
     : m_pGraphics(pDevice) {}
 
@@ -47,4 +68,8 @@ namespace engine {
   bool MaterialLoader::handles(URI const & uri, AssetManager const * pManager) const {
     return pManager->canLoad<MeshData::Material>(uri);
   }
+
+  int64_t MaterialLoader::sizeOf(Material const & asset) const {
+    return estimateMaterialSize(asset);
+  }
 } // namespace engine
@@ -9,10 +9,15 @@ namespace bfc {
 } // namespace bfc
 
 namespace engine {
+  /// Estimate the memory used by `material` in bytes.
+  /// Includes the textures it references, as they can't be unloaded until the material is.
+  int64_t estimateMaterialSize(bfc::Material const & material);
+
   class MaterialFileLoader : public AssetLoader<bfc::MeshData::Material> {
   public:
     virtual bfc::Ref<bfc::MeshData::Material> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                              handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                           sizeOf(bfc::MeshData::Material const & asset) const override;
   };
 
   class MaterialLoader : public AssetLoader<bfc::Material> {
@@ -21,6 +26,7 @@ namespace engine {
 
     virtual bfc::Ref<bfc::Material> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                    handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                 sizeOf(bfc::Material const & asset) const override;
 
   private:
     bfc::GraphicsDevice * m_pGraphics;
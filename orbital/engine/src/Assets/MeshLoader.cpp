@@ -1,8 +1,11 @@
 #include "MeshLoader.h"
 #include "AssetManager.h"
 #include "AssetLoadContext.h"
+#include "MaterialLoader.h"
 
 #include "mesh/Mesh.h"
+#include "mesh/MeshBlob.h"
+#include "mesh/MeshSimplifier.h"
 #include "mesh/parsers/OBJParser.h"
 #include "mesh/parsers/FBXParser.h"
 
@@ -11,6 +14,11 @@
 using namespace bfc;
 
 namespace engine {
+  namespace {
+    /// Number of simplified levels generated for each mesh.
+    constexpr int64_t MaxLodCount = 4;
+  } // namespace
+
   Ref<MeshData> MeshDataFileLoader::load(URI const & uri, AssetLoadContext * pContext) const {
     BFC_UNUSED(pContext);
 
@@ -26,8 +34,11 @@ namespace engine {
     Filename   parentPath = Filename::parent(pContext->getFileSystem()->resolveUri(uri).path());
 
     if (ext.equals("obj", true)) {
-      // TODO: more customization of how dependent files are loaded.
-      success = OBJParser::read(pStream.get(), pMeshData.get(), parentPath);
+      // Material libraries are opened through the context, so the cached mesh is invalidated when they change.
+      URI const resourceDir = uri.resolveRelativeReference("../");
+      success = OBJParser::read(pStream.get(), pMeshData.get(), [=](StringView const & path) {
+        return pContext->open(resourceDir.resolveRelativeReference(URI(path)));
+      });
     } else if (ext.equals("fbx", true)) {
       success = FBXParser::read(pStream.get(), pMeshData.get(), parentPath);
     }
@@ -45,6 +56,9 @@ namespace engine {
 
     pMeshData->findTextures();
 
+    // Generated with the mesh data, rather than in MeshLoader, so the levels are stored in the mesh cache.
+    MeshSimplifier::generateLODs(pMeshData.get(), MaxLodCount);
+
     return pMeshData;
   }
 
@@ -54,12 +68,50 @@ namespace engine {
     return MeshData::canRead(Filename::extension(uri.pathView()));
   }
 
+  int64_t MeshDataFileLoader::sizeOf(MeshData const & asset) const {
+    int64_t lodTriangleCount = 0;
+    for (MeshData::LevelOfDetail const & lod : asset.lods) {
+      lodTriangleCount += lod.triangles.size();
+    }
+
+    return asset.positions.size() * sizeof(Vec3d) + asset.uvs.size() * sizeof(Vec2d) + asset.colours.size() * sizeof(Vec4d)
+         + asset.normals.size() * sizeof(Vec3d) + asset.tangents.size() * sizeof(Vec3d) + asset.vertices.size() * sizeof(MeshData::Vertex)
+         + asset.triangles.size() * sizeof(MeshData::Triangle) + lodTriangleCount * sizeof(MeshData::Triangle);
+  }
+
+  int64_t MeshDataFileLoader::version() const {
+    // 2: OBJ face corners are merged and levels of detail are generated.
+    return 2;
+  }
+
+  Ref<MeshBlob> MeshBlobLoader::load(URI const & uri, AssetLoadContext * pContext) const {
+    Ref<MeshData> pData = pContext->load<MeshData>(uri);
+    if (pData == nullptr) {
+      return nullptr;
+    }
+
+    return NewRef<MeshBlob>(*pData, MeshOptimizeFlags_All);
+  }
+
+  bool MeshBlobLoader::handles(URI const & uri, AssetManager const * pManager) const {
+    return pManager->canLoad<MeshData>(uri);
+  }
+
+  int64_t MeshBlobLoader::sizeOf(MeshBlob const & asset) const {
+    return asset.bytes().size();
+  }
+
+  int64_t MeshBlobLoader::version() const {
+    // 2: Blobs are built from meshes with merged corners and normalized LOD errors.
+    return 2;
+  }
+
   MeshLoader::MeshLoader(GraphicsDevice * pDevice)
     : m_pGraphics(pDevice) {}
 
   Ref<Mesh> MeshLoader::load(URI const & uri, AssetLoadContext * pContext) const {
-    Ref<MeshData> pData = pContext->load<MeshData>(uri);
-    if (pData == nullptr) {
+    Ref<MeshBlob> pBlob = pContext->load<MeshBlob>(uri);
+    if (pBlob == nullptr) {
       return nullptr;
     }
 
@@ -67,7 +119,7 @@ namespace engine {
     auto      pCmdList = m_pGraphics->createCommandList();
     pCmdList->setDebugName("MeshLoader::load");
 
-    if (!pMesh->load(pCmdList.get(), *pData)) {
+    if (!pMesh->load(pCmdList.get(), pBlob)) {
       return nullptr;
     }
 
@@ -80,6 +132,10 @@ namespace engine {
     return pManager->canLoad<MeshData>(uri);
   }
 
+  int64_t MeshLoader::sizeOf(Mesh const & asset) const {
+    return asset.getVertexCount() * sizeof(Mesh::Vertex) + asset.getIndexCount() * sizeof(Mesh::Index);
+  }
+
   MeshMaterialLoader::MeshMaterialLoader(GraphicsDevice * pDevice)
     : m_pGraphics(pDevice) {}
 
@@ -122,6 +178,10 @@ namespace engine {
     return fragment.startsWith(fragmentPrefix) && pManager->canLoad<MeshData>(uri);
   }
 
+  int64_t MeshMaterialLoader::sizeOf(Material const & asset) const {
+    return estimateMaterialSize(asset);
+  }
+
   Ref<MeshData> MeshDataCache::read(bfc::Stream * pStream) const {
     auto mesh = bfc::read<MeshData>(pStream);
     if (mesh.has_value())
@@ -132,4 +192,15 @@ namespace engine {
   bool MeshDataCache::store(bfc::Ref<MeshData> pAsset, bfc::Stream * pStream) const {
     return pStream->write(*pAsset.get());
   }
+
+  Ref<MeshBlob> MeshBlobCache::read(bfc::Stream * pStream) const {
+    auto blob = bfc::read<MeshBlob>(pStream);
+    if (blob.has_value())
+      return bfc::NewRef<MeshBlob>(std::move(blob.value()));
+    return nullptr;
+  }
+
+  bool MeshBlobCache::store(bfc::Ref<MeshBlob> pAsset, bfc::Stream * pStream) const {
+    return pStream->write(*pAsset.get());
+  }
 } // namespace engine
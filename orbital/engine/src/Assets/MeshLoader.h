@@ -6,6 +6,7 @@
 namespace bfc {
   class GraphicsDevice;
   class MeshData;
+  class MeshBlob;
   class Mesh;
   class Material;
 }
@@ -15,6 +16,17 @@ namespace engine {
   public:
     virtual bfc::Ref<bfc::MeshData> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                    handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                 sizeOf(bfc::MeshData const & asset) const override;
+    virtual int64_t                 version() const override;
+  };
+
+  /// Converts mesh data to a GPU ready blob, so it can be cached and uploaded without processing it again.
+  class MeshBlobLoader : public AssetLoader<bfc::MeshBlob> {
+  public:
+    virtual bfc::Ref<bfc::MeshBlob> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
+    virtual bool                    handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                 sizeOf(bfc::MeshBlob const & asset) const override;
+    virtual int64_t                 version() const override;
   };
 
   class MeshLoader : public AssetLoader<bfc::Mesh> {
@@ -23,6 +35,7 @@ namespace engine {
 
     virtual bfc::Ref<bfc::Mesh> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t             sizeOf(bfc::Mesh const & asset) const override;
 
   private:
     bfc::GraphicsDevice * m_pGraphics;
@@ -34,6 +47,7 @@ namespace engine {
 
     virtual bfc::Ref<bfc::Material> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                    handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                 sizeOf(bfc::Material const & asset) const override;
 
     inline static bfc::String fragmentPrefix = "material.";
 
@@ -48,4 +62,12 @@ namespace engine {
     /// Write the asset to `pStream`
     virtual bool store(bfc::Ref<bfc::MeshData> pAsset, bfc::Stream * pStream) const override;
   };
+
+  class MeshBlobCache : public AssetCache<bfc::MeshBlob> {
+  public:
+    /// Load the asset from the URI provided
+    virtual bfc::Ref<bfc::MeshBlob> read(bfc::Stream * pStream) const override;
+    /// Write the asset to `pStream`
+    virtual bool store(bfc::Ref<bfc::MeshBlob> pAsset, bfc::Stream * pStream) const override;
+  };
 } // namespace engine
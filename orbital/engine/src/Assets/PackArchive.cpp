@@ -0,0 +1,268 @@
+#include "PackArchive.h"
+#include "VirtualFileSystem.h"
+
+#include "core/File.h"
+#include "core/Set.h"
+#include "util/Hash.h"
+#include "util/Log.h"
+
+#include <algorithm>
+
+using namespace bfc;
+
+namespace engine {
+  namespace {
+    /// Reads a file in place from a mapped pack archive.
+    class PackFileStream : public MemoryReader {
+    public:
+      PackFileStream(Ref<PackArchive> const & pArchive, Span<uint8_t> const & data)
+        : MemoryReader(data)
+        , m_pArchive(pArchive) {}
+
+    private:
+      Ref<PackArchive> m_pArchive;
+    };
+
+    StringView trimPath(StringView path) {
+      while (path.startsWith("/") || path.startsWith("./")) {
+        path = path.substr(path[0] == '/' ? 1 : 2);
+      }
+      while (path.endsWith("/")) {
+        path = path.substr(0, path.length() - 1);
+      }
+      return path;
+    }
+
+    int64_t alignUp(int64_t value, int64_t alignment) {
+      return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /// Collect the paths of all files in a directory of a mounted drive.
+    void collectFiles(VirtualFileSystem const * pFileSystem, StringView const & drive, String const & directory, Vector<String> * pFiles) {
+      String prefix       = directory.empty() ? String() : directory + "/";
+      URI    directoryUri = URI::File(drive + ":" + prefix);
+      for (URI const & child : pFileSystem->walk(directoryUri)) {
+        String path = prefix + Filename::name(child.pathView());
+        URI    uri  = URI::File(drive + ":" + path);
+        if (pFileSystem->isLeaf(uri)) {
+          pFiles->pushBack(path);
+        } else {
+          collectFiles(pFileSystem, drive, path, pFiles);
+        }
+      }
+    }
+  } // namespace
+
+  Ref<PackArchive> PackArchive::open(Filename const & path) {
+    Ref<PackArchive> pArchive = NewRef<PackArchive>();
+    if (!pArchive->m_mapping.open(path)) {
+      return nullptr;
+    }
+
+    uint8_t const * pData = pArchive->m_mapping.data();
+    int64_t         size  = pArchive->m_mapping.size();
+    if (size < (int64_t)sizeof(Header)) {
+      BFC_LOG_WARNING("PackArchive", "Archive is too small (path: %s)", path);
+      return nullptr;
+    }
+
+    Header const * pHeader = (Header const *)pData;
+    if (pHeader->magic != Magic || pHeader->version != Version) {
+      BFC_LOG_WARNING("PackArchive", "Archive has an unsupported format (path: %s)", path);
+      return nullptr;
+    }
+
+    if (pHeader->entryCount < 0 || pHeader->tocOffset + pHeader->entryCount * (int64_t)sizeof(Entry) > size || pHeader->namesOffset > size) {
+      BFC_LOG_WARNING("PackArchive", "Archive table of contents is corrupt (path: %s)", path);
+      return nullptr;
+    }
+
+    pArchive->m_pHeader  = pHeader;
+    pArchive->m_pEntries = (Entry const *)(pData + pHeader->tocOffset);
+    pArchive->m_pNames   = (char const *)(pData + pHeader->namesOffset);
+    pArchive->m_modified = FileInfo(path).lastModified();
+
+    for (int64_t i = 0; i < pHeader->entryCount; ++i) {
+      Entry const & entry = pArchive->m_pEntries[i];
+      if (pHeader->namesOffset + entry.nameOffset + entry.nameLength > size || entry.dataOffset + entry.size > size) {
+        BFC_LOG_WARNING("PackArchive", "Archive entry %lld is corrupt (path: %s)", i, path);
+        return nullptr;
+      }
+    }
+
+    return pArchive;
+  }
+
+  bool PackArchive::build(VirtualFileSystem const * pFileSystem, StringView const & drive, Filename const & output) {
+    Vector<String> files;
+    collectFiles(pFileSystem, drive, "", &files);
+
+    Vector<Entry> entries;
+    entries.reserve(files.size());
+    int64_t namesSize = 0;
+    for (String const & file : files) {
+      Entry entry;
+      entry.pathHash     = hashPath(file);
+      entry.nameOffset   = namesSize;
+      entry.nameLength   = file.length();
+      entry.dataOffset   = 0;
+      entry.size         = 0;
+      entry.lastModified = 0;
+      namesSize += file.length();
+      entries.pushBack(entry);
+    }
+
+    // Sort the table of contents by hash so that lookups can binary search it.
+    Vector<int64_t> order;
+    for (int64_t i = 0; i < entries.size(); ++i) {
+      order.pushBack(i);
+    }
+    std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      if (entries[a].pathHash != entries[b].pathHash)
+        return entries[a].pathHash < entries[b].pathHash;
+      return files[a] < files[b];
+    });
+
+    Header header;
+    header.magic       = Magic;
+    header.version     = Version;
+    header.entryCount  = entries.size();
+    header.tocOffset   = sizeof(Header);
+    header.namesOffset = header.tocOffset + entries.size() * sizeof(Entry);
+
+    File archive;
+    if (!archive.open(output, FileMode_WriteBinary)) {
+      BFC_LOG_ERROR("PackArchive", "Failed to open archive for writing (path: %s)", output);
+      return false;
+    }
+
+    // Write the file contents first, leaving space for the header, table of contents and names.
+    static uint8_t const padding[Alignment] = {0};
+    int64_t              offset             = alignUp(header.namesOffset + namesSize, Alignment);
+    archive.write(Vector<uint8_t>(offset, 0).data(), offset);
+    for (int64_t i = 0; i < files.size(); ++i) {
+      URI             uri = URI::File(drive + ":" + files[i]);
+      Vector<uint8_t> content;
+      if (!pFileSystem->read(uri, &content)) {
+        BFC_LOG_ERROR("PackArchive", "Failed to read file (uri: %s)", uri);
+        return false;
+      }
+
+      int64_t aligned = alignUp(offset, Alignment);
+      archive.write(padding, aligned - offset);
+      if (archive.write(content.data(), content.size()) != content.size()) {
+        BFC_LOG_ERROR("PackArchive", "Failed to write archive (path: %s)", output);
+        return false;
+      }
+
+      entries[i].dataOffset   = aligned;
+      entries[i].size         = content.size();
+      entries[i].lastModified = pFileSystem->lastModified(uri).value_or(Timestamp()).length;
+      offset                  = aligned + content.size();
+    }
+
+    archive.seek(0, SeekOrigin_Start);
+    archive.write(header);
+    for (int64_t index : order) {
+      archive.write(entries[index]);
+    }
+    for (String const & file : files) {
+      archive.write(file.data(), file.length());
+    }
+
+    BFC_LOG_INFO("PackArchive", "Packed drive (name: %.*s, files: %lld, path: %s)", (int)drive.length(), drive.data(), files.size(), output);
+    return archive.flush();
+  }
+
+  int64_t PackArchive::size() const {
+    return m_pHeader->entryCount;
+  }
+
+  int64_t PackArchive::find(StringView const & path) const {
+    StringView    trimmed = trimPath(path);
+    uint64_t      hash    = hashPath(trimmed);
+    Entry const * pBegin  = m_pEntries;
+    Entry const * pEnd    = m_pEntries + m_pHeader->entryCount;
+    Entry const * pFirst  = std::lower_bound(pBegin, pEnd, hash, [](Entry const & entry, uint64_t hash) { return entry.pathHash < hash; });
+    for (Entry const * pEntry = pFirst; pEntry != pEnd && pEntry->pathHash == hash; ++pEntry) {
+      if (this->path(pEntry - pBegin) == trimmed) {
+        return pEntry - pBegin;
+      }
+    }
+    return -1;
+  }
+
+  StringView PackArchive::path(int64_t index) const {
+    Entry const & e = entry(index);
+    return StringView(m_pNames + e.nameOffset, e.nameLength);
+  }
+
+  Span<uint8_t> PackArchive::data(int64_t index) const {
+    Entry const & e = entry(index);
+    return Span<uint8_t>(m_mapping.data() + e.dataOffset, e.size);
+  }
+
+  Timestamp PackArchive::lastModified(int64_t index) const {
+    return Timestamp(entry(index).lastModified);
+  }
+
+  bool PackArchive::isDirectory(StringView const & path) const {
+    StringView directory = trimPath(path);
+    if (directory.empty()) {
+      return size() > 0;
+    }
+
+    for (int64_t i = 0; i < size(); ++i) {
+      StringView file = this->path(i);
+      if (file.length() > directory.length() && file.startsWith(directory) && file[directory.length()] == '/') {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Vector<String> PackArchive::list(StringView const & path) const {
+    StringView     directory = trimPath(path);
+    Set<String>    found;
+    Vector<String> names;
+    for (int64_t i = 0; i < size(); ++i) {
+      StringView file = this->path(i);
+      if (!directory.empty()) {
+        if (file.length() <= directory.length() || !file.startsWith(directory) || file[directory.length()] != '/') {
+          continue;
+        }
+        file = file.substr(directory.length() + 1);
+      }
+
+      int64_t separator = file.find('/');
+      String  name      = separator == npos ? file : file.substr(0, separator);
+      if (found.add(name)) {
+        names.pushBack(name);
+      }
+    }
+    return names;
+  }
+
+  Ref<Stream> PackArchive::openStream(Ref<PackArchive> const & pArchive, StringView const & path) {
+    int64_t index = pArchive->find(path);
+    if (index == -1) {
+      return nullptr;
+    }
+
+    return NewRef<PackFileStream>(pArchive, pArchive->data(index));
+  }
+
+  Timestamp PackArchive::archiveModified() const {
+    return m_modified;
+  }
+
+  uint64_t PackArchive::hashPath(StringView const & path) {
+    // The hash is stored in the archive, so it must not change between builds. hash128() is stable.
+    return hash128(path.data(), path.length()).low;
+  }
+
+  PackArchive::Entry const & PackArchive::entry(int64_t index) const {
+    BFC_ASSERT(index >= 0 && index < size(), "Pack entry index out of range");
+    return m_pEntries[index];
+  }
+} // namespace engine
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core/Stream.h"
+#include "core/String.h"
+#include "core/Timestamp.h"
+#include "platform/OS.h"
+
+#include <optional>
+
+namespace engine {
+  class VirtualFileSystem;
+
+  /// A read-only archive of files packed into a single memory mapped file.
+  /// The table of contents is sorted by path hash so entries are found with a binary search,
+  /// and each entry is stored aligned so it can be read in place without copying.
+  class PackArchive {
+  public:
+    inline static constexpr uint32_t Magic     = 0x4B41504F; // "OPAK"
+    inline static constexpr uint32_t Version   = 2;
+    inline static constexpr int64_t  Alignment = 64;
+
+    /// Open a pack archive.
+    /// @retval nullptr The file could not be mapped or is not a valid archive.
+    static bfc::Ref<PackArchive> open(bfc::Filename const & path);
+
+    /// Write all files in a mounted drive to a pack archive.
+    /// @param pFileSystem The file system the drive is mounted in.
+    /// @param drive       The name of the drive to pack.
+    /// @param output      The path of the archive to write.
+    static bool build(VirtualFileSystem const * pFileSystem, bfc::StringView const & drive, bfc::Filename const & output);
+
+    /// Get the number of files in the archive.
+    int64_t size() const;
+
+    /// Find the index of a file by its path.
+    /// @retval -1 The archive does not contain the file.
+    int64_t find(bfc::StringView const & path) const;
+
+    bfc::StringView path(int64_t index) const;
+
+    bfc::Span<uint8_t> data(int64_t index) const;
+
+    bfc::Timestamp lastModified(int64_t index) const;
+
+    /// Test if `path` is a directory containing at least one file.
+    bool isDirectory(bfc::StringView const & path) const;
+
+    /// List the names of the files and directories directly inside `directory`.
+    bfc::Vector<bfc::String> list(bfc::StringView const & directory) const;
+
+    /// Open a stream that reads a file directly from the mapped archive.
+    /// The stream keeps the archive alive.
+    static bfc::Ref<bfc::Stream> openStream(bfc::Ref<PackArchive> const & pArchive, bfc::StringView const & path);
+
+    /// Get the timestamp of the archive file.
+    bfc::Timestamp archiveModified() const;
+
+  private:
+    struct Header {
+      uint32_t magic;
+      uint32_t version;
+      int64_t  entryCount;
+      int64_t  tocOffset;
+      int64_t  namesOffset;
+    };
+
+    struct Entry {
+      uint64_t pathHash;
+      int64_t  nameOffset;
+      int64_t  nameLength;
+      int64_t  dataOffset;
+      int64_t  size;
+      int64_t  lastModified;
+    };
+
+    static uint64_t hashPath(bfc::StringView const & path);
+
+    Entry const & entry(int64_t index) const;
+
+    bfc::os::FileMapping m_mapping;
+    Header const *       m_pHeader = nullptr;
+    Entry const *        m_pEntries = nullptr;
+    char const *         m_pNames   = nullptr;
+    bfc::Timestamp       m_modified;
+  };
+} // namespace engine
@@ -4,6 +4,11 @@
 
 using namespace bfc;
 
+namespace {
+  /// Drivers don't report the size of compiled programs, so each one is assumed to be this size.
+  constexpr int64_t ProgramSizeEstimate = 64 * 1024;
+} // namespace
+
 namespace engine {
   ShaderLoader::ShaderLoader(GraphicsDevice * pGraphicsDevice)
     : m_pGraphicsDevice(pGraphicsDevice) {}
@@ -35,4 +40,10 @@ namespace engine {
   bool ShaderLoader::handles(URI const& uri, AssetManager const *) const {
     return Filename::extension(uri.pathView()).equals("shader", true);
   }
+
+  int64_t ShaderLoader::sizeOf(graphics::Program const & asset) const {
+    BFC_UNUSED(asset);
+
+    return ProgramSizeEstimate;
+  }
 } // namespace engine
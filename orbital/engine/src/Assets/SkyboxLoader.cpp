@@ -2,6 +2,7 @@
 #include "AssetLoadContext.h"
 #include "AssetLoader.h"
 #include "AssetManager.h"
+#include "TextureLoader.h"
 
 #include "VirtualFileSystem.h"
 #include "render/GraphicsDevice.h"
@@ -66,4 +67,8 @@ namespace engine {
 
     return Filename::extension(uri.pathView()).equals("skybox", true);
   }
+
+  int64_t SkyboxLoader::sizeOf(graphics::Texture const & asset) const {
+    return estimateTextureSize(asset);
+  }
 } // namespace engine
@@ -39,6 +39,7 @@ namespace engine {
 
     virtual bfc::Ref<bfc::graphics::Texture> load(bfc::URI const & uri, AssetLoadContext * pContext) const override;
     virtual bool                   handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                sizeOf(bfc::graphics::Texture const & asset) const override;
 
   private:
     bfc::GraphicsDevice * m_pGraphicsDevice = nullptr;
@@ -1,10 +1,75 @@
 #include "TextureLoader.h"
 #include "render/GraphicsDevice.h"
+#include "media/BlockCompression.h"
+#include "util/ThreadPool.h"
 #include "AssetManager.h"
 #include "AssetLoadContext.h"
 
 using namespace bfc;
 
+namespace {
+  /// Incremented when the layout of cached textures changes. Older entries fail to read and are rebuilt.
+  constexpr int32_t TextureCacheVersion = 3;
+
+  /// Describes the levels that follow it in a cache entry.
+  /// Each level is stored as packed pixels, half the size of the level above.
+  struct TextureCacheHeader {
+    int32_t     version  = TextureCacheVersion;
+    TextureType type     = TextureType_2D;
+    PixelFormat format   = PixelFormat_Unknown;
+    Vec3i       size     = {0, 0, 1};
+    int32_t     mipCount = 0;
+    Timestamp   sourceModified;
+  };
+
+  /// Get the size of mip `level` of a texture with a base level of `size`.
+  Vec3i getMipSize(Vec3i const & size, int64_t level) {
+    return {std::max(size.x >> level, 1), std::max(size.y >> level, 1), size.z};
+  }
+
+  /// Get the block compressed format used to cache a texture with `format`.
+  /// Returns PixelFormat_Unknown if the texture is cached uncompressed.
+  PixelFormat getCompressedFormat(PixelFormat format) {
+    switch (format) {
+    case PixelFormat_Ru8: return PixelFormat_BC4;
+    case PixelFormat_RGBu8: // Fall-through
+    case PixelFormat_RGBAu8: return PixelFormat_BC7;
+    default: return PixelFormat_Unknown;
+    }
+  }
+
+  /// Get the options used to filter the mip chain of a texture.
+  media::MipChainOptions getMipChainOptions() {
+    media::MipChainOptions options;
+    // Textures are uploaded in linear formats and shaders read texels as they are stored, so levels are
+    // averaged as stored too. Data textures (normals, roughness, etc.) would be skewed by filtering them as sRGB.
+    options.space    = media::ColourSpace_Linear;
+    // Textures are usually loaded on a pool thread, which must not block waiting on the pool.
+    options.pThreads = ThreadPool::IsPoolThread() ? nullptr : &ThreadPool::Global();
+    return options;
+  }
+} // namespace
+
+namespace bfc {
+  int64_t write(Stream * pStream, ::TextureCacheHeader const * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i) {
+      if (!(pStream->write(pValue[i].version) && pStream->write(pValue[i].type) && pStream->write(pValue[i].format) && pStream->write(pValue[i].size)
+            && pStream->write(pValue[i].mipCount) && pStream->write(pValue[i].sourceModified)))
+        return i;
+    }
+    return count;
+  }
+
+  int64_t read(Stream * pStream, ::TextureCacheHeader * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i) {
+      if (!(pStream->read(&pValue[i].version) && pStream->read(&pValue[i].type) && pStream->read(&pValue[i].format) && pStream->read(&pValue[i].size)
+            && pStream->read(&pValue[i].mipCount) && pStream->read(&pValue[i].sourceModified)))
+        return i;
+    }
+    return count;
+  }
+} // namespace bfc
+
 namespace engine {
   Ref<media::Surface> SurfaceLoader::load(URI const & uri, AssetLoadContext * pContext) const {
     Ref<Stream> pStream = pContext->getFileSystem()->open(uri, FileMode_ReadBinary);
@@ -28,60 +93,156 @@ namespace engine {
     return media::canLoadSurface(Filename::extension(uri.path()));
   }
 
+  int64_t SurfaceLoader::sizeOf(media::Surface const & asset) const {
+    return media::calculateSurfaceSize(asset);
+  }
+
+  TextureMips::~TextureMips() {
+    for (media::Surface & level : levels)
+      level.free();
+  }
+
+  Ref<TextureMips> TextureMipsLoader::load(URI const & uri, AssetLoadContext * pContext) const {
+    Ref<media::Surface> pSurface = pContext->load<media::Surface>(uri);
+    if (pSurface == nullptr) {
+      return nullptr;
+    }
+
+    // The surface is owned by another asset, so the base level is a copy.
+    media::Surface base;
+    base.format = pSurface->format;
+    base.size   = pSurface->size;
+    media::convertSurface(&base, *pSurface);
+    if (base.pBuffer == nullptr) {
+      return nullptr;
+    }
+
+    Ref<TextureMips> pMips = NewRef<TextureMips>();
+    pMips->sourceModified  = pContext->getFileSystem()->lastModified(uri).value_or(Timestamp{});
+    pMips->levels.pushBack(base);
+    media::generateMipChain(&pMips->levels, base, getMipChainOptions());
+    return pMips;
+  }
+
+  bool TextureMipsLoader::handles(URI const & uri, AssetManager const * pManager) const {
+    return pManager->canLoad<media::Surface>(uri);
+  }
+
+  int64_t TextureMipsLoader::sizeOf(TextureMips const & asset) const {
+    int64_t size = 0;
+    for (media::Surface const & level : asset.levels)
+      size += media::calculateSurfaceSize(level);
+    return size;
+  }
+
+  int64_t TextureMipsLoader::version() const {
+    // 2: Mip chains are filtered on the CPU.
+    // 3: 8-bit colour is filtered as stored rather than as sRGB.
+    return 3;
+  }
+
   Texture2DLoader::Texture2DLoader(GraphicsDevice * pGraphicsDevice)
     : m_pGraphicsDevice(pGraphicsDevice) {}
 
   bfc::Ref<graphics::Texture> Texture2DLoader::load(URI const & uri, AssetLoadContext * pContext) const {
-    Ref<media::Surface> pSurface = pContext->load<media::Surface>(uri);
-    if (pSurface == nullptr) {
+    // Mips are filtered on the CPU, so every level is uploaded at once rather than generated by the device.
+    Ref<TextureMips> pMips = pContext->load<TextureMips>(uri);
+    if (pMips == nullptr || pMips->levels.size() == 0) {
       return nullptr;
     }
 
     auto pLoadList = m_pGraphicsDevice->createCommandList();
     pLoadList->setDebugName("Texture2DLoader::load");
     graphics::TextureRef pTexture;
-    graphics::loadTexture2D(pLoadList.get(), &pTexture, *pSurface);
+    graphics::loadTextureMips(pLoadList.get(), &pTexture, pMips->type, Span<const media::Surface>{pMips->levels.begin(), pMips->levels.size()});
     m_pGraphicsDevice->submit(std::move(pLoadList));
     return pTexture;
   }
 
   bool Texture2DLoader::handles(URI const & uri, AssetManager const * pManager) const {
-    return pManager->canLoad<media::Surface>(uri);
+    return pManager->canLoad<TextureMips>(uri);
   }
 
-  TextureCache::TextureCache(bfc::GraphicsDevice * pDevice)
-    : m_pGraphicsDevice(pDevice) {}
+  int64_t estimateTextureSize(graphics::Texture const & texture) {
+    media::Surface surface;
+    surface.format = texture.isDepthTexture() ? PixelFormat_Rf32 : texture.getColourFormat();
+    surface.size   = texture.getSize();
+    // Include a third for the mip chain.
+    return media::calculateSurfaceSize(surface) * 4 / 3;
+  }
 
-  bfc::Ref<bfc::graphics::Texture> TextureCache::read(bfc::Stream * pStream) const {
-    bfc::TextureType type;
-    if (!pStream->read(&type))
-      return nullptr;
+  int64_t Texture2DLoader::sizeOf(graphics::Texture const & asset) const {
+    return estimateTextureSize(asset);
+  }
 
-    auto surface = bfc::read<bfc::media::Surface>(pStream);
-    if (!surface.has_value())
+  Ref<TextureMips> TextureMipsCache::read(bfc::Stream * pStream) const {
+    auto header = bfc::read<::TextureCacheHeader>(pStream);
+    if (!header.has_value() || header->version != TextureCacheVersion || header->size.x < 1 || header->size.y < 1 || header->mipCount < 1
+        || header->mipCount > media::calculateMipCount(header->size))
       return nullptr;
 
-    auto pLoadList = m_pGraphicsDevice->createCommandList();
-    pLoadList->setDebugName("TextureCache::read");
-    graphics::TextureRef pTexture;
-    graphics::loadTexture(pLoadList.get(), &pTexture, type, surface.value());
-    m_pGraphicsDevice->submit(std::move(pLoadList));
-    surface->free();
-    return pTexture;
+    Ref<TextureMips> pMips = NewRef<TextureMips>();
+    pMips->type            = header->type;
+    pMips->sourceModified  = header->sourceModified;
+    for (int64_t level = 0; level < header->mipCount; ++level) {
+      media::Surface surface;
+      surface.format  = header->format;
+      surface.size    = getMipSize(header->size, level);
+      surface.pBuffer = media::allocateSurface(surface);
+      pMips->levels.pushBack(surface);
+
+      int64_t const size = media::calculateSurfaceSize(surface);
+      if (pStream->read(surface.pBuffer, size) != size)
+        return nullptr;
+    }
+    return pMips;
   }
 
-  bool TextureCache::store(bfc::Ref<bfc::graphics::Texture> pAsset, bfc::Stream * pStream) const {
-    bfc::graphics::TextureDownloadRef pDownload = m_pGraphicsDevice->createTextureDownload();
-    {
-      auto pLoadList = m_pGraphicsDevice->createCommandList();
-      pLoadList->setDebugName("TextureCache::store");
-      pLoadList->downloadTexture(pAsset, pDownload);
-      m_pGraphicsDevice->submit(std::move(pLoadList));
-    }
+  bool TextureMipsCache::store(bfc::Ref<TextureMips> pAsset, bfc::Stream * pStream) const {
+    if (pAsset->levels.size() == 0)
+      return false;
+
+    media::Surface const & base = pAsset->levels.front();
 
-    if (!pDownload->wait())
+    TextureCacheHeader header;
+    header.type           = pAsset->type;
+    header.format         = base.format;
+    header.size           = base.size;
+    header.mipCount       = (int32_t)pAsset->levels.size();
+    header.sourceModified = pAsset->sourceModified;
+
+    // Levels are written packed. 8-bit colour is compressed if the format supports it.
+    PixelFormat const              compressedFormat = getCompressedFormat(base.format);
+    media::BlockCompressionOptions compression;
+    compression.pThreads = ThreadPool::IsPoolThread() ? nullptr : &ThreadPool::Global();
+    if (compressedFormat != PixelFormat_Unknown)
+      header.format = compressedFormat;
+
+    if (!pStream->write(header))
       return false;
 
-    return pStream->write(pAsset->getType()) && pStream->write(pDownload->view());
+    for (int64_t level = 0; level < pAsset->levels.size(); ++level) {
+      media::Surface const & src = pAsset->levels[level];
+      if (src.size != getMipSize(base.size, level))
+        return false;
+
+      media::Surface packed;
+      packed.format = header.format;
+      packed.size   = src.size;
+      if (compressedFormat != PixelFormat_Unknown)
+        media::compressSurface(&packed, src, compression);
+      else if (src.pitch != 0)
+        media::convertSurface(&packed, src);
+      else
+        packed.pBuffer = src.pBuffer;
+
+      int64_t const size    = media::calculateSurfaceSize(packed);
+      bool const    written = packed.pBuffer != nullptr && pStream->write(packed.pBuffer, size) == size;
+      if (packed.pBuffer != src.pBuffer)
+        packed.free();
+      if (!written)
+        return false;
+    }
+    return true;
   }
 } // namespace engine
@@ -3,39 +3,60 @@
 #include "AssetLoader.h"
 #include "AssetCache.h"
 #include "render/GraphicsDevice.h"
-
-namespace bfc {
-  namespace media {
-    class Surface;
-  }
-} // namespace bfc
+#include "media/Surface.h"
+#include "core/Timestamp.h"
 
 namespace engine {
+  /// The decoded mip levels of a texture, ready to upload.
+  /// Textures are cached in this form, so cache entries are written without reading textures back from the device.
+  class TextureMips {
+  public:
+    TextureMips() = default;
+    TextureMips(TextureMips const &) = delete;
+    TextureMips & operator=(TextureMips const &) = delete;
+    ~TextureMips();
+
+    bfc::TextureType                 type = bfc::TextureType_2D;
+    bfc::Timestamp                   sourceModified; ///< When the source image was last modified.
+    bfc::Vector<bfc::media::Surface> levels;         ///< Starting with the base level. Owned by this object.
+  };
+
   class SurfaceLoader : public AssetLoader<bfc::media::Surface> {
   public:
     virtual bfc::Ref<bfc::media::Surface> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                          handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t                       sizeOf(bfc::media::Surface const & asset) const override;
+  };
+
+  /// Decodes an image and filters its mip chain on the CPU.
+  class TextureMipsLoader : public AssetLoader<TextureMips> {
+  public:
+    virtual bfc::Ref<TextureMips> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
+    virtual bool                  handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t               sizeOf(TextureMips const & asset) const override;
+    virtual int64_t               version() const override;
   };
 
+  /// Estimate the video memory used by `texture` in bytes, including its mip chain.
+  int64_t estimateTextureSize(bfc::graphics::Texture const & texture);
+
   class Texture2DLoader : public AssetLoader<bfc::graphics::Texture> {
   public:
     Texture2DLoader(bfc::GraphicsDevice * pGraphicsDevice);
 
     virtual bfc::Ref<bfc::graphics::Texture> load(bfc::URI const & uri, AssetLoadContext * pManager) const override;
     virtual bool                 handles(bfc::URI const & uri, AssetManager const * pManager) const override;
+    virtual int64_t              sizeOf(bfc::graphics::Texture const & asset) const override;
 
   private:
     bfc::GraphicsDevice * m_pGraphicsDevice = nullptr;
   };
 
-  class TextureCache : public AssetCache<bfc::graphics::Texture> {
+  /// Stores the mip levels of textures behind a compact header.
+  /// 8-bit colour levels are block compressed, so they are smaller on disk and in video memory when read.
+  class TextureMipsCache : public AssetCache<TextureMips> {
   public:
-    TextureCache(bfc::GraphicsDevice *pDevice);
-
-    virtual bfc::Ref<bfc::graphics::Texture> read(bfc::Stream * pStream) const override;
-    virtual bool store(bfc::Ref<bfc::graphics::Texture> pAsset, bfc::Stream * pStream) const override;
-
-  private:
-    bfc::GraphicsDevice * m_pGraphicsDevice = nullptr;
+    virtual bfc::Ref<TextureMips> read(bfc::Stream * pStream) const override;
+    virtual bool                  store(bfc::Ref<TextureMips> pAsset, bfc::Stream * pStream) const override;
   };
 } // namespace engine
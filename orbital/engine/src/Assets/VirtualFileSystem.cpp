@@ -1,6 +1,8 @@
 #include "VirtualFileSystem.h"
+#include "PackArchive.h"
 #include "core/File.h"
 #include "util/Log.h"
+#include "util/YAML.h"
 
 using namespace bfc;
 
@@ -13,7 +15,7 @@ namespace engine {
 
   bool VirtualFileSystem::mountDrive(StringView const & name, URI const & target) {
     std::scoped_lock guard{ m_lock };
-    if (!m_drives.tryAdd(name, target)) {
+    if (m_packs.contains(name) || !m_drives.tryAdd(name, target)) {
       return false;
     }
 
@@ -21,9 +23,25 @@ namespace engine {
     return true;
   }
 
+  bool VirtualFileSystem::mountPack(StringView const & name, URI const & packFile) {
+    Ref<PackArchive> pArchive = PackArchive::open(packFile.path());
+    if (pArchive == nullptr) {
+      BFC_LOG_WARNING("VirtualFileSystem", "failed to open pack (name=%s, target=%s)", name, packFile);
+      return false;
+    }
+
+    std::scoped_lock guard{m_lock};
+    if (m_drives.contains(name) || !m_packs.tryAdd(name, pArchive)) {
+      return false;
+    }
+
+    BFC_LOG_INFO("VirtualFileSystem", "mounted pack (name=%s, target=%s, files=%lld)", name, packFile, pArchive->size());
+    return true;
+  }
+
   bool VirtualFileSystem::unmountDrive(StringView const & name) {
     std::scoped_lock guard{m_lock};
-    if (!m_drives.erase(name)) {
+    if (!m_drives.erase(name) && !m_packs.erase(name)) {
       return false;
     }
 
@@ -34,10 +52,17 @@ namespace engine {
   bfc::Vector<bfc::String> VirtualFileSystem::drives() const {
     std::scoped_lock guard{m_lock};
 
-    return m_drives.getKeys();
+    Vector<String> names = m_drives.getKeys();
+    names.pushBack(m_packs.getKeys());
+    return names;
   }
 
   Ref<Stream> VirtualFileSystem::open(URI const & uri, FileMode mode) const {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(uri, &packPath)) {
+      return (mode & (FileMode_Write | FileMode_Append)) == 0 ? PackArchive::openStream(pPack, packPath) : nullptr;
+    }
+
     URI resolved = resolveUri(uri);
 
     return bfc::openURI(resolved, mode);
@@ -45,6 +70,11 @@ namespace engine {
 
 
   bool VirtualFileSystem::exists(URI const & uri) const {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(uri, &packPath)) {
+      return pPack->find(packPath) != -1 || pPack->isDirectory(packPath);
+    }
+
     URI resolved = resolveUri(uri);
 
     return uriExists(resolved);
@@ -82,6 +112,14 @@ namespace engine {
       return false;
     }
 
+    // Read streams with a known length in a single call.
+    const int64_t knownLength = pStream->length();
+    if (knownLength >= 0) {
+      pContent->resize(knownLength);
+      pContent->resize(pStream->read(pContent->data(), knownLength));
+      return true;
+    }
+
     int64_t   length   = 0;
     int64_t   capacity = 0;
     uint8_t * pData    = nullptr;
@@ -124,10 +162,20 @@ namespace engine {
   }
 
   bool VirtualFileSystem::isWritable(URI const & resource) const {
+    StringView packPath;
+    if (findPack(resource, &packPath) != nullptr) {
+      return false;
+    }
+
     return uriExists(resolveUri(resource));
   }
 
   bool VirtualFileSystem::isReadable(URI const & resource) const {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(resource, &packPath)) {
+      return pPack->find(packPath) != -1;
+    }
+
     return uriExists(resolveUri(resource));
   }
 
@@ -143,6 +191,11 @@ namespace engine {
   }
 
   bool VirtualFileSystem::isLeaf(bfc::URI const & resource) const {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(resource, &packPath)) {
+      return pPack->find(packPath) != -1;
+    }
+
     return bfc::isLeaf(resolveUri(resource));
   }
 
@@ -152,6 +205,11 @@ namespace engine {
 
     BFC_ASSERT(recursive == false, "Recursive not fully supported. Fix resolving relative references");
 
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(resource, &packPath)) {
+      return pPack->list(packPath).map([=](String const & name) { return resource.resolveRelativeReference(name); });
+    }
+
     bfc::URI resolved = resolveUri(resource);
 
     return bfc::walk(resolved, recursive).map([=](URI const & o) {
@@ -160,14 +218,56 @@ namespace engine {
   }
 
   std::optional<Timestamp> VirtualFileSystem::lastModified(bfc::URI const & resource) const {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(resource, &packPath)) {
+      int64_t index = pPack->find(packPath);
+      if (index == -1) {
+        return std::nullopt;
+      }
+      return pPack->lastModified(index);
+    }
+
     return bfc::lastModified(resolveUri(resource));
   }
 
   bool VirtualFileSystem::serialize(bfc::URI const & resource, SerializedObject const & o, bfc::DataFormat format) {
+    StringView packPath;
+    if (findPack(resource, &packPath) != nullptr) {
+      return false;
+    }
+
     return bfc::serialize(resolveUri(resource), o, format);
   }
 
   std::optional<SerializedObject> VirtualFileSystem::deserialize(bfc::URI const & resource, bfc::DataFormat format) {
+    StringView packPath;
+    if (Ref<PackArchive> pPack = findPack(resource, &packPath)) {
+      Ref<Stream> pStream = PackArchive::openStream(pPack, packPath);
+      if (pStream == nullptr) {
+        return std::nullopt;
+      }
+
+      switch (format) {
+      case DataFormat_Binary: return bfc::read<SerializedObject>(pStream.get());
+      case DataFormat_YAML: return readYAML(pStream.get());
+      }
+      return std::nullopt;
+    }
+
     return bfc::deserialize(resolveUri(resource), format);
   }
+
+  Ref<PackArchive> VirtualFileSystem::findPack(URI const & uri, StringView * pPath) const {
+    StringView path  = uri.pathView();
+    StringView drive = Filename::drive(path);
+
+    std::scoped_lock guard{m_lock};
+    Ref<PackArchive> const * ppPack = m_packs.tryGet(drive);
+    if (ppPack == nullptr) {
+      return nullptr;
+    }
+
+    *pPath = path.substr(drive.length() + 1);
+    return *ppPack;
+  }
 }
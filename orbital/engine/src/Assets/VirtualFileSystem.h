@@ -13,6 +13,8 @@
 #include <mutex>
 
 namespace engine {
+  class PackArchive;
+
   class VirtualFileSystem : public Subsystem {
   public:
     VirtualFileSystem(bfc::URI const & gameAssetsRoot, bfc::URI const & engineAssetsRoot);
@@ -24,6 +26,14 @@ namespace engine {
     /// @retval false The drive name is already mounted.
     bool mountDrive(bfc::StringView const & name, bfc::URI const & target);
 
+    /// Mount a pack archive as a read-only virtual drive.
+    /// Files in the drive are read directly from the memory mapped archive.
+    /// @param name The name of the drive.
+    /// @param packFile The URI of the pack archive. See PackArchive::build().
+    /// @retval true The archive was mounted.
+    /// @retval false The drive name is already mounted or the archive could not be opened.
+    bool mountPack(bfc::StringView const & name, bfc::URI const & packFile);
+
     /// Unmount a virtual drive name.
     /// @param name The name of the drive.
     /// @retval true  If the drive name existed and was unmounted.
@@ -130,8 +140,13 @@ namespace engine {
     std::optional<bfc::SerializedObject> deserialize(bfc::URI const & resource, bfc::DataFormat format = bfc::DataFormat_YAML);
 
   private:
+    /// Find the pack archive mounted for the drive in `uri`.
+    /// @param pPath Set to the path of the resource within the archive.
+    bfc::Ref<PackArchive> findPack(bfc::URI const & uri, bfc::StringView * pPath) const;
+
     mutable std::mutex m_lock;
     bfc::Map<bfc::String, bfc::URI> m_drives;
+    bfc::Map<bfc::String, bfc::Ref<PackArchive>> m_packs;
     bfc::Map<bfc::URI, bfc::UUID>   m_virtualFiles;
   };
 }
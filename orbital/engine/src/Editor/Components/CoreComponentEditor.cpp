@@ -72,10 +72,11 @@ namespace engine {
     AssetManager *      pAssets     = pEditor->getApp()->findSubsystem<AssetManager>().get();
     VirtualFileSystem * pFileSystem = pEditor->getApp()->findSubsystem<VirtualFileSystem>().get();
 
-    ui::Input("Cast Shadows",    &pComponent->castShadows);
-    ui::Input("Use Tesselation", &pComponent->useTesselation);
+    bool modified = false;
+    modified |= ui::Input("Cast Shadows",    &pComponent->castShadows);
+    modified |= ui::Input("Use Tesselation", &pComponent->useTesselation);
 
-    LevelEditor::drawAssetSelector("Mesh", &pComponent->pMesh, pAssets, pFileSystem);
+    modified |= LevelEditor::drawAssetSelector("Mesh", &pComponent->pMesh, pAssets, pFileSystem);
 
     ui::Separator();
     ui::Label("Materials");
@@ -100,11 +101,16 @@ namespace engine {
 
           pComponent->materials[i].pMaterial = pMaterial;
           pComponent->materials[i].pProgram  = pProgram;
+          modified = true;
         }
 
         ImGui::PopID();
       }
     }
+
+    if (modified) {
+      pLevel->modified<components::StaticMesh>(entityID);
+    }
   }
 
   void PostProcessVolumeEditor::draw(LevelEditor * pEditor, Ref<Level> const & pLevel, EntityID entityID, components::PostProcessVolume * pComponent) {
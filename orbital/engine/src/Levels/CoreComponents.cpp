@@ -1,6 +1,21 @@
 #include "CoreComponents.h"
 #include "util/Log.h"
 
+#include <atomic>
+
+namespace {
+  /// Transforms that may be the top-most dirty transform in their hierarchy.
+  /// Stored in each level, so updateGlobalTransforms() doesn't need to visit every transform.
+  struct DirtyTransforms {
+    bfc::Vector<engine::EntityID> roots;
+  };
+
+  DirtyTransforms & dirtyTransforms(engine::Level * pLevel) {
+    bfc::Ref<DirtyTransforms> pDirty = pLevel->getData<DirtyTransforms>();
+    return pDirty != nullptr ? *pDirty : *pLevel->addData<DirtyTransforms>();
+  }
+} // namespace
+
 namespace components {
   bfc::Vec3d Transform::applyToPoint(bfc::Mat4d const & transform, bfc::Vec3d const & point) {
     return (transform * bfc::Vec4d(point, 1));
@@ -69,9 +84,104 @@ namespace components {
   }
 
   bfc::Mat4d Transform::globalTransform(engine::Level const * pLevel) const {
+    if (!isGlobalTransformDirty(pLevel))
+      return m_globalTransform;
+
     return parentTransform(pLevel) * transform();
   }
 
+  bfc::Mat4d const & Transform::cachedGlobalTransform() const {
+    return m_globalTransform;
+  }
+
+  bool Transform::isGlobalTransformDirty(engine::Level const * pLevel) const {
+    BFC_UNUSED(pLevel);
+
+    return m_dirty;
+  }
+
+  void Transform::markDirty() {
+    m_dirty = true;
+
+    const engine::EntityID self = m_pLevel != nullptr ? m_pLevel->toEntity(this) : engine::InvalidEntity;
+    if (self == engine::InvalidEntity)
+      return;
+
+    dirtyTransforms(m_pLevel).roots.pushBack(self);
+
+    // The descendants of a dirty transform are always dirty, so stop at children that already are.
+    bfc::Vector<Transform *> stack = {this};
+    while (stack.size() > 0) {
+      Transform * pTransform = stack.popBack();
+      for (engine::EntityID child : pTransform->m_children) {
+        Transform * pChild = m_pLevel->tryGet<Transform>(child);
+        if (pChild != nullptr && !pChild->m_dirty) {
+          pChild->m_dirty = true;
+          stack.pushBack(pChild);
+        }
+      }
+    }
+  }
+
+  void Transform::invalidate() {
+    // A dirty transform is already waiting to be refreshed along with its descendants.
+    if (!m_dirty)
+      markDirty();
+  }
+
+  uint64_t Transform::globalRevision() const {
+    return m_globalRevision;
+  }
+
+  void Transform::updateGlobalTransforms(engine::Level * pLevel) {
+    static std::atomic_uint64_t nextRevision = 1;
+
+    bfc::Ref<DirtyTransforms> pDirty = pLevel->getData<DirtyTransforms>();
+    if (pDirty == nullptr || pDirty->roots.size() == 0)
+      return;
+
+    engine::LevelComponentStorage<Transform> & transforms = pLevel->components<Transform>();
+    uint64_t const                             revision   = nextRevision++;
+
+    bfc::Vector<engine::EntityID> updated;
+    bfc::Vector<Transform *>      stack;
+    for (engine::EntityID entity : pDirty->roots) {
+      // Skip transforms that were removed or already refreshed with an ancestor. Transforms with a dirty
+      // parent are refreshed when the subtree of their top-most dirty ancestor, which is also listed, is visited.
+      Transform * pRoot = transforms.tryGet(entity);
+      if (pRoot == nullptr || !pRoot->m_dirty)
+        continue;
+
+      Transform const * pParent = transforms.tryGet(pRoot->m_parent);
+      if (pParent != nullptr && pParent->m_dirty)
+        continue;
+
+      pRoot->m_globalTransform  = pParent != nullptr ? pParent->m_globalTransform * pRoot->transform() : pRoot->transform();
+      pRoot->m_globalRevision   = revision;
+      pRoot->m_dirty            = false;
+      updated.pushBack(entity);
+
+      stack.pushBack(pRoot);
+      while (stack.size() > 0) {
+        Transform * pTransform = stack.popBack();
+        for (engine::EntityID child : pTransform->m_children) {
+          Transform * pChild = transforms.tryGet(child);
+          if (pChild == nullptr)
+            continue;
+
+          pChild->m_globalTransform = pTransform->m_globalTransform * pChild->transform();
+          pChild->m_globalRevision  = revision;
+          pChild->m_dirty           = false;
+          updated.pushBack(child);
+          stack.pushBack(pChild);
+        }
+      }
+    }
+
+    pDirty->roots.clear();
+    pLevel->getEvents()->broadcast(engine::events::OnTransformsUpdated{updated});
+  }
+
   bfc::Mat4d Transform::globalTransformInverse(engine::Level const * pLevel) const {
     return glm::inverse(globalTransform(pLevel));
   }
@@ -127,10 +237,12 @@ namespace components {
 
   void Transform::setTranslation(bfc::Vec3d const & translation) {
     m_translation = translation;
+    invalidate();
   }
 
   void Transform::setOrientation(bfc::Quatd const & orientation) {
     m_orientation = orientation;
+    invalidate();
   }
 
   void Transform::setYpr(bfc::Vec3d const & ypr) {
@@ -139,6 +251,7 @@ namespace components {
 
   void Transform::setScale(bfc::Vec3d const & scale) {
     m_scale = scale;
+    invalidate();
   }
 
   void Transform::setTransform(bfc::Mat4d const & transform) {
@@ -146,6 +259,7 @@ namespace components {
     bfc::Vec4d perspective;
 
     glm::decompose(transform, m_scale, m_orientation, m_translation, skew, perspective);
+    invalidate();
   }
 
   void Transform::lookAt(bfc::Vec3d const & direction, bfc::Vec3d const & up) {
@@ -229,6 +343,8 @@ namespace components {
       m_parent = entityID;
     }
 
+    // Always list the transform, as it may have been dirty only because of its old parent.
+    markDirty();
     return true;
   }
 
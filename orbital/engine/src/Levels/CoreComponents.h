@@ -41,6 +41,30 @@ namespace components {
     bfc::Mat4d globalTransform(engine::Level const * pLevel) const;
     bfc::Mat4d globalTransformInverse(engine::Level const * pLevel) const;
 
+    /// Get the global transform computed by the last call to updateGlobalTransforms().
+    /// This does not visit the parent hierarchy, so it is only up to date if no
+    /// transform in the hierarchy has changed since the level was last updated.
+    bfc::Mat4d const & cachedGlobalTransform() const;
+
+    /// Test if the cached global transform is out of date.
+    /// Changes are propagated to descendants when they are made, so this does not visit the parent hierarchy.
+    bool isGlobalTransformDirty(engine::Level const * pLevel) const;
+
+    /// Mark the cached global transform of this transform, and its descendants, as out of date.
+    /// They are refreshed in the next call to updateGlobalTransforms().
+    void markDirty();
+
+    /// Get the revision of the cached global transform.
+    /// This changes each time updateGlobalTransforms() recomputes the cached value, so
+    /// it can be used to detect that a transform has moved.
+    uint64_t globalRevision() const;
+
+    /// Recompute the cached global transforms in `pLevel`.
+    /// Only transforms that changed since the last update, and their descendants, are
+    /// visited. Parents are always updated before their children.
+    /// Broadcasts engine::events::OnTransformsUpdated with the transforms that were recomputed.
+    static void updateGlobalTransforms(engine::Level * pLevel);
+
     bfc::Vec3d globalForward(engine::Level const * pLevel) const;
     bfc::Vec3d globalRight(engine::Level const * pLevel) const;
     bfc::Vec3d globalUp(engine::Level const * pLevel) const;
@@ -80,12 +104,22 @@ namespace components {
     bfc::Span<engine::EntityID> children() const;
 
   private:
+    friend struct engine::LevelComponent_OnPostAdd<Transform>;
+
+    /// Called when the local transform changes.
+    void invalidate();
+
+    engine::Level *               m_pLevel = nullptr; ///< The level this transform was added to, used to find its children.
     engine::EntityID              m_parent = engine::InvalidEntity;
     bfc::Vector<engine::EntityID> m_children;
 
     bfc::Vec3d m_translation = {0, 0, 0};
     bfc::Quatd m_orientation = glm::identity<bfc::Quatd>();
     bfc::Vec3d m_scale       = {1, 1, 1};
+
+    bfc::Mat4d m_globalTransform = glm::identity<bfc::Mat4d>();
+    uint64_t   m_globalRevision  = 0;
+    bool       m_dirty           = true;
   };
 
   struct Camera {
@@ -195,10 +229,38 @@ namespace engine {
     }
   };
 
+  template<>
+  struct LevelComponent_OnPostAdd<components::Transform> {
+    inline static void onPostAdd(components::Transform * pComponent, Level * pLevel) {
+      pComponent->m_pLevel = pLevel;
+      pComponent->markDirty();
+    }
+  };
+
   template<>
   struct LevelComponent_OnPreErase<components::Transform> {
     inline static void onPreErase(components::Transform * pComponent, Level * pLevel) {
+      pLevel->getEvents()->broadcast(events::OnComponentErased<components::Transform>{pLevel->toEntity(pComponent)});
       pComponent->setParent(pLevel, InvalidEntity); // Remove from parent entity
+
+      // Children are detached from the hierarchy and must be re-evaluated
+      for (EntityID child : pComponent->children())
+        if (components::Transform * pChild = pLevel->tryGet<components::Transform>(child))
+          pChild->markDirty();
+    }
+  };
+
+  template<>
+  struct LevelComponent_OnPostAdd<components::StaticMesh> {
+    inline static void onPostAdd(components::StaticMesh * pComponent, Level * pLevel) {
+      pLevel->getEvents()->broadcast(events::OnComponentAdded<components::StaticMesh>{pLevel->toEntity(pComponent)});
+    }
+  };
+
+  template<>
+  struct LevelComponent_OnPreErase<components::StaticMesh> {
+    inline static void onPreErase(components::StaticMesh * pComponent, Level * pLevel) {
+      pLevel->getEvents()->broadcast(events::OnComponentErased<components::StaticMesh>{pLevel->toEntity(pComponent)});
     }
   };
 }
@@ -1,5 +1,4 @@
 #include "Level.h"
-#include "platform/Events.h"
 #include "LevelSystem.h"
 
 using namespace bfc;
@@ -112,6 +111,10 @@ namespace engine {
     return contains(indexOf(entityID), versionOf(entityID));
   }
 
+  Events * Level::getEvents() const {
+    return m_pEvents.get();
+  }
+
   bfc::Map<bfc::type_index, bfc::Ref<ILevelComponentStorage>> const & Level::components() const {
     return m_components;
   }
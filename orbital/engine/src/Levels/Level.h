@@ -3,16 +3,41 @@
 #include "core/Map.h"
 #include "core/Pool.h"
 #include "core/Serialize.h"
+#include "core/Span.h"
 #include "core/typeindex.h"
+#include "platform/Events.h"
 #include "util/UUID.h"
 
 #include "LevelView.h"
 
-namespace bfc {
-  class Events;
-}
-
 namespace engine {
+  namespace events {
+    /// Broadcast through Level::getEvents() after a component is added to an entity, or replaced.
+    /// Only broadcast for component types whose LevelComponent_OnPostAdd hook broadcasts it.
+    template<typename T>
+    struct OnComponentAdded {
+      EntityID entity = InvalidEntity;
+    };
+
+    /// Broadcast through Level::getEvents() before a component is removed from an entity, or replaced.
+    /// Only broadcast for component types whose LevelComponent_OnPreErase hook broadcasts it.
+    template<typename T>
+    struct OnComponentErased {
+      EntityID entity = InvalidEntity;
+    };
+
+    /// Broadcast by Level::modified() when a component is modified in place.
+    template<typename T>
+    struct OnComponentModified {
+      EntityID entity = InvalidEntity;
+    };
+
+    /// Broadcast through Level::getEvents() by Transform::updateGlobalTransforms(), with the transforms it refreshed.
+    struct OnTransformsUpdated {
+      bfc::Span<const EntityID> entities;
+    };
+  } // namespace events
+
   class Level {
   public:
     class EntityView {
@@ -117,6 +142,15 @@ namespace engine {
       return components<T>().exists(entityID);
     }
 
+    /// Notify listeners that a component was modified in place, e.g. by an editor.
+    template<typename T>
+    void modified(EntityID const & entityID) {
+      m_pEvents->broadcast(events::OnComponentModified<T>{entityID});
+    }
+
+    /// Get the events broadcast by this level. See engine::events.
+    bfc::Events * getEvents() const;
+
     template<typename T>
     EntityID toEntity(T const * pComponent) const {
       return components<T>().toEntity(pComponent);
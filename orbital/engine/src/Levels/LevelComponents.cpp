@@ -69,5 +69,51 @@ namespace engine {
     void ComponentStorageLevelAccess::SetOwner(ILevelComponentStorage * pStorage, Level * pLevel) {
       pStorage->m_pLevel = pLevel;
     }
+
+    EntitySparseIndex::EntitySparseIndex(EntitySparseIndex && o) {
+      std::swap(m_pages, o.m_pages);
+    }
+
+    EntitySparseIndex::~EntitySparseIndex() {
+      clear();
+    }
+
+    EntitySparseIndex & EntitySparseIndex::operator=(EntitySparseIndex && o) {
+      std::swap(m_pages, o.m_pages);
+      return *this;
+    }
+
+    void EntitySparseIndex::set(EntityID const & entityID, int64_t denseIndex) {
+      BFC_ASSERT(denseIndex >= 0 && denseIndex <= 0xFFFFFFFF, "Dense index does not fit in 32 bits");
+
+      const uint64_t index = entityID & 0x00000000FFFFFFFF;
+      const int64_t  page  = (int64_t)(index >> PageShift);
+      if (page >= m_pages.size()) {
+        m_pages.resize(page + 1, nullptr);
+      }
+
+      if (m_pages[page] == nullptr) {
+        m_pages[page] = bfc::mem::alloc<uint64_t>(PageSize);
+        std::memset(m_pages[page], 0, PageSize * sizeof(uint64_t));
+      }
+
+      m_pages[page][index & PageMask] = (entityID & 0xFFFFFFFF00000000) | (uint64_t)denseIndex;
+    }
+
+    void EntitySparseIndex::erase(EntityID const & entityID) {
+      if (find(entityID) == bfc::npos) {
+        return;
+      }
+
+      const uint64_t index = entityID & 0x00000000FFFFFFFF;
+      m_pages[index >> PageShift][index & PageMask] = 0;
+    }
+
+    void EntitySparseIndex::clear() {
+      for (uint64_t * pPage : m_pages) {
+        bfc::mem::free(pPage);
+      }
+      m_pages.clear();
+    }
   } // namespace impl
 } // namespace engine
@@ -137,7 +137,56 @@ namespace engine {
       friend Level;
       static void SetOwner(ILevelComponentStorage * pStorage, Level * pLevel);
     };
-  }
+
+    /// Maps entities to the index of their component in a dense array.
+    /// Slots are addressed by the entity index and allocated in fixed size pages on first use.
+    /// Each slot stores the dense index in the lower 32 bits and the entity version in the
+    /// upper 32 bits, so stale entity IDs are rejected without touching the dense array.
+    class EntitySparseIndex {
+    public:
+      inline static constexpr int64_t PageShift = 12;
+      inline static constexpr int64_t PageSize  = 1ll << PageShift;
+      inline static constexpr int64_t PageMask  = PageSize - 1;
+
+      EntitySparseIndex() = default;
+      EntitySparseIndex(EntitySparseIndex && o);
+      EntitySparseIndex(EntitySparseIndex const & o) = delete;
+      ~EntitySparseIndex();
+
+      EntitySparseIndex & operator=(EntitySparseIndex && o);
+      EntitySparseIndex & operator=(EntitySparseIndex const & o) = delete;
+
+      /// Find the dense index for `entityID`.
+      /// @returns The dense index, or bfc::npos if the entity is not in the index.
+      int64_t find(EntityID const & entityID) const {
+        const uint64_t index = entityID & 0x00000000FFFFFFFF;
+        const uint64_t page  = index >> PageShift;
+        if (page >= (uint64_t)m_pages.size() || m_pages[page] == nullptr) {
+          return bfc::npos;
+        }
+
+        // Version 0 is never issued, so an empty slot can not match a valid entity.
+        const uint64_t slot = m_pages[page][index & PageMask];
+        if (slot == 0 || (slot >> 32) != (entityID >> 32)) {
+          return bfc::npos;
+        }
+
+        return (int64_t)(slot & 0x00000000FFFFFFFF);
+      }
+
+      /// Set the dense index for `entityID`.
+      void set(EntityID const & entityID, int64_t denseIndex);
+
+      /// Remove `entityID` from the index.
+      void erase(EntityID const & entityID);
+
+      /// Remove all entities and release all pages.
+      void clear();
+
+    private:
+      bfc::Vector<uint64_t *> m_pages;
+    };
+  } // namespace impl
 
   class ILevelComponentStorage {
     friend impl::ComponentStorageLevelAccess;
@@ -179,7 +228,7 @@ namespace engine {
     }
 
     virtual bool exists(EntityID entityID) const override {
-      return toIndex(entityID) != bfc::npos;
+      return m_entityToComponent.find(entityID) != bfc::npos;
     }
 
     virtual bool erase(EntityID entityID) override {
@@ -195,7 +244,7 @@ namespace engine {
 
       std::swap(m_components[index], m_components.back());
       std::swap(m_componentToEntity[index], m_componentToEntity.back());
-      m_entityToComponent[backEntity] = index;
+      m_entityToComponent.set(backEntity, index);
 
       m_entityToComponent.erase(entityID);
       m_componentToEntity.popBack();
@@ -212,9 +261,7 @@ namespace engine {
     }
 
     virtual int64_t toIndex(EntityID entityID) const override {
-      int64_t ret = bfc::npos;
-      m_entityToComponent.tryGet(entityID, &ret);
-      return ret;
+      return m_entityToComponent.find(entityID);
     }
 
     virtual int64_t size() const override {
@@ -245,7 +292,7 @@ namespace engine {
         return m_components[index];
       }
 
-      m_entityToComponent.add(entityID, m_components.size());
+      m_entityToComponent.set(entityID, m_components.size());
       m_componentToEntity.pushBack(entityID);
       m_components.pushBack(T(std::forward<Args>(args)...));
 
@@ -272,27 +319,27 @@ namespace engine {
     }
 
     T & get(EntityID entityID) {
-      return m_components[toIndex(entityID)];
+      return m_components[m_entityToComponent.find(entityID)];
     }
 
     T const & get(EntityID entityID) const {
-      return m_components[toIndex(entityID)];
+      return m_components[m_entityToComponent.find(entityID)];
     }
 
     T * tryGet(EntityID entityID) {
-      const int64_t index = toIndex(entityID);
+      const int64_t index = m_entityToComponent.find(entityID);
       if (index == bfc::npos) {
         return nullptr;
       }
-      return &m_components[toIndex(entityID)];
+      return &m_components[index];
     }
 
     T const * tryGet(EntityID entityID) const {
-      const int64_t index = toIndex(entityID);
+      const int64_t index = m_entityToComponent.find(entityID);
       if (index == bfc::npos) {
         return nullptr;
       }
-      return &m_components[toIndex(entityID)];
+      return &m_components[index];
     }
 
     bfc::Span<T> components() {
@@ -326,6 +373,6 @@ namespace engine {
   private:
     bfc::Vector<T>              m_components;
     bfc::Vector<EntityID>       m_componentToEntity;
-    bfc::Map<EntityID, int64_t> m_entityToComponent;
+    impl::EntitySparseIndex     m_entityToComponent;
   };
 } // namespace engine
@@ -1,4 +1,5 @@
 #include "DeferredRenderer.h"
+#include "DrawPackets.h"
 #include "RenderData.h"
 #include "Renderables.h"
 
@@ -263,7 +264,7 @@ namespace engine {
           pCmdList->clear(0);
           pCmdList->pushState(graphics::State::Viewport{{0, 0}, m_shadowAtlas.resolution(shadowMapData.atlasIndex)});
 
-          pRenderer->request(DeferredRenderer::Stages::ShadowDepth{&shadowMapData}, pCmdList, view);
+          pRenderer->request(DeferredRenderer::Stages::ShadowDepth{&shadowMapData, m_depthPass.instance()}, pCmdList, view);
 
           pCmdList->popState();
         }
@@ -856,11 +857,17 @@ namespace engine {
 
   class StaticMeshRenderer : public FeatureRenderer {
   public:
+    /// Instance ranges bound to the instance buffer must start on a multiple of this many instances.
+    /// This keeps each range offset aligned to 256 bytes, the largest storage buffer offset alignment in common use.
+    inline static constexpr int64_t InstanceAlignment = 256 / sizeof(renderer::InstanceData);
+
     StaticMeshRenderer(AssetManager * pAssets, graphics::StructuredBuffer<renderer::ModelBuffer> * pModelBuffer,
                        graphics::StructuredBuffer<renderer::PBRMaterial> * pDefaultMaterial)
       : m_pModelData(pModelBuffer)
       , m_pDefaultMaterial(pDefaultMaterial)
-      , m_shader(pAssets, URI::File("engine:shaders/gbuffer/base.shader")) {}
+      , m_instancedShader(pAssets, URI::File("engine:shaders/gbuffer/base-instanced.shader"))
+      , m_instancedDepthShader(pAssets, URI::File("engine:shaders/general/depth-pass-instanced.shader"))
+      , m_instances(BufferUsageHint_Storage | BufferUsageHint_Dynamic) {}
 
     virtual void onRenderRequest(std::any const & request, bfc::graphics::CommandList * pCmdList, Renderer * pRenderer,
                                  RenderView const & view) override {
@@ -882,44 +889,125 @@ namespace engine {
 
       Mat4d vp = view.projectionMatrix * view.viewMatrix;
 
-      pCmdList->bindProgram(m_shader);
-      pCmdList->bindUniformBuffer(*m_pModelData, renderer::BufferBinding_ModelBuffer);
-
       geometry::Frustum<float> camFrustum = view.projectionMatrix * view.viewMatrix;
 
-      for (auto & renderable : view.pRenderData->renderables<StaticMeshRenderable>()) {
+      // Build a sort key for each visible renderable so that draws sharing state are adjacent.
+      Span<StaticMeshRenderable> renderables = view.pRenderData->renderables<StaticMeshRenderable>().getView();
+      m_packets.clear();
+      m_programIDs.clear();
+      m_materialIDs.clear();
+      m_meshIDs.clear();
+      for (int64_t i = 0; i < renderables.size(); ++i) {
+        StaticMeshRenderable const & renderable = renderables[i];
         if (!geometry::intersects(camFrustum, renderable.bounds)) {
           continue;
         }
 
-        if (renderable.shader != InvalidGraphicsResource) {
-          pCmdList->bindProgram(renderable.shader);
-        } else {
-          pCmdList->bindProgram(m_shader);
+        uint64_t material = hash((uintptr_t)renderable.materialBuffer.get());
+        for (graphics::TextureRef const & texture : renderable.materialTextures) {
+          material = hashCombine(material, hash((uintptr_t)texture.get()));
         }
 
-        m_pModelData->data.modelMatrix  = renderable.modelMatrix;
-        m_pModelData->data.normalMatrix = renderable.normalMatrix;
-        m_pModelData->data.mvpMatrix    = vp * renderable.modelMatrix;
-        m_pModelData->upload(pCmdList);
+        // Only draws of the same index range can be merged, so the range is part of the mesh ID to keep them adjacent.
+        uint64_t const mesh  = hash((uintptr_t)renderable.vertexArray.get(), renderable.elementOffset, renderable.elementCount);
+        float          depth = (float)glm::dot(Vec3d(renderable.bounds.center()) - view.getCameraPosition(), view.getCameraForward());
+        m_packets.add(makeDrawKey(DrawPass_Opaque, m_programIDs.get((uintptr_t)renderable.shader.get()), m_materialIDs.get(material),
+                                  m_meshIDs.get(mesh), depth),
+                      i);
+      }
+
+      m_packets.sort();
+      m_packets.batch(
+        [&](int64_t a, int64_t b) {
+          StaticMeshRenderable const & lhs = renderables[a];
+          StaticMeshRenderable const & rhs = renderables[b];
+          // Custom shaders do not read the instance buffer, so they are drawn one at a time.
+          if (lhs.shader != InvalidGraphicsResource || rhs.shader != InvalidGraphicsResource) {
+            return false;
+          }
+
+          if (lhs.vertexArray != rhs.vertexArray || lhs.elementOffset != rhs.elementOffset || lhs.elementCount != rhs.elementCount ||
+              lhs.primitiveType != rhs.primitiveType || lhs.materialBuffer != rhs.materialBuffer) {
+            return false;
+          }
+
+          for (int64_t slot = 0; slot < Material::TextureSlot_Count; ++slot) {
+            if (lhs.materialTextures[slot] != rhs.materialTextures[slot]) {
+              return false;
+            }
+          }
+          return true;
+        },
+        InstanceAlignment);
+
+      if (m_packets.batches().size() == 0) {
+        return;
+      }
+
+      // Upload the transforms of every instance at once.
+      Span<DrawPacket const> packets = m_packets.packets();
+      m_instances.data.resize(m_packets.instanceCount());
+      for (DrawBatch const & batch : m_packets.batches()) {
+        for (int64_t i = 0; i < batch.instanceCount; ++i) {
+          StaticMeshRenderable const & renderable = renderables[packets[batch.firstPacket + i].index];
+          m_instances.data[batch.firstInstance + i] = {Mat4(renderable.modelMatrix), Mat4(renderable.normalMatrix)};
+        }
+      }
+      m_instances.upload(pCmdList);
+
+      // Instanced draws apply the view-projection on top of each instance transform.
+      uploadModelData(pCmdList, vp);
+      pCmdList->bindUniformBuffer(*m_pModelData, renderer::BufferBinding_ModelBuffer);
+
+      graphics::Program *     pBoundProgram  = nullptr;
+      graphics::Buffer *      pBoundMaterial = nullptr;
+      graphics::VertexArray * pBoundVAO      = nullptr;
+      graphics::Texture *     boundTextures[Material::TextureSlot_Count] = {};
+
+      for (DrawBatch const & batch : m_packets.batches()) {
+        StaticMeshRenderable const & renderable = renderables[packets[batch.firstPacket].index];
+        const bool                   instanced  = renderable.shader == InvalidGraphicsResource;
+
+        graphics::Program * pProgram = instanced ? (graphics::Program *)m_instancedShader : renderable.shader.get();
+        if (pProgram != pBoundProgram) {
+          pCmdList->bindProgram(instanced ? m_instancedShader : renderable.shader);
+          pBoundProgram = pProgram;
+        }
 
         for (auto & [i, texture] : enumerate(renderable.materialTextures)) {
-          if (texture != InvalidGraphicsResource) {
-            pCmdList->bindTexture(texture, Material::TextureBindPointBase + i);
-          } else {
-            pCmdList->bindTexture(pDeferred->getDefaultTexture((Material::TextureSlot)i),
-                                  Material::TextureBindPointBase + i);
+          graphics::TextureRef const & bound =
+            texture != InvalidGraphicsResource ? texture : pDeferred->getDefaultTexture((Material::TextureSlot)i);
+          if (bound.get() != boundTextures[i]) {
+            pCmdList->bindTexture(bound, Material::TextureBindPointBase + i);
+            boundTextures[i] = bound.get();
           }
         }
 
-        if (renderable.materialBuffer != InvalidGraphicsResource) {
-          pCmdList->bindUniformBuffer(renderable.materialBuffer, renderer::BufferBinding_PBRMaterial);
-        } else {
-          pCmdList->bindUniformBuffer(*m_pDefaultMaterial, renderer::BufferBinding_PBRMaterial);
+        graphics::BufferRef const & material =
+          renderable.materialBuffer != InvalidGraphicsResource ? renderable.materialBuffer : m_pDefaultMaterial->getBuffer();
+        if (material.get() != pBoundMaterial) {
+          pCmdList->bindUniformBuffer(material, renderer::BufferBinding_PBRMaterial);
+          pBoundMaterial = material.get();
         }
 
-        pCmdList->bindVertexArray(renderable.vertexArray);
-        pCmdList->drawIndexed(renderable.elementCount, renderable.elementOffset, renderable.primitiveType);
+        if (renderable.vertexArray.get() != pBoundVAO) {
+          pCmdList->bindVertexArray(renderable.vertexArray);
+          pBoundVAO = renderable.vertexArray.get();
+        }
+
+        if (instanced) {
+          pCmdList->bindShaderStorageBuffer(m_instances, renderer::BufferBinding_InstanceBuffer,
+                                            batch.firstInstance * sizeof(renderer::InstanceData),
+                                            batch.instanceCount * sizeof(renderer::InstanceData));
+          pCmdList->drawIndexed(renderable.elementCount, renderable.elementOffset, renderable.primitiveType, batch.instanceCount);
+        } else {
+          m_pModelData->data.modelMatrix  = renderable.modelMatrix;
+          m_pModelData->data.normalMatrix = renderable.normalMatrix;
+          m_pModelData->data.mvpMatrix    = vp * renderable.modelMatrix;
+          m_pModelData->upload(pCmdList);
+          pCmdList->drawIndexed(renderable.elementCount, renderable.elementOffset, renderable.primitiveType);
+          uploadModelData(pCmdList, vp);
+        }
       }
     }
 
@@ -939,7 +1027,7 @@ namespace engine {
     void onShadowCasterLightSpaceBounds(DeferredRenderer::Stages::ShadowCasterOrthoBounds const * pShadow,
                                         bfc::graphics::CommandList * pCmdList, Renderer * pRenderer,
                                         RenderView const & view) {
-      auto & allCasters = view.pRenderData->renderables<StaticMeshShadowCasterRenderable>();
+      auto const & allCasters = view.pRenderData->renderables<StaticMeshShadowCasterRenderable>();
       for (auto & caster : allCasters) {
         geometry::Boxf casterBoundsLightSpace =
           caster.bounds.projected(pShadow->right, pShadow->up, pShadow->light.direction);
@@ -951,32 +1039,81 @@ namespace engine {
 
     void onShadowCasterBounds(DeferredRenderer::Stages::ShadowCasterBounds const * pShadow,
                               bfc::graphics::CommandList * pCmdList, Renderer * pRenderer, RenderView const & view) {
-      auto & allCasters = view.pRenderData->renderables<StaticMeshShadowCasterRenderable>();
-      for (auto & caster : allCasters) {
-        if (geometry::intersects(pShadow->lightFrustum, caster.bounds)) {
-          pShadow->pBounds->growToContain(caster.bounds);
-        }
-      }
+      view.pRenderData->forEachIntersecting<StaticMeshShadowCasterRenderable>(
+        pShadow->lightFrustum, [&](StaticMeshShadowCasterRenderable const & caster) { pShadow->pBounds->growToContain(caster.bounds); });
     }
 
     void onShadowDepth(DeferredRenderer::Stages::ShadowDepth const * pPass, bfc::graphics::CommandList * pCmdList,
                        Renderer * pRenderer, RenderView const & view) {
-      for (StaticMeshShadowCasterRenderable const & caster :
-           view.pRenderData->renderables<StaticMeshShadowCasterRenderable>()) {
-        if (geometry::intersects(pPass->pShadowData->lightFrustum, caster.bounds)) {
-          m_pModelData->data.mvpMatrix = (Mat4d)pPass->pShadowData->lightVP * caster.modelMatrix;
-          m_pModelData->upload(pCmdList);
+      Span<StaticMeshShadowCasterRenderable> casters = view.pRenderData->renderables<StaticMeshShadowCasterRenderable>().getView();
+
+      // Depth only draws need no material state, so casters are grouped by mesh alone.
+      m_packets.clear();
+      m_meshIDs.clear();
+      view.pRenderData->forEachIntersecting<StaticMeshShadowCasterRenderable>(
+        pPass->pShadowData->lightFrustum, [&](StaticMeshShadowCasterRenderable const & caster) {
+          uint64_t const mesh = hash((uintptr_t)caster.vertexArray.get(), caster.elementOffset, caster.elementCount);
+          m_packets.add(makeDrawKey(DrawPass_Shadow, 0, 0, m_meshIDs.get(mesh), 0), &caster - casters.begin());
+        });
+
+      m_packets.sort();
+      m_packets.batch(
+        [&](int64_t a, int64_t b) {
+          StaticMeshShadowCasterRenderable const & lhs = casters[a];
+          StaticMeshShadowCasterRenderable const & rhs = casters[b];
+          return lhs.vertexArray == rhs.vertexArray && lhs.elementOffset == rhs.elementOffset && lhs.elementCount == rhs.elementCount;
+        },
+        InstanceAlignment);
+
+      if (m_packets.batches().size() == 0) {
+        return;
+      }
 
-          pCmdList->bindVertexArray(caster.vertexArray);
-          pCmdList->drawIndexed(caster.elementCount, caster.elementOffset);
+      Span<DrawPacket const> packets = m_packets.packets();
+      m_instances.data.resize(m_packets.instanceCount());
+      for (DrawBatch const & batch : m_packets.batches()) {
+        for (int64_t i = 0; i < batch.instanceCount; ++i) {
+          StaticMeshShadowCasterRenderable const & caster = casters[packets[batch.firstPacket + i].index];
+          m_instances.data[batch.firstInstance + i] = {Mat4(caster.modelMatrix), Mat4(caster.normalMatrix)};
         }
       }
+      m_instances.upload(pCmdList);
+
+      uploadModelData(pCmdList, (Mat4d)pPass->pShadowData->lightVP);
+      pCmdList->bindProgram(m_instancedDepthShader);
+
+      for (DrawBatch const & batch : m_packets.batches()) {
+        StaticMeshShadowCasterRenderable const & caster = casters[packets[batch.firstPacket].index];
+        pCmdList->bindShaderStorageBuffer(m_instances, renderer::BufferBinding_InstanceBuffer,
+                                          batch.firstInstance * sizeof(renderer::InstanceData),
+                                          batch.instanceCount * sizeof(renderer::InstanceData));
+        pCmdList->bindVertexArray(caster.vertexArray);
+        pCmdList->drawIndexed(caster.elementCount, caster.elementOffset, PrimitiveType_Triangle, batch.instanceCount);
+      }
+
+      // Other casters are drawn with the depth program bound by the light renderer.
+      pCmdList->bindProgram(pPass->depthProgram);
     }
 
   private:
+    /// Upload a model buffer with an identity model transform, as used by instanced draws.
+    void uploadModelData(bfc::graphics::CommandList * pCmdList, Mat4d const & mvp) {
+      m_pModelData->data.modelMatrix  = Mat4(1);
+      m_pModelData->data.normalMatrix = Mat4(1);
+      m_pModelData->data.mvpMatrix    = mvp;
+      m_pModelData->upload(pCmdList);
+    }
+
     graphics::StructuredBuffer<renderer::PBRMaterial> * m_pDefaultMaterial = nullptr;
     graphics::StructuredBuffer<renderer::ModelBuffer> * m_pModelData       = nullptr;
-    Asset<graphics::Program>                            m_shader;
+    Asset<graphics::Program>                            m_instancedShader;
+    Asset<graphics::Program>                            m_instancedDepthShader;
+
+    graphics::StructuredArrayBuffer<renderer::InstanceData> m_instances;
+    DrawPacketList                                          m_packets;
+    DrawKeyIDs                                              m_programIDs;
+    DrawKeyIDs                                              m_materialIDs;
+    DrawKeyIDs                                              m_meshIDs;
   };
 
   DeferredRenderer::DeferredRenderer(graphics::CommandList * pCmdList, AssetManager * pAssets)
@@ -52,7 +52,8 @@ namespace engine {
       };
 
       struct ShadowDepth {
-        ShadowMapData const * pShadowData = nullptr;
+        ShadowMapData const *     pShadowData = nullptr;
+        bfc::graphics::ProgramRef depthProgram; ///< Bound before the request. Handlers that bind another program must restore it.
       };
 
       struct ShadowReceiverBounds {
@@ -0,0 +1,59 @@
+#include "DrawPackets.h"
+#include "util/RadixSort.h"
+
+#include <cstring>
+
+namespace engine {
+  uint64_t makeDrawKey(DrawPass pass, uint32_t program, uint32_t material, uint32_t mesh, float depth) {
+    // The bits of a non-negative float sort in the same order as its value.
+    // Keep the 20 most significant bits below the sign bit.
+    uint32_t depthBits = 0;
+    if (depth > 0) {
+      std::memcpy(&depthBits, &depth, sizeof(depth));
+    }
+
+    return (uint64_t(pass & 0x3) << 62)
+      | (uint64_t(program & 0xFFF) << 50)
+      | (uint64_t(material & 0xFFFF) << 34)
+      | (uint64_t(mesh & 0x3FFF) << 20)
+      | uint64_t((depthBits >> 11) & 0xFFFFF);
+  }
+
+  uint32_t DrawKeyIDs::get(uint64_t resource) {
+    uint32_t & id = m_ids.getOrAdd(resource);
+    if (id == 0) {
+      id = (uint32_t)m_ids.size(); // 0 marks a new entry, so IDs are stored offset by one.
+    }
+    return id - 1;
+  }
+
+  void DrawKeyIDs::clear() {
+    m_ids.clear();
+  }
+
+  void DrawPacketList::clear() {
+    m_packets.clear();
+    m_batches.clear();
+    m_instanceCount = 0;
+  }
+
+  void DrawPacketList::add(uint64_t key, int64_t index) {
+    m_packets.pushBack({key, index});
+  }
+
+  void DrawPacketList::sort() {
+    bfc::radixSort(m_packets.getView(), [](DrawPacket const & packet) { return packet.key; }, &m_scratch);
+  }
+
+  bfc::Span<DrawPacket const> DrawPacketList::packets() const {
+    return m_packets;
+  }
+
+  bfc::Span<DrawBatch const> DrawPacketList::batches() const {
+    return m_batches;
+  }
+
+  int64_t DrawPacketList::instanceCount() const {
+    return m_instanceCount;
+  }
+} // namespace engine
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/Map.h"
+#include "core/Span.h"
+#include "core/Vector.h"
+
+namespace engine {
+  /// Render passes, in the order their draws are sorted.
+  enum DrawPass {
+    DrawPass_Opaque,
+    DrawPass_Shadow,
+    DrawPass_Count,
+  };
+
+  /// A sortable reference to a single draw.
+  struct DrawPacket {
+    uint64_t key;   ///< Sort key. See makeDrawKey().
+    int64_t  index; ///< Index of the renderable this packet draws.
+  };
+
+  /// A run of sorted packets that are submitted as one instanced draw.
+  struct DrawBatch {
+    int64_t firstPacket;   ///< Index of the first packet in the run.
+    int64_t instanceCount; ///< Number of packets in the run.
+    int64_t firstInstance; ///< Index of the first instance in the instance buffer.
+  };
+
+  /// Build a 64-bit draw sort key.
+  /// From the most significant bits, the key is made of the pass (2 bits), program (12 bits),
+  /// material (16 bits), mesh (14 bits) and depth (20 bits). The mesh ID identifies the vertex array and the index range drawn
+  /// from it, as only draws of the same range are merged. IDs that exceed their bit count
+  /// wrap, which only affects how well draws are grouped.
+  uint64_t makeDrawKey(DrawPass pass, uint32_t program, uint32_t material, uint32_t mesh, float depth);
+
+  /// Assigns small sequential IDs to distinct resources so they can be packed into sort keys.
+  /// Resources are usually identified by address, which can be reused once a resource is destroyed,
+  /// so clear the IDs whenever the draws are rebuilt rather than keeping them between frames.
+  class DrawKeyIDs {
+  public:
+    /// Get the ID for a resource identified by `resource`. IDs start at 0.
+    uint32_t get(uint64_t resource);
+
+    /// Forget every resource, so IDs start from 0 again.
+    void clear();
+
+  private:
+    bfc::Map<uint64_t, uint32_t> m_ids;
+  };
+
+  /// Collects draw packets, sorts them by key and merges them into instanced batches.
+  class DrawPacketList {
+  public:
+    void clear();
+
+    void add(uint64_t key, int64_t index);
+
+    /// Sort the packets by key using a radix sort.
+    void sort();
+
+    /// Merge runs of adjacent packets into batches.
+    /// @param canMerge          `canMerge(a, b)` returns true if the renderables at index `a` and `b` can be drawn as instances of one draw.
+    /// @param instanceAlignment The first instance of each batch is aligned to a multiple of this.
+    template<typename CanMerge>
+    void batch(CanMerge const & canMerge, int64_t instanceAlignment = 1) {
+      m_batches.clear();
+      m_instanceCount = 0;
+
+      for (int64_t i = 0; i < m_packets.size();) {
+        int64_t end = i + 1;
+        while (end < m_packets.size() && canMerge(m_packets[i].index, m_packets[end].index)) {
+          ++end;
+        }
+
+        int64_t firstInstance = (m_instanceCount + instanceAlignment - 1) / instanceAlignment * instanceAlignment;
+        m_batches.pushBack({i, end - i, firstInstance});
+        m_instanceCount = firstInstance + end - i;
+        i               = end;
+      }
+    }
+
+    bfc::Span<DrawPacket const> packets() const;
+
+    bfc::Span<DrawBatch const> batches() const;
+
+    /// Get the number of instance slots used by the batches, including alignment padding.
+    int64_t instanceCount() const;
+
+  private:
+    bfc::Vector<DrawPacket> m_packets;
+    bfc::Vector<DrawPacket> m_scratch;
+    bfc::Vector<DrawBatch>  m_batches;
+    int64_t                 m_instanceCount = 0;
+  };
+} // namespace engine
@@ -19,6 +19,9 @@ namespace engine {
     for (auto & [type, pStorage] : m_renderables) {
       pStorage->clear();
     }
+    for (auto & [type, hierarchy] : m_hierarchies) {
+      hierarchy.bvh.clear();
+    }
     m_pUpload = nullptr;
   }
 
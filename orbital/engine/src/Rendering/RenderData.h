@@ -1,6 +1,7 @@
 #pragma once
 
 #include "RenderableStorage.h"
+#include "geometry/BVH.h"
 #include "math/MathTypes.h"
 #include "render/GraphicsDevice.h"
 
@@ -44,6 +45,76 @@ namespace engine {
     /// Clear all the renderable data.
     void clear();
 
+    /// Clear all the renderable data, except for the renderable types in `Retained`.
+    template<typename... Retained>
+    void clearExcept() {
+      for (auto & [type, pStorage] : m_renderables) {
+        if (((type != bfc::TypeID<Retained>()) && ...)) {
+          pStorage->clear();
+        }
+      }
+      for (auto & [type, hierarchy] : m_hierarchies) {
+        if (((type != bfc::TypeID<Retained>()) && ...)) {
+          hierarchy.bvh.clear();
+        }
+      }
+      m_pUpload = nullptr;
+    }
+
+    /// Build a bounding volume hierarchy over the renderables of type `T`.
+    /// Does nothing if the renderables haven't been modified since the hierarchy was last built.
+    template<typename T>
+    void buildHierarchy(bfc::ThreadPool * pThreads = nullptr) {
+      RenderableStorage<T> const & storage   = renderables<T>();
+      Hierarchy &                  hierarchy = m_hierarchies.getOrAdd(bfc::TypeID<T>());
+      if (hierarchy.version == storage.version()) {
+        return;
+      }
+
+      bfc::Vector<bfc::geometry::Boxf> bounds;
+      bounds.reserve(storage.size());
+      for (T const & renderable : storage) {
+        bounds.pushBack(bfc::calcBoundingBox(renderable));
+      }
+
+      hierarchy.bvh.build(bounds, nullptr, pThreads);
+      hierarchy.version = storage.version();
+    }
+
+    /// Get the bounding volume hierarchy built over the renderables of type `T`.
+    /// Leaf values are indices into renderables<T>(). It is out of date if the renderables
+    /// were modified after it was built.
+    template<typename T>
+    bfc::geometry::BVH<float> const & hierarchy() const {
+      static const bfc::geometry::BVH<float> empty;
+      Hierarchy const *                      pHierarchy = m_hierarchies.tryGet(bfc::TypeID<T>());
+      return pHierarchy != nullptr ? pHierarchy->bvh : empty;
+    }
+
+    /// Check if the hierarchy for `T` was built from the current renderables.
+    template<typename T>
+    bool isHierarchyCurrent() const {
+      Hierarchy const * pHierarchy = m_hierarchies.tryGet(bfc::TypeID<T>());
+      return pHierarchy != nullptr && pHierarchy->version == renderables<T>().version();
+    }
+
+    /// Call `callback(renderable)` for each renderable of type `T` with bounds that intersect `volume`.
+    /// The hierarchy for `T` is used if it is up to date, otherwise each renderable is tested.
+    template<typename T, typename Volume, typename Callback>
+    void forEachIntersecting(Volume const & volume, Callback && callback) const {
+      RenderableStorage<T> const & storage = renderables<T>();
+      if (isHierarchyCurrent<T>()) {
+        hierarchy<T>().query(volume, [&](int64_t index) { callback(storage[index]); });
+        return;
+      }
+
+      for (T const & renderable : storage) {
+        if (bfc::geometry::BVH<float>::overlaps(volume, bfc::calcBoundingBox(renderable))) {
+          callback(renderable);
+        }
+      }
+    }
+
     /// Add a renderable to the render data.
     template<typename T>
     void submit(T const & renderable) {
@@ -86,8 +157,14 @@ namespace engine {
     bfc::GraphicsDevice * getGraphicsDevice() const;
 
   private:
-    bfc::GraphicsDevice *                              m_pGraphics;
-    std::unique_ptr<bfc::graphics::CommandList>        m_pUpload;
-    bfc::Map<bfc::type_index, RenderableStorageBase *> m_renderables; ///< Lookup renderable list by type.
+    struct Hierarchy {
+      bfc::geometry::BVH<float> bvh;
+      uint64_t                  version = ~0ull; ///< Version of the renderables the hierarchy was built from.
+    };
+
+    bfc::GraphicsDevice *                                  m_pGraphics;
+    std::unique_ptr<bfc::graphics::CommandList>            m_pUpload;
+    bfc::Map<bfc::type_index, RenderableStorageBase *>     m_renderables; ///< Lookup renderable list by type.
+    bfc::Map<bfc::type_index, Hierarchy>                   m_hierarchies; ///< Bounding volume hierarchies over renderable lists.
   };
 } // namespace engine
@@ -9,77 +9,6 @@
 using namespace bfc;
 
 namespace engine {
-  class StaticMeshCollector : public ILevelRenderDataCollector {
-  public:
-    virtual void collectRenderData(RenderView * pReviewView, Level const * pLevel) override {
-      RenderData *                                    pRenderData = pReviewView->pRenderData;
-      RenderableStorage<StaticMeshRenderable> &             meshes      = pRenderData->renderables<StaticMeshRenderable>();
-      RenderableStorage<StaticMeshShadowCasterRenderable> & shadows     = pRenderData->renderables<StaticMeshShadowCasterRenderable>();
-
-      auto val = pLevel->getView<components::Transform, components::StaticMesh>();
-      LevelView<components::Transform, components::StaticMesh> test(
-        &pLevel->components<components::Transform>(),
-        &pLevel->components<components::StaticMesh>()
-      );
-
-      for (auto & [transform, meshComponent] : pLevel->getView<components::Transform, components::StaticMesh>()) {
-        if (meshComponent.pMesh == nullptr) {
-          continue;
-        }
-
-        Mesh *     pMesh       = meshComponent.pMesh.get();
-        Mat4d      modelMat    = transform.globalTransform(pLevel);
-        Mat4d      normalMat   = glm::transpose(glm::inverse(modelMat));
-        const bool castShadows = meshComponent.castShadows;
-
-        for (int64_t i = 0; i < pMesh->getSubmeshCount(); ++i) {
-          auto const & sm = pMesh->getSubMesh(i);
-
-          geometry::Boxf bounds = sm.bounds;
-          bounds.transform(modelMat);
-
-          Material *     pMaterial = i < meshComponent.materials.size() ? meshComponent.materials[i].pMaterial.instance().get() : nullptr;
-
-          StaticMeshRenderable renderable;
-          renderable.elementOffset = sm.elmOffset;
-          renderable.elementCount  = sm.elmCount;
-          renderable.modelMatrix   = modelMat;
-          renderable.normalMatrix  = normalMat;
-          renderable.vertexArray   = pMesh->getVertexArray();
-          renderable.bounds        = bounds;
-          renderable.shader        = i < meshComponent.materials.size() ? meshComponent.materials[i].pProgram.instance() : nullptr;
-          renderable.primitiveType = meshComponent.useTesselation ? PrimitiveType_Patches : PrimitiveType_Triangle;
-
-          if (pMaterial == nullptr) {
-            renderable.materialBuffer = InvalidGraphicsResource;
-            for (auto & texture : renderable.materialTextures) {
-              texture = InvalidGraphicsResource;
-            }
-          } else {
-            renderable.materialBuffer = *pMaterial;
-            for (auto & [i, texture] : enumerate(pMaterial->textures)) {
-              if (texture != nullptr) {
-                renderable.materialTextures[i] = texture;
-              }
-            }
-          }
-          meshes.pushBack(renderable);
-
-          if (castShadows) {
-            StaticMeshShadowCasterRenderable shadowCaster;
-            shadowCaster.vertexArray   = pMesh->getVertexArray();
-            shadowCaster.elementCount  = sm.elmCount;
-            shadowCaster.elementOffset = sm.elmOffset;
-            shadowCaster.bounds        = bounds;
-            shadowCaster.modelMatrix   = modelMat;
-            shadowCaster.normalMatrix  = normalMat;
-            shadows.pushBack(shadowCaster);
-          }
-        }
-      }
-    }
-  };
-  
   class LightCollector : public ILevelRenderDataCollector {
   public:
     virtual void collectRenderData(RenderView * pReviewView, Level const * pLevel) override {
@@ -88,7 +17,7 @@ namespace engine {
       RenderableStorage<LightRenderable> & lights = pRenderData->renderables<LightRenderable>();
   
       for (auto & [transform, lightComponent] : pLevel->getView<components::Transform, components::Light>()) {
-        Mat4d transformMat = transform.globalTransform(pLevel);
+        Mat4d transformMat = transform.cachedGlobalTransform();
   
         LightRenderable renderable;
         renderable.type           = lightComponent.type;
@@ -184,9 +113,126 @@ namespace engine {
     }
   };
 
-  RenderScene::RenderScene(bfc::GraphicsDevice * pDevice, bfc::Ref<Level> const & pLevel)
-    : m_pLevel(pLevel)
-    , m_pDevice(pDevice) {}
+  namespace {
+    /// Largest geometric error of a mesh level of detail allowed on screen, in pixels.
+    constexpr double MaxLodErrorPixels = 1.0;
+
+    /// Pick the least detailed level of a mesh whose error projects to at most MaxLodErrorPixels in the view.
+    int64_t selectLod(RenderView const & view, Mesh const & mesh, geometry::Boxf const & bounds, double modelScale) {
+      const int64_t lodCount = mesh.getLodCount();
+      if (lodCount <= 1 || view.renderTarget == nullptr) {
+        return 0;
+      }
+
+      // Pixels covered by one unit of world space error, at the nearest point of the bounds.
+      Mat4d const & proj           = view.projectionMatrix;
+      const double  viewportHeight = view.renderTarget->getSize().y * view.viewport.w;
+      double        pixelsPerUnit  = viewportHeight * 0.5 * proj[1][1];
+      if (proj[2][3] != 0) {
+        Vec3d  camera   = view.getCameraPosition();
+        Vec3d  nearest  = glm::clamp(camera, Vec3d(bounds.min), Vec3d(bounds.max));
+        double distance = glm::length(camera - nearest);
+        if (distance <= 0) {
+          return 0;
+        }
+
+        pixelsPerUnit /= distance;
+      }
+
+      int64_t lod = 0;
+      while (lod + 1 < lodCount && mesh.getLodError(lod + 1) * modelScale * pixelsPerUnit <= MaxLodErrorPixels) {
+        ++lod;
+      }
+      return lod;
+    }
+
+    /// Fraction of a sub-mesh's indices that must be culled before it is drawn in parts.
+    /// Below this, drawing the few extra indices is cheaper than splitting the draw, which also stops it being
+    /// merged with other draws of the same sub-mesh.
+    constexpr double MinCulledFraction = 0.25;
+
+    /// Test if a transform scales every direction equally, so that it preserves angles.
+    /// Meshlet normal cones can only be tested in the space of the mesh if it does.
+    bool preservesAngles(Mat4d const & transform) {
+      Mat3d const  linear = Mat3d(transform);
+      Mat3d const  metric = glm::transpose(linear) * linear;
+      double const scale  = (metric[0][0] + metric[1][1] + metric[2][2]) / 3;
+      for (int64_t col = 0; col < 3; ++col) {
+        for (int64_t row = 0; row < 3; ++row) {
+          if (std::abs(metric[col][row] - (col == row ? scale : 0)) > scale * 1e-4) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    /// Add the visible meshlets of a sub-mesh to the view. Adjacent meshlets are drawn together.
+    /// The whole sub-mesh is drawn if less than MinCulledFraction of it is culled.
+    /// @param frustum The view frustum in the space of the mesh.
+    /// @param viewer  The position of the viewer in the space of the mesh.
+    void pushVisibleMeshlets(RenderableStorage<StaticMeshRenderable> & meshes, StaticMeshRenderable const & renderable, Span<const Meshlet> const & meshlets,
+                             geometry::Frustumf const & frustum, Vec3 const & viewer, bool useCone) {
+      Vector<Pair<int64_t, int64_t>> ranges; // Offset and count of each run of visible meshlets.
+      int64_t                        visibleCount = 0;
+      bool                           extendRange  = false;
+      for (Meshlet const & meshlet : meshlets) {
+        if (!MeshletBuilder::isVisible(meshlet, frustum, viewer, useCone)) {
+          extendRange = false;
+          continue;
+        }
+
+        if (extendRange) {
+          ranges.back().second += meshlet.elmCount;
+        } else {
+          ranges.pushBack({meshlet.elmOffset, meshlet.elmCount});
+        }
+        visibleCount += meshlet.elmCount;
+        extendRange = true;
+      }
+
+      if (visibleCount >= renderable.elementCount * (1 - MinCulledFraction)) {
+        meshes.pushBack(renderable);
+        return;
+      }
+
+      for (auto & [offset, count] : ranges) {
+        StaticMeshRenderable range = renderable;
+        range.elementOffset        = offset;
+        range.elementCount         = count;
+        meshes.pushBack(range);
+      }
+    }
+  } // namespace
+
+  RenderScene::RenderScene(bfc::GraphicsDevice * pDevice, bfc::Ref<Level> const & pLevel, bfc::ThreadPool * pThreads)
+    : m_pDevice(pDevice)
+    , m_pThreads(pThreads)
+    , m_pLevel(pLevel) {
+    if (m_pLevel == nullptr) {
+      return;
+    }
+
+    auto markPending = [this](EntityID entity) { m_pending.add(entity); };
+
+    m_pLevelEvents = m_pLevel->getEvents()->addListener();
+    m_pLevelEvents->on([=](events::OnComponentAdded<components::StaticMesh> const & e) { markPending(e.entity); });
+    m_pLevelEvents->on([=](events::OnComponentModified<components::StaticMesh> const & e) { markPending(e.entity); });
+    m_pLevelEvents->on([=](events::OnComponentErased<components::StaticMesh> const & e) { markPending(e.entity); });
+    m_pLevelEvents->on([=](events::OnComponentErased<components::Transform> const & e) { markPending(e.entity); });
+    m_pLevelEvents->on([=](events::OnTransformsUpdated const & e) {
+      for (EntityID entity : e.entities) {
+        if (m_pLevel->has<components::StaticMesh>(entity)) {
+          markPending(entity);
+        }
+      }
+    });
+
+    // Entities added before the scene was created.
+    for (auto & [meshComponent] : m_pLevel->getView<components::StaticMesh>()) {
+      markPending(m_pLevel->toEntity(&meshComponent));
+    }
+  }
 
   Level * RenderScene::getLevel() const {
     return m_pLevel.get();
@@ -194,13 +240,14 @@ namespace engine {
 
   void RenderScene::setViews(Span<RenderView> const & views) {
     m_views = views;
+    m_viewStates.resize(m_views.size());
     for (auto & [i, view] : enumerate(m_views)) {
       if (i >= m_renderData.size())
         m_renderData.pushBack(bfc::NewRef<RenderData>(m_pDevice));
-      else
-        m_renderData[i]->clear();
     }
 
+    // Render data is not cleared here. Retained renderables stay valid while the
+    // view and the level are unchanged, which collect() detects using the view ID.
     for (auto & [i, view] : enumerate(m_views)) {
       view.pRenderData = m_renderData[i].get();
       view.updateCachedProperties();
@@ -212,25 +259,263 @@ namespace engine {
       return;
     }
 
-    StaticMeshCollector  staticMeshes;
-    LightCollector       lights;
-    SkyboxCollector      skyboxes;
-    PostProcessCollector pps;
+    // Refresh world matrices for anything that moved since the last collect.
+    // Only entities whose transforms were recomputed are rebuilt below.
+    components::Transform::updateGlobalTransforms(m_pLevel.get());
+
+    syncStaticMeshes();
 
-    for (auto & view : m_views) {
-      view.pRenderData->clear();
+    if (m_views.size() == 1) {
+      collectView(0);
+      return;
+    }
 
-      staticMeshes.collectRenderData(&view, m_pLevel.get());
-      lights.collectRenderData(&view, m_pLevel.get());
-      skyboxes.collectRenderData(&view, m_pLevel.get());
-      pps.collectRenderData(&view, m_pLevel.get());
+    Vector<std::future<void>> jobs;
+    for (int64_t i = 0; i < m_views.size(); ++i) {
+      jobs.pushBack(m_pThreads->run([this, i]() { collectView(i); }));
+    }
 
-      // Collect from extensions
-      collectRenderData(&view, m_pLevel.get());
+    for (auto & job : jobs) {
+      job.wait();
     }
   }
 
   Span<RenderView const> RenderScene::views() const {
     return m_views;
   }
+
+  uint64_t RenderScene::getRevision() const {
+    return m_revision;
+  }
+
+  void RenderScene::syncStaticMeshes() {
+    // Meshes and materials are checked once each, rather than once for every entity that draws them.
+    for (auto & [pMesh, users] : m_meshUsers) {
+      if (users.pMesh->getVertexArray() != users.vertexArray) { // Mesh was reloaded
+        for (EntityID entity : users.entities) {
+          m_pending.add(entity);
+        }
+      }
+    }
+
+    for (auto & [key, users] : m_materialUsers) {
+      Material const *          pMaterial = users.shaded.pMaterial.instance().get();
+      graphics::Program const * pProgram  = users.shaded.pProgram.instance().get();
+      if (pMaterial != users.pMaterial || pProgram != users.pProgram || (pMaterial != nullptr && pMaterial->revision != users.revision)) {
+        for (EntityID entity : users.entities) {
+          m_pending.add(entity);
+        }
+      }
+    }
+
+    if (m_pending.size() == 0) {
+      return;
+    }
+
+    for (EntityID entity : m_pending) {
+      rebuildStaticMesh(entity);
+    }
+
+    m_pending = {};
+    ++m_revision;
+  }
+
+  void RenderScene::rebuildStaticMesh(EntityID entity) {
+    Level *                        pLevel        = m_pLevel.get();
+    components::Transform const *  pTransform    = pLevel->tryGet<components::Transform>(entity);
+    components::StaticMesh const * pMeshComponent = pLevel->tryGet<components::StaticMesh>(entity);
+
+    if (RetainedStaticMesh * pRetained = m_staticMeshes.tryGet(entity)) {
+      removeUsers(entity, *pRetained);
+    }
+
+    // Drop entities that were removed, or lost their mesh, since the last collect.
+    if (pTransform == nullptr || pMeshComponent == nullptr || pMeshComponent->pMesh == nullptr) {
+      m_staticMeshes.erase(entity);
+      return;
+    }
+
+    components::StaticMesh const & meshComponent = *pMeshComponent;
+    RetainedStaticMesh &           retained      = m_staticMeshes.getOrAdd(entity);
+
+    Mesh *     pMesh       = meshComponent.pMesh.get();
+    Mat4d      modelMat    = pTransform->cachedGlobalTransform();
+    Mat4d      normalMat   = glm::transpose(glm::inverse(modelMat));
+    const bool castShadows = meshComponent.castShadows;
+
+    retained.pMesh           = pMesh;
+    retained.useTesselation  = meshComponent.useTesselation;
+    retained.modelScale      = std::max({glm::length(Vec3d(modelMat[0])), glm::length(Vec3d(modelMat[1])), glm::length(Vec3d(modelMat[2]))});
+    retained.preservesAngles = preservesAngles(modelMat);
+    retained.bounds          = pMesh->getBounds();
+    retained.bounds.transform(modelMat);
+    retained.inverseModelMatrix = glm::inverse(modelMat);
+    retained.meshes.clear();
+    retained.shadowCasters.clear();
+
+    for (int64_t i = 0; i < pMesh->getSubmeshCount(); ++i) {
+      auto const & sm = pMesh->getSubMesh(i);
+
+      geometry::Boxf bounds = sm.bounds;
+      bounds.transform(modelMat);
+
+      Material * pMaterial = i < meshComponent.materials.size() ? meshComponent.materials[i].pMaterial.instance().get() : nullptr;
+
+      StaticMeshRenderable renderable;
+      renderable.elementOffset = sm.elmOffset;
+      renderable.elementCount  = sm.elmCount;
+      renderable.modelMatrix   = modelMat;
+      renderable.normalMatrix  = normalMat;
+      renderable.vertexArray   = pMesh->getVertexArray();
+      renderable.bounds        = bounds;
+      renderable.shader        = i < meshComponent.materials.size() ? meshComponent.materials[i].pProgram.instance() : nullptr;
+      renderable.primitiveType = meshComponent.useTesselation ? PrimitiveType_Patches : PrimitiveType_Triangle;
+
+      if (pMaterial == nullptr) {
+        renderable.materialBuffer = InvalidGraphicsResource;
+        for (auto & texture : renderable.materialTextures) {
+          texture = InvalidGraphicsResource;
+        }
+      } else {
+        renderable.materialBuffer = *pMaterial;
+        for (auto & [i, texture] : enumerate(pMaterial->textures)) {
+          if (texture != nullptr) {
+            renderable.materialTextures[i] = texture;
+          }
+        }
+      }
+      retained.meshes.pushBack(renderable);
+
+      if (castShadows) {
+        StaticMeshShadowCasterRenderable shadowCaster;
+        shadowCaster.vertexArray   = pMesh->getVertexArray();
+        shadowCaster.elementCount  = sm.elmCount;
+        shadowCaster.elementOffset = sm.elmOffset;
+        shadowCaster.bounds        = bounds;
+        shadowCaster.modelMatrix   = modelMat;
+        shadowCaster.normalMatrix  = normalMat;
+        retained.shadowCasters.pushBack(shadowCaster);
+      }
+    }
+
+    addUsers(entity, retained, meshComponent);
+  }
+
+  void RenderScene::addUsers(EntityID entity, RetainedStaticMesh & retained, components::StaticMesh const & meshComponent) {
+    MeshUsers & meshUsers = m_meshUsers.getOrAdd(retained.pMesh);
+    meshUsers.pMesh       = meshComponent.pMesh;
+    meshUsers.vertexArray = meshComponent.pMesh->getVertexArray();
+    meshUsers.entities.add(entity);
+
+    retained.materialKeys.clear();
+    for (int64_t i = 0; i < retained.meshes.size() && i < meshComponent.materials.size(); ++i) {
+      components::ShadedMaterial const & shaded    = meshComponent.materials[i];
+      Material const *                   pMaterial = shaded.pMaterial.instance().get();
+      graphics::Program const *          pProgram  = shaded.pProgram.instance().get();
+
+      const uint64_t  key           = hash((uintptr_t)pMaterial, (uintptr_t)pProgram);
+      MaterialUsers & materialUsers = m_materialUsers.getOrAdd(key);
+      materialUsers.shaded          = shaded;
+      materialUsers.pMaterial       = pMaterial;
+      materialUsers.pProgram        = pProgram;
+      materialUsers.revision        = pMaterial != nullptr ? pMaterial->revision : 0;
+      materialUsers.entities.add(entity);
+      retained.materialKeys.pushBack(key);
+    }
+  }
+
+  void RenderScene::removeUsers(EntityID entity, RetainedStaticMesh const & retained) {
+    if (MeshUsers * pUsers = m_meshUsers.tryGet(retained.pMesh)) {
+      pUsers->entities.erase(entity);
+      if (pUsers->entities.size() == 0) {
+        m_meshUsers.erase(retained.pMesh);
+      }
+    }
+
+    for (uint64_t key : retained.materialKeys) {
+      if (MaterialUsers * pUsers = m_materialUsers.tryGet(key)) {
+        pUsers->entities.erase(entity);
+        if (pUsers->entities.size() == 0) {
+          m_materialUsers.erase(key);
+        }
+      }
+    }
+  }
+
+  void RenderScene::collectView(int64_t viewIndex) {
+    RenderView &  view        = m_views[viewIndex];
+    ViewState &   state       = m_viewStates[viewIndex];
+    RenderData *  pRenderData = view.pRenderData;
+    Level const * pLevel      = m_pLevel.get();
+
+    // Retained renderables are only copied into the view when it, or the scene, has changed.
+    pRenderData->clearExcept<StaticMeshRenderable, StaticMeshShadowCasterRenderable>();
+
+    const uint64_t viewID = view.getViewID();
+    if (state.viewID != viewID || state.revision != m_revision) {
+      RenderableStorage<StaticMeshRenderable> &             meshes  = pRenderData->renderables<StaticMeshRenderable>();
+      RenderableStorage<StaticMeshShadowCasterRenderable> & shadows = pRenderData->renderables<StaticMeshShadowCasterRenderable>();
+      meshes.clear();
+      shadows.clear();
+
+      geometry::Frustum<float> frustum(Mat4(view.getViewProjectionMatrix()));
+      const bool perspective = view.projectionMatrix[2][3] != 0;
+      for (auto & [entity, retained] : m_staticMeshes) {
+        const int64_t lod = selectLod(view, *retained.pMesh, retained.bounds, retained.modelScale);
+
+        // Meshlets are culled in the space of the mesh. Tesselated meshes may be displaced outside of the meshlet bounds.
+        // Meshes drawn by several entities are drawn whole, so their draws can be merged into instanced batches.
+        std::optional<geometry::Frustumf> localFrustum;
+        Vec3                              localViewer;
+        const bool                        instanced = m_meshUsers.tryGet(retained.pMesh)->entities.size() > 1;
+        if (lod == 0 && !retained.useTesselation && !retained.meshes.empty() && !instanced) {
+          localFrustum.emplace(Mat4(view.getViewProjectionMatrix() * retained.meshes.front().modelMatrix));
+          localViewer = Vec3(retained.inverseModelMatrix * Vec4d(view.getCameraPosition(), 1));
+        }
+
+        for (auto & [i, renderable] : enumerate(retained.meshes)) {
+          if (!geometry::intersects(frustum, renderable.bounds)) {
+            continue;
+          }
+
+          Span<const Meshlet> meshlets = retained.pMesh->getMeshlets(i);
+          if (localFrustum.has_value() && meshlets.size() > 1) {
+            pushVisibleMeshlets(meshes, renderable, meshlets, localFrustum.value(), localViewer, perspective && retained.preservesAngles);
+            continue;
+          }
+
+          StaticMeshRenderable visible = renderable;
+          if (lod > 0) {
+            Mesh::SubMesh const & sm = retained.pMesh->getSubMesh(i, lod);
+            visible.elementOffset    = sm.elmOffset;
+            visible.elementCount     = sm.elmCount;
+          }
+          meshes.pushBack(visible);
+        }
+
+        // Shadow casters outside of the view may still cast shadows into it.
+        // These always use the full detail mesh, as the view doesn't know where the shadows are seen from.
+        shadows.pushBack(retained.shadowCasters.begin(), retained.shadowCasters.end());
+      }
+
+      state.viewID   = viewID;
+      state.revision = m_revision;
+    }
+
+    // Shadow passes query casters per light (and per cube face), so index them spatially.
+    // This only rebuilds the hierarchy if the casters were modified since it was last built.
+    // Avoid blocking a pool thread on nested build tasks when views are collected in parallel.
+    pRenderData->buildHierarchy<StaticMeshShadowCasterRenderable>(ThreadPool::IsPoolThread() ? nullptr : m_pThreads);
+
+    LightCollector       lights;
+    SkyboxCollector      skyboxes;
+    PostProcessCollector pps;
+
+    lights.collectRenderData(&view, pLevel);
+    skyboxes.collectRenderData(&view, pLevel);
+    pps.collectRenderData(&view, pLevel);
+
+    // Collect from extensions
+    collectRenderData(&view, pLevel);
+  }
 } // namespace engine
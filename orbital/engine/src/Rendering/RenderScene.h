@@ -1,9 +1,15 @@
 #pragma once
 
+#include "core/Map.h"
+#include "core/Set.h"
 #include "core/Span.h"
 #include "core/Vector.h"
+#include "util/ThreadPool.h"
 
+#include "../Levels/CoreComponents.h"
+#include "../Levels/LevelComponents.h"
 #include "RenderData.h"
+#include "Renderables.h"
 #include "Renderer.h"
 
 namespace bfc {
@@ -16,9 +22,15 @@ namespace engine {
   class RenderView;
   class RenderScene;
 
+  /// Collects render data from a level for a set of views.
+  /// Static mesh renderables are retained between frames and only rebuilt for
+  /// entities that were added, removed or modified. Changes to entities are
+  /// received from the level's events, and changes to the meshes and materials
+  /// they use are detected once per mesh or material rather than per entity.
+  /// Each view then receives the subset of the retained renderables that are visible to it.
   class RenderScene {
   public:
-    RenderScene(bfc::GraphicsDevice * pDevice, bfc::Ref<Level> const & pLevel);
+    RenderScene(bfc::GraphicsDevice * pDevice, bfc::Ref<Level> const & pLevel, bfc::ThreadPool * pThreads = &bfc::ThreadPool::Global());
 
     Level * getLevel() const;
 
@@ -28,10 +40,75 @@ namespace engine {
 
     bfc::Span<RenderView const> views() const;
 
+    /// Get the revision of the retained render data.
+    /// This is incremented each time a retained renderable is added, removed or modified.
+    uint64_t getRevision() const;
+
   private:
+    /// Renderables built for a single entity with a StaticMesh component.
+    struct RetainedStaticMesh {
+      bool   useTesselation  = false;
+      double modelScale      = 1; ///< Largest scale of the model matrix, used to project the mesh LOD errors.
+      bool   preservesAngles = true; ///< The model matrix scales uniformly, so meshlet normal cones can be tested in mesh space.
+
+      bfc::geometry::Boxf bounds;             ///< World space bounds of the mesh.
+      bfc::Mat4d          inverseModelMatrix; ///< Transforms the view into the space of the mesh to cull meshlets.
+
+      bfc::Mesh const *                              pMesh = nullptr;
+      bfc::Vector<uint64_t>                          materialKeys; ///< Key into m_materialUsers for each sub-mesh.
+      bfc::Vector<StaticMeshRenderable>              meshes;
+      bfc::Vector<StaticMeshShadowCasterRenderable> shadowCasters;
+    };
+
+    /// A mesh drawn by retained entities, and the vertex array their renderables were built with.
+    struct MeshUsers {
+      bfc::Ref<bfc::Mesh>           pMesh; ///< Kept alive until the entities using it are next synced.
+      bfc::graphics::VertexArrayRef vertexArray;
+      bfc::Set<EntityID>            entities;
+    };
+
+    /// A material drawn by retained entities, and the instances their renderables were built with.
+    struct MaterialUsers {
+      components::ShadedMaterial     shaded;
+      bfc::Material const *          pMaterial = nullptr;
+      bfc::graphics::Program const * pProgram  = nullptr;
+      uint64_t                       revision  = 0; ///< Revision of pMaterial the renderables were built with.
+      bfc::Set<EntityID>             entities;
+    };
+
+    /// The state of the retained render data when a view was last collected.
+    struct ViewState {
+      uint64_t viewID   = 0;
+      uint64_t revision = 0;
+    };
+
+    /// Update the retained renderables of entities that changed since the last collect.
+    void syncStaticMeshes();
+
+    /// Rebuild, or remove, the retained renderables of a single entity.
+    void rebuildStaticMesh(EntityID entity);
+
+    /// Record the mesh and materials drawn by a retained entity.
+    void addUsers(EntityID entity, RetainedStaticMesh & retained, components::StaticMesh const & meshComponent);
+
+    /// Stop tracking the mesh and materials drawn by a retained entity.
+    void removeUsers(EntityID entity, RetainedStaticMesh const & retained);
+
+    /// Collect the render data for a single view.
+    void collectView(int64_t viewIndex);
+
     bfc::GraphicsDevice *   m_pDevice;
+    bfc::ThreadPool *       m_pThreads;
     bfc::Ref<Level>         m_pLevel;
     bfc::Vector<bfc::Ref<RenderData>> m_renderData;
     bfc::Vector<RenderView> m_views;
+    bfc::Vector<ViewState>  m_viewStates;
+
+    bfc::Ref<bfc::EventListener>           m_pLevelEvents;
+    bfc::Set<EntityID>                     m_pending; ///< Entities whose retained renderables must be rebuilt.
+    bfc::Map<EntityID, RetainedStaticMesh> m_staticMeshes;
+    bfc::Map<bfc::Mesh const *, MeshUsers> m_meshUsers;
+    bfc::Map<uint64_t, MaterialUsers>      m_materialUsers; ///< Keyed by the material and program instances.
+    uint64_t                               m_revision = 0;
   };
 } // namespace engine
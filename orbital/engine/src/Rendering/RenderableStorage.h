@@ -16,12 +16,22 @@ namespace engine {
 
     virtual bfc::geometry::Boxf calcBoundingBox(int64_t const & start = 0, int64_t const & count = bfc::npos) const = 0;
     virtual bool                hasCalcBoundingBox() const                                                          = 0;
+
+    /// Incremented whenever the renderables are added, removed or accessed for writing.
+    /// Data derived from the renderables, such as a bounding volume hierarchy, is stale once this changes.
+    uint64_t version() const {
+      return m_version;
+    }
+
+  protected:
+    uint64_t m_version = 0;
   };
 
   template<typename T>
   class RenderableStorage : public RenderableStorageBase {
   public:
     virtual void clear() override {
+      ++m_version;
       items.clear();
     }
 
@@ -30,6 +40,7 @@ namespace engine {
     }
 
     virtual bool erase(int64_t const & index, int64_t count = 1) override {
+      ++m_version;
       return items.erase(index, count);
     }
 
@@ -68,14 +79,17 @@ namespace engine {
     }
 
     T & at(int64_t index) {
+      ++m_version;
       return items.at(index);
     }
 
     T & back() {
+      ++m_version;
       return items.back();
     }
 
     T & front() {
+      ++m_version;
       return items.front();
     }
 
@@ -104,82 +118,102 @@ namespace engine {
     }
 
     void pushBack(T && value) {
+      ++m_version;
       return items.pushBack(std::move(value));
     }
 
     void pushBack(T const & value) {
+      ++m_version;
       return items.pushBack(value);
     }
 
     void pushBack(T const * first, T const * last) {
+      ++m_version;
       return items.pushBack(first, last);
     }
 
     void pushBack(bfc::Span<T> const & items) {
+      ++m_version;
       return items.pushBack(items);
     }
 
     void pushBack(std::initializer_list<T> const & il) {
+      ++m_version;
       return items.pushBack(il);
     }
 
     void pushBackMove(T * first, T * last) {
+      ++m_version;
       return items.pushBackMove(first, last);
     }
 
     void pushFront(T && value) {
+      ++m_version;
       return items.pushFront(std::move(value));
     }
 
     void pushFront(T const & value) {
+      ++m_version;
       return items.pushFront(value);
     }
 
     void pushFront(T const * first, T const * last) {
+      ++m_version;
       return items.pushFront(first, last);
     }
 
     void pushFront(bfc::Span<T> const & items) {
+      ++m_version;
       return items.pushFront(items);
     }
 
     void pushFront(std::initializer_list<T> const & il) {
+      ++m_version;
       return items.pushFront(il);
     }
 
     void pushFrontMove(T * first, T * last) {
+      ++m_version;
       return items.pushFrontMove(first, last);
     }
 
     T popBack() {
+      ++m_version;
       return items.popBack();
     }
 
     T popFront() {
+      ++m_version;
       return items.popFront();
     }
 
     void insert(int64_t index, T && value) {
+      ++m_version;
       return items.insert(index, std::move(value));
     }
 
     void insert(int64_t index, T const & value) {
+      ++m_version;
       return items.insert(index, value);
     }
 
     void insert(int64_t index, bfc::Span<T> const & items) {
+      ++m_version;
       return items.insert(index, items);
     }
 
     void insert(int64_t index, T const * first, T const * last) {
+      ++m_version;
       return items.insert(index, first, last);
     }
 
     void insertMove(int64_t index, T * first, T * last) {
+      ++m_version;
       return items.insertMove(index, first, last);
     }
 
     void resize(int64_t newSize, T const & value = T{}) {
+      ++m_version;
       return items.resize(newSize, value);
     }
 
@@ -204,12 +238,15 @@ namespace engine {
     }
 
     T * begin() {
+      ++m_version;
       return items.begin();
     }
     T * end() {
+      ++m_version;
       return items.end();
     }
     T * data() {
+      ++m_version;
       return items.data();
     }
 
@@ -224,6 +261,7 @@ namespace engine {
     }
 
     T & operator[](int64_t index) {
+      ++m_version;
       return items.at(index);
     }
 
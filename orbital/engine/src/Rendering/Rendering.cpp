@@ -13,6 +13,7 @@ namespace engine {
   Rendering::Rendering() 
     : Subsystem(TypeID<Rendering>(), "Rendering") {
     graphicsDevice_registerOpenGL();
+    graphicsDevice_registerNull();
   }
 
   GraphicsDevice* Rendering::getDevice() const {
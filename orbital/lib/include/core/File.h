@@ -3,6 +3,7 @@
 #include "Stream.h"
 #include "Filename.h"
 #include "Timestamp.h"
+#include "../platform/OS.h"
 
 #include <optional>
 
@@ -80,6 +81,62 @@ namespace bfc {
     int64_t m_length = 0;
   };
 
+  /// A stream over a memory mapped file.
+  /// The file contents can be accessed in place with data(), without copying them into a buffer.
+  /// The mapping has a fixed size, so writes past the end of the stream are truncated.
+  class BFC_API MappedFileStream : public Stream {
+  public:
+    using Stream::write;
+    using Stream::read;
+
+    /// Map a file.
+    /// @param file The file to map.
+    /// @param mode The file is mapped for writing if `mode` contains FileMode_Write or FileMode_Append.
+    /// @param size The number of bytes to map. If 0, the whole file is mapped.
+    ///             A file mapped for writing is grown to `size` if it is smaller.
+    bool open(Filename const & file, FileMode mode = FileMode_ReadBinary, int64_t size = 0);
+
+    void close();
+
+    /// Hint how the stream will be accessed so the OS can read ahead.
+    void setAccessHint(os::MappingAccess access);
+
+    virtual int64_t write(void const * data, int64_t length) override;
+
+    virtual int64_t read(void * data, int64_t length) override;
+
+    virtual bool seek(int64_t pos, SeekOrigin origin = SeekOrigin_Current) override;
+
+    virtual bool readable() const override;
+
+    virtual bool writeable() const override;
+
+    virtual bool seekable() const override;
+
+    virtual bool eof() const override;
+
+    virtual int64_t tell() const override;
+
+    virtual bool flush() override;
+
+    virtual int64_t length() const override;
+
+    virtual uint8_t const * data() const override;
+
+    /// Get the mapped file contents for writing.
+    uint8_t * data();
+
+    /// Get the number of bytes mapped.
+    int64_t size() const;
+
+    FileMode mode() const;
+
+  private:
+    os::FileMapping m_mapping;
+    FileMode        m_mode      = FileMode_Closed;
+    int64_t         m_streamPos = 0;
+  };
+
   BFC_API bool readFile(Filename const& path, Vector<uint8_t> *pContent);
 
   BFC_API bool readTextFile(Filename const& path, String *pContent);
@@ -3,21 +3,124 @@
 #include "Pair.h"
 #include "Vector.h"
 
+#include <cstring>
+
+#if defined(BFC_X64) || defined(BFC_X86) || defined(__SSE2__)
+#define BFC_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef BFC_MSVC
+#include <intrin.h>
+#endif
+
 namespace bfc {
+  namespace impl {
+    /// Control bytes used by Map to track the state of each slot.
+    /// Full slots store the low 7 bits of the key hash (0 - 127).
+    using MapCtrl = int8_t;
+
+    inline constexpr MapCtrl   MapCtrl_Empty   = -128;
+    inline constexpr MapCtrl   MapCtrl_Deleted = -2;
+    inline constexpr int64_t   MapGroupWidth   = 16;
+
+    /// Written before each serialized Map. Maps written by older versions start with their bucket count,
+    /// which is never negative, so the tag also tells the two formats apart.
+    inline constexpr int64_t MapSerializeTag     = -1;
+    inline constexpr int64_t MapSerializeVersion = 2;
+
+    inline uint32_t countTrailingZeros(uint32_t bits) {
+#ifdef BFC_MSVC
+      unsigned long index = 0;
+      _BitScanForward(&index, bits);
+      return (uint32_t)index;
+#else
+      return (uint32_t)__builtin_ctz(bits);
+#endif
+    }
+
+    inline uint32_t countLeadingZeros16(uint32_t bits) {
+      if (bits == 0)
+        return 16;
+#ifdef BFC_MSVC
+      unsigned long index = 0;
+      _BitScanReverse(&index, bits);
+      return 15 - (uint32_t)index;
+#else
+      return (uint32_t)__builtin_clz(bits) - 16;
+#endif
+    }
+
+    /// A group of 16 control bytes that are tested in parallel.
+    /// Each match returns a bitmask where bit `i` corresponds to the control byte at `pCtrl[i]`.
+    class MapGroup {
+    public:
+#ifdef BFC_MAP_SSE2
+      explicit MapGroup(MapCtrl const * pCtrl)
+        : m_ctrl(_mm_loadu_si128((__m128i const *)pCtrl)) {}
+
+      uint32_t match(MapCtrl h2) const {
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+      }
+
+      uint32_t matchEmpty() const {
+        return match(MapCtrl_Empty);
+      }
+
+      uint32_t matchEmptyOrDeleted() const {
+        // Empty and deleted are the only control bytes with the sign bit set.
+        return (uint32_t)_mm_movemask_epi8(m_ctrl);
+      }
+
+    private:
+      __m128i m_ctrl;
+#else
+      explicit MapGroup(MapCtrl const * pCtrl) {
+        memcpy(m_ctrl, pCtrl, sizeof(m_ctrl));
+      }
+
+      uint32_t match(MapCtrl h2) const {
+        uint32_t bits = 0;
+        for (int64_t i = 0; i < MapGroupWidth; ++i)
+          bits |= uint32_t(m_ctrl[i] == h2) << i;
+        return bits;
+      }
+
+      uint32_t matchEmpty() const {
+        return match(MapCtrl_Empty);
+      }
+
+      uint32_t matchEmptyOrDeleted() const {
+        uint32_t bits = 0;
+        for (int64_t i = 0; i < MapGroupWidth; ++i)
+          bits |= uint32_t(m_ctrl[i] < 0) << i;
+        return bits;
+      }
+
+    private:
+      MapCtrl m_ctrl[MapGroupWidth];
+#endif
+    };
+  } // namespace impl
+
+  /// Open addressing hash map.
+  /// Items are stored inline in a single slot array alongside an array of control bytes. Lookups probe
+  /// the control bytes 16 at a time, so only slots whose hash fragment matches are compared.
   template <typename Key, typename Value>
   class Map {
+    using Ctrl = impl::MapCtrl;
+
   public:
     using KeyType = Key;
     using ValueType = Value;
 
     using Item = Pair<Key, Value>;
-    using Bucket = Vector<Item>;
 
-    constexpr static int64_t BucketSize = 16ll;
+    constexpr static int64_t GroupWidth = impl::MapGroupWidth;
 
-    Map(int64_t capacity = 0)
-        : m_bucketOrder(findBucketOrder(capacity)) {
-      m_buckets.resize(getBucketCount());
+    Map(int64_t capacity = 0) {
+      if (capacity > 0)
+        allocate(findSlotCount(capacity));
     }
 
     Map(std::initializer_list<Item> const& items)
@@ -32,24 +135,46 @@ namespace bfc {
         tryAdd(i);
     }
 
-    bool contains(Key const& key) const {
-      return tryGet(key) != nullptr;
+    Map(Map const & o)
+        : Map(o.m_size) {
+      for (Item const & item : o)
+        insertUnique(hashOf(item.first), Item(item));
     }
 
-    Value& add(Key&& key, Value&& value) {
-      tryRehash();
-      int64_t bucketIndex = findBucket(key);
+    Map(Map && o) {
+      swap(o);
+    }
 
-      BFC_ASSERT(bucketIndex >= 0 && bucketIndex < m_buckets.size(), "Invalid Bucket");
+    ~Map() {
+      release();
+    }
 
-      Bucket& bucket = m_buckets[bucketIndex];
+    Map & operator=(Map const & o) {
+      if (this != &o) {
+        Map copy(o);
+        swap(copy);
+      }
+      return *this;
+    }
 
-      BFC_ASSERT(findInBucket(bucket, key) == -1, "Duplicate Key");
+    Map & operator=(Map && o) {
+      if (this != &o) {
+        release();
+        swap(o);
+      }
+      return *this;
+    }
 
-      bucket.pushBack(Item(std::move(key), std::move(value)));
-      ++m_size;
+    bool contains(Key const& key) const {
+      return tryGet(key) != nullptr;
+    }
+
+    Value& add(Key&& key, Value&& value) {
+      uint64_t hashCode = hashOf(key);
 
-      return bucket.back().second;
+      BFC_ASSERT(findIndex(key, hashCode) == -1, "Duplicate Key");
+
+      return insertUnique(hashCode, Item(std::move(key), std::move(value))).second;
     }
 
     Value& add(Key const& key, Value const& value) {
@@ -65,15 +190,11 @@ namespace bfc {
     }
 
     bool tryAdd(Key&& key, Value&& value) {
-      tryRehash();
-
-      Bucket& bucket = m_buckets[findBucket(key)];
-      int64_t index = findInBucket(bucket, key);
-      if (index != -1)
+      uint64_t hashCode = hashOf(key);
+      if (findIndex(key, hashCode) != -1)
         return false;
 
-      bucket.pushBack(Item(std::move(key), std::move(value)));
-      ++m_size;
+      insertUnique(hashCode, Item(std::move(key), std::move(value)));
       return true;
     }
 
@@ -90,56 +211,35 @@ namespace bfc {
     }
 
     Value & addOrSet(Key const & key, Value const & value) {
-      tryRehash();
-
-      int64_t bucketIndex = findBucket(key);
-
-      BFC_ASSERT(bucketIndex >= 0 && bucketIndex < m_buckets.size(), "Invalid Bucket");
-
-      Bucket& bucket = m_buckets[bucketIndex];
-      int64_t index = findInBucket(bucket, key);
+      uint64_t hashCode = hashOf(key);
+      int64_t  index    = findIndex(key, hashCode);
       if (index != -1) {
-        bucket[index].second = value;
-        return bucket[index].second;
-      }
-      else {
-        bucket.pushBack(Item(key, value));
-        ++m_size;
-        return bucket.back().second;
+        m_pSlots[index].second = value;
+        return m_pSlots[index].second;
       }
+
+      return insertUnique(hashCode, Item(key, value)).second;
     }
 
     bool erase(Key const & key) {
-      int64_t bucketIndex = findBucket(key);
-
-      BFC_ASSERT(bucketIndex >= 0 && bucketIndex < m_buckets.size(), "Invalid Bucket");
-
-      Bucket & bucket = m_buckets[bucketIndex];
-      int64_t  index  = findInBucket(bucket, key);
+      int64_t index = findIndex(key, hashOf(key));
       if (index == -1)
         return false;
 
-      bucket.erase(index);
-      --m_size;
+      eraseAt(index);
       return true;
     }
 
     bool erase(Key const & key, Value * pValue) {
-      int64_t bucketIndex = findBucket(key);
-
-      BFC_ASSERT(bucketIndex >= 0 && bucketIndex < m_buckets.size(), "Invalid Bucket");
-
-      Bucket & bucket = m_buckets[bucketIndex];
-      int64_t  index  = findInBucket(bucket, key);
+      int64_t index = findIndex(key, hashOf(key));
       if (index == -1)
         return false;
 
       if (pValue != nullptr) {
-        *pValue = std::move(bucket[index].second);
+        *pValue = std::move(m_pSlots[index].second);
       }
 
-      bucket.erase(index);
-      --m_size;
+      eraseAt(index);
       return true;
     }
 
@@ -158,36 +258,27 @@ namespace bfc {
     }
 
     Value* tryGet(Key const& key) {
-      Bucket& bucket = m_buckets[findBucket(key)];
-      int64_t index = findInBucket(bucket, key);
-      return index == -1 ? nullptr : &bucket[index].second;
+      int64_t index = findIndex(key, hashOf(key));
+      return index == -1 ? nullptr : &m_pSlots[index].second;
     }
 
     Value const* tryGet(Key const& key) const {
-      Bucket const& bucket = m_buckets[findBucket(key)];
-      int64_t index = findInBucket(bucket, key);
-      return index == -1 ? nullptr : &bucket[index].second;
+      int64_t index = findIndex(key, hashOf(key));
+      return index == -1 ? nullptr : &m_pSlots[index].second;
     }
 
     Value getOr(Key const& key, Value const& defaultValue) const {
-      Bucket const & bucket = m_buckets[findBucket(key)];
-      int64_t index = findInBucket(bucket, key);
-      return index == -1 ? defaultValue : bucket[index].second;
+      Value const * pValue = tryGet(key);
+      return pValue == nullptr ? defaultValue : *pValue;
     }
 
     Value & getOrAdd(Key const & key) {
-      tryRehash();
-
-      Bucket& bucket = m_buckets[findBucket(key)];
-      int64_t index = findInBucket(bucket, key);
-
-      if (index == -1) {
-        index = bucket.size();
-        bucket.pushBack(Item(key, Value()));
-        ++m_size;
-      }
+      uint64_t hashCode = hashOf(key);
+      int64_t  index    = findIndex(key, hashCode);
+      if (index != -1)
+        return m_pSlots[index].second;
 
-      return bucket[index].second;
+      return insertUnique(hashCode, Item(key, Value())).second;
     }
 
     Value& get(Key const& key) {
@@ -210,91 +301,105 @@ namespace bfc {
       return get(key);
     }
 
+    /// Get the number of items that can be stored before the map needs to grow.
     int64_t capacity() const {
-      return getBucketCount() * BucketSize;
+      return growthLimit(m_slotCount);
     }
 
     int64_t size() const {
       return m_size;
     }
 
+    /// Ensure at least `capacity` items can be stored without rehashing.
+    void reserve(int64_t capacity) {
+      if (capacity > m_size + m_growthLeft)
+        resize(findSlotCount(capacity));
+    }
+
     void clear() {
-      for (Bucket& bucket : m_buckets)
-        bucket.clear();
-      m_size = 0;
+      if (m_slotCount == 0)
+        return;
+
+      for (int64_t i = 0; i < m_slotCount; ++i)
+        if (isFull(m_pCtrl[i]))
+          mem::destruct(m_pSlots + i);
+
+      memset(m_pCtrl, (uint8_t)impl::MapCtrl_Empty, m_slotCount + GroupWidth);
+      m_size       = 0;
+      m_growthLeft = growthLimit(m_slotCount);
     }
 
     Vector<Key> getKeys() const {
       Vector<Key> keys;
       keys.reserve(m_size);
-      for (Bucket const& bucket : m_buckets)
-        for (Item const& item : bucket)
-          keys.pushBack(item.first);
+      for (Item const& item : *this)
+        keys.pushBack(item.first);
       return keys;
     }
 
     Vector<Value> getValues() const {
       Vector<Value> values;
       values.reserve(m_size);
-      for (Bucket const& bucket : m_buckets)
-        for (Item const& item : bucket)
-          values.pushBack(item.second);
+      for (Item const& item : *this)
+        values.pushBack(item.second);
       return values;
     }
 
     Vector<Pair<Key, Value>> getItems() const {
       Vector<Pair<Key, Value>> values;
       values.reserve(m_size);
-      for (Bucket const & bucket : m_buckets)
-        for (Item const & item : bucket)
-          values.pushBack(item);
+      for (Item const & item : *this)
+        values.pushBack(item);
       return values;
     }
 
     class Iterator {
     public:
-      Iterator(Bucket* pBucket, Item* pItem, Bucket* pEndBucket)
-          : m_pBucket(pBucket), m_pItem(pItem), m_pEndBucket(pEndBucket) {}
+      Iterator(Ctrl const * pCtrl, Item * pItem, Ctrl const * pEndCtrl)
+          : m_pCtrl(pCtrl), m_pItem(pItem), m_pEndCtrl(pEndCtrl) {
+        skipUnused();
+      }
 
-      bool operator==(Iterator const& o) const { return o.m_pBucket == m_pBucket && o.m_pItem == m_pItem; }
+      bool operator==(Iterator const& o) const { return o.m_pCtrl == m_pCtrl && o.m_pItem == m_pItem; }
       bool operator!=(Iterator const& o) const { return !(*this == o); }
       Item* operator->() const { return m_pItem; }
       Item& operator*() const { return *m_pItem; }
 
       Iterator& operator++() {
-        if (m_pBucket == nullptr)
-          return *this;
         if (m_pItem == nullptr)
           return *this;
 
-        // Goto next item
+        ++m_pCtrl;
         ++m_pItem;
+        skipUnused();
+        return *this;
+      }
 
-        // Goto next bucket if we don't have a valid item
-        while (m_pItem != nullptr && m_pItem >= m_pBucket->end()) {
-          ++m_pBucket;
-          if (m_pBucket >= m_pEndBucket) {
-            m_pItem = nullptr;
-            m_pBucket = nullptr;
-          }
-          else {
-            m_pItem = m_pBucket->begin();
-          }
+    private:
+      void skipUnused() {
+        if (m_pItem == nullptr)
+          return;
+
+        while (m_pCtrl < m_pEndCtrl && !isFull(*m_pCtrl)) {
+          ++m_pCtrl;
+          ++m_pItem;
         }
 
-        return *this;
+        if (m_pCtrl >= m_pEndCtrl) {
+          m_pCtrl = nullptr;
+          m_pItem = nullptr;
+        }
       }
 
-    private:
-      Bucket* m_pBucket = nullptr;
-      Item* m_pItem = nullptr;
-      Bucket* m_pEndBucket = nullptr;
+      Ctrl const * m_pCtrl    = nullptr;
+      Item *       m_pItem    = nullptr;
+      Ctrl const * m_pEndCtrl = nullptr;
     };
 
     class ConstIterator : public Iterator {
     public:
-      ConstIterator(Bucket const* pBucket, Item const* pItem, Bucket const* pEnd)
-          : Iterator((Bucket*)pBucket, (Item*)pItem, (Bucket*)pEnd) {}
+      ConstIterator(Ctrl const * pCtrl, Item const * pItem, Ctrl const * pEndCtrl)
+          : Iterator(pCtrl, (Item*)pItem, pEndCtrl) {}
 
       bool operator==(ConstIterator const& o) const { return Iterator::operator==(o); }
       bool operator!=(ConstIterator const& o) const { return Iterator::operator!=(o); }
@@ -307,22 +412,22 @@ namespace bfc {
       if (size() == 0)
         return end();
       else
-        return Iterator(m_buckets.begin(), m_buckets.front().begin(), m_buckets.end());
+        return Iterator(m_pCtrl, m_pSlots, m_pCtrl + m_slotCount);
     }
 
     Iterator end() {
-      return Iterator(nullptr, nullptr, m_buckets.end());
+      return Iterator(nullptr, nullptr, nullptr);
     }
 
     ConstIterator begin() const {
       if (size() == 0)
         return end();
       else
-        return ConstIterator(m_buckets.begin(), m_buckets.front().begin(), m_buckets.end());
+        return ConstIterator(m_pCtrl, m_pSlots, m_pCtrl + m_slotCount);
     }
 
     ConstIterator end() const {
-      return ConstIterator(nullptr, nullptr, m_buckets.end());
+      return ConstIterator(nullptr, nullptr, nullptr);
     }
 
     bool operator==(Map const& rhs) const {
@@ -351,197 +456,300 @@ namespace bfc {
     friend int64_t read(Stream * pStream, Map<Key2, Value2> * pValue, int64_t count);
 
   private:
-    bool tryRehash() {
-      if (m_size + 1 <= capacity())
-        return false;
+    static constexpr bool isFull(Ctrl ctrl) {
+      return ctrl >= 0;
+    }
+
+    static uint64_t hashOf(Key const & key) {
+      // Mix the hash so that both the probe position and the 7 bit fragment
+      // are well distributed, even for identity hashes (e.g. integers).
+      uint64_t h = hash(key);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      return h;
+    }
+
+    static constexpr uint64_t h1(uint64_t hashCode) {
+      return hashCode >> 7;
+    }
+
+    static constexpr Ctrl h2(uint64_t hashCode) {
+      return Ctrl(hashCode & 0x7F);
+    }
+
+    /// Maximum number of items stored in a table of `slotCount` slots (7/8 load factor).
+    static constexpr int64_t growthLimit(int64_t slotCount) {
+      return slotCount - slotCount / 8;
+    }
+
+    /// Find the smallest power-of-two slot count that can hold `capacity` items.
+    static constexpr int64_t findSlotCount(int64_t capacity) {
+      int64_t slotCount = GroupWidth;
+      while (growthLimit(slotCount) < capacity)
+        slotCount *= 2;
+      return slotCount;
+    }
+
+    int64_t findIndex(Key const & key, uint64_t hashCode) const {
+      if (m_slotCount == 0)
+        return -1;
 
-      // Create a new map with capcity for size + 1 items
-      Map rehashed(m_size + 1);
+      uint64_t const mask = m_slotCount - 1;
+      Ctrl const     tag  = h2(hashCode);
+      uint64_t       pos  = h1(hashCode) & mask;
+      uint64_t       step = 0;
+      while (true) {
+        impl::MapGroup group(m_pCtrl + pos);
+        for (uint32_t bits = group.match(tag); bits != 0; bits &= bits - 1) {
+          int64_t index = (pos + impl::countTrailingZeros(bits)) & mask;
+          if (m_pSlots[index].first == key)
+            return index;
+        }
+
+        if (group.matchEmpty() != 0)
+          return -1;
 
-      // Move all items to the new map
-      auto it = begin();
-      auto last = end();
-      for (; it != last; ++it) {
-        rehashed.add(std::move(it->first), std::move(it->second));
+        step += GroupWidth;
+        pos = (pos + step) & mask;
       }
+    }
 
-      *this = std::move(rehashed);
+    /// Find the first empty or deleted slot in the probe sequence for `hashCode`.
+    int64_t findFirstNonFull(uint64_t hashCode) const {
+      uint64_t const mask = m_slotCount - 1;
+      uint64_t       pos  = h1(hashCode) & mask;
+      uint64_t       step = 0;
+      while (true) {
+        uint32_t bits = impl::MapGroup(m_pCtrl + pos).matchEmptyOrDeleted();
+        if (bits != 0)
+          return (pos + impl::countTrailingZeros(bits)) & mask;
 
-      return true;
+        step += GroupWidth;
+        pos = (pos + step) & mask;
+      }
     }
 
-    static int64_t findInBucket(Bucket const& bucket, Key const& key) {
-      for (int64_t i = 0; i < bucket.size(); ++i)
-        if (bucket[i].first == key)
-          return i;
-      return -1;
-    }
-
-    int64_t findBucket(Key const& key) const {
-      return getBucketIndex(hash(key));
-    }
-
-    static constexpr int64_t findBucketOrder(int64_t capacity) {
-      int64_t order = 0;
-      while (order < 30 && getBucketCount(order) * BucketSize < capacity)
-        ++order;
-      return order;
-    }
-
-    uint64_t getBucketCount() const {
-      uint64_t count = getBucketCount(m_bucketOrder);
-      return count < 0 ? m_buckets.size() : count;
-    }
-
-    uint64_t getBucketIndex(uint64_t const& hashCode) const {
-      switch (m_bucketOrder) {
-      case 0:
-        return hashCode % 1;
-      case 1:
-        return hashCode % 3;
-      case 2:
-        return hashCode % 7;
-      case 3:
-        return hashCode % 13;
-      case 4:
-        return hashCode % 29;
-      case 5:
-        return hashCode % 59;
-      case 6:
-        return hashCode % 127;
-      case 7:
-        return hashCode % 233;
-      case 8:
-        return hashCode % 547;
-      case 9:
-        return hashCode % 1153;
-      case 10:
-        return hashCode % 2137;
-      case 11:
-        return hashCode % 4391;
-      case 12:
-        return hashCode % 8191;
-      case 13:
-        return hashCode % 16931;
-      case 14:
-        return hashCode % 32467;
-      case 15:
-        return hashCode % 65449;
-      case 16:
-        return hashCode % 125149;
-      case 17:
-        return hashCode % 255329;
-      case 18:
-        return hashCode % 512747;
-      case 19:
-        return hashCode % 1045151;
-      case 20:
-        return hashCode % 2013751;
-      case 21:
-        return hashCode % 4002839;
-      case 22:
-        return hashCode % 8008549;
-      case 23:
-        return hashCode % 16007441;
-      case 24:
-        return hashCode % 32007299;
-      case 25:
-        return hashCode % 64010267;
-      case 26:
-        return hashCode % 128010517;
-      default:
-        return hashCode % m_buckets.size();
+    /// Insert an item that is known not to be in the map.
+    Item & insertUnique(uint64_t hashCode, Item && item) {
+      int64_t index = m_slotCount == 0 ? -1 : findFirstNonFull(hashCode);
+      if (index == -1 || (m_growthLeft == 0 && m_pCtrl[index] != impl::MapCtrl_Deleted)) {
+        rehashForInsert();
+        index = findFirstNonFull(hashCode);
       }
+
+      m_growthLeft -= m_pCtrl[index] == impl::MapCtrl_Empty;
+      setCtrl(index, h2(hashCode));
+      mem::construct(m_pSlots + index, std::move(item));
+      ++m_size;
+      return m_pSlots[index];
     }
 
-    static constexpr int64_t getBucketCount(int64_t order) {
-      switch (order) {
-      case 0:
-        return 1;
-      case 1:
-        return 3;
-      case 2:
-        return 7;
-      case 3:
-        return 13;
-      case 4:
-        return 29;
-      case 5:
-        return 59;
-      case 6:
-        return 127;
-      case 7:
-        return 233;
-      case 8:
-        return 547;
-      case 9:
-        return 1153;
-      case 10:
-        return 2137;
-      case 11:
-        return 4391;
-      case 12:
-        return 8191;
-      case 13:
-        return 16931;
-      case 14:
-        return 32467;
-      case 15:
-        return 65449;
-      case 16:
-        return 125149;
-      case 17:
-        return 255329;
-      case 18:
-        return 255329;
-      case 19:
-        return 512747;
-      case 20:
-        return 512747;
-      case 21:
-        return 1045151;
-      case 22:
-        return 2013751;
-      case 23:
-        return 4002839;
-      case 24:
-        return 4002839;
-      case 25:
-        return 8008549;
-      case 26:
-        return 16007441;
-      case 27:
-        return 32007299;
-      case 28:
-        return 64010267;
-      case 29:
-        return 128010517;
-      default:
-        return -1;
+    void eraseAt(int64_t index) {
+      mem::destruct(m_pSlots + index);
+      --m_size;
+
+      // If the slot was never part of a full group, no probe sequence can have
+      // passed over it, so it can go straight back to empty without a tombstone.
+      uint64_t const mask        = m_slotCount - 1;
+      uint32_t const emptyAfter  = impl::MapGroup(m_pCtrl + index).matchEmpty();
+      uint32_t const emptyBefore = impl::MapGroup(m_pCtrl + ((index - GroupWidth) & mask)).matchEmpty();
+      bool const     wasNeverFull =
+        emptyBefore != 0 && emptyAfter != 0
+        && impl::countTrailingZeros(emptyAfter) + impl::countLeadingZeros16(emptyBefore) < GroupWidth;
+
+      if (wasNeverFull) {
+        setCtrl(index, impl::MapCtrl_Empty);
+        ++m_growthLeft;
+      } else {
+        setCtrl(index, impl::MapCtrl_Deleted);
       }
     }
 
-    Vector<Bucket> m_buckets;
-    int64_t m_bucketOrder = 0;
-    int64_t m_size = 0;
+    void setCtrl(int64_t index, Ctrl ctrl) {
+      m_pCtrl[index] = ctrl;
+      // The first GroupWidth - 1 bytes are mirrored past the end of the table
+      // so a group can be loaded from any slot without wrapping.
+      if (index < GroupWidth - 1)
+        m_pCtrl[m_slotCount + index] = ctrl;
+    }
+
+    void rehashForInsert() {
+      if (m_slotCount > 0 && m_size <= growthLimit(m_slotCount) / 2) {
+        // Mostly tombstones. Reclaim them without growing the table.
+        dropDeletes();
+      } else {
+        resize(m_slotCount == 0 ? GroupWidth : m_slotCount * 2);
+      }
+    }
+
+    /// Move all items into a table with `slotCount` slots.
+    /// Items are placed directly into their new slots without any key comparisons.
+    void resize(int64_t slotCount) {
+      Ctrl *  pOldCtrl      = m_pCtrl;
+      Item *  pOldSlots     = m_pSlots;
+      int64_t oldSlotCount  = m_slotCount;
+      int64_t size          = m_size;
+
+      allocate(slotCount);
+      for (int64_t i = 0; i < oldSlotCount; ++i) {
+        if (!isFull(pOldCtrl[i]))
+          continue;
+
+        uint64_t hashCode = hashOf(pOldSlots[i].first);
+        int64_t  index    = findFirstNonFull(hashCode);
+        setCtrl(index, h2(hashCode));
+        mem::moveConstruct(m_pSlots + index, pOldSlots + i, 1);
+        mem::destruct(pOldSlots + i);
+      }
+
+      m_size       = size;
+      m_growthLeft = growthLimit(m_slotCount) - m_size;
+
+      mem::free(pOldCtrl);
+      mem::free(pOldSlots);
+    }
+
+    /// Rehash in place, converting all tombstones back to empty slots.
+    void dropDeletes() {
+      uint64_t const mask = m_slotCount - 1;
+
+      // Mark full slots as deleted (pending) and deleted slots as empty.
+      for (int64_t i = 0; i < m_slotCount; ++i)
+        m_pCtrl[i] = isFull(m_pCtrl[i]) ? impl::MapCtrl_Deleted : impl::MapCtrl_Empty;
+      memcpy(m_pCtrl + m_slotCount, m_pCtrl, GroupWidth - 1);
+
+      for (int64_t i = 0; i < m_slotCount; ++i) {
+        if (m_pCtrl[i] != impl::MapCtrl_Deleted)
+          continue;
+
+        uint64_t hashCode = hashOf(m_pSlots[i].first);
+        int64_t  target   = findFirstNonFull(hashCode);
+        uint64_t probeStart = h1(hashCode) & mask;
+        auto     probeIndex = [=](int64_t pos) { return ((pos - probeStart) & mask) / GroupWidth; };
+
+        if (probeIndex(target) == probeIndex(i)) {
+          // Already in the best group it can be in.
+          setCtrl(i, h2(hashCode));
+        } else if (m_pCtrl[target] == impl::MapCtrl_Empty) {
+          setCtrl(target, h2(hashCode));
+          mem::moveConstruct(m_pSlots + target, m_pSlots + i, 1);
+          mem::destruct(m_pSlots + i);
+          setCtrl(i, impl::MapCtrl_Empty);
+        } else {
+          // Target holds another pending item. Swap and reprocess this slot.
+          setCtrl(target, h2(hashCode));
+          std::swap(m_pSlots[i], m_pSlots[target]);
+          --i;
+        }
+      }
+
+      m_growthLeft = growthLimit(m_slotCount) - m_size;
+    }
+
+    void allocate(int64_t slotCount) {
+      m_pCtrl      = mem::alloc<Ctrl>(slotCount + GroupWidth);
+      m_pSlots     = mem::alloc<Item>(slotCount);
+      m_slotCount  = slotCount;
+      m_size       = 0;
+      m_growthLeft = growthLimit(slotCount);
+      memset(m_pCtrl, (uint8_t)impl::MapCtrl_Empty, slotCount + GroupWidth);
+    }
+
+    void release() {
+      clear();
+      mem::free(m_pCtrl);
+      mem::free(m_pSlots);
+      m_pCtrl      = nullptr;
+      m_pSlots     = nullptr;
+      m_slotCount  = 0;
+      m_growthLeft = 0;
+    }
+
+    void swap(Map & o) {
+      std::swap(m_pCtrl, o.m_pCtrl);
+      std::swap(m_pSlots, o.m_pSlots);
+      std::swap(m_slotCount, o.m_slotCount);
+      std::swap(m_size, o.m_size);
+      std::swap(m_growthLeft, o.m_growthLeft);
+    }
+
+    Ctrl *  m_pCtrl      = nullptr;
+    Item *  m_pSlots     = nullptr;
+    int64_t m_slotCount  = 0;
+    int64_t m_size       = 0;
+    int64_t m_growthLeft = 0;
   };
 
   template<typename Key, typename Value>
   int64_t write(Stream * pStream, Map<Key, Value> const * pValue, int64_t count) {
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->write(pValue[i].m_buckets) && pStream->write(pValue[i].m_size) && pStream->write(pValue[i].m_bucketOrder))) {
+      if (!(pStream->write(impl::MapSerializeTag) && pStream->write(impl::MapSerializeVersion) && pStream->write(pValue[i].m_size))) {
         return i;
       }
+
+      for (auto const & item : pValue[i]) {
+        if (!pStream->write(item)) {
+          return i;
+        }
+      }
     }
     return count;
   }
 
   template<typename Key, typename Value>
   int64_t read(Stream * pStream, Map<Key, Value> * pValue, int64_t count) {
+    using Item = typename Map<Key, Value>::Item;
+
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->read(&pValue[i].m_buckets) && pStream->read(&pValue[i].m_size) && pStream->read(&pValue[i].m_bucketOrder))) {
+      int64_t tag = 0;
+      if (!pStream->read(&tag)) {
         return i;
       }
+
+      if (tag != impl::MapSerializeTag) {
+        // Version 1 wrote the bucket array, then the size and bucket order.
+        int64_t const bucketCount = tag;
+        if (bucketCount < 0) {
+          return i;
+        }
+
+        mem::construct(pValue + i);
+        for (int64_t b = 0; b < bucketCount; ++b) {
+          Vector<Item> bucket;
+          if (!pStream->read(&bucket)) {
+            return i;
+          }
+
+          for (Item & item : bucket)
+            pValue[i].addOrSet(item.first, item.second);
+        }
+
+        int64_t size        = 0;
+        int64_t bucketOrder = 0;
+        if (!(pStream->read(&size) && pStream->read(&bucketOrder))) {
+          return i;
+        }
+        continue;
+      }
+
+      int64_t version = 0;
+      int64_t size    = 0;
+      if (!(pStream->read(&version) && version == impl::MapSerializeVersion && pStream->read(&size))) {
+        return i;
+      }
+
+      mem::construct(pValue + i, size);
+      for (int64_t j = 0; j < size; ++j) {
+        alignas(Item) uint8_t buffer[sizeof(Item)];
+        Item *                pItem = (Item *)buffer;
+        if (pStream->read(pItem) != 1) {
+          return i;
+        }
+
+        pValue[i].insertUnique(Map<Key, Value>::hashOf(pItem->first), std::move(*pItem));
+        mem::destruct(pItem);
+      }
     }
     return count;
   }
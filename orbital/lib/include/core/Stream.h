@@ -101,6 +101,14 @@ namespace bfc {
       return -1;
     }
 
+    /// Get the contents of the stream, if they can be addressed directly in memory.
+    /// Consumers can use this to parse a stream in place instead of copying it with read().
+    /// @returns A pointer to the start of the stream. There are length() bytes available.
+    /// @retval nullptr The stream contents are not in memory.
+    virtual uint8_t const * data() const {
+      return nullptr;
+    }
+
     template<typename T>
     bool write(T const & value) {
       return ::bfc::write(this, &value, 1) == 1;
@@ -136,6 +144,9 @@ namespace bfc {
     virtual int64_t write(void const * data, int64_t length) override;
     virtual int64_t read(void * data, int64_t length) override;
 
+    virtual int64_t         length() const override;
+    virtual uint8_t const * data() const override;
+
     const Vector<uint8_t> & storage() const;
 
     void clear();
@@ -161,6 +172,9 @@ namespace bfc {
 
     virtual int64_t read(void * data, int64_t length) override;
 
+    virtual int64_t         length() const override;
+    virtual uint8_t const * data() const override;
+
   private:
     int64_t       m_streamPos = 0;
     Span<uint8_t> m_data;
@@ -0,0 +1,535 @@
+#pragma once
+
+#include "../core/Span.h"
+#include "../core/Vector.h"
+#include "../util/ThreadPool.h"
+#include "Geometry.h"
+
+#include <algorithm>
+
+namespace bfc {
+  namespace geometry {
+    /// A bounding volume hierarchy of axis aligned boxes.
+    /// Each leaf stores a single item, identified by a proxy ID that is stable until
+    /// the item is removed. A hierarchy can be built from a set of boxes using the
+    /// surface area heuristic, and then maintained incrementally using insert(),
+    /// remove() and update() as items are added or moved.
+    template<typename T>
+    class BVH {
+    public:
+      /// Number of bins used to evaluate split candidates when building.
+      static constexpr int64_t BinCount = 16;
+
+      /// Subtrees with fewer items than this are not built in parallel.
+      static constexpr int64_t ParallelBuildThreshold = 4096;
+
+      /// Build the hierarchy from scratch, replacing any existing items.
+      /// The item at index `i` is assigned the value `i`.
+      /// @param pProxies If not null, receives the proxy ID of each item.
+      /// @param pThreads If not null, large subtrees are built in parallel using this pool.
+      void build(Span<Box<T> const> const & bounds, Vector<int64_t> * pProxies = nullptr, ThreadPool * pThreads = nullptr) {
+        clear();
+
+        const int64_t count = bounds.size();
+        if (pProxies != nullptr) {
+          pProxies->resize(count, npos);
+        }
+
+        if (count == 0) {
+          return;
+        }
+
+        Vector<BuildItem> items;
+        items.reserve(count);
+        for (int64_t i = 0; i < count; ++i) {
+          items.pushBack({bounds[i], bounds[i].center(), i});
+        }
+
+        // A binary tree with `count` leaves has exactly `2 * count - 1` nodes. Each subtree
+        // writes to a known range of nodes, so subtrees can be built independently.
+        m_nodes.resize(count * 2 - 1);
+        m_root  = 0;
+        m_count = count;
+
+        BuildContext ctx;
+        ctx.pItems   = items.data();
+        ctx.pProxies = pProxies != nullptr ? pProxies->data() : nullptr;
+
+        if (pThreads == nullptr || count < ParallelBuildThreshold) {
+          buildRange(&ctx, 0, npos, 0, count, nullptr);
+          return;
+        }
+
+        // Split the top of the tree on this thread, then build the subtrees in the pool.
+        Vector<BuildTask> tasks;
+        buildRange(&ctx, 0, npos, 0, count, &tasks);
+
+        Vector<std::future<void>> jobs;
+        for (BuildTask const & task : tasks) {
+          jobs.pushBack(pThreads->run([this, &ctx, task]() { buildRange(&ctx, task.node, task.parent, task.begin, task.end, nullptr); }));
+        }
+
+        for (auto & job : jobs) {
+          job.wait();
+        }
+      }
+
+      /// Add an item to the hierarchy.
+      /// @returns The proxy ID of the item.
+      int64_t insert(Box<T> const & bounds, int64_t value) {
+        int64_t leaf = allocNode();
+        Node &  node = m_nodes[leaf];
+        node.bounds  = bounds;
+        node.value   = value;
+        insertLeaf(leaf);
+        ++m_count;
+        return leaf;
+      }
+
+      /// Remove an item from the hierarchy.
+      bool remove(int64_t proxy) {
+        if (!isValidProxy(proxy)) {
+          return false;
+        }
+
+        removeLeaf(proxy);
+        freeNode(proxy);
+        --m_count;
+        return true;
+      }
+
+      /// Update the bounds of an item.
+      /// If the item is still contained by its parent the hierarchy is left as it is,
+      /// otherwise the item is reinserted so that the tree stays tight as objects move.
+      void update(int64_t proxy, Box<T> const & bounds) {
+        BFC_ASSERT(isValidProxy(proxy), "Invalid BVH proxy");
+
+        m_nodes[proxy].bounds = bounds;
+
+        int64_t parent = m_nodes[proxy].parent;
+        if (parent != npos && m_nodes[parent].bounds.contains(bounds)) {
+          return;
+        }
+
+        removeLeaf(proxy);
+        insertLeaf(proxy);
+      }
+
+      /// Recompute the bounds of all internal nodes from their children.
+      /// Use this to tighten the hierarchy after many items have moved.
+      void refit() {
+        if (m_root == npos) {
+          return;
+        }
+
+        // Post-order traversal. Each node is visited twice: once to push its children
+        // and once, after they are complete, to merge their bounds.
+        Vector<std::pair<int64_t, bool>> stack;
+        stack.pushBack({m_root, false});
+        while (stack.size() > 0) {
+          auto [index, childrenDone] = stack.popBack();
+          Node & node = m_nodes[index];
+          if (node.isLeaf()) {
+            continue;
+          }
+
+          if (childrenDone) {
+            node.bounds = m_nodes[node.left].bounds;
+            node.bounds.growToContain(m_nodes[node.right].bounds);
+          } else {
+            stack.pushBack({index, true});
+            stack.pushBack({node.left, false});
+            stack.pushBack({node.right, false});
+          }
+        }
+      }
+
+      /// Remove all items from the hierarchy.
+      void clear() {
+        m_nodes.clear();
+        m_freeNodes.clear();
+        m_root  = npos;
+        m_count = 0;
+      }
+
+      /// Get the number of items in the hierarchy.
+      int64_t size() const {
+        return m_count;
+      }
+
+      bool empty() const {
+        return m_count == 0;
+      }
+
+      /// Get the bounds of the entire hierarchy.
+      Box<T> bounds() const {
+        return m_root == npos ? Box<T>() : m_nodes[m_root].bounds;
+      }
+
+      /// Get the bounds of an item.
+      Box<T> const & bounds(int64_t proxy) const {
+        return m_nodes[proxy].bounds;
+      }
+
+      /// Get the value of an item.
+      int64_t value(int64_t proxy) const {
+        return m_nodes[proxy].value;
+      }
+
+      /// Get the depth of the deepest leaf.
+      int64_t depth() const {
+        int64_t                             maxDepth = 0;
+        Vector<std::pair<int64_t, int64_t>> stack;
+        if (m_root != npos) {
+          stack.pushBack({m_root, 1});
+        }
+
+        while (stack.size() > 0) {
+          auto [index, nodeDepth] = stack.popBack();
+          maxDepth = math::max(maxDepth, nodeDepth);
+          if (!m_nodes[index].isLeaf()) {
+            stack.pushBack({m_nodes[index].left, nodeDepth + 1});
+            stack.pushBack({m_nodes[index].right, nodeDepth + 1});
+          }
+        }
+
+        return maxDepth;
+      }
+
+      /// Call `callback(value)` for each item whose bounds intersect `volume`.
+      /// `volume` can be a Frustum, Sphere or Box.
+      template<typename Volume, typename Callback>
+      void query(Volume const & volume, Callback && callback) const {
+        traverse([&](Box<T> const & bounds) { return overlaps(volume, bounds); }, callback);
+      }
+
+      /// Visit the hierarchy, descending into nodes for which `overlaps(bounds)` returns true.
+      /// `callback(value)` is called for each overlapping item.
+      template<typename Overlaps, typename Callback>
+      void traverse(Overlaps && overlaps, Callback && callback) const {
+        if (m_root == npos) {
+          return;
+        }
+
+        Vector<int64_t> stack;
+        stack.reserve(64);
+        stack.pushBack(m_root);
+        while (stack.size() > 0) {
+          Node const & node = m_nodes[stack.popBack()];
+          if (!overlaps(node.bounds)) {
+            continue;
+          }
+
+          if (node.isLeaf()) {
+            callback(node.value);
+          } else {
+            stack.pushBack(node.right);
+            stack.pushBack(node.left);
+          }
+        }
+      }
+
+      static bool overlaps(Frustum<T> const & frustum, Box<T> const & bounds) {
+        return intersects(frustum, bounds);
+      }
+
+      static bool overlaps(Sphere<T> const & sphere, Box<T> const & bounds) {
+        return intersects(bounds, sphere);
+      }
+
+      static bool overlaps(Box<T> const & box, Box<T> const & bounds) {
+        return box.overlaps(bounds);
+      }
+
+    private:
+      struct Node {
+        Box<T>  bounds;
+        int64_t parent = npos;
+        int64_t left   = npos; ///< First child. `npos` for leaf nodes.
+        int64_t right  = npos; ///< Second child. `npos` for leaf nodes.
+        int64_t value  = npos; ///< User value for leaf nodes.
+
+        bool isLeaf() const {
+          return left == npos;
+        }
+      };
+
+      struct BuildItem {
+        Box<T>     bounds;
+        Vector3<T> centroid;
+        int64_t    index;
+      };
+
+      struct BuildContext {
+        BuildItem * pItems   = nullptr;
+        int64_t *   pProxies = nullptr;
+      };
+
+      /// A subtree deferred to the thread pool.
+      struct BuildTask {
+        int64_t node;
+        int64_t parent;
+        int64_t begin;
+        int64_t end;
+      };
+
+      static T surfaceArea(Box<T> const & box) {
+        Vector3<T> size = box.size();
+        if (size.x < 0 || size.y < 0 || size.z < 0) {
+          return T(0);
+        }
+
+        return T(2) * (size.x * size.y + size.y * size.z + size.z * size.x);
+      }
+
+      static Box<T> merge(Box<T> a, Box<T> const & b) {
+        a.growToContain(b);
+        return a;
+      }
+
+      /// Build the subtree over items [begin, end) into the nodes starting at `nodeIndex`.
+      /// If `pTasks` is not null, large subtrees are appended to it instead of being built.
+      void buildRange(BuildContext * pCtx, int64_t nodeIndex, int64_t parent, int64_t begin, int64_t end, Vector<BuildTask> * pTasks) {
+        BuildItem * pItems = pCtx->pItems;
+        Node &      node   = m_nodes[nodeIndex];
+        node.parent        = parent;
+
+        const int64_t count = end - begin;
+        if (count == 1) {
+          node.bounds = pItems[begin].bounds;
+          node.value  = pItems[begin].index;
+          node.left   = npos;
+          node.right  = npos;
+          if (pCtx->pProxies != nullptr) {
+            pCtx->pProxies[pItems[begin].index] = nodeIndex;
+          }
+          return;
+        }
+
+        Box<T> bounds;
+        Box<T> centroidBounds;
+        for (int64_t i = begin; i < end; ++i) {
+          bounds.growToContain(pItems[i].bounds);
+          centroidBounds.growToContain(pItems[i].centroid);
+        }
+
+        node.bounds = bounds;
+        node.value  = npos;
+
+        const int64_t mid = partition(pItems, begin, end, centroidBounds);
+
+        // Left subtree occupies the next `2 * leftCount - 1` nodes, the right subtree follows.
+        const int64_t leftNode  = nodeIndex + 1;
+        const int64_t rightNode = nodeIndex + 2 * (mid - begin);
+        node.left               = leftNode;
+        node.right              = rightNode;
+
+        if (pTasks != nullptr) {
+          if (mid - begin >= ParallelBuildThreshold) {
+            buildRange(pCtx, leftNode, nodeIndex, begin, mid, pTasks);
+          } else {
+            pTasks->pushBack({leftNode, nodeIndex, begin, mid});
+          }
+
+          if (end - mid >= ParallelBuildThreshold) {
+            buildRange(pCtx, rightNode, nodeIndex, mid, end, pTasks);
+          } else {
+            pTasks->pushBack({rightNode, nodeIndex, mid, end});
+          }
+        } else {
+          buildRange(pCtx, leftNode, nodeIndex, begin, mid, nullptr);
+          buildRange(pCtx, rightNode, nodeIndex, mid, end, nullptr);
+        }
+      }
+
+      /// Partition items [begin, end) using a binned surface area heuristic.
+      /// @returns The index of the first item in the right partition.
+      static int64_t partition(BuildItem * pItems, int64_t begin, int64_t end, Box<T> const & centroidBounds) {
+        Vector3<T> extent = centroidBounds.size();
+        int        axis   = 0;
+        if (extent.y > extent[axis])
+          axis = 1;
+        if (extent.z > extent[axis])
+          axis = 2;
+
+        const int64_t median = begin + (end - begin) / 2;
+        if (!(extent[axis] > T(0))) {
+          return median; // All centroids coincide. Any split is as good as another.
+        }
+
+        struct Bin {
+          Box<T>  bounds;
+          int64_t count = 0;
+        } bins[BinCount];
+
+        const T minCentroid = centroidBounds.min[axis];
+        const T binScale    = T(BinCount) / extent[axis];
+        auto    binOf       = [=](BuildItem const & item) {
+          return math::min(BinCount - 1, (int64_t)((item.centroid[axis] - minCentroid) * binScale));
+        };
+
+        for (int64_t i = begin; i < end; ++i) {
+          Bin & bin = bins[binOf(pItems[i])];
+          bin.bounds.growToContain(pItems[i].bounds);
+          ++bin.count;
+        }
+
+        // Sweep from the right to accumulate the cost of each right partition.
+        T       rightCost[BinCount - 1];
+        Box<T>  rightBounds;
+        int64_t rightCount = 0;
+        for (int64_t i = BinCount - 1; i > 0; --i) {
+          rightBounds.growToContain(bins[i].bounds);
+          rightCount += bins[i].count;
+          rightCost[i - 1] = surfaceArea(rightBounds) * T(rightCount);
+        }
+
+        T       bestCost  = std::numeric_limits<T>::max();
+        int64_t bestSplit = npos;
+        Box<T>  leftBounds;
+        int64_t leftCount = 0;
+        for (int64_t i = 0; i < BinCount - 1; ++i) {
+          leftBounds.growToContain(bins[i].bounds);
+          leftCount += bins[i].count;
+          if (leftCount == 0 || leftCount == end - begin) {
+            continue;
+          }
+
+          T cost = surfaceArea(leftBounds) * T(leftCount) + rightCost[i];
+          if (cost < bestCost) {
+            bestCost  = cost;
+            bestSplit = i;
+          }
+        }
+
+        if (bestSplit == npos) {
+          std::nth_element(pItems + begin, pItems + median, pItems + end,
+                           [=](BuildItem const & a, BuildItem const & b) { return a.centroid[axis] < b.centroid[axis]; });
+          return median;
+        }
+
+        BuildItem * pMid = std::partition(pItems + begin, pItems + end, [&](BuildItem const & item) { return binOf(item) <= bestSplit; });
+        return pMid - pItems;
+      }
+
+      /// Link a detached leaf into the tree, next to the sibling that minimises the increase in surface area.
+      void insertLeaf(int64_t leaf) {
+        m_nodes[leaf].parent = npos;
+        if (m_root == npos) {
+          m_root = leaf;
+          return;
+        }
+
+        Box<T> const bounds  = m_nodes[leaf].bounds;
+        int64_t      sibling = m_root;
+        while (!m_nodes[sibling].isLeaf()) {
+          Node const & node     = m_nodes[sibling];
+          T            area     = surfaceArea(node.bounds);
+          T            combined = surfaceArea(merge(node.bounds, bounds));
+
+          // Cost of creating a new parent for this node and the leaf.
+          T cost = T(2) * combined;
+          // Minimum cost of pushing the leaf further down the tree.
+          T inheritance = T(2) * (combined - area);
+
+          auto descendCost = [&](int64_t child) {
+            Node const & c    = m_nodes[child];
+            T            cost = surfaceArea(merge(c.bounds, bounds)) + inheritance;
+            return c.isLeaf() ? cost : cost - surfaceArea(c.bounds);
+          };
+
+          T leftCost  = descendCost(node.left);
+          T rightCost = descendCost(node.right);
+          if (cost < leftCost && cost < rightCost) {
+            break;
+          }
+
+          sibling = leftCost < rightCost ? node.left : node.right;
+        }
+
+        int64_t oldParent = m_nodes[sibling].parent;
+        int64_t newParent = allocNode();
+
+        Node & parent = m_nodes[newParent];
+        parent.parent = oldParent;
+        parent.bounds = merge(m_nodes[sibling].bounds, bounds);
+        parent.left   = sibling;
+        parent.right  = leaf;
+        parent.value  = npos;
+
+        m_nodes[sibling].parent = newParent;
+        m_nodes[leaf].parent    = newParent;
+
+        if (oldParent == npos) {
+          m_root = newParent;
+        } else {
+          Node & grandParent = m_nodes[oldParent];
+          (grandParent.left == sibling ? grandParent.left : grandParent.right) = newParent;
+          refitAncestors(oldParent);
+        }
+      }
+
+      /// Unlink a leaf from the tree. The leaf node itself is not freed.
+      void removeLeaf(int64_t leaf) {
+        if (leaf == m_root) {
+          m_root = npos;
+          return;
+        }
+
+        int64_t parent      = m_nodes[leaf].parent;
+        int64_t grandParent = m_nodes[parent].parent;
+        int64_t sibling     = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+        if (grandParent == npos) {
+          m_root                  = sibling;
+          m_nodes[sibling].parent = npos;
+        } else {
+          Node & node = m_nodes[grandParent];
+          (node.left == parent ? node.left : node.right) = sibling;
+          m_nodes[sibling].parent = grandParent;
+          refitAncestors(grandParent);
+        }
+
+        freeNode(parent);
+        m_nodes[leaf].parent = npos;
+      }
+
+      /// Recompute the bounds of `index` and its ancestors.
+      void refitAncestors(int64_t index) {
+        while (index != npos) {
+          Node & node = m_nodes[index];
+          node.bounds = merge(m_nodes[node.left].bounds, m_nodes[node.right].bounds);
+          index       = node.parent;
+        }
+      }
+
+      bool isValidProxy(int64_t proxy) const {
+        return proxy >= 0 && proxy < m_nodes.size() && m_nodes[proxy].isLeaf() && m_nodes[proxy].value != npos;
+      }
+
+      int64_t allocNode() {
+        if (m_freeNodes.size() > 0) {
+          int64_t index  = m_freeNodes.popBack();
+          m_nodes[index] = Node();
+          return index;
+        }
+
+        m_nodes.pushBack(Node());
+        return m_nodes.size() - 1;
+      }
+
+      void freeNode(int64_t index) {
+        m_nodes[index] = Node();
+        m_freeNodes.pushBack(index);
+      }
+
+      Vector<Node>    m_nodes;
+      Vector<int64_t> m_freeNodes;
+      int64_t         m_root  = npos;
+      int64_t         m_count = 0;
+    };
+
+    using BVHf = BVH<float>;
+    using BVHd = BVH<double>;
+  } // namespace geometry
+} // namespace bfc
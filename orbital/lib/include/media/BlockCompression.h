@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Surface.h"
+
+namespace bfc {
+  class ThreadPool;
+
+  namespace media {
+    /// Trade off between encoding speed and quality.
+    enum BlockCompressionQuality {
+      BlockCompressionQuality_Fast,   ///< Endpoints are fit to the principal axis of each block.
+      BlockCompressionQuality_Normal, ///< Endpoints are refined with a least squares fit. BC7 encodes alpha separately where it helps.
+      BlockCompressionQuality_High,   ///< Endpoints are searched around the fit. BC7 also tries 2 subset partitions for opaque blocks.
+    };
+
+    struct BlockCompressionOptions {
+      BlockCompressionQuality quality = BlockCompressionQuality_Normal;
+
+      /// If not null, rows of blocks are compressed in bands on this pool.
+      ThreadPool * pThreads = nullptr;
+    };
+
+    /// Difference between two surfaces in 8-bit units.
+    struct SurfaceError {
+      double rmse = 0;
+      double psnr = 0; ///< Peak signal to noise ratio in decibels. Infinite if the surfaces are equal.
+    };
+
+    /// Compress `src` to the block compressed format of `pDst`.
+    /// `src` is converted to RGBAu8 first if needed. If `pDst` has no buffer, one is allocated.
+    /// Partial blocks at the edges are padded by repeating the last row and column.
+    /// If `pError` is not null, it receives the error of the compressed pixels, over the channels
+    /// stored by the format.
+    /// @returns false if `pDst` is not a block compressed format, or `src` has no pixels.
+    BFC_API bool compressSurface(Surface * pDst, Surface const & src, BlockCompressionOptions const & options = {}, SurfaceError * pError = nullptr);
+
+    /// Decompress the block compressed `src` to the format of `pDst`.
+    /// If `pDst` has no buffer, one is allocated. Its size must match `src`.
+    /// @returns false if `src` is not block compressed.
+    BFC_API bool decompressSurface(Surface * pDst, Surface const & src, ThreadPool * pThreads = nullptr);
+
+    /// Measure the error of `surface` compared to `reference`.
+    /// Only the channels stored by the format of `surface` are compared. Surfaces must be the same size.
+    BFC_API SurfaceError measureSurfaceError(Surface const & reference, Surface const & surface);
+  } // namespace media
+} // namespace bfc
@@ -18,4 +18,19 @@ namespace bfc {
     }
     return 0;
   }
+
+  bool isBlockCompressed(PixelFormat const & format) {
+    return getPixelFormatBlockSize(format) != 0;
+  }
+
+  int64_t getPixelFormatBlockSize(PixelFormat const & format) {
+    switch (format) {
+    case PixelFormat_BC1: return 8;
+    case PixelFormat_BC3: return 16;
+    case PixelFormat_BC4: return 8;
+    case PixelFormat_BC5: return 16;
+    case PixelFormat_BC7: return 16;
+    }
+    return 0;
+  }
 } // namespace bfc
@@ -43,11 +43,25 @@ namespace bfc {
     // 64-bit floating point formats
     PixelFormat_RGBAf64,
 
+    // Block compressed formats. Pixels are stored in blocks of 4x4.
+    PixelFormat_BC1, ///< RGB with 1-bit alpha. 8 bytes per block.
+    PixelFormat_BC3, ///< RGBA. BC1 colour with a BC4 alpha channel. 16 bytes per block.
+    PixelFormat_BC4, ///< R. 8 bytes per block.
+    PixelFormat_BC5, ///< RG. Two BC4 channels. 16 bytes per block.
+    PixelFormat_BC7, ///< RGBA. Variable per-block modes. 16 bytes per block.
+
     PixelFormat_Count,
   };
 
+  /// Get the size of a pixel in bytes. Returns 0 for block compressed formats.
   BFC_API int64_t getPixelFormatStride(PixelFormat const & format);
 
+  /// Test if `format` stores pixels in compressed 4x4 blocks.
+  BFC_API bool isBlockCompressed(PixelFormat const & format);
+
+  /// Get the size of a 4x4 block in bytes. Returns 0 if `format` is not block compressed.
+  BFC_API int64_t getPixelFormatBlockSize(PixelFormat const & format);
+
   struct RGBAu8 {
     static constexpr PixelFormat FormatID = PixelFormat_RGBAu8;
 
@@ -349,6 +363,11 @@ namespace bfc {
        { PixelFormat_RGBf32, "fgb-f32" },
        { PixelFormat_Rf32, "r-f32" },
        { PixelFormat_RGBAf64, "rgba-f64" },
+       { PixelFormat_BC1, "bc1" },
+       { PixelFormat_BC3, "bc3" },
+       { PixelFormat_BC4, "bc4" },
+       { PixelFormat_BC5, "bc5" },
+       { PixelFormat_BC7, "bc7" },
     };
   };
 } // namespace bfc
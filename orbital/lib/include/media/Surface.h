@@ -9,8 +9,11 @@
 
 namespace bfc {
   class Stream;
+  class ThreadPool;
 
   namespace media {
+    /// A buffer of pixels.
+    /// For block compressed formats, `pitch` is the size of a row of blocks rather than a row of pixels.
     class BFC_API Surface {
     public:
       void *      pBuffer = nullptr;
@@ -41,93 +44,101 @@ namespace bfc {
 
     BFC_API int64_t getSurfacePitch(Surface const & surface);
 
+    /// Get the number of rows in a slice of `surface`.
+    /// This is the number of rows of blocks for block compressed formats, otherwise the height.
+    BFC_API int64_t getSurfaceRowCount(Surface const & surface);
+
     inline int64_t calculatePixelOffset(Vec3i pos, Vec3i size, int64_t stride, int64_t pitch) {
       return pos.x * stride + (pos.y + pos.z * size.y) * pitch;
     }
 
+    /// Filters used when a surface is converted to a different size.
+    enum ResampleFilter {
+      ResampleFilter_Nearest,  ///< Use the closest source pixel. Aliases when the surface is minified.
+      ResampleFilter_Box,      ///< Average the source pixels covered by each destination pixel.
+      ResampleFilter_Bilinear, ///< Tent filter. Widened when minifying, so every source pixel contributes.
+      ResampleFilter_Lanczos,  ///< Windowed sinc with 3 lobes. Sharpest, but can ring around hard edges.
+      ResampleFilter_Kaiser,   ///< Sinc with a Kaiser window. Sharp, with less ringing than Lanczos.
+    };
+
+    /// Encoding of the colour channels of a surface. Alpha is always linear.
+    enum ColourSpace {
+      ColourSpace_Linear,
+      ColourSpace_SRGB,
+    };
+
+    struct ConvertSurfaceOptions {
+      ResampleFilter filter   = ResampleFilter_Bilinear;
+      ColourSpace    srcSpace = ColourSpace_Linear;
+      ColourSpace    dstSpace = ColourSpace_Linear;
+
+      /// If not null, rows are converted in bands on this pool.
+      ThreadPool * pThreads = nullptr;
+    };
+
+    /// Convert `src` to the format and size of `pDst`.
+    /// If `pDst` has no buffer, one is allocated. Rows are converted with vectorized kernels where the
+    /// CPU supports them. Surfaces of a different size are resampled with a separable filter in the
+    /// X and Y axes. Depth slices are not filtered, as they are often unrelated images, such as the
+    /// faces of a cube map. Block compressed surfaces are converted through RGBAu8.
+    BFC_API void convertSurface(Surface * pDst, Surface const & src, ConvertSurfaceOptions const & options);
+
+    BFC_API void convertSurface(Surface * pDst, Surface const & src);
+
+    struct MipChainOptions {
+      ResampleFilter filter = ResampleFilter_Box;
+
+      /// Encoding of the colour channels. sRGB surfaces are filtered in linear space.
+      ColourSpace space = ColourSpace_Linear;
+
+      /// If greater than 0, alpha is scaled in each level so the fraction of pixels with an alpha of at
+      /// least this value matches the base level. Keeps alpha tested cutouts from thinning out in the distance.
+      float alphaCoverageThreshold = 0;
+
+      /// Treat RGB as normals packed in [0, 1] and renormalize each level.
+      bool normalMap = false;
+
+      /// If not null, each level is filtered in bands on this pool.
+      ThreadPool * pThreads = nullptr;
+    };
+
+    /// Get the number of levels in a full mip chain for a surface of `size`, including the base level.
+    BFC_API int64_t calculateMipCount(Vec3i const & size);
+
+    /// Generate the mip levels below `base`, down to 1x1, and append them to `pMips`.
+    /// Each level is half the size of the level above, rounded down, and has the format of `base`. Levels
+    /// are filtered from the level above with full precision, so odd sizes are filtered with fractional
+    /// weights. Depth slices are filtered separately. The caller owns the appended surfaces.
+    /// @returns the number of levels appended.
+    BFC_API int64_t generateMipChain(Vector<Surface> * pMips, Surface const & base, MipChainOptions const & options = {});
+
     template<typename DstFormat, typename SrcFormat = DstFormat>
     void convertSurface(void ** ppDst, void const * pSrc, Vec3i dstSize, Vec3i srcSize, int64_t dstPitch = 0, int64_t srcPitch = 0) {
-      using DstT = Colour<DstFormat>;
-      using SrcT = Colour<SrcFormat>;
-
-      // Ensure pitch is correct
-      if (dstPitch == 0)
-        dstPitch = dstSize.x * sizeof(DstT);
-      if (srcPitch == 0)
-        srcPitch = srcSize.x * sizeof(SrcT);
-
-      // Allocate a destination buffer if none is provided
-      if (*ppDst == nullptr)
-        *ppDst = mem::alloc(dstPitch * dstSize.y * std::max(dstSize.z, 1));
-
-      if (dstSize != srcSize) {
-        // Different size. Re-sample surface regardless of format.
-        DstT *       pDstRow  = (DstT *)*ppDst;
-        SrcT const * pSrcPtr  = (SrcT const *)pSrc;
-        Vec3i        coord    = { 0, 0, 0 };
-        Vec3         srcRatio = Vec3(srcSize) / Vec3(dstSize);
-        for (coord.z = 0; coord.z < dstSize.z; ++coord.z) {
-          for (coord.y = 0; coord.y < dstSize.y; ++coord.y) {
-            for (coord.x = 0; coord.x < dstSize.x; ++coord.x) {
-              int64_t srcOffset = calculatePixelOffset(Vec3i(Vec3(coord) * srcRatio), srcSize, sizeof(SrcT), srcPitch);
-
-              pDstRow[coord.x] = *(SrcT const *)(((uint8_t const *)pSrcPtr) + srcOffset);
-            }
-
-            pDstRow = (DstT *)(((uint8_t *)pDstRow) + dstPitch);
-          }
-        }
-      } else {
-        // Same size.
-        if constexpr (std::is_same_v<DstT, SrcT>) {
-          if (dstPitch == srcPitch && dstSize == srcSize) {
-            // Same format, same pitch. Copy entire buffer.
-            memcpy(*ppDst, pSrc, dstPitch * srcSize.y * std::max(srcSize.z, 1));
-          } else { // Copy row by row
-            // Same format, different pitch. Copy row by row.
-            DstT *       pDstRow = (DstT *)*ppDst;
-            SrcT const * pSrcRow = (SrcT const *)pSrc;
-            for (int64_t z = 0; z < dstSize.z; ++z) {
-              for (int64_t y = 0; y < dstSize.y; ++y) {
-                for (int64_t x = 0; x < dstSize.x; ++x)
-                  memcpy(pDstRow, pSrcRow, srcPitch);
-                pDstRow = (DstT *)(((uint8_t *)pDstRow) + dstPitch);
-                pSrcRow = (SrcT *)(((uint8_t *)pSrcRow) + srcPitch);
-              }
-            }
-          }
-        } else {
-          // Different format. Re-sample surface.
-          DstT *       pDstRow = (DstT *)*ppDst;
-          SrcT const * pSrcRow = (SrcT const *)pSrc;
-          for (int64_t z = 0; z < dstSize.z; ++z) {
-            for (int64_t y = 0; y < dstSize.y; ++y) {
-              for (int64_t x = 0; x < dstSize.x; ++x) {
-                pDstRow[x] = pSrcRow[x];
-              }
-
-              pDstRow = (DstT *)(((uint8_t *)pDstRow) + dstPitch);
-              pSrcRow = (SrcT *)(((uint8_t *)pSrcRow) + srcPitch);
-            }
-          }
-        }
-      }
+      Surface dst;
+      dst.pBuffer = *ppDst;
+      dst.format  = DstFormat::FormatID;
+      dst.size    = dstSize;
+      dst.pitch   = dstPitch;
+
+      Surface src;
+      src.pBuffer = (void *)pSrc;
+      src.format  = SrcFormat::FormatID;
+      src.size    = srcSize;
+      src.pitch   = srcPitch;
+
+      convertSurface(&dst, src);
+      *ppDst = dst.pBuffer;
     }
 
     template<typename SrcFormat>
     void convertSurface(Surface * pDst, void const * pSrc, Vec3i size, int64_t srcPitch = 0) {
-      switch (pDst->format) {
-      case PixelFormat_Lu8: convertSurface<Lu8, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_LAu8: convertSurface<LAu8, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_Ru8: convertSurface<Ru8, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_RGBu8: convertSurface<RGBu8, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_RGBAu8: convertSurface<RGBAu8, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_Rf32: convertSurface<Rf32, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      case PixelFormat_RGBAf32: convertSurface<RGBAf32, SrcFormat>(&pDst->pBuffer, pSrc, pDst->size, size, pDst->pitch, srcPitch); break;
-      }
+      Surface src;
+      src.pBuffer = (void *)pSrc;
+      src.format  = SrcFormat::FormatID;
+      src.size    = size;
+      src.pitch   = srcPitch;
+      convertSurface(pDst, src);
     }
-
-    BFC_API void convertSurface(Surface * pDst, Surface const & src);
   } // namespace media
 
   BFC_API int64_t write(Stream * pStream, media::Surface const * pValue, int64_t count);
@@ -2,12 +2,30 @@
 
 #include "../render/GraphicsDevice.h"
 #include "../mesh/MeshData.h"
+#include "../mesh/Meshlet.h"
 #include "../util/Iterators.h"
 #include "../geometry/Box.h"
 
 #include "../render/RendererCommon.h"
 
 namespace bfc {
+  /// Optimizations applied to mesh data when it is loaded.
+  enum MeshOptimizeFlags {
+    MeshOptimizeFlags_None        = 0,
+    MeshOptimizeFlags_Weld        = 1 << 0, ///< Merge vertices with identical attributes.
+    MeshOptimizeFlags_VertexCache = 1 << 1, ///< Reorder triangles in each sub-mesh for the post-transform vertex cache.
+    MeshOptimizeFlags_Overdraw    = 1 << 2, ///< Reorder triangle clusters in each sub-mesh to reduce overdraw.
+    MeshOptimizeFlags_VertexFetch = 1 << 3, ///< Reorder vertices in the order they are referenced.
+    MeshOptimizeFlags_Meshlets    = 1 << 4, ///< Split each sub-mesh into meshlets that can be culled individually.
+    MeshOptimizeFlags_All         = MeshOptimizeFlags_Weld | MeshOptimizeFlags_VertexCache | MeshOptimizeFlags_Overdraw | MeshOptimizeFlags_VertexFetch |
+                                    MeshOptimizeFlags_Meshlets,
+  };
+
+  template<>
+  struct enable_bitwise_operators<MeshOptimizeFlags> : std::true_type {};
+
+  class MeshBlob;
+
   class BFC_API Mesh {
   public:
     using Index = uint32_t;
@@ -24,21 +42,39 @@ namespace bfc {
       int64_t elmOffset;
       int64_t elmCount;
 
+      int64_t meshletOffset = 0; ///< First meshlet of the sub-mesh in getMeshlets().
+      int64_t meshletCount  = 0; ///< Number of meshlets in the sub-mesh. Only the full detail level has meshlets.
+
       geometry::Box<float> bounds;
     };
 
     Mesh() = default;
 
-    Mesh(graphics::CommandList * pCmdList, MeshData const & data);
+    Mesh(graphics::CommandList * pCmdList, MeshData const & data, MeshOptimizeFlags optimizeFlags = MeshOptimizeFlags_None);
 
     ~Mesh();
 
-    bool load(graphics::CommandList * pCmdList, MeshData const & data);
+    bool load(graphics::CommandList * pCmdList, MeshData const & data, MeshOptimizeFlags optimizeFlags = MeshOptimizeFlags_None);
+
+    /// Load GPU ready mesh data. The blob is referenced until the upload has completed.
+    bool load(graphics::CommandList * pCmdList, Ref<MeshBlob> const & pBlob);
 
     void release();
     
     SubMesh const& getSubMesh(int64_t index) const;
 
+    /// Get a sub-mesh at a level of detail. Level 0 is the full detail mesh.
+    SubMesh const& getSubMesh(int64_t index, int64_t lod) const;
+
+    /// Get the number of levels of detail, including the full detail mesh.
+    int64_t getLodCount() const;
+
+    /// Get the largest geometric error of a level of detail, in the units of the vertex positions.
+    float getLodError(int64_t lod) const;
+
+    /// Get the meshlets of a sub-mesh. Element offsets are relative to the start of the index buffer.
+    Span<const Meshlet> getMeshlets(int64_t subMeshIndex) const;
+
     Vector<SubMesh> const& getSubMeshes() const;
 
     int64_t getSubmeshCount() const;
@@ -54,6 +90,9 @@ namespace bfc {
   private:
     // Graphics resources for this mesh
     Vector<SubMesh> m_meshes;
+    Vector<SubMesh> m_lodMeshes; ///< Sub-meshes of the simplified levels, grouped by level.
+    Vector<float>   m_lodErrors;
+    Vector<Meshlet> m_meshlets;
     geometry::Boxf  m_bounds;
 
     graphics::BufferRef      m_vertexBuffer;
@@ -88,6 +127,10 @@ namespace bfc {
 
     graphics::TextureRef textures[TextureSlot_Count];
 
+    /// Incremented each time the textures are loaded, so renderers that keep copies of them can tell when to refresh.
+    /// Increment this after assigning textures directly.
+    uint64_t revision = 0;
+
     void load(graphics::CommandList * pDevice, MeshData::Material const & def);
     void load(graphics::CommandList * pDevice, MeshData::Material const & def, LoadTextureFunc textureLoader);
     void loadValues(MeshData::Material const & def);
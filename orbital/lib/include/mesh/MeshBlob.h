@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Mesh.h"
+
+namespace bfc {
+  /// GPU ready mesh data in a single block of memory.
+  /// The block starts with a Header, followed by the interleaved vertex buffer, the index buffer, the
+  /// sub-mesh table and the meshlets. Each section is aligned to 16 bytes, so a blob read from disk with
+  /// a single read can be uploaded to the device without converting it.
+  /// The header stores a format version and a checksum of the contents, so stale or corrupt blobs are rejected.
+  class BFC_API MeshBlob {
+  public:
+    constexpr static inline uint32_t Magic     = 0x424D4642; // "BFMB"
+    constexpr static inline uint32_t Version   = 2;
+    constexpr static inline int64_t  Alignment = 16;
+
+    struct Section {
+      int64_t offset = 0; ///< Offset of the section from the start of the blob, in bytes.
+      int64_t count  = 0; ///< Number of elements in the section.
+    };
+
+    struct Header {
+      uint32_t magic    = Magic;
+      uint32_t version  = Version;
+      uint64_t checksum = 0; ///< Low half of the hash128() of every byte following the header.
+      int64_t  size     = 0; ///< Size of the blob, including the header.
+
+      // Sizes of the stored types. These change with the layout of the data, without the version being updated.
+      int32_t vertexSize  = sizeof(Mesh::Vertex);
+      int32_t subMeshSize = sizeof(Mesh::SubMesh);
+      int32_t meshletSize = sizeof(Meshlet);
+      int32_t lodCount    = 1; ///< Number of levels of detail, including the full detail mesh.
+
+      geometry::Boxf bounds;
+
+      Section vertices;
+      Section indices;
+      Section subMeshes; ///< Sub-meshes of every level of detail, grouped by level.
+      Section lodErrors;
+      Section meshlets;
+    };
+
+    MeshBlob() = default;
+
+    /// Build a blob from mesh data. See Mesh::load.
+    MeshBlob(MeshData const & data, MeshOptimizeFlags optimizeFlags = MeshOptimizeFlags_None);
+
+    /// Build a blob from mesh data.
+    /// Vertices are interleaved and triangles are grouped into sub-meshes by material, then the
+    /// optimizations in `optimizeFlags` are applied.
+    void build(MeshData const & data, MeshOptimizeFlags optimizeFlags = MeshOptimizeFlags_None);
+
+    /// Use a block of memory, such as one read from disk, as the blob.
+    /// @returns false if the block is not a valid blob of the current version. The blob is left empty.
+    bool assign(Vector<uint8_t> && bytes);
+
+    void clear();
+
+    bool empty() const;
+
+    Header const & header() const;
+
+    Span<const uint8_t> bytes() const;
+
+    Span<const Mesh::Vertex> vertices() const;
+
+    Span<const Mesh::Index> indices() const;
+
+    /// Get the sub-meshes of a level of detail. Level 0 is the full detail mesh.
+    Span<const Mesh::SubMesh> subMeshes(int64_t lod = 0) const;
+
+    int64_t getLodCount() const;
+
+    /// Get the largest geometric error of each simplified level of detail, starting with level 1.
+    Span<const float> lodErrors() const;
+
+    Span<const Meshlet> meshlets() const;
+
+  private:
+    template<typename T>
+    Span<const T> section(Section const & s) const {
+      return Span<const T>((T const *)(m_data.data() + s.offset), s.count);
+    }
+
+    Vector<uint8_t> m_data;
+  };
+
+  BFC_API int64_t write(Stream * pStream, MeshBlob const * pValue, int64_t count);
+  BFC_API int64_t read(Stream * pStream, MeshBlob * pValue, int64_t count);
+} // namespace bfc
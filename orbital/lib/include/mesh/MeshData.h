@@ -135,6 +135,11 @@ namespace bfc {
       Vector<Weight>   vertices; ///< Vertices influenced by this deformer
     };
 
+    struct LevelOfDetail {
+      Vector<Triangle> triangles; ///< Simplified triangles. These index the same vertices as the full detail mesh.
+      double           error = 0; ///< Largest error introduced by the simplification, in the units of the positions.
+    };
+
     struct Skin {
       String           name;      ///< Name of this skin
       Vector<Deformer> deformers; ///< Deformers in this skin
@@ -152,6 +157,8 @@ namespace bfc {
 
     Vector<Skin> skins;
 
+    Vector<LevelOfDetail> lods; ///< Simplified versions of the mesh, ordered from most to least detailed.
+
     Filename sourceFile;
   };
 
@@ -161,6 +168,8 @@ namespace bfc {
   BFC_API int64_t read(Stream * pStream, MeshData::Skin * pValue, int64_t count);
   BFC_API int64_t write(Stream * pStream, MeshData::Deformer const * pValue, int64_t count);
   BFC_API int64_t read(Stream * pStream, MeshData::Deformer * pValue, int64_t count);
+  BFC_API int64_t write(Stream * pStream, MeshData::LevelOfDetail const * pValue, int64_t count);
+  BFC_API int64_t read(Stream * pStream, MeshData::LevelOfDetail * pValue, int64_t count);
 
   template<>
   struct Serializer<bfc::MeshData::Material> {
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../core/Core.h"
+#include "../core/Span.h"
+#include "../core/Vector.h"
+
+namespace bfc {
+  /// Post-transform vertex cache statistics for an index buffer.
+  struct MeshCacheStatistics {
+    int64_t vertexTransforms = 0; ///< Number of vertices that missed the cache and were transformed.
+    float   acmr             = 0; ///< Average cache miss ratio. Transformed vertices per triangle (0.5 to 3).
+    float   atvr             = 0; ///< Average transform to vertex ratio. Transformed vertices per referenced vertex (1 is optimal).
+  };
+
+  /// Reorders and welds indexed triangle lists to reduce vertex shader work and memory bandwidth.
+  /// All functions operate on triangle lists with 32 bit indices. Vertex data is treated as
+  /// opaque blocks of `vertexStride` bytes, except where positions are required.
+  class BFC_API MeshOptimizer {
+  public:
+    using Index = uint32_t;
+
+    MeshOptimizer() = delete;
+
+    /// Find vertices that are bitwise identical.
+    /// @param pRemap Receives the new index of each vertex. Unique vertices are numbered in order of first appearance.
+    /// @returns The number of unique vertices.
+    static int64_t weldVertices(void const * pVertices, int64_t vertexCount, int64_t vertexStride, Vector<Index> * pRemap);
+
+    /// Move vertices to the positions given by a remap table.
+    /// Where several vertices map to the same index, the first is kept.
+    /// @param pDst Destination for the remapped vertices. Must not overlap pSrc.
+    static void remapVertices(void * pDst, void const * pSrc, int64_t vertexCount, int64_t vertexStride, Span<const Index> const & remap);
+
+    /// Replace each index with its entry in a remap table.
+    static void remapIndices(Span<Index> const & indices, Span<const Index> const & remap);
+
+    /// Reorder triangles to improve post-transform vertex cache hits, using Tipsify (Sander et al. 2007).
+    /// @param cacheSize The size of the cache to optimize for.
+    static void optimizeVertexCache(Span<Index> const & indices, int64_t vertexCount, int64_t cacheSize = 16);
+
+    /// Reorder clusters of triangles so that triangles likely to occlude others are drawn first.
+    /// The index buffer should already be optimized for the vertex cache. Clusters are split where the
+    /// cache would be flushed, and further split while the cache miss ratio stays within `threshold`
+    /// times the original, so vertex cache efficiency is traded for less overdraw.
+    /// @param pPositions   Pointer to the first vertex position (3 floats).
+    /// @param vertexStride The distance in bytes between vertex positions.
+    /// @param threshold    The allowed increase in the cache miss ratio. 1 keeps the original efficiency.
+    static void optimizeOverdraw(Span<Index> const & indices, float const * pPositions, int64_t vertexCount, int64_t vertexStride, float threshold = 1.05f, int64_t cacheSize = 16);
+
+    /// Reorder vertices in the order they are first referenced by the index buffer.
+    /// Unreferenced vertices are removed.
+    /// @returns The number of vertices remaining.
+    static int64_t optimizeVertexFetch(Span<Index> const & indices, void * pVertices, int64_t vertexCount, int64_t vertexStride);
+
+    /// Simulate a FIFO post-transform vertex cache.
+    static MeshCacheStatistics analyzeVertexCache(Span<const Index> const & indices, int64_t vertexCount, int64_t cacheSize = 16);
+  };
+} // namespace bfc
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../core/Core.h"
+#include "../core/Span.h"
+#include "../core/Vector.h"
+#include "MeshData.h"
+
+namespace bfc {
+  struct MeshSimplifyOptions {
+    int64_t targetTriangleCount = 0;     ///< Stop once at most this many triangles remain.
+    double  targetError         = 0.01;  ///< Stop before the error exceeds this, relative to the size of the mesh.
+    double  uvWeight            = 1.0;   ///< Weight of texture coordinate error relative to position error.
+    double  normalWeight        = 0.5;   ///< Weight of normal error relative to position error.
+    bool    lockBorders         = false; ///< Keep open borders of the mesh in place.
+  };
+
+  /// Reduces the triangle count of MeshData using quadric error metrics (Garland and Heckbert 1997).
+  /// Edges are collapsed onto one of their existing vertices, so simplified triangles index the
+  /// original vertices. Attributes are included in the error with per-vertex attribute quadrics
+  /// (Hoppe 1999), and collapses that would break UV or normal seams are rejected.
+  /// Each material is simplified separately, keeping the edges between materials in place.
+  class BFC_API MeshSimplifier {
+  public:
+    MeshSimplifier() = delete;
+
+    /// Simplify a set of triangles from a mesh.
+    /// @param pError If not null, receives the largest error introduced, in the units of the mesh positions.
+    /// @returns The simplified triangles. These reference mesh.vertices.
+    static Vector<MeshData::Triangle> simplify(MeshData const & mesh, Span<const MeshData::Triangle> const & triangles, MeshSimplifyOptions const & options,
+                                               double * pError = nullptr);
+
+    /// Generate a chain of progressively simpler levels of detail, stored in pMesh->lods.
+    /// Each level targets `reduction` times the triangles of the previous one. The chain ends early
+    /// if a level cannot be reduced further without exceeding `maxError`.
+    /// @param levelCount The maximum number of levels to generate, not including the full detail mesh.
+    /// @param maxError   The largest error allowed in any level, relative to the size of the mesh.
+    static void generateLODs(MeshData * pMesh, int64_t levelCount, double reduction = 0.5, double maxError = 0.05);
+  };
+} // namespace bfc
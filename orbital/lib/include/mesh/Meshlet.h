@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../core/Core.h"
+#include "../core/Span.h"
+#include "../core/Vector.h"
+#include "../geometry/Geometry.h"
+
+namespace bfc {
+  /// A cluster of connected triangles within a sub-mesh, with the bounds used to cull it.
+  struct Meshlet {
+    int64_t elmOffset = 0; ///< Offset of the first index in the cluster.
+    int64_t elmCount  = 0; ///< Number of indices in the cluster.
+
+    geometry::Spheref bounds;         ///< Sphere containing every triangle in the cluster.
+    Vec3              coneApex;       ///< Apex of the cone containing the triangle normals.
+    Vec3              coneAxis;       ///< Axis of the cone containing the triangle normals.
+    float             coneCutoff = 2; ///< Sine of the cone angle. Values above 1 mean the cluster can't be backface culled.
+  };
+
+  /// Splits triangle lists into meshlets, clusters with a bounded number of vertices and triangles,
+  /// so that large meshes can be culled in parts.
+  class BFC_API MeshletBuilder {
+  public:
+    using Index = uint32_t;
+
+    static constexpr int64_t DefaultMaxVertices  = 64;
+    static constexpr int64_t DefaultMaxTriangles = 124;
+
+    MeshletBuilder() = delete;
+
+    /// Reorder a triangle list so that it is made of meshlets.
+    /// Meshlets are grown from a seed triangle by adding the neighbouring triangle that adds the fewest new
+    /// vertices, preferring triangles closer to the meshlet. The order of the seeds follows the input order,
+    /// so indices optimized for the vertex cache stay mostly in order.
+    /// @param pPositions   Pointer to the first vertex position (3 floats).
+    /// @param vertexStride The distance in bytes between vertex positions.
+    /// @returns The meshlets, in the order they appear in indices. Offsets are relative to the start of indices.
+    static Vector<Meshlet> build(Span<Index> const & indices, float const * pPositions, int64_t vertexCount, int64_t vertexStride,
+                                 int64_t maxVertices = DefaultMaxVertices, int64_t maxTriangles = DefaultMaxTriangles);
+
+    /// Calculate the bounding sphere and normal cone of a meshlet.
+    /// @param indices The indices of the triangles in the meshlet.
+    static void calculateBounds(Meshlet * pMeshlet, Span<const Index> const & indices, float const * pPositions, int64_t vertexStride);
+
+    /// Test if a meshlet may be visible to a viewer.
+    /// @param frustum  The view frustum, in the space of the mesh.
+    /// @param viewer   The position of the viewer, in the space of the mesh.
+    /// @param useCone  Cull meshlets facing away from the viewer. This needs a viewer position, so should not be used with orthographic views.
+    static bool isVisible(Meshlet const & meshlet, geometry::Frustumf const & frustum, Vec3 const & viewer, bool useCone = true);
+  };
+} // namespace bfc
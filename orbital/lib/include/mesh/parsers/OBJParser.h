@@ -2,6 +2,7 @@
 
 #include "../../core/Core.h"
 #include "../../core/StringView.h"
+#include "../../util/ThreadPool.h"
 #include "../MeshData.h"
 
 namespace bfc {
@@ -10,7 +11,17 @@ namespace bfc {
 
   class BFC_API OBJParser {
   public:
-    static bool read(Stream* pStream, MeshData* pMesh, StringView const& resourceDir = "");
+    /// Opens a file referenced by an OBJ file (i.e. its material library), given the path written in the OBJ file.
+    using OpenResourceFunc = std::function<Ref<Stream>(StringView const & path)>;
+
+    /// Read a Wavefront OBJ file.
+    /// The file is split into chunks at line boundaries which are parsed in parallel. Face corners
+    /// that reference the same position, uv and normal are merged into a single vertex.
+    /// @param pThreads The pool used to parse chunks. If null, the file is parsed on the calling thread.
+    static bool read(Stream* pStream, MeshData* pMesh, StringView const& resourceDir = "", ThreadPool * pThreads = &ThreadPool::Global());
+
+    /// Read a Wavefront OBJ file, opening the files it references with `openResource`.
+    static bool read(Stream * pStream, MeshData * pMesh, OpenResourceFunc const & openResource, ThreadPool * pThreads = &ThreadPool::Global());
     static bool write(Stream* pStream, MeshData const* pMesh);
   };
 
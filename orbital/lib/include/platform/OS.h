@@ -34,6 +34,63 @@ namespace bfc {
     BFC_API Filename searchInPath(Filename const & path, bool *pFound = nullptr);
     BFC_API int64_t access(Filename const & path, AccessFlag const & flags);
 
+    /// How the pages of a mapped file are expected to be accessed.
+    enum MappingAccess {
+      MappingAccess_Normal,     ///< No special treatment.
+      MappingAccess_Sequential, ///< Pages will be read in order. The OS may read ahead.
+      MappingAccess_Random,     ///< Pages will be read in no particular order.
+      MappingAccess_WillNeed,   ///< All pages will be needed soon. The OS may prefetch them.
+    };
+
+    /// A file mapped into the address space of the process.
+    /// Pages are read from the file on demand and shared with the OS file cache.
+    class BFC_API FileMapping {
+    public:
+      FileMapping() = default;
+      FileMapping(FileMapping && o);
+      FileMapping(FileMapping const & o) = delete;
+      ~FileMapping();
+
+      FileMapping & operator=(FileMapping && o);
+
+      /// Map a file into memory.
+      /// @param path     The file to map.
+      /// @param writable Map the file for reading and writing. The file is created if it does not exist.
+      /// @param size     The number of bytes to map. If 0, the whole file is mapped.
+      ///                 A writable file is grown to `size` if it is smaller.
+      ///                 Other handles can't write the file while it is mapped, as its contents are read in place.
+      /// @retval true  The file was mapped. An empty file is mapped with a null data pointer.
+      /// @retval false The file could not be opened or mapped.
+      bool open(Filename const & path, bool writable = false, int64_t size = 0);
+
+      /// Unmap the file.
+      void close();
+
+      /// Write modified pages back to the file.
+      bool flush();
+
+      /// Hint how a range of the mapping will be accessed.
+      /// @param offset The start of the range in bytes.
+      /// @param size   The number of bytes in the range. If 0, the range extends to the end of the mapping.
+      void advise(MappingAccess access, int64_t offset = 0, int64_t size = 0);
+
+      bool isOpen() const;
+
+      bool writable() const;
+
+      uint8_t * data() const;
+
+      int64_t size() const;
+
+    private:
+      void *    m_hFile    = nullptr;
+      void *    m_hMapping = nullptr;
+      uint8_t * m_pData    = nullptr;
+      int64_t   m_size     = 0;
+      bool      m_writable = false;
+      bool      m_open     = false;
+    };
+
     enum FolderAttribute {
       FolderAttribute_None      = 0,
       FolderAttribute_Files     = 1 << 0,
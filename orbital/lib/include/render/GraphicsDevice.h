@@ -696,6 +696,33 @@ namespace bfc {
       Vector<State>   m_stack;  // History of state changes.
     };
 
+    /// Counters recorded by a graphics device while it executes command lists.
+    /// A frame ends when a swap() command is executed.
+    struct FrameStatistics {
+      int64_t frame             = 0; ///< Index of the frame these statistics were recorded for.
+      int64_t commandLists      = 0; ///< Number of command lists executed.
+      int64_t drawCalls         = 0; ///< Number of draw() and drawIndexed() calls.
+      int64_t indexedDrawCalls  = 0; ///< Number of drawIndexed() calls.
+      int64_t instances         = 0; ///< Instances submitted by all draw calls.
+      int64_t elements          = 0; ///< Vertices or indices submitted by all draw calls (per instance).
+      int64_t programBinds      = 0;
+      int64_t vertexArrayBinds  = 0;
+      int64_t textureBinds      = 0;
+      int64_t samplerBinds      = 0;
+      int64_t bufferBinds       = 0; ///< Uniform and shader storage buffer binds.
+      int64_t renderTargetBinds = 0;
+      int64_t stateChanges      = 0; ///< Individual pipeline states applied to the device.
+      int64_t uniformUpdates    = 0;
+      int64_t clears            = 0;
+      int64_t bytesUploaded     = 0; ///< Buffer and texture data uploaded to the device.
+      int64_t bytesDownloaded   = 0; ///< Buffer and texture data read back from the device.
+
+      /// Total number of resource binds.
+      int64_t binds() const {
+        return programBinds + vertexArrayBinds + textureBinds + samplerBinds + bufferBinds + renderTargetBinds;
+      }
+    };
+
     class BFC_API BufferDownload {
     public:
       virtual ~BufferDownload() = default;
@@ -793,10 +820,14 @@ namespace bfc {
       // Textures
       virtual bool uploadTexture(TextureRef textureID, DepthStencilFormat format, Vec3i size)           = 0;
       virtual bool uploadTexture(TextureRef textureID, media::Surface const & src)                      = 0;
+      /// Upload a chain of mip levels, starting with the base level. Mips are not generated.
+      /// Block compressed textures must be uploaded this way to have mips.
+      virtual bool uploadTextureMips(TextureRef textureID, Span<const media::Surface> const & mips)    = 0;
       virtual bool uploadTextureSubData(TextureRef textureID, media::Surface const & src, Vec3i offset) = 0;
       virtual void generateMipMaps(TextureRef textureID)                                                = 0;
       virtual void downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, PixelFormat format) = 0;
       virtual void downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, DepthStencilFormat format) = 0;
+      /// Download in the format of the texture. Block compressed textures are decompressed to RGBAu8.
       void         downloadTexture(TextureRef textureID, TextureDownloadRef pDownload);
 
       // Shaders
@@ -860,6 +891,7 @@ namespace bfc {
     };
 
     void loadTexture(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, media::Surface const & surface);
+    void loadTextureMips(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, Span<const media::Surface> const & mips);
     void loadTexture(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, Vec3i const & size, PixelFormat const & format,
                      void const * pPixels = nullptr, int64_t rowPitch = 0);
     void loadTexture(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, Vec3i const & size, DepthStencilFormat const & depthFormat);
@@ -963,6 +995,13 @@ namespace bfc {
 
     /// Wait for a command list to complete execution.
     virtual bool wait(uint64_t handle, std::optional<Timestamp> const & timeout = std::nullopt) = 0;
+
+    /// Get the statistics recorded for the most recently completed frame.
+    /// @retval false The device does not record statistics, or no frame has completed yet.
+    virtual bool getFrameStatistics(graphics::FrameStatistics * pStats) const {
+      BFC_UNUSED(pStats);
+      return false;
+    }
   };
 
   /// Graphics device factory function type.
@@ -991,6 +1030,7 @@ namespace bfc {
 
   // TODO: Work out a solution that doesn't require exposing these functions
   bool graphicsDevice_registerOpenGL();
+  bool graphicsDevice_registerNull();
 
   template<typename T>
   struct EnumValueMap;
@@ -37,6 +37,12 @@ namespace bfc {
       Mat4 mvpMatrix;
     };
 
+    /// Per-instance data for instanced draws. Matches `InstanceData` in instancing.glsl.
+    struct InstanceData {
+      Mat4 modelMatrix;
+      Mat4 normalMatrix;
+    };
+
     struct LightBuffer {
       Vec3 position;
       int32_t type;
@@ -81,6 +87,7 @@ namespace bfc {
       BufferBinding_ModelBuffer,
       BufferBinding_LightBuffer,
       BufferBinding_PBRMaterial,
+      BufferBinding_InstanceBuffer,
       BufferBinding_Count,
     };
 
@@ -8,19 +8,61 @@
 #include <mutex>
 
 namespace bfc {
+  namespace impl {
+    class PackedCache;
+  }
+
+  enum CacheStorage {
+    CacheStorage_Files,  ///< Each entry is stored in its own file, listed in a header file.
+    CacheStorage_Packed, ///< Entries are appended to segment files, listed in a journaled index.
+  };
+
+  struct CacheOptions {
+    CacheStorage storage = CacheStorage_Files;
+
+    // The options below only apply to CacheStorage_Packed.
+
+    /// Least recently used entries are evicted when the entries take more than this many bytes. 0 for no limit.
+    int64_t maxBytes = 0;
+
+    /// Entries that have not been checked out for this long are evicted. 0 for no limit.
+    Timestamp maxAge = 0;
+
+    /// A new segment file is started once the current one is this large.
+    int64_t segmentBytes = 64ll * 1024 * 1024;
+
+    /// Segments are compacted in the background once this fraction of them is dead space.
+    double compactThreshold = 0.5;
+  };
+
+  enum CacheEntryFlags {
+    CacheEntryFlags_None       = 0,
+    CacheEntryFlags_Compressed = 1 << 0, ///< The entry is compressed with CompressedWriter.
+  };
+
   class BFC_API Cache {
   public:
-    constexpr static inline int64_t Version = 1; // Version of this cache implementation
+    constexpr static inline int64_t Version = 2; // Version of this cache implementation
 
-    struct Entry {
+    struct BFC_API Entry {
       UUID     uuid;
       int64_t  timestamp = 0;
       int64_t  version   = 0;
-      File     stream;
+      int64_t  flags     = CacheEntryFlags_None;
+
+      /// Get the stream to read or write the entry data.
+      /// Compressed entries are compressed and decompressed as they are streamed.
+      Stream * stream() const;
+
+      /// Close the entry stream.
+      void close();
+
+      Ref<Stream> pStream; ///< The stored entry data.
+      Ref<Stream> pCodec;  ///< Compresses or decompresses `pStream` if the entry is compressed.
     };
 
     /// Create or open a cache at `path`.
-    Cache(Filename const & path);
+    Cache(Filename const & path, CacheOptions const & options = {});
 
     /// Destruct the cache.
     /// This does not remove the cache from disk.
@@ -35,7 +77,8 @@ namespace bfc {
 
     /// Create a new cache entry.
     /// This does not add it to the cache. Call commit to finalize the entry.
-    Entry create() const;
+    /// @param flags A combination of CacheEntryFlags. Stored with the entry when it is committed.
+    Entry create(int64_t flags = CacheEntryFlags_None) const;
 
     /// Submit the entry to the cache.
     void commit(StringView const & identifier, Entry *pEntry);
@@ -43,6 +86,13 @@ namespace bfc {
     /// Remove an entry from the cache.
     void remove(StringView const & identifier);
 
+    /// Get the number of bytes used by the entries in the cache.
+    /// Only tracked by packed storage. Returns -1 otherwise.
+    int64_t size() const;
+
+    /// Compact packed storage now, instead of waiting for it to happen in the background.
+    void compact();
+
   private:
     struct OpenInfo {
       std::atomic_int64_t refs;
@@ -54,6 +104,7 @@ namespace bfc {
       UUID    uuid;
       int64_t timestamp = 0;
       int64_t version   = 0;
+      int64_t flags     = CacheEntryFlags_None;
     };
 
     bool readHeaderItem(HeaderItem * pItem);
@@ -65,5 +116,7 @@ namespace bfc {
     Filename m_path;
 
     std::mutex *m_pLock = nullptr;
+
+    impl::PackedCache * m_pPacked = nullptr;
   };
 }
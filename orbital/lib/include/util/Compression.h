@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../core/Stream.h"
+#include "../core/Vector.h"
+
+namespace bfc {
+  /// Size of the blocks compressed by CompressedWriter.
+  /// Blocks are compressed independently, so this is also the furthest a match can refer back.
+  constexpr int64_t CompressionBlockSize = 64 * 1024;
+
+  /// Get the largest size that `size` bytes can be compressed to by compressBlock().
+  BFC_API int64_t compressBlockBound(int64_t size);
+
+  /// Compress `src` with a fast LZ codec.
+  /// Matches are found with a single hash table and can refer back up to 64 KiB.
+  /// @param pDst        Receives the compressed data.
+  /// @param dstCapacity The size of `pDst`. Should be at least compressBlockBound(srcSize).
+  /// @returns The compressed size.
+  /// @retval -1 The compressed data does not fit in `pDst`.
+  BFC_API int64_t compressBlock(uint8_t * pDst, int64_t dstCapacity, uint8_t const * pSrc, int64_t srcSize);
+
+  /// Decompress data written by compressBlock().
+  /// Malformed input is detected. Reads and writes stay within the buffers given.
+  /// @returns The decompressed size.
+  /// @retval -1 `pSrc` is malformed, or the data does not fit in `pDst`.
+  BFC_API int64_t decompressBlock(uint8_t * pDst, int64_t dstCapacity, uint8_t const * pSrc, int64_t srcSize);
+
+  /// A stream that compresses the data written to it, and writes it to another stream.
+  /// Data is compressed in blocks of CompressionBlockSize. Blocks that do not compress are stored as is.
+  /// The last block is written by finish(), which is called when the writer is destroyed.
+  class BFC_API CompressedWriter : public Stream {
+  public:
+    using Stream::write;
+
+    CompressedWriter(Stream * pStream);
+    ~CompressedWriter();
+
+    /// Write the buffered data and the end of the compressed stream.
+    /// Nothing can be written after this is called.
+    bool finish();
+
+    virtual bool readable() const override;
+    virtual bool writeable() const override;
+    virtual bool seekable() const override;
+    virtual bool eof() const override;
+
+    /// Get the number of uncompressed bytes written.
+    virtual int64_t tell() const override;
+
+    virtual int64_t write(void const * data, int64_t length) override;
+
+    /// Write the buffered data as a block and flush the underlying stream.
+    virtual bool flush() override;
+
+  private:
+    bool writeBlock(uint8_t const * pData, int64_t size);
+
+    Stream *        m_pStream = nullptr;
+    Vector<uint8_t> m_block;
+    Vector<uint8_t> m_compressed;
+    int64_t         m_written  = 0;
+    bool            m_started  = false;
+    bool            m_finished = false;
+  };
+
+  /// A stream that reads and decompresses data written by CompressedWriter.
+  class BFC_API DecompressingReader : public Stream {
+  public:
+    using Stream::read;
+
+    DecompressingReader(Stream * pStream);
+
+    virtual bool readable() const override;
+    virtual bool writeable() const override;
+    virtual bool seekable() const override;
+
+    /// Check if the end of the compressed stream has been read, or it is malformed.
+    virtual bool eof() const override;
+
+    /// Get the number of uncompressed bytes read.
+    virtual int64_t tell() const override;
+
+    virtual int64_t read(void * data, int64_t length) override;
+
+  private:
+    /// Read the next block into `pDst` if it fits, otherwise into the block buffer.
+    /// @returns The number of bytes decompressed into `pDst`.
+    int64_t readBlock(uint8_t * pDst, int64_t capacity);
+
+    Stream *        m_pStream = nullptr;
+    Vector<uint8_t> m_block;
+    Vector<uint8_t> m_compressed;
+    int64_t         m_blockPos = 0;
+    int64_t         m_read     = 0;
+    bool            m_started  = false;
+    bool            m_end      = false;
+  };
+} // namespace bfc
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../core/Stream.h"
+#include "../core/String.h"
+
+namespace bfc {
+  /// A 128-bit hash of some content.
+  /// Used to identify data by its content, e.g. as a cache key. It is not a cryptographic hash.
+  struct Hash128 {
+    uint64_t low  = 0;
+    uint64_t high = 0;
+
+    bool operator==(Hash128 const & rhs) const {
+      return low == rhs.low && high == rhs.high;
+    }
+
+    bool operator!=(Hash128 const & rhs) const {
+      return !(*this == rhs);
+    }
+
+    /// Convert the hash to 32 hex digits, starting with the most significant.
+    BFC_API String toString() const;
+  };
+
+  inline uint64_t hash(Hash128 const & value) {
+    return value.low;
+  }
+
+  /// Hash `size` bytes with XXH3-128.
+  /// The result matches other XXH3-128 implementations, so it can be stored and compared between builds.
+  BFC_API Hash128 hash128(void const * pData, int64_t size, uint64_t seed = 0);
+
+  /// Hash the rest of `pStream` with XXH3-128. Reads until the end of the stream.
+  BFC_API Hash128 hashStream(Stream * pStream, uint64_t seed = 0);
+
+  /// A stream that hashes the data written to it.
+  /// Writing data in any number of pieces gives the same hash as hash128() of all the data.
+  class BFC_API HashWriter : public Stream {
+  public:
+    using Stream::write;
+
+    HashWriter(uint64_t seed = 0);
+
+    /// Start a new hash.
+    void reset(uint64_t seed = 0);
+
+    /// Get the hash of the data written so far. More data can be written after this is called.
+    Hash128 digest() const;
+
+    virtual bool readable() const override;
+    virtual bool writeable() const override;
+    virtual bool seekable() const override;
+    virtual bool eof() const override;
+
+    /// Get the number of bytes hashed.
+    virtual int64_t tell() const override;
+
+    virtual int64_t write(void const * data, int64_t length) override;
+
+  private:
+    static constexpr int64_t BufferSize = 256;
+
+    uint64_t m_acc[8];
+    uint8_t  m_secret[192];
+    uint8_t  m_buffer[BufferSize];
+    int64_t  m_buffered = 0;
+    int64_t  m_stripes  = 0; ///< Stripes accumulated in the current block.
+    int64_t  m_length   = 0;
+    uint64_t m_seed     = 0;
+  };
+} // namespace bfc
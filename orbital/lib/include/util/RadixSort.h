@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../core/Span.h"
+#include "../core/Vector.h"
+
+namespace bfc {
+  /// Sort items by an unsigned integer key using a least-significant-digit radix sort.
+  /// The sort is stable. Digits that are the same for every item are skipped, so keys
+  /// that only use their low bits are sorted in fewer passes.
+  /// @param items    The items to sort.
+  /// @param keyOf    Callable returning the key for an item. Must return an unsigned integer.
+  /// @param pScratch Optional scratch storage, reused between calls to avoid allocations.
+  template<typename T, typename KeyFunc>
+  void radixSort(Span<T> const & items, KeyFunc const & keyOf, Vector<T> * pScratch = nullptr) {
+    using Key = std::decay_t<decltype(keyOf(std::declval<T const &>()))>;
+    static_assert(std::is_unsigned_v<Key>, "radixSort requires an unsigned key");
+
+    constexpr int64_t DigitBits  = 8;
+    constexpr int64_t DigitCount = int64_t(1) << DigitBits;
+    constexpr int64_t PassCount  = (sizeof(Key) * 8) / DigitBits;
+
+    const int64_t count = items.size();
+    if (count < 2) {
+      return;
+    }
+
+    // Count the occurrences of each digit for every pass at once.
+    int64_t histograms[PassCount][DigitCount] = {};
+    for (T const & item : items) {
+      Key key = keyOf(item);
+      for (int64_t pass = 0; pass < PassCount; ++pass) {
+        ++histograms[pass][(key >> (pass * DigitBits)) & (DigitCount - 1)];
+      }
+    }
+
+    Vector<T> localScratch;
+    Vector<T> & scratch = pScratch != nullptr ? *pScratch : localScratch;
+    scratch.resize(count);
+
+    T * pSrc = items.begin();
+    T * pDst = scratch.begin();
+    for (int64_t pass = 0; pass < PassCount; ++pass) {
+      int64_t * histogram = histograms[pass];
+      const int64_t shift = pass * DigitBits;
+
+      // Skip passes where every item has the same digit.
+      if (histogram[(keyOf(*pSrc) >> shift) & (DigitCount - 1)] == count) {
+        continue;
+      }
+
+      int64_t offset = 0;
+      for (int64_t digit = 0; digit < DigitCount; ++digit) {
+        int64_t digitCount = histogram[digit];
+        histogram[digit]   = offset;
+        offset += digitCount;
+      }
+
+      for (int64_t i = 0; i < count; ++i) {
+        int64_t digit = (keyOf(pSrc[i]) >> shift) & (DigitCount - 1);
+        pDst[histogram[digit]++] = std::move(pSrc[i]);
+      }
+
+      std::swap(pSrc, pDst);
+    }
+
+    if (pSrc != items.begin()) {
+      for (int64_t i = 0; i < count; ++i) {
+        items[i] = std::move(pSrc[i]);
+      }
+    }
+  }
+} // namespace bfc
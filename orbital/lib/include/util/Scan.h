@@ -13,6 +13,14 @@ namespace bfc {
     static StringView readString(const StringView & str, int64_t * pLen = nullptr);
     static StringView readQuote(const StringView & str, int64_t * pLen = nullptr);
 
+    /// Read up to `count` whitespace separated numbers into `pValues`.
+    /// Reading stops at the first token that is not a number.
+    /// @param pLen If not null, receives the number of characters consumed by the values read.
+    /// @returns The number of values read.
+    static int64_t readFloats(const StringView & str, double * pValues, int64_t count, int64_t * pLen = nullptr);
+    static int64_t readFloats(const StringView & str, float * pValues, int64_t count, int64_t * pLen = nullptr);
+    static int64_t readInts(const StringView & str, int64_t * pValues, int64_t count, int64_t * pLen = nullptr);
+
     static bool       readBool(StringView * pStr);
     static int64_t    readInt(StringView * pStr);
     static double     readFloat(StringView * pStr);
@@ -2,10 +2,16 @@
 
 #include "core/Vector.h"
 
+#include <atomic>
 #include <future>
 #include <optional>
 
 namespace bfc {
+  namespace impl {
+    class WorkStealingRunner;
+    class ThreadedRunner;
+  } // namespace impl
+
   enum AsyncFlags {
     AsyncFlags_None           = 0,      ///< Default behaviour. Run in a pooled thread.
     AsyncFlags_NewThread      = 1 << 0, ///< Always run in a new thread.
@@ -49,18 +55,11 @@ namespace bfc {
       if ((flags & AsyncFlags_AllowRunInline) && IsPoolThread()) {
         task.callback(); // Run inline
         return future;
-      } else {
-        std::scoped_lock guard{m_lock};
-
-        if (!m_running) {
-          promise->set_exception(std::make_exception_ptr(std::exception("Thread pool is not running")));
-          return future;
-        }
-
-        m_dispatchQueue.pushBack(std::move(task));
       }
 
-      m_dispatchNotifier.notify_one();
+      if (!submit(std::move(task))) {
+        promise->set_exception(std::make_exception_ptr(std::exception("Thread pool is not running")));
+      }
 
       return future;
     }
@@ -72,14 +71,13 @@ namespace bfc {
     static ThreadPool & Global();
 
   private:
-    void dispatchTasks(int64_t targetConcurrency = std::thread::hardware_concurrency());
-
-    std::mutex              m_lock;
-    std::condition_variable m_dispatchNotifier;
-    Vector<Task>            m_dispatchQueue;
-    bool                    m_running = true;
+    /// Hand a task to the workers or to a new thread, depending on its flags.
+    /// @retval false The pool is shutting down and the task was not queued.
+    bool submit(Task && task);
 
-    std::thread             m_dispatcher;
+    std::atomic_bool                          m_running = true;
+    std::unique_ptr<impl::WorkStealingRunner> m_pWorkers;
+    std::unique_ptr<impl::ThreadedRunner>     m_pThreads;
   };
 
   template<>
@@ -94,4 +92,29 @@ namespace bfc {
   auto async(AsyncFlags flags, Callable && cb, Args &&... args) -> std::future<return_value_of_t<Callable, Args...>> {
     return ThreadPool::Global().run(flags, std::forward<Callable>(cb), std::forward<Args>(args)...);
   }
+
+  /// Split `count` items into ranges of at least `minRange` items and call `func(first, last)` for each.
+  /// Ranges are processed in parallel if `pThreads` is not null. Returns once every range is done.
+  /// Runs inline when called from a pool thread, as waiting on pool tasks from a worker can deadlock.
+  template<typename Func>
+  void parallelFor(ThreadPool * pThreads, int64_t count, int64_t minRange, Func const & func) {
+    constexpr int64_t MaxRanges  = 64;
+    const int64_t     rangeCount = std::min(count / std::max<int64_t>(minRange, 1), MaxRanges);
+    if (pThreads == nullptr || rangeCount <= 1 || ThreadPool::IsPoolThread()) {
+      if (count > 0)
+        func(int64_t(0), count);
+      return;
+    }
+
+    Vector<std::future<void>> jobs;
+    for (int64_t i = 0; i < rangeCount; ++i) {
+      const int64_t first = count * i / rangeCount;
+      const int64_t last  = count * (i + 1) / rangeCount;
+      jobs.pushBack(pThreads->run([&func, first, last]() { func(first, last); }));
+    }
+
+    for (auto & job : jobs) {
+      job.wait();
+    }
+  }
 }
@@ -196,6 +196,119 @@ namespace bfc {
     return m_mode;
   }
 
+  bool MappedFileStream::open(Filename const & file, FileMode mode, int64_t size) {
+    close();
+
+    const bool writable = (mode & (FileMode_Write | FileMode_Append)) != 0;
+    if (!m_mapping.open(file, writable, size)) {
+      return false;
+    }
+
+    m_mode      = mode;
+    m_streamPos = (mode & FileMode_Append) != 0 ? m_mapping.size() : 0;
+    return true;
+  }
+
+  void MappedFileStream::close() {
+    m_mapping.close();
+    m_mode      = FileMode_Closed;
+    m_streamPos = 0;
+  }
+
+  void MappedFileStream::setAccessHint(os::MappingAccess access) {
+    m_mapping.advise(access);
+  }
+
+  int64_t MappedFileStream::write(void const * data, int64_t length) {
+    if (!writeable()) {
+      return 0;
+    }
+
+    int64_t bytesWritten = std::min(m_mapping.size() - m_streamPos, length);
+    if (bytesWritten <= 0) {
+      return 0; // At the end of the mapping. Empty files are mapped with a null pointer.
+    }
+
+    memcpy(m_mapping.data() + m_streamPos, data, bytesWritten);
+    m_streamPos += bytesWritten;
+    return bytesWritten;
+  }
+
+  int64_t MappedFileStream::read(void * data, int64_t length) {
+    if (!readable()) {
+      return 0;
+    }
+
+    int64_t bytesRead = std::min(m_mapping.size() - m_streamPos, length);
+    if (bytesRead <= 0) {
+      return 0; // At the end of the mapping. Empty files are mapped with a null pointer.
+    }
+
+    memcpy(data, m_mapping.data() + m_streamPos, bytesRead);
+    m_streamPos += bytesRead;
+    return bytesRead;
+  }
+
+  bool MappedFileStream::seek(int64_t pos, SeekOrigin origin) {
+    if (!m_mapping.isOpen())
+      return false;
+
+    int64_t newPos = 0;
+    switch (origin) {
+    case SeekOrigin_Current: newPos = m_streamPos + pos; break;
+    case SeekOrigin_End: newPos = m_mapping.size() - pos; break;
+    case SeekOrigin_Start: newPos = pos; break;
+    default: return false;
+    }
+
+    m_streamPos = std::clamp<int64_t>(newPos, 0, m_mapping.size());
+    return m_streamPos == newPos;
+  }
+
+  bool MappedFileStream::readable() const {
+    return m_mapping.isOpen() && (m_mode & FileMode_Read) != 0;
+  }
+
+  bool MappedFileStream::writeable() const {
+    return m_mapping.isOpen() && m_mapping.writable();
+  }
+
+  bool MappedFileStream::seekable() const {
+    return m_mapping.isOpen();
+  }
+
+  bool MappedFileStream::eof() const {
+    return m_streamPos >= m_mapping.size();
+  }
+
+  int64_t MappedFileStream::tell() const {
+    return m_streamPos;
+  }
+
+  bool MappedFileStream::flush() {
+    return m_mapping.flush();
+  }
+
+  int64_t MappedFileStream::length() const {
+    return m_mapping.size();
+  }
+
+  uint8_t * MappedFileStream::data() {
+    return m_mapping.data();
+  }
+
+  uint8_t const * MappedFileStream::data() const {
+    return m_mapping.data();
+  }
+
+  int64_t MappedFileStream::size() const {
+    return m_mapping.size();
+  }
+
+  FileMode MappedFileStream::mode() const {
+    return m_mode;
+  }
+
   bool readFile(Filename const& path, Vector<uint8_t>* pContent) {
     File f;
     if (!f.open(path, FileMode_ReadBinary)) {
@@ -59,6 +59,14 @@ namespace bfc {
     return bytesRead;
   }
 
+  int64_t MemoryStream::length() const {
+    return m_data.size();
+  }
+
+  uint8_t const * MemoryStream::data() const {
+    return m_data.data();
+  }
+
   const Vector<uint8_t> & MemoryStream::storage() const {
     return m_data;
   }
@@ -131,6 +139,14 @@ namespace bfc {
     return bytesRead;
   }
 
+  int64_t MemoryReader::length() const {
+    return m_data.size();
+  }
+
+  uint8_t const * MemoryReader::data() const {
+    return m_data.data();
+  }
+
   TextReader::TextReader(Stream * pStream)
     : m_pStream(pStream) {}
 
@@ -190,6 +206,16 @@ namespace bfc {
     }
 
     if (uri.scheme().empty() || uri.scheme() == "file") {
+      // Map large binary files for reading so their contents are read in place from the OS file cache.
+      // Small files are cheaper to read with a single copy.
+      constexpr int64_t MapThreshold = 64 * 1024;
+      if (mode == FileMode_ReadBinary && FileInfo(uri.path()).length() >= MapThreshold) {
+        Ref<MappedFileStream> pMapped = NewRef<MappedFileStream>();
+        if (pMapped->open(uri.path(), mode)) {
+          return pMapped;
+        }
+      }
+
       Ref<File> pFile = NewRef<File>();
       if (pFile->open(uri.path(), mode)) {
         return pFile;
@@ -0,0 +1,1255 @@
+#include "media/BlockCompression.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace bfc {
+  namespace media {
+    namespace {
+      /// A block of 4x4 RGBA pixels, in row major order.
+      struct Block {
+        uint8_t px[16][4];
+      };
+
+      /// Writes bits to a block, starting from the least significant bit of the first byte.
+      struct BitWriter {
+        uint8_t * pData;
+        int32_t   bit = 0;
+
+        void write(uint32_t value, int32_t count) {
+          for (int32_t i = 0; i < count; ++i, ++bit) {
+            pData[bit / 8] |= uint8_t(((value >> i) & 1) << (bit % 8));
+          }
+        }
+      };
+
+      struct BitReader {
+        uint8_t const * pData;
+        int32_t         bit = 0;
+
+        uint32_t read(int32_t count) {
+          uint32_t value = 0;
+          for (int32_t i = 0; i < count; ++i, ++bit) {
+            value |= uint32_t((pData[bit / 8] >> (bit % 8)) & 1) << i;
+          }
+          return value;
+        }
+      };
+
+      inline int32_t square(int32_t v) {
+        return v * v;
+      }
+
+      template<int N>
+      struct Vec {
+        float v[N] = {};
+
+        float & operator[](int i) { return v[i]; }
+        float   operator[](int i) const { return v[i]; }
+      };
+
+      template<int N>
+      float dot(Vec<N> const & a, Vec<N> const & b) {
+        float sum = 0;
+        for (int i = 0; i < N; ++i)
+          sum += a[i] * b[i];
+        return sum;
+      }
+
+      /// Fit a line through `count` points. `pEnds` receives the extent of the points along their principal axis.
+      /// Channels without variance collapse both ends onto the mean.
+      template<int N>
+      void fitLine(Vec<N> const * pPoints, int64_t count, int32_t iterations, Vec<N> * pEnds) {
+        Vec<N> mean;
+        for (int64_t i = 0; i < count; ++i)
+          for (int c = 0; c < N; ++c)
+            mean[c] += pPoints[i][c];
+        for (int c = 0; c < N; ++c)
+          mean[c] /= float(count);
+
+        float  cov[N][N] = {};
+        Vec<N> lo        = pPoints[0];
+        Vec<N> hi        = pPoints[0];
+        for (int64_t i = 0; i < count; ++i) {
+          for (int a = 0; a < N; ++a) {
+            lo[a] = std::min(lo[a], pPoints[i][a]);
+            hi[a] = std::max(hi[a], pPoints[i][a]);
+            for (int b = a; b < N; ++b)
+              cov[a][b] += (pPoints[i][a] - mean[a]) * (pPoints[i][b] - mean[b]);
+          }
+        }
+        for (int a = 0; a < N; ++a)
+          for (int b = 0; b < a; ++b)
+            cov[a][b] = cov[b][a];
+
+        // Start from the diagonal of the bounding box, oriented by the covariance with its widest channel.
+        int widest = 0;
+        for (int c = 1; c < N; ++c)
+          widest = hi[c] - lo[c] > hi[widest] - lo[widest] ? c : widest;
+
+        Vec<N> axis;
+        for (int c = 0; c < N; ++c)
+          axis[c] = (hi[c] - lo[c]) * (cov[widest][c] < 0 ? -1.0f : 1.0f);
+
+        // Power iteration converges on the principal axis.
+        for (int32_t it = 0; it < iterations; ++it) {
+          Vec<N> next;
+          for (int a = 0; a < N; ++a)
+            for (int b = 0; b < N; ++b)
+              next[a] += cov[a][b] * axis[b];
+
+          float const len = std::sqrt(dot(next, next));
+          if (len < 1e-6f)
+            break;
+          for (int c = 0; c < N; ++c)
+            axis[c] = next[c] / len;
+        }
+
+        float const len = std::sqrt(dot(axis, axis));
+        if (len < 1e-6f) {
+          pEnds[0] = mean;
+          pEnds[1] = mean;
+          return;
+        }
+        for (int c = 0; c < N; ++c)
+          axis[c] /= len;
+
+        float tMin = std::numeric_limits<float>::max();
+        float tMax = -std::numeric_limits<float>::max();
+        for (int64_t i = 0; i < count; ++i) {
+          Vec<N> d;
+          for (int c = 0; c < N; ++c)
+            d[c] = pPoints[i][c] - mean[c];
+          float const t = dot(d, axis);
+          tMin          = std::min(tMin, t);
+          tMax          = std::max(tMax, t);
+        }
+
+        for (int c = 0; c < N; ++c) {
+          pEnds[0][c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+          pEnds[1][c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+        }
+      }
+
+      /// Solve for the endpoints that minimise the squared error of `count` points, given the weight of the second
+      /// endpoint used by each point. Returns false if the weights do not constrain both endpoints.
+      template<int N>
+      bool solveEndpoints(Vec<N> const * pPoints, float const * pWeights, int64_t count, Vec<N> * pEnds) {
+        float  aa = 0, ab = 0, bb = 0;
+        Vec<N> ax, bx;
+        for (int64_t i = 0; i < count; ++i) {
+          float const b = pWeights[i];
+          float const a = 1.0f - b;
+          aa += a * a;
+          ab += a * b;
+          bb += b * b;
+          for (int c = 0; c < N; ++c) {
+            ax[c] += a * pPoints[i][c];
+            bx[c] += b * pPoints[i][c];
+          }
+        }
+
+        float const det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f)
+          return false;
+
+        for (int c = 0; c < N; ++c) {
+          pEnds[0][c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+          pEnds[1][c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+        }
+        return true;
+      }
+
+      // BC1 colour
+
+      inline uint16_t packRGB565(Vec<3> const & rgb) {
+        int32_t const r = std::clamp(int32_t(rgb[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        int32_t const g = std::clamp(int32_t(rgb[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        int32_t const b = std::clamp(int32_t(rgb[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return uint16_t((r << 11) | (g << 5) | b);
+      }
+
+      inline void unpackRGB565(uint16_t colour, int32_t * pRGB) {
+        int32_t const r = (colour >> 11) & 31;
+        int32_t const g = (colour >> 5) & 63;
+        int32_t const b = colour & 31;
+        pRGB[0]         = (r << 3) | (r >> 2);
+        pRGB[1]         = (g << 2) | (g >> 4);
+        pRGB[2]         = (b << 3) | (b >> 2);
+      }
+
+      void calculateColourPalette(uint16_t c0, uint16_t c1, bool fourColour, int32_t (*pPalette)[3]) {
+        unpackRGB565(c0, pPalette[0]);
+        unpackRGB565(c1, pPalette[1]);
+        for (int c = 0; c < 3; ++c) {
+          if (fourColour) {
+            pPalette[2][c] = (2 * pPalette[0][c] + pPalette[1][c]) / 3;
+            pPalette[3][c] = (pPalette[0][c] + 2 * pPalette[1][c]) / 3;
+          } else {
+            pPalette[2][c] = (pPalette[0][c] + pPalette[1][c]) / 2;
+            pPalette[3][c] = 0;
+          }
+        }
+      }
+
+      /// Colour endpoints and indices of a BC1 block being encoded.
+      struct ColourFit {
+        uint16_t c[2]     = {};
+        uint8_t  idx[16]  = {};
+        int64_t  error    = std::numeric_limits<int64_t>::max();
+      };
+
+      /// Choose the closest palette entry for each pixel. In 3 colour mode, transparent pixels use index 3.
+      int64_t fitColourIndices(Block const & block, bool const * pTransparent, bool fourColour, ColourFit * pFit) {
+        int32_t palette[4][3];
+        calculateColourPalette(pFit->c[0], pFit->c[1], fourColour, palette);
+
+        int64_t   total      = 0;
+        int const paletteLen = fourColour ? 4 : 3;
+        for (int i = 0; i < 16; ++i) {
+          if (pTransparent[i]) {
+            pFit->idx[i] = 3;
+            continue;
+          }
+
+          int32_t best      = std::numeric_limits<int32_t>::max();
+          int32_t bestIndex = 0;
+          for (int p = 0; p < paletteLen; ++p) {
+            int32_t const err =
+              square(block.px[i][0] - palette[p][0]) + square(block.px[i][1] - palette[p][1]) + square(block.px[i][2] - palette[p][2]);
+            if (err < best) {
+              best      = err;
+              bestIndex = p;
+            }
+          }
+          pFit->idx[i] = uint8_t(bestIndex);
+          total += best;
+        }
+
+        pFit->error = total;
+        return total;
+      }
+
+      /// Encode the colour of `block` as a BC1 colour block.
+      /// If `punchThrough` is set, pixels with an alpha below 128 are encoded as transparent with the 3 colour mode.
+      void encodeColourBlock(uint8_t * pOut, Block const & block, BlockCompressionQuality quality, bool punchThrough) {
+        bool    transparent[16] = {};
+        Vec<3>  points[16];
+        float   weights[16];
+        int64_t count = 0;
+        for (int i = 0; i < 16; ++i) {
+          transparent[i] = punchThrough && block.px[i][3] < 128;
+          if (!transparent[i]) {
+            for (int c = 0; c < 3; ++c)
+              points[count][c] = block.px[i][c];
+            ++count;
+          }
+        }
+
+        bool const hasTransparent = count < 16;
+        bool const fourColour     = !hasTransparent;
+
+        ColourFit best;
+        if (count > 0) {
+          Vec<3> ends[2];
+          fitLine(points, count, quality == BlockCompressionQuality_Fast ? 2 : 8, ends);
+          best.c[0] = packRGB565(ends[0]);
+          best.c[1] = packRGB565(ends[1]);
+          fitColourIndices(block, transparent, fourColour, &best);
+
+          // Refit the endpoints to the chosen indices.
+          int32_t const refinements = quality == BlockCompressionQuality_Fast ? 0 : quality == BlockCompressionQuality_Normal ? 2 : 4;
+          for (int32_t it = 0; it < refinements && best.error > 0; ++it) {
+            static constexpr float weights4[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+            static constexpr float weights3[3] = {0.0f, 1.0f, 0.5f};
+
+            int64_t n = 0;
+            for (int i = 0; i < 16; ++i)
+              if (!transparent[i])
+                weights[n++] = fourColour ? weights4[best.idx[i]] : weights3[best.idx[i]];
+
+            if (!solveEndpoints(points, weights, count, ends))
+              break;
+
+            ColourFit fit;
+            fit.c[0] = packRGB565(ends[0]);
+            fit.c[1] = packRGB565(ends[1]);
+            if (fitColourIndices(block, transparent, fourColour, &fit) >= best.error)
+              break;
+            best = fit;
+          }
+
+          // Nudge each endpoint channel by one step while it improves the error.
+          if (quality == BlockCompressionQuality_High) {
+            static constexpr int32_t shifts[3] = {11, 5, 0};
+            static constexpr int32_t maxima[3] = {31, 63, 31};
+            bool                     improved  = true;
+            for (int32_t pass = 0; pass < 2 && improved && best.error > 0; ++pass) {
+              improved = false;
+              for (int e = 0; e < 2; ++e) {
+                for (int c = 0; c < 3; ++c) {
+                  for (int32_t step : {-1, 1}) {
+                    int32_t const value = ((best.c[e] >> shifts[c]) & maxima[c]) + step;
+                    if (value < 0 || value > maxima[c])
+                      continue;
+
+                    ColourFit fit = best;
+                    fit.c[e]      = uint16_t((fit.c[e] & ~(maxima[c] << shifts[c])) | (value << shifts[c]));
+                    if (fitColourIndices(block, transparent, fourColour, &fit) < best.error) {
+                      best     = fit;
+                      improved = true;
+                    }
+                  }
+                }
+              }
+            }
+          }
+        } else {
+          std::fill(std::begin(best.idx), std::end(best.idx), uint8_t(3));
+        }
+
+        // The mode is selected by the order of the endpoints. 4 colour mode needs c0 > c1, 3 colour mode c0 <= c1.
+        if (fourColour) {
+          if (best.c[0] < best.c[1]) {
+            std::swap(best.c[0], best.c[1]);
+            for (uint8_t & i : best.idx)
+              i ^= 1;
+          } else if (best.c[0] == best.c[1]) {
+            std::fill(std::begin(best.idx), std::end(best.idx), uint8_t(0));
+          }
+        } else if (best.c[0] > best.c[1]) {
+          std::swap(best.c[0], best.c[1]);
+          for (uint8_t & i : best.idx)
+            i = i < 2 ? i ^ 1 : i;
+        }
+
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+          indices |= uint32_t(best.idx[i]) << (i * 2);
+
+        pOut[0] = uint8_t(best.c[0]);
+        pOut[1] = uint8_t(best.c[0] >> 8);
+        pOut[2] = uint8_t(best.c[1]);
+        pOut[3] = uint8_t(best.c[1] >> 8);
+        std::memcpy(pOut + 4, &indices, 4);
+      }
+
+      /// Decode a BC1 colour block. `alwaysFourColour` is set for the colour block of BC3, which has no 3 colour mode.
+      void decodeColourBlock(uint8_t const * pIn, bool alwaysFourColour, Block * pBlock) {
+        uint16_t const c0 = uint16_t(pIn[0] | (pIn[1] << 8));
+        uint16_t const c1 = uint16_t(pIn[2] | (pIn[3] << 8));
+        uint32_t       indices;
+        std::memcpy(&indices, pIn + 4, 4);
+
+        bool const fourColour = alwaysFourColour || c0 > c1;
+        int32_t    palette[4][3];
+        calculateColourPalette(c0, c1, fourColour, palette);
+
+        for (int i = 0; i < 16; ++i) {
+          uint32_t const index = (indices >> (i * 2)) & 3;
+          for (int c = 0; c < 3; ++c)
+            pBlock->px[i][c] = uint8_t(palette[index][c]);
+          pBlock->px[i][3] = !fourColour && index == 3 ? 0 : 255;
+        }
+      }
+
+      // BC4 channel
+
+      void calculateChannelPalette(int32_t a0, int32_t a1, int32_t * pPalette) {
+        pPalette[0] = a0;
+        pPalette[1] = a1;
+        if (a0 > a1) {
+          for (int i = 0; i < 6; ++i)
+            pPalette[2 + i] = ((6 - i) * a0 + (1 + i) * a1) / 7;
+        } else {
+          for (int i = 0; i < 4; ++i)
+            pPalette[2 + i] = ((4 - i) * a0 + (1 + i) * a1) / 5;
+          pPalette[6] = 0;
+          pPalette[7] = 255;
+        }
+      }
+
+      int64_t fitChannelIndices(uint8_t const * pValues, int32_t a0, int32_t a1, uint8_t * pIndices) {
+        int32_t palette[8];
+        calculateChannelPalette(a0, a1, palette);
+
+        int64_t total = 0;
+        for (int i = 0; i < 16; ++i) {
+          int32_t best = std::numeric_limits<int32_t>::max();
+          for (int p = 0; p < 8; ++p) {
+            int32_t const err = square(pValues[i] - palette[p]);
+            if (err < best) {
+              best        = err;
+              pIndices[i] = uint8_t(p);
+            }
+          }
+          total += best;
+        }
+        return total;
+      }
+
+      /// Encode 16 values as a BC4 block.
+      void encodeChannelBlock(uint8_t * pOut, uint8_t const * pValues, BlockCompressionQuality quality) {
+        int32_t lo = 255, hi = 0;
+        int32_t innerLo = 255, innerHi = 0;
+        for (int i = 0; i < 16; ++i) {
+          lo = std::min<int32_t>(lo, pValues[i]);
+          hi = std::max<int32_t>(hi, pValues[i]);
+          if (pValues[i] != 0 && pValues[i] != 255) {
+            innerLo = std::min<int32_t>(innerLo, pValues[i]);
+            innerHi = std::max<int32_t>(innerHi, pValues[i]);
+          }
+        }
+
+        int32_t bestA0 = hi, bestA1 = lo;
+        uint8_t bestIdx[16];
+        int64_t bestError = fitChannelIndices(pValues, hi, lo, bestIdx);
+
+        const auto tryEndpoints = [&](int32_t a0, int32_t a1) {
+          uint8_t       idx[16];
+          int64_t const err = fitChannelIndices(pValues, a0, a1, idx);
+          if (err < bestError) {
+            bestError = err;
+            bestA0    = a0;
+            bestA1    = a1;
+            std::memcpy(bestIdx, idx, 16);
+          }
+        };
+
+        if (quality != BlockCompressionQuality_Fast && bestError > 0) {
+          // The 6 value mode has exact 0 and 255 entries, so the interpolated range only covers the other values.
+          if (innerLo <= innerHi && (lo == 0 || hi == 255))
+            tryEndpoints(innerLo, innerHi);
+
+          // Shrink the range. Values near the ends are often better served by the interpolated entries.
+          if (quality == BlockCompressionQuality_High) {
+            int32_t const range = std::min((hi - lo) / 4, 8);
+            for (int32_t d0 = 0; d0 <= range; ++d0)
+              for (int32_t d1 = 0; d1 <= range; ++d1)
+                if (hi - d0 > lo + d1)
+                  tryEndpoints(hi - d0, lo + d1);
+          }
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+          indices |= uint64_t(bestIdx[i]) << (i * 3);
+
+        pOut[0] = uint8_t(bestA0);
+        pOut[1] = uint8_t(bestA1);
+        for (int i = 0; i < 6; ++i)
+          pOut[2 + i] = uint8_t(indices >> (i * 8));
+      }
+
+      void decodeChannelBlock(uint8_t const * pIn, int channel, Block * pBlock) {
+        int32_t palette[8];
+        calculateChannelPalette(pIn[0], pIn[1], palette);
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i)
+          indices |= uint64_t(pIn[2 + i]) << (i * 8);
+
+        for (int i = 0; i < 16; ++i)
+          pBlock->px[i][channel] = uint8_t(palette[(indices >> (i * 3)) & 7]);
+      }
+
+      // BC7
+
+      struct BC7ModeInfo {
+        int32_t subsets;
+        int32_t partitionBits;
+        int32_t rotationBits;
+        int32_t indexSelectionBits;
+        int32_t colourBits;
+        int32_t alphaBits;
+        int32_t endpointPBits;
+        int32_t sharedPBits;
+        int32_t indexBits;
+        int32_t secondaryIndexBits;
+      };
+
+      constexpr BC7ModeInfo bc7Modes[8] = {
+        {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+        {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+        {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+        {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+        {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+        {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+        {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+        {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+      };
+
+      constexpr int32_t bc7Weights2[4]  = {0, 21, 43, 64};
+      constexpr int32_t bc7Weights3[8]  = {0, 9, 18, 27, 37, 46, 55, 64};
+      constexpr int32_t bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+      inline int32_t const * bc7WeightTable(int32_t bits) {
+        return bits == 2 ? bc7Weights2 : bits == 3 ? bc7Weights3 : bc7Weights4;
+      }
+
+      inline int32_t bc7Interpolate(int32_t e0, int32_t e1, int32_t weight) {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+      }
+
+      /// Subset of each pixel for the 2 subset partitions. Bit i is the subset of pixel i.
+      constexpr uint16_t bc7Partitions2[64] = {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+        0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+        0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+        0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+        0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+      };
+
+      /// Subset of each pixel for the 3 subset partitions. Bits 2i and 2i+1 are the subset of pixel i.
+      constexpr uint32_t bc7Partitions3[64] = {
+        0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+        0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+        0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+        0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+        0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+        0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+        0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+        0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+      };
+
+      /// Pixel that stores the index of the second subset with one less bit, for 2 subset partitions.
+      constexpr uint8_t bc7Anchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,
+         2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,
+         2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2,
+        15, 15, 15, 15, 15,  2,  2, 15,
+      };
+
+      /// Anchor pixels of the second and third subsets, for 3 subset partitions.
+      constexpr uint8_t bc7Anchors3[2][64] = {
+        {
+           3,  3, 15, 15,  8,  3, 15, 15,
+           8,  8,  6,  6,  6,  5,  3,  3,
+           3,  3,  8, 15,  3,  3,  6, 10,
+           5,  8,  8,  6,  8,  5, 15, 15,
+           8, 15,  3,  5,  6, 10,  8, 15,
+          15,  3, 15,  5, 15, 15, 15, 15,
+           3, 15,  5,  5,  5,  8,  5, 10,
+           5, 10,  8, 13, 15, 12,  3,  3,
+        },
+        {
+          15,  8,  8,  3, 15, 15,  3,  8,
+          15, 15, 15, 15, 15, 15, 15,  8,
+          15,  8, 15,  3, 15,  8, 15,  8,
+           3, 15,  6, 10, 15, 15, 10,  8,
+          15,  3, 15, 10, 10,  8,  9, 10,
+           6, 15,  8, 15,  3,  6,  6,  8,
+          15,  3, 15, 15, 15, 15, 15, 15,
+          15, 15, 15, 15,  3, 15, 15,  8,
+        },
+      };
+
+      inline int32_t bc7Subset(int32_t subsets, int32_t partition, int32_t pixel) {
+        switch (subsets) {
+        case 2: return (bc7Partitions2[partition] >> pixel) & 1;
+        case 3: return (bc7Partitions3[partition] >> (pixel * 2)) & 3;
+        }
+        return 0;
+      }
+
+      inline bool bc7IsAnchor(int32_t subsets, int32_t partition, int32_t pixel) {
+        switch (subsets) {
+        case 2: return pixel == 0 || pixel == bc7Anchors2[partition];
+        case 3: return pixel == 0 || pixel == bc7Anchors3[0][partition] || pixel == bc7Anchors3[1][partition];
+        }
+        return pixel == 0;
+      }
+
+      /// Expand an endpoint channel of `bits` bits to 8 bits by replicating its high bits.
+      inline int32_t bc7Expand(int32_t value, int32_t bits) {
+        return bits >= 8 ? value : (value << (8 - bits)) | (value >> (2 * bits - 8));
+      }
+
+      void decodeBC7Block(uint8_t const * pIn, Block * pBlock) {
+        int32_t mode = 0;
+        while (mode < 8 && (pIn[0] & (1 << mode)) == 0)
+          ++mode;
+
+        if (mode == 8) { // Reserved. Decodes to transparent black.
+          std::memset(pBlock, 0, sizeof(Block));
+          return;
+        }
+
+        BC7ModeInfo const & info = bc7Modes[mode];
+        BitReader           reader{pIn, mode + 1};
+
+        int32_t const partition      = reader.read(info.partitionBits);
+        int32_t const rotation       = reader.read(info.rotationBits);
+        int32_t const indexSelection = reader.read(info.indexSelectionBits);
+
+        int32_t endpoints[3][2][4] = {};
+        for (int c = 0; c < 3; ++c)
+          for (int s = 0; s < info.subsets; ++s)
+            for (int e = 0; e < 2; ++e)
+              endpoints[s][e][c] = reader.read(info.colourBits);
+
+        for (int s = 0; s < info.subsets; ++s)
+          for (int e = 0; e < 2; ++e)
+            endpoints[s][e][3] = info.alphaBits > 0 ? reader.read(info.alphaBits) : 255;
+
+        int32_t colourBits = info.colourBits;
+        int32_t alphaBits  = info.alphaBits;
+        if (info.endpointPBits || info.sharedPBits) {
+          int32_t pbits[3][2] = {};
+          for (int s = 0; s < info.subsets; ++s) {
+            if (info.endpointPBits) {
+              pbits[s][0] = reader.read(1);
+              pbits[s][1] = reader.read(1);
+            } else {
+              pbits[s][0] = pbits[s][1] = reader.read(1);
+            }
+          }
+
+          for (int s = 0; s < info.subsets; ++s)
+            for (int e = 0; e < 2; ++e)
+              for (int c = 0; c < (info.alphaBits > 0 ? 4 : 3); ++c)
+                endpoints[s][e][c] = (endpoints[s][e][c] << 1) | pbits[s][e];
+
+          ++colourBits;
+          alphaBits += alphaBits > 0 ? 1 : 0;
+        }
+
+        for (int s = 0; s < info.subsets; ++s) {
+          for (int e = 0; e < 2; ++e) {
+            for (int c = 0; c < 3; ++c)
+              endpoints[s][e][c] = bc7Expand(endpoints[s][e][c], colourBits);
+            if (alphaBits > 0)
+              endpoints[s][e][3] = bc7Expand(endpoints[s][e][3], alphaBits);
+          }
+        }
+
+        int32_t indices[16]          = {};
+        int32_t secondaryIndices[16] = {};
+        for (int i = 0; i < 16; ++i)
+          indices[i] = reader.read(info.indexBits - (bc7IsAnchor(info.subsets, partition, i) ? 1 : 0));
+        if (info.secondaryIndexBits > 0)
+          for (int i = 0; i < 16; ++i)
+            secondaryIndices[i] = reader.read(info.secondaryIndexBits - (i == 0 ? 1 : 0));
+
+        // Modes 4 and 5 interpolate alpha with the secondary indices. Mode 4 can swap them.
+        int32_t colourIndexBits = info.indexBits;
+        int32_t alphaIndexBits  = info.secondaryIndexBits > 0 ? info.secondaryIndexBits : info.indexBits;
+        if (indexSelection)
+          std::swap(colourIndexBits, alphaIndexBits);
+
+        int32_t const * colourWeights = bc7WeightTable(colourIndexBits);
+        int32_t const * alphaWeights  = bc7WeightTable(alphaIndexBits);
+        for (int i = 0; i < 16; ++i) {
+          int32_t const   subset = bc7Subset(info.subsets, partition, i);
+          int32_t const * e0     = endpoints[subset][0];
+          int32_t const * e1     = endpoints[subset][1];
+
+          int32_t colourIndex = indices[i];
+          int32_t alphaIndex  = info.secondaryIndexBits > 0 ? secondaryIndices[i] : indices[i];
+          if (indexSelection)
+            std::swap(colourIndex, alphaIndex);
+
+          for (int c = 0; c < 3; ++c)
+            pBlock->px[i][c] = uint8_t(bc7Interpolate(e0[c], e1[c], colourWeights[colourIndex]));
+          pBlock->px[i][3] = uint8_t(bc7Interpolate(e0[3], e1[3], alphaWeights[alphaIndex]));
+
+          if (rotation > 0)
+            std::swap(pBlock->px[i][3], pBlock->px[i][rotation - 1]);
+        }
+      }
+
+      /// Endpoints, p-bits and indices of one subset of a BC7 block being encoded.
+      /// Endpoints are stored without their p-bit.
+      template<int N>
+      struct BC7SubsetFit {
+        int32_t ends[2][N] = {};
+        int32_t pbits[2]   = {};
+        uint8_t idx[16]    = {};
+        int64_t error      = std::numeric_limits<int64_t>::max();
+      };
+
+      /// Quantize an 8-bit endpoint channel to `bits` bits, given the p-bit appended to it.
+      inline int32_t bc7Quantize(float value, int32_t bits, int32_t pbit) {
+        int32_t const maxValue = (1 << bits) - 1;
+        int32_t       best     = 0;
+        int32_t       bestErr  = std::numeric_limits<int32_t>::max();
+        int32_t const guess    = int32_t(value * float((2 << bits) - 1) / 255.0f) >> 1;
+        for (int32_t q = std::max(guess - 1, 0); q <= std::min(guess + 1, maxValue); ++q) {
+          int32_t const err = std::abs(bc7Expand((q << 1) | pbit, bits + 1) - int32_t(value + 0.5f));
+          if (err < bestErr) {
+            bestErr = err;
+            best    = q;
+          }
+        }
+        return best;
+      }
+
+      /// Choose the closest interpolated colour for each point and return the squared error.
+      template<int N>
+      int64_t fitBC7Indices(Vec<N> const * pPoints, int64_t count, int32_t bits, int32_t indexBits, BC7SubsetFit<N> * pFit) {
+        int32_t const   paletteLen = 1 << indexBits;
+        int32_t const * weights    = bc7WeightTable(indexBits);
+
+        int32_t palette[16][N];
+        for (int c = 0; c < N; ++c) {
+          int32_t const e0 = bc7Expand((pFit->ends[0][c] << 1) | pFit->pbits[0], bits + 1);
+          int32_t const e1 = bc7Expand((pFit->ends[1][c] << 1) | pFit->pbits[1], bits + 1);
+          for (int32_t p = 0; p < paletteLen; ++p)
+            palette[p][c] = bc7Interpolate(e0, e1, weights[p]);
+        }
+
+        int64_t total = 0;
+        for (int64_t i = 0; i < count; ++i) {
+          int32_t best = std::numeric_limits<int32_t>::max();
+          for (int32_t p = 0; p < paletteLen; ++p) {
+            int32_t err = 0;
+            for (int c = 0; c < N; ++c)
+              err += square(int32_t(pPoints[i][c]) - palette[p][c]);
+            if (err < best) {
+              best         = err;
+              pFit->idx[i] = uint8_t(p);
+            }
+          }
+          total += best;
+        }
+        pFit->error = total;
+        return total;
+      }
+
+      /// Fit the endpoints of one subset of a BC7 block. `sharedPBit` selects a single p-bit for both endpoints.
+      template<int N>
+      BC7SubsetFit<N> fitBC7Subset(Vec<N> const * pPoints, int64_t count, int32_t bits, int32_t indexBits, bool sharedPBit,
+                                   BlockCompressionQuality quality) {
+        Vec<N> ends[2];
+        fitLine(pPoints, count, quality == BlockCompressionQuality_Fast ? 2 : 8, ends);
+
+        const auto quantize = [&](Vec<N> const * pEnds, int32_t p0, int32_t p1) {
+          BC7SubsetFit<N> fit;
+          fit.pbits[0] = p0;
+          fit.pbits[1] = p1;
+          for (int c = 0; c < N; ++c) {
+            fit.ends[0][c] = bc7Quantize(pEnds[0][c], bits, p0);
+            fit.ends[1][c] = bc7Quantize(pEnds[1][c], bits, p1);
+          }
+          fitBC7Indices(pPoints, count, bits, indexBits, &fit);
+          return fit;
+        };
+
+        // Try each p-bit combination. Fast encodes only try matching p-bits.
+        const auto quantizeBest = [&](Vec<N> const * pEnds) {
+          BC7SubsetFit<N> best = quantize(pEnds, 0, 0);
+          for (int32_t combination = 1; combination < 4; ++combination) {
+            int32_t const p0 = combination & 1;
+            int32_t const p1 = combination >> 1;
+            if ((sharedPBit || quality == BlockCompressionQuality_Fast) && p0 != p1)
+              continue;
+
+            BC7SubsetFit<N> fit = quantize(pEnds, p0, p1);
+            if (fit.error < best.error)
+              best = fit;
+          }
+          return best;
+        };
+
+        BC7SubsetFit<N> best = quantizeBest(ends);
+
+        int32_t const refinements = quality == BlockCompressionQuality_Fast ? 0 : quality == BlockCompressionQuality_Normal ? 1 : 2;
+        for (int32_t it = 0; it < refinements && best.error > 0; ++it) {
+          int32_t const * table = bc7WeightTable(indexBits);
+          float           weights[16];
+          for (int64_t i = 0; i < count; ++i)
+            weights[i] = float(table[best.idx[i]]) / 64.0f;
+
+          if (!solveEndpoints(pPoints, weights, count, ends))
+            break;
+
+          BC7SubsetFit<N> fit = quantizeBest(ends);
+          if (fit.error >= best.error)
+            break;
+          best = fit;
+        }
+
+        return best;
+      }
+
+      /// Encode `block` with mode 6. A single subset of RGBA endpoints with 4-bit indices.
+      int64_t encodeBC7Mode6(uint8_t * pOut, Block const & block, BlockCompressionQuality quality) {
+        Vec<4> points[16];
+        for (int i = 0; i < 16; ++i)
+          for (int c = 0; c < 4; ++c)
+            points[i][c] = block.px[i][c];
+
+        BC7SubsetFit<4> fit = fitBC7Subset(points, 16, 7, 4, false, quality);
+
+        // The index of the anchor pixel has an implicit high bit of 0.
+        if (fit.idx[0] >= 8) {
+          std::swap(fit.ends[0], fit.ends[1]);
+          std::swap(fit.pbits[0], fit.pbits[1]);
+          for (uint8_t & i : fit.idx)
+            i = uint8_t(15 - i);
+        }
+
+        std::memset(pOut, 0, 16);
+        BitWriter writer{pOut};
+        writer.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+          for (int e = 0; e < 2; ++e)
+            writer.write(fit.ends[e][c], 7);
+        writer.write(fit.pbits[0], 1);
+        writer.write(fit.pbits[1], 1);
+        for (int i = 0; i < 16; ++i)
+          writer.write(fit.idx[i], i == 0 ? 3 : 4);
+
+        return fit.error;
+      }
+
+      /// Encode `block` with mode 5. RGB and alpha are interpolated separately, with 2-bit indices each.
+      int64_t encodeBC7Mode5(uint8_t * pOut, Block const & block, BlockCompressionQuality quality) {
+        Vec<3> colours[16];
+        Vec<1> alphas[16];
+        for (int i = 0; i < 16; ++i) {
+          for (int c = 0; c < 3; ++c)
+            colours[i][c] = block.px[i][c];
+          alphas[i][0] = block.px[i][3];
+        }
+
+        // Mode 5 has no p-bits. 7-bit colour and 8-bit alpha endpoints are fit as one bit less with a p-bit
+        // per endpoint, which can represent the same values.
+        BC7SubsetFit<3> colour = fitBC7Subset(colours, 16, 6, 2, false, quality);
+        BC7SubsetFit<1> alpha  = fitBC7Subset(alphas, 16, 7, 2, false, quality);
+
+        const auto fixAnchor = [](auto * pFit) {
+          if (pFit->idx[0] < 2)
+            return;
+          std::swap(pFit->ends[0], pFit->ends[1]);
+          std::swap(pFit->pbits[0], pFit->pbits[1]);
+          for (uint8_t & i : pFit->idx)
+            i = uint8_t(3 - i);
+        };
+        fixAnchor(&colour);
+        fixAnchor(&alpha);
+
+        std::memset(pOut, 0, 16);
+        BitWriter writer{pOut};
+        writer.write(1 << 5, 6);
+        writer.write(0, 2); // No rotation
+        for (int c = 0; c < 3; ++c)
+          for (int e = 0; e < 2; ++e)
+            writer.write((colour.ends[e][c] << 1) | colour.pbits[e], 7);
+        for (int e = 0; e < 2; ++e)
+          writer.write((alpha.ends[e][0] << 1) | alpha.pbits[e], 8);
+        for (int i = 0; i < 16; ++i)
+          writer.write(colour.idx[i], i == 0 ? 1 : 2);
+        for (int i = 0; i < 16; ++i)
+          writer.write(alpha.idx[i], i == 0 ? 1 : 2);
+
+        return colour.error + alpha.error;
+      }
+
+      /// 7-bit endpoint pairs that interpolate to each 8-bit value at the first weight of mode 5.
+      struct BC7SolidTable {
+        uint8_t ends[256][2];
+
+        BC7SolidTable() {
+          for (int32_t value = 0; value < 256; ++value) {
+            int32_t bestErr = std::numeric_limits<int32_t>::max();
+            for (int32_t e0 = 0; e0 < 128 && bestErr > 0; ++e0) {
+              for (int32_t e1 = 0; e1 < 128 && bestErr > 0; ++e1) {
+                int32_t const colour = ((64 - bc7Weights2[1]) * bc7Expand(e0, 7) + bc7Weights2[1] * bc7Expand(e1, 7) + 32) >> 6;
+                int32_t const err    = std::abs(colour - value);
+                if (err < bestErr) {
+                  bestErr        = err;
+                  ends[value][0] = uint8_t(e0);
+                  ends[value][1] = uint8_t(e1);
+                }
+              }
+            }
+          }
+        }
+      };
+
+      /// Encode a block of a single colour with mode 5. Every 8-bit colour can be represented exactly.
+      void encodeBC7Solid(uint8_t * pOut, Block const & block) {
+        static BC7SolidTable const table;
+
+        std::memset(pOut, 0, 16);
+        BitWriter writer{pOut};
+        writer.write(1 << 5, 6);
+        writer.write(0, 2); // No rotation
+        for (int c = 0; c < 3; ++c)
+          for (int e = 0; e < 2; ++e)
+            writer.write(table.ends[block.px[0][c]][e], 7);
+        for (int e = 0; e < 2; ++e)
+          writer.write(block.px[0][3], 8);
+        for (int i = 0; i < 16; ++i)
+          writer.write(1, i == 0 ? 1 : 2);
+        // Alpha indices are all 0.
+      }
+
+      /// Encode the opaque `block` with mode 1. Two subsets of RGB endpoints with 3-bit indices.
+      /// The partitions that best fit a line in each subset are encoded, and the best is kept.
+      int64_t encodeBC7Mode1(uint8_t * pOut, Block const & block, BlockCompressionQuality quality) {
+        constexpr int32_t Candidates = 4;
+
+        // Rank the partitions by the variance of each subset away from its principal axis.
+        float   estimates[64];
+        int32_t order[64];
+        for (int32_t part = 0; part < 64; ++part) {
+          float estimate = 0;
+          for (int32_t s = 0; s < 2; ++s) {
+            Vec<3>  points[16];
+            int64_t count = 0;
+            for (int i = 0; i < 16; ++i)
+              if (bc7Subset(2, part, i) == s) {
+                for (int c = 0; c < 3; ++c)
+                  points[count][c] = block.px[i][c];
+                ++count;
+              }
+
+            Vec<3> ends[2];
+            fitLine(points, count, 3, ends);
+            Vec<3> axis;
+            for (int c = 0; c < 3; ++c)
+              axis[c] = ends[0][c] - ends[1][c];
+            float const lenSq = dot(axis, axis);
+            for (int64_t i = 0; i < count; ++i) {
+              Vec<3> d;
+              for (int c = 0; c < 3; ++c)
+                d[c] = points[i][c] - ends[1][c];
+              float const t = lenSq > 0 ? dot(d, axis) / lenSq : 0;
+              for (int c = 0; c < 3; ++c)
+                estimate += (d[c] - axis[c] * t) * (d[c] - axis[c] * t);
+            }
+          }
+          estimates[part] = estimate;
+          order[part]     = part;
+        }
+        std::partial_sort(order, order + Candidates, order + 64, [&](int32_t a, int32_t b) { return estimates[a] < estimates[b]; });
+
+        int64_t         bestError = std::numeric_limits<int64_t>::max();
+        int32_t         bestPart  = 0;
+        BC7SubsetFit<3> bestFits[2];
+        uint8_t         bestIdx[16] = {};
+        for (int32_t candidate = 0; candidate < Candidates; ++candidate) {
+          int32_t const   part = order[candidate];
+          BC7SubsetFit<3> fits[2];
+          uint8_t         idx[16] = {};
+          int64_t         error   = 0;
+          for (int32_t s = 0; s < 2; ++s) {
+            Vec<3>  points[16];
+            int32_t pixels[16];
+            int64_t count = 0;
+            for (int i = 0; i < 16; ++i)
+              if (bc7Subset(2, part, i) == s) {
+                for (int c = 0; c < 3; ++c)
+                  points[count][c] = block.px[i][c];
+                pixels[count++] = i;
+              }
+
+            fits[s] = fitBC7Subset(points, count, 6, 3, true, quality);
+            error += fits[s].error;
+            for (int64_t i = 0; i < count; ++i)
+              idx[pixels[i]] = fits[s].idx[i];
+          }
+
+          if (error < bestError) {
+            bestError   = error;
+            bestPart    = part;
+            bestFits[0] = fits[0];
+            bestFits[1] = fits[1];
+            std::memcpy(bestIdx, idx, 16);
+          }
+        }
+
+        // The indices of the anchor pixels have an implicit high bit of 0.
+        int32_t const anchors[2] = {0, bc7Anchors2[bestPart]};
+        for (int32_t s = 0; s < 2; ++s) {
+          if (bestIdx[anchors[s]] < 4)
+            continue;
+          std::swap(bestFits[s].ends[0], bestFits[s].ends[1]);
+          for (int i = 0; i < 16; ++i)
+            if (bc7Subset(2, bestPart, i) == s)
+              bestIdx[i] = uint8_t(7 - bestIdx[i]);
+        }
+
+        std::memset(pOut, 0, 16);
+        BitWriter writer{pOut};
+        writer.write(1 << 1, 2);
+        writer.write(bestPart, 6);
+        for (int c = 0; c < 3; ++c)
+          for (int s = 0; s < 2; ++s)
+            for (int e = 0; e < 2; ++e)
+              writer.write(bestFits[s].ends[e][c], 6);
+        writer.write(bestFits[0].pbits[0], 1);
+        writer.write(bestFits[1].pbits[0], 1);
+        for (int i = 0; i < 16; ++i)
+          writer.write(bestIdx[i], bc7IsAnchor(2, bestPart, i) ? 2 : 3);
+
+        return bestError;
+      }
+
+      /// Encode `block` with mode 6, and try other modes that may suit the block better.
+      /// Mode 5 is tried for blocks with alpha, where alpha does not vary with the colour. Mode 1 is tried for opaque
+      /// blocks at high quality, for blocks with more than one gradient.
+      void encodeBC7Block(uint8_t * pOut, Block const & block, BlockCompressionQuality quality) {
+        bool solid = true;
+        for (int i = 1; i < 16; ++i)
+          solid &= std::memcmp(block.px[i], block.px[0], 4) == 0;
+        if (solid)
+          return encodeBC7Solid(pOut, block);
+
+        int64_t const error = encodeBC7Mode6(pOut, block, quality);
+        if (quality == BlockCompressionQuality_Fast || error == 0)
+          return;
+
+        bool opaque = true;
+        for (int i = 0; i < 16; ++i)
+          opaque &= block.px[i][3] == 255;
+
+        uint8_t candidate[16];
+        int64_t candidateError = error;
+        if (!opaque)
+          candidateError = encodeBC7Mode5(candidate, block, quality);
+        else if (quality == BlockCompressionQuality_High)
+          candidateError = encodeBC7Mode1(candidate, block, quality);
+
+        if (candidateError < error)
+          std::memcpy(pOut, candidate, 16);
+      }
+
+      // Formats
+
+      void encodeBlock(PixelFormat format, uint8_t * pOut, Block const & block, BlockCompressionQuality quality) {
+        uint8_t channel[16];
+        const auto gather = [&](int c) {
+          for (int i = 0; i < 16; ++i)
+            channel[i] = block.px[i][c];
+          return channel;
+        };
+
+        switch (format) {
+        case PixelFormat_BC1: encodeColourBlock(pOut, block, quality, true); break;
+        case PixelFormat_BC3:
+          encodeChannelBlock(pOut, gather(3), quality);
+          encodeColourBlock(pOut + 8, block, quality, false);
+          break;
+        case PixelFormat_BC4: encodeChannelBlock(pOut, gather(0), quality); break;
+        case PixelFormat_BC5:
+          encodeChannelBlock(pOut, gather(0), quality);
+          encodeChannelBlock(pOut + 8, gather(1), quality);
+          break;
+        case PixelFormat_BC7: encodeBC7Block(pOut, block, quality); break;
+        }
+      }
+
+      void decodeBlock(PixelFormat format, uint8_t const * pIn, Block * pBlock) {
+        for (int i = 0; i < 16; ++i) {
+          pBlock->px[i][0] = pBlock->px[i][1] = pBlock->px[i][2] = 0;
+          pBlock->px[i][3]                                      = 255;
+        }
+
+        switch (format) {
+        case PixelFormat_BC1: decodeColourBlock(pIn, false, pBlock); break;
+        case PixelFormat_BC3:
+          decodeColourBlock(pIn + 8, true, pBlock);
+          decodeChannelBlock(pIn, 3, pBlock);
+          break;
+        case PixelFormat_BC4: decodeChannelBlock(pIn, 0, pBlock); break;
+        case PixelFormat_BC5:
+          decodeChannelBlock(pIn, 0, pBlock);
+          decodeChannelBlock(pIn + 8, 1, pBlock);
+          break;
+        case PixelFormat_BC7: decodeBC7Block(pIn, pBlock); break;
+        }
+      }
+
+      /// Number of channels compared when measuring the error of `format`.
+      int32_t storedChannels(PixelFormat format) {
+        switch (format) {
+        case PixelFormat_BC4: return 1;
+        case PixelFormat_BC5: return 2;
+        }
+        return 4;
+      }
+
+      SurfaceError calculateError(double squaredError, int64_t samples) {
+        SurfaceError result;
+        result.rmse = samples > 0 ? std::sqrt(squaredError / double(samples)) : 0;
+        result.psnr = result.rmse > 0 ? 20.0 * std::log10(255.0 / result.rmse) : std::numeric_limits<double>::infinity();
+        return result;
+      }
+
+      /// Load the block at `blockCoord` from an RGBAu8 surface. Pixels outside the surface repeat the edge.
+      void loadBlock(Surface const & src, Vec3i blockCoord, Block * pBlock) {
+        for (int32_t y = 0; y < 4; ++y) {
+          for (int32_t x = 0; x < 4; ++x) {
+            Vec3i const coord = {std::min(blockCoord.x * 4 + x, src.size.x - 1), std::min(blockCoord.y * 4 + y, src.size.y - 1), blockCoord.z};
+            std::memcpy(pBlock->px[y * 4 + x], getSurfacePixel(src, coord), 4);
+          }
+        }
+      }
+
+      /// Store the pixels of the block at `blockCoord` that are inside the RGBAu8 surface `pDst`.
+      void storeBlock(Surface const & dst, Vec3i blockCoord, Block const & block) {
+        for (int32_t y = 0; y < 4 && blockCoord.y * 4 + y < dst.size.y; ++y)
+          for (int32_t x = 0; x < 4 && blockCoord.x * 4 + x < dst.size.x; ++x)
+            std::memcpy(getSurfacePixel(dst, {blockCoord.x * 4 + x, blockCoord.y * 4 + y, blockCoord.z}), block.px[y * 4 + x], 4);
+      }
+
+      /// The fewest rows of blocks given to each parallel task.
+      constexpr int64_t MinBandRows = 4;
+
+      /// Get `src` as RGBAu8. `pStorage` receives the converted surface if a conversion was needed.
+      Surface toRGBAu8(Surface const & src, Surface * pStorage, ThreadPool * pThreads) {
+        if (src.format == PixelFormat_RGBAu8)
+          return src;
+
+        pStorage->format = PixelFormat_RGBAu8;
+        pStorage->size   = src.size;
+        ConvertSurfaceOptions options;
+        options.pThreads = pThreads;
+        convertSurface(pStorage, src, options);
+        return *pStorage;
+      }
+    } // namespace
+
+    bool compressSurface(Surface * pDst, Surface const & src, BlockCompressionOptions const & options, SurfaceError * pError) {
+      int64_t const blockSize = getPixelFormatBlockSize(pDst->format);
+      if (blockSize == 0 || src.pBuffer == nullptr || src.size.x <= 0 || src.size.y <= 0)
+        return false;
+
+      Surface       storage;
+      Surface const pixels = toRGBAu8(src, &storage, options.pThreads);
+      if (pixels.pBuffer == nullptr)
+        return false;
+
+      pDst->size = src.size;
+      if (pDst->pBuffer == nullptr)
+        pDst->pBuffer = allocateSurface(*pDst);
+
+      int64_t const blocksX   = (src.size.x + 3) / 4;
+      int64_t const blocksY   = getSurfaceRowCount(*pDst);
+      int64_t const depth     = std::max(src.size.z, 1);
+      int64_t const pitch     = getSurfacePitch(*pDst);
+      int32_t const channels  = storedChannels(pDst->format);
+      PixelFormat   format    = pDst->format;
+      uint8_t *     pDstBytes = (uint8_t *)pDst->pBuffer;
+
+      Vector<double> rowErrors;
+      if (pError != nullptr)
+        rowErrors.resize(blocksY * depth, 0.0);
+
+      parallelFor(options.pThreads, blocksY * depth, MinBandRows, [&](int64_t first, int64_t last) {
+        Block block;
+        Block decoded;
+        for (int64_t row = first; row < last; ++row) {
+          Vec3i const blockCoord = {0, int32_t(row % blocksY), int32_t(row / blocksY)};
+          uint8_t *   pRow       = pDstBytes + row * pitch;
+          for (int64_t x = 0; x < blocksX; ++x) {
+            loadBlock(pixels, {int32_t(x), blockCoord.y, blockCoord.z}, &block);
+            encodeBlock(format, pRow + x * blockSize, block, options.quality);
+
+            if (pError == nullptr)
+              continue;
+
+            // Only measure pixels inside the surface, so padding does not count towards the error.
+            decodeBlock(format, pRow + x * blockSize, &decoded);
+            for (int32_t py = 0; py < 4 && blockCoord.y * 4 + py < src.size.y; ++py)
+              for (int32_t px = 0; px < 4 && x * 4 + px < src.size.x; ++px)
+                for (int32_t c = 0; c < channels; ++c)
+                  rowErrors[row] += square(block.px[py * 4 + px][c] - decoded.px[py * 4 + px][c]);
+          }
+        }
+      });
+
+      if (pError != nullptr) {
+        double total = 0;
+        for (double rowError : rowErrors)
+          total += rowError;
+        *pError = calculateError(total, int64_t(src.size.x) * src.size.y * depth * channels);
+      }
+
+      storage.free();
+      return true;
+    }
+
+    bool decompressSurface(Surface * pDst, Surface const & src, ThreadPool * pThreads) {
+      int64_t const blockSize = getPixelFormatBlockSize(src.format);
+      if (blockSize == 0 || src.pBuffer == nullptr)
+        return false;
+
+      // Decode to RGBAu8, then convert to the destination format if needed.
+      Surface decoded;
+      decoded.format  = PixelFormat_RGBAu8;
+      decoded.size    = src.size;
+      decoded.pBuffer = pDst->format == PixelFormat_RGBAu8 ? pDst->pBuffer : nullptr;
+      decoded.pitch   = pDst->format == PixelFormat_RGBAu8 ? pDst->pitch : 0;
+      if (decoded.pBuffer == nullptr)
+        decoded.pBuffer = allocateSurface(decoded);
+
+      int64_t const blocksX  = (src.size.x + 3) / 4;
+      int64_t const blocksY  = getSurfaceRowCount(src);
+      int64_t const pitch    = getSurfacePitch(src);
+      uint8_t const * pBytes = (uint8_t const *)src.pBuffer;
+      parallelFor(pThreads, blocksY * std::max(src.size.z, 1), MinBandRows, [&](int64_t first, int64_t last) {
+        Block block;
+        for (int64_t row = first; row < last; ++row) {
+          Vec3i const blockCoord = {0, int32_t(row % blocksY), int32_t(row / blocksY)};
+          for (int64_t x = 0; x < blocksX; ++x) {
+            decodeBlock(src.format, pBytes + row * pitch + x * blockSize, &block);
+            storeBlock(decoded, {int32_t(x), blockCoord.y, blockCoord.z}, block);
+          }
+        }
+      });
+
+      if (pDst->format == PixelFormat_RGBAu8) {
+        pDst->size    = src.size;
+        pDst->pBuffer = decoded.pBuffer;
+        return true;
+      }
+
+      ConvertSurfaceOptions options;
+      options.pThreads = pThreads;
+      convertSurface(pDst, decoded, options);
+      decoded.free();
+      return true;
+    }
+
+    SurfaceError measureSurfaceError(Surface const & reference, Surface const & surface) {
+      if (reference.size != surface.size || reference.pBuffer == nullptr || surface.pBuffer == nullptr)
+        return calculateError(255.0 * 255.0, 1);
+
+      Surface       refStorage;
+      Surface       testStorage;
+      Surface const a = toRGBAu8(reference, &refStorage, nullptr);
+      Surface const b = toRGBAu8(surface, &testStorage, nullptr);
+
+      int32_t const channels = storedChannels(surface.format);
+      int64_t const depth    = std::max(surface.size.z, 1);
+      double        total    = 0;
+      for (int32_t z = 0; z < depth; ++z) {
+        for (int32_t y = 0; y < surface.size.y; ++y) {
+          uint8_t const * pA = (uint8_t const *)getSurfacePixel(a, {0, y, z});
+          uint8_t const * pB = (uint8_t const *)getSurfacePixel(b, {0, y, z});
+          for (int32_t x = 0; x < surface.size.x; ++x)
+            for (int32_t c = 0; c < channels; ++c)
+              total += square(pA[x * 4 + c] - pB[x * 4 + c]);
+        }
+      }
+
+      refStorage.free();
+      testStorage.free();
+      return calculateError(total, int64_t(surface.size.x) * surface.size.y * depth * channels);
+    }
+  } // namespace media
+} // namespace bfc
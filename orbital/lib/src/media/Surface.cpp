@@ -1,6 +1,26 @@
 #include "media/Surface.h"
+#include "media/BlockCompression.h"
 #include "core/Stream.h"
 #include "core/File.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(BFC_X64) || defined(BFC_X86) || defined(__SSE2__)
+#define BFC_SURFACE_SIMD
+#include <immintrin.h>
+#endif
+
+// Kernels for instruction sets above the compiler's baseline are selected at runtime.
+// GCC and Clang require them to be marked with the instruction set they use.
+#ifdef BFC_MSVC
+#include <intrin.h>
+#define BFC_SURFACE_TARGET(isa)
+#else
+#define BFC_SURFACE_TARGET(isa) __attribute__((target(isa)))
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_FREE(p)    ::bfc::mem::free(p)
@@ -10,41 +30,969 @@
 
 namespace bfc {
   namespace media {
-    void convertSurface(Surface* pDst, Surface const& src) {
-      switch (src.format) {
-      case PixelFormat_Ru8:
-        convertSurface<Ru8>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_Lu8:
-        convertSurface<Lu8>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_LAu8:
-        convertSurface<LAu8>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_RGBu8:
-        convertSurface<RGBu8>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_RGBAu8:
-        convertSurface<RGBAu8>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_Rf32:
-        convertSurface<Rf32>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
-      case PixelFormat_RGBAf32:
-        convertSurface<RGBAf32>(pDst, src.pBuffer, src.size, src.pitch);
-        break;
+    namespace {
+      /// Instruction sets used by the conversion kernels. Detected at runtime, so the library
+      /// runs on any x64 CPU while using wider kernels where they are available.
+      struct CPUFeatures {
+        bool sse41 = false;
+        bool avx2  = false;
+      };
+
+      CPUFeatures detectCPUFeatures() {
+        CPUFeatures features;
+#if defined(BFC_SURFACE_SIMD) && defined(BFC_MSVC)
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        features.sse41        = (info[2] & (1 << 19)) != 0;
+        const bool osxsave    = (info[2] & (1 << 27)) != 0;
+        const bool avx        = (info[2] & (1 << 28)) != 0;
+        const bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+        if (maxLeaf >= 7 && ymmEnabled) {
+          __cpuidex(info, 7, 0);
+          features.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#elif defined(BFC_SURFACE_SIMD)
+        __builtin_cpu_init();
+        features.sse41 = __builtin_cpu_supports("sse4.1");
+        features.avx2  = __builtin_cpu_supports("avx2");
+#endif
+        return features;
+      }
+
+      CPUFeatures const & cpuFeatures() {
+        static const CPUFeatures features = detectCPUFeatures();
+        return features;
+      }
+
+      constexpr float U8ToFloat = 1.0f / 255.0f;
+
+      /// Clamp `value` to [0, 1] and round it to 8 bits. NaN is converted to 0.
+      /// Matches the vector kernels exactly.
+      inline uint8_t floatToU8(float value) {
+        value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+        return uint8_t(value * 255.0f + 0.5f);
+      }
+
+      template<typename T>
+      T srgbToLinear(T value) {
+        return value <= T(0.04045) ? value / T(12.92) : std::pow((value + T(0.055)) / T(1.055), T(2.4));
+      }
+
+      template<typename T>
+      T linearToSrgb(T value) {
+        return value <= T(0.0031308) ? value * T(12.92) : T(1.055) * std::pow(value, T(1.0 / 2.4)) - T(0.055);
+      }
+
+      /// Tables used to convert 8-bit sRGB channels to and from linear floats.
+      /// Encoding uses a piecewise linear fit of the curve, indexed by the exponent and top 3 mantissa
+      /// bits of the linear value. The fit is evaluated with integer arithmetic, so the vector kernels
+      /// produce the same results as the scalar code. Results are within 0.6 of the exact value.
+      struct SRGBTables {
+        constexpr static uint32_t MinValue  = 0x39000000; ///< 2^-13. Smaller values encode to 0.
+        constexpr static uint32_t AlmostOne = 0x3f7fffff; ///< The largest float below 1.
+        constexpr static int64_t  Buckets   = 104;
+
+        float    decode[256];
+        uint32_t encode[Buckets]; ///< Bias in the high 16 bits, scale in the low 16 bits.
+
+        SRGBTables() {
+          for (int64_t i = 0; i < 256; ++i) {
+            decode[i] = (float)srgbToLinear(i / 255.0);
+          }
+
+          // Least squares fit of a line to the curve, sampled at the centre of each step of the bucket.
+          for (int64_t bucket = 0; bucket < Buckets; ++bucket) {
+            double sumT = 0, sumY = 0, sumTT = 0, sumTY = 0;
+            for (int64_t t = 0; t < 256; ++t) {
+              const uint32_t bits = MinValue + uint32_t(bucket << 20) + uint32_t(t << 12) + (1u << 11);
+              float          x;
+              memcpy(&x, &bits, sizeof(x));
+              const double y = linearToSrgb<double>(x) * 255.0;
+              sumT += t;
+              sumY += y;
+              sumTT += double(t * t);
+              sumTY += t * y;
+            }
+
+            const double slope  = (256 * sumTY - sumT * sumY) / (256 * sumTT - sumT * sumT);
+            const double offset = (sumY - slope * sumT) / 256;
+            const uint32_t bias  = (uint32_t)std::lround((offset + 0.5) * 128.0); // Stored as 16.16 fixed point, shifted down by 9.
+            const uint32_t scale = (uint32_t)std::lround(slope * 65536.0);
+            encode[bucket]       = (bias << 16) | scale;
+          }
+        }
+      };
+
+      SRGBTables const & srgbTables() {
+        static const SRGBTables tables;
+        return tables;
+      }
+
+      inline uint8_t encodeSRGB(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if (!(bits > SRGBTables::MinValue && value > 0.0f)) // Also true for NaN
+          bits = SRGBTables::MinValue;
+        else if (bits > SRGBTables::AlmostOne)
+          bits = SRGBTables::AlmostOne;
+
+        const uint32_t entry = srgbTables().encode[(bits - SRGBTables::MinValue) >> 20];
+        const uint32_t bias  = (entry >> 16) << 9;
+        const uint32_t scale = entry & 0xffff;
+        const uint32_t t     = (bits >> 12) & 0xff;
+        return (uint8_t)std::min<uint32_t>((bias + scale * t) >> 16, 255);
+      }
+
+#ifdef BFC_SURFACE_SIMD
+      // Each kernel converts as many elements as it can and returns the number converted.
+      // The caller converts the remainder with scalar code.
+
+      BFC_SURFACE_TARGET("avx2") int64_t u8ToF32_AVX2(float * pDst, uint8_t const * pSrc, int64_t count) {
+        const __m256 scale = _mm256_set1_ps(U8ToFloat);
+        int64_t      i     = 0;
+        for (; i + 8 <= count; i += 8) {
+          const __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)(pSrc + i)));
+          _mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") int64_t u8ToF32_SSE41(float * pDst, uint8_t const * pSrc, int64_t count) {
+        const __m128 scale = _mm_set1_ps(U8ToFloat);
+        int64_t      i     = 0;
+        for (; i + 16 <= count; i += 16) {
+          const __m128i bytes = _mm_loadu_si128((__m128i const *)(pSrc + i));
+          _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes)), scale));
+          _mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4))), scale));
+          _mm_storeu_ps(pDst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8))), scale));
+          _mm_storeu_ps(pDst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12))), scale));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("avx2") inline __m256i quantizeU8_AVX2(__m256 value) {
+        value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") inline __m128i quantizeU8_SSE41(__m128 value) {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+      }
+
+      /// Pack four vectors of 32-bit integers to bytes, in order.
+      BFC_SURFACE_TARGET("avx2") inline __m256i packU8_AVX2(__m256i a, __m256i b, __m256i c, __m256i d) {
+        // Packing works within each 128-bit lane, so the 4 byte groups end up interleaved between the lanes.
+        const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+        return _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") inline __m128i packU8_SSE41(__m128i a, __m128i b, __m128i c, __m128i d) {
+        return _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d));
+      }
+
+      BFC_SURFACE_TARGET("avx2") int64_t f32ToU8_AVX2(uint8_t * pDst, float const * pSrc, int64_t count) {
+        int64_t i = 0;
+        for (; i + 32 <= count; i += 32) {
+          const __m256i a = quantizeU8_AVX2(_mm256_loadu_ps(pSrc + i));
+          const __m256i b = quantizeU8_AVX2(_mm256_loadu_ps(pSrc + i + 8));
+          const __m256i c = quantizeU8_AVX2(_mm256_loadu_ps(pSrc + i + 16));
+          const __m256i d = quantizeU8_AVX2(_mm256_loadu_ps(pSrc + i + 24));
+          _mm256_storeu_si256((__m256i *)(pDst + i), packU8_AVX2(a, b, c, d));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") int64_t f32ToU8_SSE41(uint8_t * pDst, float const * pSrc, int64_t count) {
+        int64_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+          const __m128i a = quantizeU8_SSE41(_mm_loadu_ps(pSrc + i));
+          const __m128i b = quantizeU8_SSE41(_mm_loadu_ps(pSrc + i + 4));
+          const __m128i c = quantizeU8_SSE41(_mm_loadu_ps(pSrc + i + 8));
+          const __m128i d = quantizeU8_SSE41(_mm_loadu_ps(pSrc + i + 12));
+          _mm_storeu_si128((__m128i *)(pDst + i), packU8_SSE41(a, b, c, d));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") int64_t rgbToRgba_SSE41(uint8_t * pDst, uint8_t const * pSrc, int64_t count) {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha   = _mm_set1_epi32((int)0xFF000000);
+        int64_t       i       = 0;
+        // Each load reads 16 bytes but only uses 12, so stop early to avoid reading past the end of the row.
+        for (; i + 6 <= count; i += 4) {
+          const __m128i rgb = _mm_loadu_si128((__m128i const *)(pSrc + i * 3));
+          _mm_storeu_si128((__m128i *)(pDst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") int64_t rgbaToRgb_SSE41(uint8_t * pDst, uint8_t const * pSrc, int64_t count) {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        int64_t       i       = 0;
+        for (; i + 4 <= count; i += 4) {
+          const __m128i rgb  = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)(pSrc + i * 4)), shuffle);
+          const int32_t last = _mm_extract_epi32(rgb, 2);
+          _mm_storel_epi64((__m128i *)(pDst + i * 3), rgb);
+          memcpy(pDst + i * 3 + 8, &last, sizeof(last));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("avx2") int64_t decodeSRGB_AVX2(float * pDst, uint8_t const * pSrc, int64_t count) {
+        float const * pTable = srgbTables().decode;
+        const __m256  scale  = _mm256_set1_ps(U8ToFloat);
+        int64_t       i      = 0;
+        for (; i + 2 <= count; i += 2) {
+          const __m256i values  = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)(pSrc + i * 4)));
+          const __m256  decoded = _mm256_i32gather_ps(pTable, values, 4);
+          const __m256  alpha   = _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale);
+          _mm256_storeu_ps(pDst + i * 4, _mm256_blend_ps(decoded, alpha, 0x88));
+        }
+        return i;
+      }
+
+      /// Encode 8 linear values to sRGB, as 32-bit integers.
+      BFC_SURFACE_TARGET("avx2") inline __m256i encodeChannelsSRGB_AVX2(__m256 value, uint32_t const * pTable) {
+        const __m256i minValue = _mm256_set1_epi32(SRGBTables::MinValue);
+        value                  = _mm256_max_ps(value, _mm256_castsi256_ps(minValue));
+        value                  = _mm256_min_ps(value, _mm256_castsi256_ps(_mm256_set1_epi32(SRGBTables::AlmostOne)));
+
+        const __m256i bits  = _mm256_castps_si256(value);
+        const __m256i index = _mm256_srli_epi32(_mm256_sub_epi32(bits, minValue), 20);
+        const __m256i entry = _mm256_i32gather_epi32((int const *)pTable, index, 4);
+        const __m256i bias  = _mm256_slli_epi32(_mm256_srli_epi32(entry, 16), 9);
+        const __m256i scale = _mm256_and_si256(entry, _mm256_set1_epi32(0xffff));
+        const __m256i t     = _mm256_and_si256(_mm256_srli_epi32(bits, 12), _mm256_set1_epi32(0xff));
+        return _mm256_srli_epi32(_mm256_add_epi32(bias, _mm256_mullo_epi32(scale, t)), 16);
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") inline __m128i encodeChannelsSRGB_SSE41(__m128 value, uint32_t const * pTable) {
+        const __m128i minValue = _mm_set1_epi32(SRGBTables::MinValue);
+        value                  = _mm_max_ps(value, _mm_castsi128_ps(minValue));
+        value                  = _mm_min_ps(value, _mm_castsi128_ps(_mm_set1_epi32(SRGBTables::AlmostOne)));
+
+        const __m128i bits  = _mm_castps_si128(value);
+        const __m128i index = _mm_srli_epi32(_mm_sub_epi32(bits, minValue), 20);
+        const __m128i entry = _mm_setr_epi32(pTable[_mm_extract_epi32(index, 0)], pTable[_mm_extract_epi32(index, 1)],
+                                             pTable[_mm_extract_epi32(index, 2)], pTable[_mm_extract_epi32(index, 3)]);
+        const __m128i bias  = _mm_slli_epi32(_mm_srli_epi32(entry, 16), 9);
+        const __m128i scale = _mm_and_si128(entry, _mm_set1_epi32(0xffff));
+        const __m128i t     = _mm_and_si128(_mm_srli_epi32(bits, 12), _mm_set1_epi32(0xff));
+        return _mm_srli_epi32(_mm_add_epi32(bias, _mm_mullo_epi32(scale, t)), 16);
+      }
+
+      BFC_SURFACE_TARGET("avx2") inline __m256i encodePixelsSRGB_AVX2(float const * pSrc, uint32_t const * pTable) {
+        const __m256 value = _mm256_loadu_ps(pSrc);
+        return _mm256_blend_epi32(encodeChannelsSRGB_AVX2(value, pTable), quantizeU8_AVX2(value), 0x88);
+      }
+
+      BFC_SURFACE_TARGET("avx2") int64_t encodeSRGB_AVX2(uint8_t * pDst, float const * pSrc, int64_t count) {
+        uint32_t const * pTable = srgbTables().encode;
+        int64_t          i      = 0;
+        for (; i + 8 <= count; i += 8) {
+          const __m256i a = encodePixelsSRGB_AVX2(pSrc + i * 4, pTable);
+          const __m256i b = encodePixelsSRGB_AVX2(pSrc + i * 4 + 8, pTable);
+          const __m256i c = encodePixelsSRGB_AVX2(pSrc + i * 4 + 16, pTable);
+          const __m256i d = encodePixelsSRGB_AVX2(pSrc + i * 4 + 24, pTable);
+          _mm256_storeu_si256((__m256i *)(pDst + i * 4), packU8_AVX2(a, b, c, d));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") inline __m128i encodePixelSRGB_SSE41(float const * pSrc, uint32_t const * pTable) {
+        const __m128 value = _mm_loadu_ps(pSrc);
+        return _mm_blend_epi16(encodeChannelsSRGB_SSE41(value, pTable), quantizeU8_SSE41(value), 0xC0);
+      }
+
+      BFC_SURFACE_TARGET("sse4.1") int64_t encodeSRGB_SSE41(uint8_t * pDst, float const * pSrc, int64_t count) {
+        uint32_t const * pTable = srgbTables().encode;
+        int64_t          i      = 0;
+        for (; i + 4 <= count; i += 4) {
+          const __m128i a = encodePixelSRGB_SSE41(pSrc + i * 4, pTable);
+          const __m128i b = encodePixelSRGB_SSE41(pSrc + i * 4 + 4, pTable);
+          const __m128i c = encodePixelSRGB_SSE41(pSrc + i * 4 + 8, pTable);
+          const __m128i d = encodePixelSRGB_SSE41(pSrc + i * 4 + 12, pTable);
+          _mm_storeu_si128((__m128i *)(pDst + i * 4), packU8_SSE41(a, b, c, d));
+        }
+        return i;
+      }
+
+      BFC_SURFACE_TARGET("avx2") void accumulate_AVX2(float * pDst, float const * pSrc, float weight, int64_t count) {
+        const __m256 w = _mm256_set1_ps(weight);
+        int64_t      i = 0;
+        for (; i + 8 <= count; i += 8) {
+          _mm256_storeu_ps(pDst + i, _mm256_add_ps(_mm256_loadu_ps(pDst + i), _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), w)));
+        }
+
+        for (; i < count; ++i) {
+          pDst[i] += pSrc[i] * weight;
+        }
+      }
+#endif
+
+      /// Convert 8-bit channels to floats in [0, 1].
+      void u8ToF32(float * pDst, uint8_t const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().avx2)
+          i = u8ToF32_AVX2(pDst, pSrc, count);
+        else if (cpuFeatures().sse41)
+          i = u8ToF32_SSE41(pDst, pSrc, count);
+#endif
+        for (; i < count; ++i)
+          pDst[i] = pSrc[i] * U8ToFloat;
+      }
+
+      /// Convert floats to 8-bit channels, clamping them to [0, 1] and rounding to the nearest value.
+      void f32ToU8(uint8_t * pDst, float const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().avx2)
+          i = f32ToU8_AVX2(pDst, pSrc, count);
+        else if (cpuFeatures().sse41)
+          i = f32ToU8_SSE41(pDst, pSrc, count);
+#endif
+        for (; i < count; ++i)
+          pDst[i] = floatToU8(pSrc[i]);
+      }
+
+      void rgbToRgba(uint8_t * pDst, uint8_t const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().sse41)
+          i = rgbToRgba_SSE41(pDst, pSrc, count);
+#endif
+        for (; i < count; ++i) {
+          pDst[i * 4 + 0] = pSrc[i * 3 + 0];
+          pDst[i * 4 + 1] = pSrc[i * 3 + 1];
+          pDst[i * 4 + 2] = pSrc[i * 3 + 2];
+          pDst[i * 4 + 3] = 255;
+        }
+      }
+
+      void rgbaToRgb(uint8_t * pDst, uint8_t const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().sse41)
+          i = rgbaToRgb_SSE41(pDst, pSrc, count);
+#endif
+        for (; i < count; ++i) {
+          pDst[i * 3 + 0] = pSrc[i * 4 + 0];
+          pDst[i * 3 + 1] = pSrc[i * 4 + 1];
+          pDst[i * 3 + 2] = pSrc[i * 4 + 2];
+        }
+      }
+
+      /// Convert RGBA pixels with sRGB encoded 8-bit channels to linear floats.
+      void decodeSRGB(float * pDst, uint8_t const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().avx2)
+          i = decodeSRGB_AVX2(pDst, pSrc, count);
+#endif
+        float const * pTable = srgbTables().decode;
+        for (; i < count; ++i) {
+          pDst[i * 4 + 0] = pTable[pSrc[i * 4 + 0]];
+          pDst[i * 4 + 1] = pTable[pSrc[i * 4 + 1]];
+          pDst[i * 4 + 2] = pTable[pSrc[i * 4 + 2]];
+          pDst[i * 4 + 3] = pSrc[i * 4 + 3] * U8ToFloat;
+        }
+      }
+
+      /// Convert RGBA pixels with linear float channels to sRGB encoded 8-bit channels.
+      void encodeSRGB(uint8_t * pDst, float const * pSrc, int64_t count) {
+        int64_t i = 0;
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().avx2)
+          i = encodeSRGB_AVX2(pDst, pSrc, count);
+        else if (cpuFeatures().sse41)
+          i = encodeSRGB_SSE41(pDst, pSrc, count);
+#endif
+        for (; i < count; ++i) {
+          pDst[i * 4 + 0] = encodeSRGB(pSrc[i * 4 + 0]);
+          pDst[i * 4 + 1] = encodeSRGB(pSrc[i * 4 + 1]);
+          pDst[i * 4 + 2] = encodeSRGB(pSrc[i * 4 + 2]);
+          pDst[i * 4 + 3] = floatToU8(pSrc[i * 4 + 3]);
+        }
+      }
+
+      /// pDst[i] += pSrc[i] * weight
+      void accumulate(float * pDst, float const * pSrc, float weight, int64_t count) {
+#ifdef BFC_SURFACE_SIMD
+        if (cpuFeatures().avx2) {
+          accumulate_AVX2(pDst, pSrc, weight, count);
+          return;
+        }
+
+        const __m128 w = _mm_set1_ps(weight);
+        int64_t      i = 0;
+        for (; i + 4 <= count; i += 4) {
+          _mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(_mm_loadu_ps(pSrc + i), w)));
+        }
+#else
+        int64_t i = 0;
+#endif
+        for (; i < count; ++i) {
+          pDst[i] += pSrc[i] * weight;
+        }
+      }
+
+      /// Call `func` with a default constructed pixel of `format`.
+      /// @returns false if the format does not have a pixel type.
+      template<typename Func>
+      bool visitFormat(PixelFormat format, Func const & func) {
+        switch (format) {
+        case PixelFormat_RGBAu8: func(RGBAu8()); return true;
+        case PixelFormat_RGBu8: func(RGBu8()); return true;
+        case PixelFormat_Ru8: func(Ru8()); return true;
+        case PixelFormat_Lu8: func(Lu8()); return true;
+        case PixelFormat_LAu8: func(LAu8()); return true;
+        case PixelFormat_RGBAu16: func(RGBAu16()); return true;
+        case PixelFormat_RGBAu32: func(RGBAu32()); return true;
+        case PixelFormat_RGBAi32: func(RGBAi32()); return true;
+        case PixelFormat_RGBAf32: func(RGBAf32()); return true;
+        case PixelFormat_RGBf32: func(RGBf32()); return true;
+        case PixelFormat_Rf32: func(Rf32()); return true;
+        case PixelFormat_RGBAf64: func(RGBAf64()); return true;
+        default: return false;
+        }
+      }
+
+      template<typename T>
+      T quantizeChannel(float value) {
+        if constexpr (std::is_floating_point_v<T>) {
+          return T(value);
+        } else if constexpr (std::is_same_v<T, uint8_t>) {
+          return floatToU8(value);
+        } else {
+          const double clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+          return T(clamped * pixel_range<T>::Max + 0.5);
+        }
+      }
+
+      template<typename Format>
+      void readPixelsGeneric(float * pDst, void const * pSrc, int64_t count) {
+        Colour<Format> const * pPixels = (Colour<Format> const *)pSrc;
+        for (int64_t i = 0; i < count; ++i) {
+          const Colour<RGBAf32> pixel = pPixels[i];
+          pDst[i * 4 + 0]             = pixel.r;
+          pDst[i * 4 + 1]             = pixel.g;
+          pDst[i * 4 + 2]             = pixel.b;
+          pDst[i * 4 + 3]             = pixel.a;
+        }
+      }
+
+      template<typename Format>
+      void writePixelsGeneric(void * pDst, float const * pSrc, int64_t count) {
+        Colour<Format> * pPixels = (Colour<Format> *)pDst;
+        for (int64_t i = 0; i < count; ++i) {
+          Colour<Format> & pixel = pPixels[i];
+          if constexpr (Colour<Format>::hasR)
+            pixel.r = quantizeChannel<std::decay_t<decltype(pixel.r)>>(pSrc[i * 4 + 0]);
+          if constexpr (Colour<Format>::hasG)
+            pixel.g = quantizeChannel<std::decay_t<decltype(pixel.g)>>(pSrc[i * 4 + 1]);
+          if constexpr (Colour<Format>::hasB)
+            pixel.b = quantizeChannel<std::decay_t<decltype(pixel.b)>>(pSrc[i * 4 + 2]);
+          if constexpr (Colour<Format>::hasA)
+            pixel.a = quantizeChannel<std::decay_t<decltype(pixel.a)>>(pSrc[i * 4 + 3]);
+        }
+      }
+
+      /// Scratch memory used to convert rows. Each band of rows has its own, so bands can be converted in parallel.
+      struct RowScratch {
+        Vector<uint8_t> bytes;
+        Vector<float>   pixels;
+        Vector<float>   encoded;
+      };
+
+      /// Read pixels of any format as RGBA floats.
+      void readPixels(float * pDst, uint8_t const * pSrc, PixelFormat format, bool decode, int64_t count, RowScratch * pScratch) {
+        switch (format) {
+        case PixelFormat_RGBAu8:
+          if (decode)
+            decodeSRGB(pDst, pSrc, count);
+          else
+            u8ToF32(pDst, pSrc, count * 4);
+          return;
+        case PixelFormat_RGBu8:
+          pScratch->bytes.resize(count * 4);
+          rgbToRgba(pScratch->bytes.data(), pSrc, count);
+          readPixels(pDst, pScratch->bytes.data(), PixelFormat_RGBAu8, decode, count, pScratch);
+          return;
+        case PixelFormat_RGBAf32: memcpy(pDst, pSrc, count * sizeof(float) * 4); break;
+        default: visitFormat(format, [&](auto pixel) { readPixelsGeneric<decltype(pixel)>(pDst, pSrc, count); }); break;
+        }
+
+        if (decode) {
+          for (int64_t i = 0; i < count; ++i) {
+            for (int64_t c = 0; c < 3; ++c) {
+              pDst[i * 4 + c] = srgbToLinear(pDst[i * 4 + c]);
+            }
+          }
+        }
+      }
+
+      /// Write RGBA floats as pixels of any format.
+      void writePixels(uint8_t * pDst, float const * pSrc, PixelFormat format, bool encode, int64_t count, RowScratch * pScratch) {
+        switch (format) {
+        case PixelFormat_RGBAu8:
+          if (encode)
+            encodeSRGB(pDst, pSrc, count);
+          else
+            f32ToU8(pDst, pSrc, count * 4);
+          return;
+        case PixelFormat_RGBu8:
+          pScratch->bytes.resize(count * 4);
+          writePixels(pScratch->bytes.data(), pSrc, PixelFormat_RGBAu8, encode, count, pScratch);
+          rgbaToRgb(pDst, pScratch->bytes.data(), count);
+          return;
+        default: break;
+        }
+
+        if (encode) {
+          pScratch->encoded.resize(count * 4);
+          for (int64_t i = 0; i < count * 4; ++i) {
+            pScratch->encoded[i] = i % 4 == 3 ? pSrc[i] : linearToSrgb(pSrc[i]);
+          }
+          pSrc = pScratch->encoded.data();
+        }
+
+        if (format == PixelFormat_RGBAf32)
+          memcpy(pDst, pSrc, count * sizeof(float) * 4);
+        else
+          visitFormat(format, [&](auto pixel) { writePixelsGeneric<decltype(pixel)>(pDst, pSrc, count); });
       }
+
+      /// Convert a row of pixels to another format.
+      void convertRow(uint8_t * pDst, PixelFormat dstFormat, uint8_t const * pSrc, PixelFormat srcFormat, bool decode, bool encode, int64_t count,
+                      RowScratch * pScratch) {
+        if (!decode && !encode) {
+          if (dstFormat == srcFormat) {
+            memcpy(pDst, pSrc, count * getPixelFormatStride(srcFormat));
+            return;
+          } else if (srcFormat == PixelFormat_RGBu8 && dstFormat == PixelFormat_RGBAu8) {
+            rgbToRgba(pDst, pSrc, count);
+            return;
+          } else if (srcFormat == PixelFormat_RGBAu8 && dstFormat == PixelFormat_RGBu8) {
+            rgbaToRgb(pDst, pSrc, count);
+            return;
+          } else if ((srcFormat == PixelFormat_Ru8 || srcFormat == PixelFormat_Lu8) && dstFormat == PixelFormat_Rf32) {
+            u8ToF32((float *)pDst, pSrc, count);
+            return;
+          } else if (srcFormat == PixelFormat_Rf32 && dstFormat == PixelFormat_Ru8) {
+            f32ToU8(pDst, (float const *)pSrc, count);
+            return;
+          }
+        }
+
+        if (dstFormat == PixelFormat_RGBAf32 && !encode) {
+          readPixels((float *)pDst, pSrc, srcFormat, decode, count, pScratch);
+        } else if (srcFormat == PixelFormat_RGBAf32 && !decode) {
+          writePixels(pDst, (float const *)pSrc, dstFormat, encode, count, pScratch);
+        } else {
+          pScratch->pixels.resize(count * 4);
+          readPixels(pScratch->pixels.data(), pSrc, srcFormat, decode, count, pScratch);
+          writePixels(pDst, pScratch->pixels.data(), dstFormat, encode, count, pScratch);
+        }
+      }
+
+      /// The source pixels that contribute to each destination pixel along one axis, and their weights.
+      struct FilterKernel {
+        Vector<int64_t> first;   ///< First source pixel of each destination pixel.
+        Vector<int64_t> offsets; ///< Offset of the weights of each destination pixel. Has one more element than `first`.
+        Vector<float>   weights;
+        int64_t         maxTaps = 0;
+
+        int64_t taps(int64_t i) const {
+          return offsets[i + 1] - offsets[i];
+        }
+      };
+
+      double filterRadius(ResampleFilter filter) {
+        switch (filter) {
+        case ResampleFilter_Box: return 0.5;
+        case ResampleFilter_Bilinear: return 1.0;
+        case ResampleFilter_Lanczos: return 3.0;
+        case ResampleFilter_Kaiser: return 3.0;
+        default: return 0.0;
+        }
+      }
+
+      /// Modified Bessel function of the first kind, order 0. Used by the Kaiser window.
+      double besselI0(double x) {
+        double sum  = 1.0;
+        double term = 1.0;
+        for (int64_t k = 1; k < 32 && term > sum * 1e-12; ++k) {
+          term *= (x * x * 0.25) / double(k * k);
+          sum += term;
+        }
+        return sum;
+      }
+
+      double evaluateFilter(ResampleFilter filter, double x) {
+        switch (filter) {
+        case ResampleFilter_Box: return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+        case ResampleFilter_Bilinear: return std::max(1.0 - std::abs(x), 0.0);
+        case ResampleFilter_Lanczos: {
+          x = std::abs(x);
+          if (x < 1e-6)
+            return 1.0;
+          if (x >= 3.0)
+            return 0.0;
+          const double px = glm::pi<double>() * x;
+          return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+        }
+        case ResampleFilter_Kaiser: {
+          // Same window parameters as commonly used for mip generation.
+          constexpr double Width = 3.0;
+          constexpr double Alpha = 4.0;
+          x = std::abs(x);
+          if (x >= Width)
+            return 0.0;
+          const double px   = glm::pi<double>() * x;
+          const double sinc = x < 1e-6 ? 1.0 : std::sin(px) / px;
+          const double t    = x / Width;
+          return sinc * besselI0(Alpha * std::sqrt(1.0 - t * t)) / besselI0(Alpha);
+        }
+        default: return 0.0;
+        }
+      }
+
+      FilterKernel calculateKernel(ResampleFilter filter, int64_t srcSize, int64_t dstSize) {
+        FilterKernel kernel;
+        kernel.offsets.pushBack(0);
+
+        // Pixel `i` covers [i, i + 1). When minifying, the filter is widened to cover every source pixel.
+        const double scale  = double(srcSize) / dstSize;
+        const double widen  = std::max(scale, 1.0);
+        const double radius = filterRadius(filter) * widen;
+
+        Vector<double> weights;
+        for (int64_t i = 0; i < dstSize; ++i) {
+          const double  center  = (i + 0.5) * scale;
+          const int64_t nearest = std::clamp((int64_t)center, int64_t(0), srcSize - 1);
+
+          // Sample outside the surface by clamping to the edge.
+          const int64_t first = std::clamp((int64_t)std::ceil(center - radius - 0.5), int64_t(0), srcSize - 1);
+          const int64_t last  = std::clamp((int64_t)std::floor(center + radius - 0.5), int64_t(0), srcSize - 1);
+          weights.clear();
+          weights.resize(last - first + 1, 0.0);
+          double total = 0;
+          if (filter != ResampleFilter_Nearest) {
+            for (int64_t j = (int64_t)std::ceil(center - radius - 0.5); j <= (int64_t)std::floor(center + radius - 0.5); ++j) {
+              const double weight = evaluateFilter(filter, (j + 0.5 - center) / widen);
+              weights[std::clamp(j, first, last) - first] += weight;
+              total += weight;
+            }
+          }
+
+          int64_t begin = 0;
+          int64_t end   = weights.size();
+          if (std::abs(total) < 1e-8) {
+            // Use the nearest pixel, if the filter has no area here.
+            weights.clear();
+            weights.pushBack(total = 1.0);
+            begin = 0;
+            end   = 1;
+            kernel.first.pushBack(nearest);
+          } else {
+            // Skip source pixels that do not contribute.
+            while (weights[begin] == 0.0)
+              ++begin;
+            while (weights[end - 1] == 0.0)
+              --end;
+            kernel.first.pushBack(first + begin);
+          }
+
+          for (int64_t j = begin; j < end; ++j) {
+            kernel.weights.pushBack(float(weights[j] / total));
+          }
+          kernel.offsets.pushBack(kernel.weights.size());
+          kernel.maxTaps = std::max(kernel.maxTaps, end - begin);
+        }
+
+        return kernel;
+      }
+
+      /// Filter a row of RGBA floats horizontally.
+      void filterRow(float * pDst, float const * pSrc, FilterKernel const & kernel, int64_t count) {
+        for (int64_t i = 0; i < count; ++i) {
+          float const * pPixel   = pSrc + kernel.first[i] * 4;
+          float const * pWeights = kernel.weights.data() + kernel.offsets[i];
+          const int64_t taps     = kernel.taps(i);
+#ifdef BFC_SURFACE_SIMD
+          __m128 sum = _mm_setzero_ps();
+          for (int64_t k = 0; k < taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pPixel + k * 4), _mm_set1_ps(pWeights[k])));
+          }
+          _mm_storeu_ps(pDst + i * 4, sum);
+#else
+          float sum[4] = {0, 0, 0, 0};
+          for (int64_t k = 0; k < taps; ++k) {
+            for (int64_t c = 0; c < 4; ++c) {
+              sum[c] += pPixel[k * 4 + c] * pWeights[k];
+            }
+          }
+          memcpy(pDst + i * 4, sum, sizeof(sum));
+#endif
+        }
+      }
+
+      /// The fewest rows given to each parallel task.
+      constexpr int64_t MinBandRows = 16;
+
+      /// Renormalize normals packed in the RGB channels of an RGBAf32 surface.
+      void renormalizeSurface(Surface const & surface, ThreadPool * pThreads) {
+        const int64_t pitch = getSurfacePitch(surface);
+        parallelFor(pThreads, surface.size.y * std::max(surface.size.z, 1), MinBandRows, [&](int64_t first, int64_t last) {
+          for (int64_t row = first; row < last; ++row) {
+            float * pPixels = (float *)((uint8_t *)surface.pBuffer + row * pitch);
+            for (int64_t x = 0; x < surface.size.x; ++x) {
+              float *     pPixel = pPixels + x * 4;
+              Vec3 const  normal = Vec3(pPixel[0], pPixel[1], pPixel[2]) * 2.0f - 1.0f;
+              float const len    = glm::length(normal);
+              if (len < 1e-6f)
+                continue;
+              Vec3 const packed = normal / len * 0.5f + 0.5f;
+              pPixel[0]         = packed.x;
+              pPixel[1]         = packed.y;
+              pPixel[2]         = packed.z;
+            }
+          }
+        });
+      }
+
+      /// Get the fraction of pixels in a slice of an RGBAf32 surface with an alpha of at least `threshold`.
+      float calculateAlphaCoverage(Surface const & slice, float threshold) {
+        const int64_t pitch   = getSurfacePitch(slice);
+        int64_t       covered = 0;
+        for (int64_t y = 0; y < slice.size.y; ++y) {
+          float const * pPixels = (float const *)((uint8_t const *)slice.pBuffer + y * pitch);
+          for (int64_t x = 0; x < slice.size.x; ++x)
+            covered += pPixels[x * 4 + 3] >= threshold;
+        }
+        return float(covered) / float(slice.size.x * slice.size.y);
+      }
+
+      /// Scale alpha in a slice of an RGBAf32 surface so `coverage` of its pixels have an alpha of at least `threshold`.
+      void scaleAlphaCoverage(Surface const & slice, float threshold, float coverage) {
+        const int64_t pitch   = getSurfacePitch(slice);
+        const int64_t count   = slice.size.x * slice.size.y;
+        const int64_t covered = std::clamp((int64_t)std::round(coverage * count), int64_t(0), count);
+        if (covered == 0)
+          return;
+
+        // The alpha that the covered pixels are at least is scaled to the threshold.
+        Vector<float> alphas;
+        alphas.reserve(count);
+        for (int64_t y = 0; y < slice.size.y; ++y) {
+          float const * pPixels = (float const *)((uint8_t const *)slice.pBuffer + y * pitch);
+          for (int64_t x = 0; x < slice.size.x; ++x)
+            alphas.pushBack(pPixels[x * 4 + 3]);
+        }
+        float * pEdge = alphas.begin() + (count - covered);
+        std::nth_element(alphas.begin(), pEdge, alphas.end());
+        if (*pEdge <= 0.0f)
+          return;
+
+        const float scale = threshold / *pEdge;
+        for (int64_t y = 0; y < slice.size.y; ++y) {
+          float * pPixels = (float *)((uint8_t *)slice.pBuffer + y * pitch);
+          for (int64_t x = 0; x < slice.size.x; ++x)
+            pPixels[x * 4 + 3] = std::min(pPixels[x * 4 + 3] * scale, 1.0f);
+        }
+      }
+    } // namespace
+
+    void convertSurface(Surface * pDst, Surface const & src, ConvertSurfaceOptions const & options) {
+      // Block compressed surfaces are converted through RGBAu8.
+      if (src.pBuffer != nullptr && isBlockCompressed(src.format)) {
+        Surface decoded;
+        decoded.format = PixelFormat_RGBAu8;
+        decoded.size   = src.size;
+        if (decompressSurface(&decoded, src, options.pThreads))
+          convertSurface(pDst, decoded, options);
+        decoded.free();
+        return;
+      }
+
+      if (src.pBuffer != nullptr && isBlockCompressed(pDst->format)) {
+        Surface resized;
+        resized.format = PixelFormat_RGBAu8;
+        resized.size   = pDst->size;
+        convertSurface(&resized, src, options);
+
+        BlockCompressionOptions compression;
+        compression.pThreads = options.pThreads;
+        compressSurface(pDst, resized, compression);
+        resized.free();
+        return;
+      }
+
+      const auto hasPixelType = [](PixelFormat format) { return visitFormat(format, [](auto) {}); };
+      if (src.pBuffer == nullptr || !hasPixelType(src.format) || !hasPixelType(pDst->format)) {
+        return;
+      }
+
+      const Vec3i   dstSize  = pDst->size;
+      const Vec3i   srcSize  = src.size;
+      const int64_t dstDepth = std::max(dstSize.z, 1);
+      const int64_t srcDepth = std::max(srcSize.z, 1);
+      const int64_t dstPitch = getSurfacePitch(*pDst);
+      const int64_t srcPitch = getSurfacePitch(src);
+
+      // Allocate a destination buffer if none is provided
+      if (pDst->pBuffer == nullptr)
+        pDst->pBuffer = mem::alloc(dstPitch * dstSize.y * dstDepth);
+
+      uint8_t *       pDstBytes = (uint8_t *)pDst->pBuffer;
+      uint8_t const * pSrcBytes = (uint8_t const *)src.pBuffer;
+
+      // Filtering is done in linear space. Otherwise, channels are only re-encoded if the colour spaces differ.
+      const bool resample = dstSize.x != srcSize.x || dstSize.y != srcSize.y || dstDepth != srcDepth;
+      const bool filtered = resample && options.filter != ResampleFilter_Nearest;
+      const bool srcSRGB  = options.srcSpace == ColourSpace_SRGB;
+      const bool dstSRGB  = options.dstSpace == ColourSpace_SRGB;
+      const bool decode   = srcSRGB && (filtered || !dstSRGB);
+      const bool encode   = dstSRGB && (filtered || !srcSRGB);
+
+      if (!resample) {
+        if (src.format == pDst->format && srcPitch == dstPitch && !decode && !encode) {
+          // Same format, same pitch. Copy entire buffer.
+          memcpy(pDstBytes, pSrcBytes, dstPitch * dstSize.y * dstDepth);
+          return;
+        }
+
+        parallelFor(options.pThreads, dstSize.y * dstDepth, MinBandRows, [&](int64_t first, int64_t last) {
+          RowScratch scratch;
+          for (int64_t row = first; row < last; ++row) {
+            convertRow(pDstBytes + row * dstPitch, pDst->format, pSrcBytes + row * srcPitch, src.format, decode, encode, dstSize.x, &scratch);
+          }
+        });
+        return;
+      }
+
+      // Different size. Filter each slice horizontally, then vertically. Slices use the nearest source slice.
+      const FilterKernel horizontal = calculateKernel(options.filter, srcSize.x, dstSize.x);
+      const FilterKernel vertical   = calculateKernel(options.filter, srcSize.y, dstSize.y);
+      parallelFor(options.pThreads, dstSize.y * dstDepth, MinBandRows, [&](int64_t first, int64_t last) {
+        // Horizontally filtered source rows are cached in a ring large enough for the vertical filter.
+        const int64_t   rowLength = dstSize.x * 4;
+        RowScratch      scratch;
+        Vector<float>   srcRow;
+        Vector<float>   dstRow;
+        Vector<float>   ring;
+        Vector<int64_t> ringRows;
+        srcRow.resize(srcSize.x * 4);
+        dstRow.resize(rowLength);
+        ring.resize(vertical.maxTaps * rowLength);
+        ringRows.resize(vertical.maxTaps, -1);
+
+        for (int64_t row = first; row < last; ++row) {
+          const int64_t z    = row / dstSize.y;
+          const int64_t y    = row % dstSize.y;
+          const int64_t srcZ = std::min(int64_t((z + 0.5) * srcDepth / dstDepth), srcDepth - 1);
+
+          std::fill(dstRow.begin(), dstRow.end(), 0.0f);
+          for (int64_t k = 0; k < vertical.taps(y); ++k) {
+            const int64_t srcRowIndex = srcZ * srcSize.y + vertical.first[y] + k;
+            const int64_t slot        = srcRowIndex % vertical.maxTaps;
+            float *       pFiltered   = ring.data() + slot * rowLength;
+            if (ringRows[slot] != srcRowIndex) {
+              readPixels(srcRow.data(), pSrcBytes + srcRowIndex * srcPitch, src.format, decode, srcSize.x, &scratch);
+              filterRow(pFiltered, srcRow.data(), horizontal, dstSize.x);
+              ringRows[slot] = srcRowIndex;
+            }
+
+            accumulate(dstRow.data(), pFiltered, vertical.weights[vertical.offsets[y] + k], rowLength);
+          }
+
+          writePixels(pDstBytes + row * dstPitch, dstRow.data(), pDst->format, encode, dstSize.x, &scratch);
+        }
+      });
+    }
+
+    void convertSurface(Surface * pDst, Surface const & src) {
+      convertSurface(pDst, src, ConvertSurfaceOptions());
+    }
+
+    int64_t calculateMipCount(Vec3i const & size) {
+      int64_t count = 1;
+      for (int64_t extent = std::max(size.x, size.y); extent > 1; extent /= 2)
+        ++count;
+      return count;
+    }
+
+    int64_t generateMipChain(Vector<Surface> * pMips, Surface const & base, MipChainOptions const & options) {
+      if (base.pBuffer == nullptr || base.size.x <= 0 || base.size.y <= 0)
+        return 0;
+
+      // Levels are filtered as linear RGBA floats, and only quantized to the format of `base` when they are stored.
+      ConvertSurfaceOptions decode;
+      decode.srcSpace = options.space;
+      decode.pThreads = options.pThreads;
+
+      ConvertSurfaceOptions filter;
+      filter.filter   = options.filter;
+      filter.pThreads = options.pThreads;
+
+      ConvertSurfaceOptions encode;
+      encode.dstSpace = options.space;
+      encode.pThreads = options.pThreads;
+
+      Surface level;
+      level.format = PixelFormat_RGBAf32;
+      level.size   = base.size;
+      convertSurface(&level, base, decode);
+      if (level.pBuffer == nullptr)
+        return 0;
+
+      const int64_t depth         = std::max(base.size.z, 1);
+      const bool    preserveAlpha = options.alphaCoverageThreshold > 0;
+      Vector<float> coverage;
+      if (preserveAlpha) {
+        for (int64_t z = 0; z < depth; ++z)
+          coverage.pushBack(calculateAlphaCoverage(level.slice(z), options.alphaCoverageThreshold));
+      }
+
+      int64_t count = 0;
+      while (level.size.x > 1 || level.size.y > 1) {
+        Surface next;
+        next.format = PixelFormat_RGBAf32;
+        next.size   = {std::max(level.size.x / 2, 1), std::max(level.size.y / 2, 1), level.size.z};
+        convertSurface(&next, level, filter);
+        level.free();
+        level = next;
+
+        if (options.normalMap)
+          renormalizeSurface(level, options.pThreads);
+
+        if (preserveAlpha) {
+          for (int64_t z = 0; z < depth; ++z)
+            scaleAlphaCoverage(level.slice(z), options.alphaCoverageThreshold, coverage[z]);
+        }
+
+        Surface mip;
+        mip.format = base.format;
+        mip.size   = level.size;
+        convertSurface(&mip, level, encode);
+        pMips->pushBack(mip);
+        ++count;
+      }
+
+      level.free();
+      return count;
     }
 
     void* allocateSurface(Surface const& surface) {
-      int64_t rowLength  = surface.pitch == 0 ? surface.size.x * getPixelFormatStride(surface.format) : surface.pitch;
-      int64_t bufferSize = rowLength * surface.size.y * surface.size.z;
-      return bfc::mem::alloc(bufferSize);
+      return bfc::mem::alloc(calculateSurfaceSize(surface));
     }
 
     int64_t calculateSurfaceSize(Surface const & surface) {
-      int64_t rowLength  = surface.pitch == 0 ? surface.size.x * getPixelFormatStride(surface.format) : surface.pitch;
-      return rowLength * surface.size.y * surface.size.z;
+      return getSurfacePitch(surface) * getSurfaceRowCount(surface) * surface.size.z;
     }
 
     bool canLoadSurface(StringView const & extension) {
@@ -72,13 +1020,20 @@ namespace bfc {
       BFC_ASSERT(pStream->readable(), "Stream is not readable.");
       BFC_ASSERT(pStream->seekable(), "Stream is not seekable.");
 
-      stbi_io_callbacks reader;
-      reader.read = [](void* pUser, char* data, int size) { return (int)((Stream*)pUser)->read(data, size); };
-      reader.eof = [](void* pUser) { return (int)((Stream*)pUser)->eof(); };
-      reader.skip = [](void *pUser, int skip) { ((Stream *)pUser)->seek(skip); };
+      int      numComponents = 0;
+      uint8_t* pData         = nullptr;
+      if (uint8_t const* pContent = pStream->data()) {
+        // Decode directly from memory when the stream contents are mapped.
+        int64_t offset = pStream->tell();
+        pData = stbi_load_from_memory(pContent + offset, (int)(pStream->length() - offset), &pSurface->size.x, &pSurface->size.y, &numComponents, 0);
+      } else {
+        stbi_io_callbacks reader;
+        reader.read = [](void* pUser, char* data, int size) { return (int)((Stream*)pUser)->read(data, size); };
+        reader.eof = [](void* pUser) { return (int)((Stream*)pUser)->eof(); };
+        reader.skip = [](void *pUser, int skip) { ((Stream *)pUser)->seek(skip); };
 
-      int numComponents = 0;
-      uint8_t* pData = stbi_load_from_callbacks(&reader, pStream, &pSurface->size.x, &pSurface->size.y, &numComponents, 0);
+        pData = stbi_load_from_callbacks(&reader, pStream, &pSurface->size.x, &pSurface->size.y, &numComponents, 0);
+      }
 
       if (pData == nullptr)
         return false;
@@ -102,12 +1057,26 @@ namespace bfc {
       }
 
       int64_t pitch = getSurfacePitch(surface);
-      int64_t index = coord.x * getPixelFormatStride(surface.format) + coord.y * pitch + coord.z * surface.size.y * pitch;
+      int64_t index = 0;
+      if (isBlockCompressed(surface.format)) {
+        // Address the block containing the pixel.
+        index = coord.x / 4 * getPixelFormatBlockSize(surface.format) + coord.y / 4 * pitch + coord.z * getSurfaceRowCount(surface) * pitch;
+      } else {
+        index = coord.x * getPixelFormatStride(surface.format) + coord.y * pitch + coord.z * surface.size.y * pitch;
+      }
       return (uint8_t*)surface.pBuffer + index;
     }
 
     int64_t getSurfacePitch(Surface const & surface) {
-      return surface.pitch == 0 ? surface.size.x * getPixelFormatStride(surface.format) : surface.pitch;
+      if (surface.pitch != 0)
+        return surface.pitch;
+      if (isBlockCompressed(surface.format))
+        return (surface.size.x + 3) / 4 * getPixelFormatBlockSize(surface.format);
+      return surface.size.x * getPixelFormatStride(surface.format);
+    }
+
+    int64_t getSurfaceRowCount(Surface const & surface) {
+      return isBlockCompressed(surface.format) ? (surface.size.y + 3) / 4 : surface.size.y;
     }
 
     void Surface::free()
@@ -123,7 +1092,7 @@ namespace bfc {
       ret.format  = format;
       ret.pBuffer = pBuffer;
       if (ret.pBuffer != nullptr) {
-        ret.pBuffer = (uint8_t *)ret.pBuffer + getSurfacePitch(*this) * size.y * z;
+        ret.pBuffer = (uint8_t *)ret.pBuffer + getSurfacePitch(*this) * getSurfaceRowCount(*this) * z;
       }
       return ret;
     }
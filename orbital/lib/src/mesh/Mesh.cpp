@@ -1,90 +1,62 @@
 #include "mesh/Mesh.h"
+#include "mesh/MeshBlob.h"
 #include "media/Image.h"
 
 namespace bfc {
-  Mesh::Mesh(graphics::CommandList * pCmdList, MeshData const & data) {
-    load(pCmdList, data);
+  Mesh::Mesh(graphics::CommandList * pCmdList, MeshData const & data, MeshOptimizeFlags optimizeFlags) {
+    load(pCmdList, data, optimizeFlags);
   }
 
   Mesh::~Mesh() {
     release();
   }
 
-  bool Mesh::load(graphics::CommandList * pCmdList, MeshData const & data) {
+  bool Mesh::load(graphics::CommandList * pCmdList, MeshData const & data, MeshOptimizeFlags optimizeFlags) {
+    return load(pCmdList, NewRef<MeshBlob>(data, optimizeFlags));
+  }
+
+  bool Mesh::load(graphics::CommandList * pCmdList, Ref<MeshBlob> const & pBlob) {
     release();
 
-    m_pDevice                         = pCmdList->getDevice();
+    if (pBlob == nullptr || pBlob->empty()) {
+      return false;
+    }
+
+    m_pDevice = pCmdList->getDevice();
 
     m_vertexBuffer = pCmdList->createBuffer(BufferUsageHint_Vertices);
     m_indexBuffer  = pCmdList->createBuffer(BufferUsageHint_Indices);
     m_vertexArray  = pCmdList->createVertexArray();
 
-    m_vertexCount = data.vertices.size();
-    m_indexCount  = data.triangles.size() * 3;
-
-    // Create vertex buffer
-    Vector<Vertex> vertexData = data.vertices.map([&](MeshData::Vertex const & v) {
-      Vertex ret;
-      ret.position = data.positions[v.position];
-      ret.uv       = data.uvs[v.uv];
-      ret.colour   = Colour<RGBAf32>(data.colours[v.colour]);
-      ret.normal   = data.normals[v.normal];
-      ret.tangent  = data.tangents[v.tangent];
-      return ret;
-    });
-
-    // Allocate memory for indices
-    Vector<Vector<Index>> subMeshIndexData;
-    subMeshIndexData.resize(data.materials.size());
-    for (Vector<Index> & indices : subMeshIndexData) {
-      indices.reserve(data.vertices.size() / subMeshIndexData.size());
-    }
-
-    // Group indices by material
-    for (MeshData::Triangle const & tri : data.triangles) {
-      Vector<Index> & indices = subMeshIndexData[tri.material];
-      for (int64_t v : tri.vertex) {
-        indices.pushBack((uint32_t)v);
-      }
-    }
-
-    // Concatenate into a single buffer
-    Vector<Index> indexData;
-    indexData.resize(m_indexCount);
-
-    Index * pBegin = indexData.begin();
-    Index * pNext  = indexData.begin();
-    for (Vector<Index> & indices : subMeshIndexData) {
-      SubMesh sm;
-      sm.elmOffset = pNext - pBegin;
-      sm.elmCount  = indices.size();
-      m_meshes.pushBack(sm);
-      memcpy(pNext, indices.begin(), sizeof(Index) * indices.size());
-      pNext += indices.size();
-    }
-    
     m_vertexArray->setLayout(VertexInputLayout::Create<Vertex>());
     m_vertexArray->setVertexBuffer(0, m_vertexBuffer);
     m_vertexArray->setIndexBuffer(m_indexBuffer, DataType_UInt32);
 
-    // Calculate extents of each sub-mesh
-    for (auto & [i, indices] : enumerate(subMeshIndexData)) {
-      geometry::Boxf & bounds = m_meshes[i].bounds;
-      bounds = geometry::Boxf();
-      for (Index const & vertIndex : indices) {
-        bounds.growToContain(vertexData[vertIndex].position);
-      }
-
-      m_bounds.growToContain(bounds);
+    Span<const Vertex> vertices = pBlob->vertices();
+    Span<const Index>  indices  = pBlob->indices();
+    m_vertexCount = vertices.size();
+    m_indexCount  = indices.size();
+    m_bounds      = pBlob->header().bounds;
+    m_meshes      = Vector<SubMesh>(pBlob->subMeshes(0));
+    for (int64_t lod = 1; lod < pBlob->getLodCount(); ++lod) {
+      m_lodMeshes.pushBack(pBlob->subMeshes(lod));
     }
+    m_lodErrors = Vector<float>(pBlob->lodErrors());
+    m_meshlets  = Vector<Meshlet>(pBlob->meshlets());
 
-    pCmdList->upload(m_vertexBuffer, std::move(vertexData));
-    pCmdList->upload(m_indexBuffer, std::move(indexData));
+    // Upload directly from the blob. It is kept alive until the command list has been executed.
+    pCmdList->upload(m_vertexBuffer, vertices.size() * sizeof(Vertex), vertices.data());
+    pCmdList->upload(m_indexBuffer, indices.size() * sizeof(Index), indices.data());
+    pCmdList->track(pBlob);
 
     return true;
   }
 
   void Mesh::release() {
+    m_meshes.clear();
+    m_lodMeshes.clear();
+    m_lodErrors.clear();
+    m_meshlets.clear();
     m_vertexArray  = {};
     m_vertexBuffer = {};
     m_indexBuffer  = {};
@@ -97,6 +69,23 @@ namespace bfc {
     return m_meshes[index];
   }
 
+  Mesh::SubMesh const & Mesh::getSubMesh(int64_t index, int64_t lod) const {
+    return lod == 0 ? m_meshes[index] : m_lodMeshes[(lod - 1) * m_meshes.size() + index];
+  }
+
+  int64_t Mesh::getLodCount() const {
+    return m_lodErrors.size() + 1;
+  }
+
+  float Mesh::getLodError(int64_t lod) const {
+    return lod == 0 ? 0.0f : m_lodErrors[lod - 1];
+  }
+
+  Span<const Meshlet> Mesh::getMeshlets(int64_t subMeshIndex) const {
+    SubMesh const & sm = m_meshes[subMeshIndex];
+    return Span<const Meshlet>(m_meshlets.data() + sm.meshletOffset, sm.meshletCount);
+  }
+
   Vector<Mesh::SubMesh> const & Mesh::getSubMeshes() const {
     return m_meshes;
   }
@@ -170,5 +159,6 @@ namespace bfc {
     textures[TextureSlot_AO]         = textureLoader(def, MeshData::Material::PBR::ao);
     textures[TextureSlot_Alpha]      = textureLoader(def, MeshData::Material::PBR::alpha);
     textures[TextureSlot_Normal]     = textureLoader(def, MeshData::Material::PBR::normal);
+    ++revision;
   }
 } // namespace bfc
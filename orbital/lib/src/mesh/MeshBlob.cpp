@@ -0,0 +1,277 @@
+#include "mesh/MeshBlob.h"
+#include "mesh/MeshOptimizer.h"
+#include "util/Hash.h"
+
+#include <cstring>
+
+namespace bfc {
+  namespace {
+    int64_t alignOffset(int64_t offset) {
+      return (offset + MeshBlob::Alignment - 1) & ~(MeshBlob::Alignment - 1);
+    }
+  } // namespace
+
+  MeshBlob::MeshBlob(MeshData const & data, MeshOptimizeFlags optimizeFlags) {
+    build(data, optimizeFlags);
+  }
+
+  void MeshBlob::build(MeshData const & data, MeshOptimizeFlags optimizeFlags) {
+    int64_t indexCount = data.triangles.size() * 3;
+    for (MeshData::LevelOfDetail const & lod : data.lods) {
+      indexCount += lod.triangles.size() * 3;
+    }
+
+    // Create vertex buffer
+    Vector<Mesh::Vertex> vertexData = data.vertices.map([&](MeshData::Vertex const & v) {
+      Mesh::Vertex ret;
+      ret.position = data.positions[v.position];
+      ret.uv       = data.uvs[v.uv];
+      ret.colour   = Colour<RGBAf32>(data.colours[v.colour]);
+      ret.normal   = data.normals[v.normal];
+      ret.tangent  = data.tangents[v.tangent];
+      return ret;
+    });
+
+    // Allocate memory for indices. Sub-meshes are grouped by level of detail, with the full detail mesh first.
+    const int64_t materialCount = data.materials.size();
+    const int64_t lodCount      = data.lods.size() + 1;
+    Vector<Vector<Mesh::Index>> subMeshIndexData;
+    subMeshIndexData.resize(materialCount * lodCount);
+    for (Vector<Mesh::Index> & indices : subMeshIndexData.getView(0, materialCount)) {
+      indices.reserve(data.vertices.size() / materialCount);
+    }
+
+    // Group indices by material
+    for (int64_t lod = 0; lod < lodCount; ++lod) {
+      Vector<MeshData::Triangle> const & triangles = lod == 0 ? data.triangles : data.lods[lod - 1].triangles;
+      for (MeshData::Triangle const & tri : triangles) {
+        Vector<Mesh::Index> & indices = subMeshIndexData[lod * materialCount + tri.material];
+        for (int64_t v : tri.vertex) {
+          indices.pushBack((uint32_t)v);
+        }
+      }
+    }
+
+    if (optimizeFlags & MeshOptimizeFlags_Weld) {
+      Vector<Mesh::Index>  remap;
+      Vector<Mesh::Vertex> welded;
+      welded.resize(MeshOptimizer::weldVertices(vertexData.data(), vertexData.size(), sizeof(Mesh::Vertex), &remap));
+      MeshOptimizer::remapVertices(welded.data(), vertexData.data(), vertexData.size(), sizeof(Mesh::Vertex), remap);
+      for (Vector<Mesh::Index> & indices : subMeshIndexData) {
+        MeshOptimizer::remapIndices(indices, remap);
+      }
+      vertexData = std::move(welded);
+    }
+
+    for (Vector<Mesh::Index> & indices : subMeshIndexData) {
+      if (optimizeFlags & MeshOptimizeFlags_VertexCache) {
+        MeshOptimizer::optimizeVertexCache(indices, vertexData.size());
+      }
+
+      if ((optimizeFlags & MeshOptimizeFlags_Overdraw) && !indices.empty()) {
+        MeshOptimizer::optimizeOverdraw(indices, &vertexData.front().position.x, vertexData.size(), sizeof(Mesh::Vertex));
+      }
+    }
+
+    // Split the full detail sub-meshes into meshlets. This reorders their triangles, so is done after the
+    // other optimizations. Meshlet offsets are made relative to the index buffer once it is built below.
+    Vector<Vector<Meshlet>> subMeshMeshlets;
+    subMeshMeshlets.resize(materialCount);
+    if (optimizeFlags & MeshOptimizeFlags_Meshlets) {
+      for (int64_t i = 0; i < materialCount; ++i) {
+        if (!subMeshIndexData[i].empty()) {
+          subMeshMeshlets[i] = MeshletBuilder::build(subMeshIndexData[i], &vertexData.front().position.x, vertexData.size(), sizeof(Mesh::Vertex));
+        }
+      }
+    }
+
+    // Concatenate into a single buffer
+    Vector<Mesh::Index> indexData;
+    indexData.resize(indexCount);
+
+    Vector<Mesh::SubMesh> subMeshes;
+    Mesh::Index * pBegin = indexData.begin();
+    Mesh::Index * pNext  = indexData.begin();
+    for (Vector<Mesh::Index> & indices : subMeshIndexData) {
+      Mesh::SubMesh sm;
+      sm.elmOffset = pNext - pBegin;
+      sm.elmCount  = indices.size();
+      subMeshes.pushBack(sm);
+      memcpy(pNext, indices.begin(), sizeof(Mesh::Index) * indices.size());
+      pNext += indices.size();
+    }
+
+    Vector<Meshlet> meshletData;
+    for (auto & [i, meshlets] : enumerate(subMeshMeshlets)) {
+      subMeshes[i].meshletOffset = meshletData.size();
+      subMeshes[i].meshletCount  = meshlets.size();
+      for (Meshlet & meshlet : meshlets) {
+        meshlet.elmOffset += subMeshes[i].elmOffset;
+        meshletData.pushBack(meshlet);
+      }
+    }
+
+    if (optimizeFlags & MeshOptimizeFlags_VertexFetch) {
+      // The index buffer is remapped in place. Copy it back to the sub-mesh indices used for the bounds below.
+      // The full detail mesh comes first, so vertices are ordered for it rather than the simplified levels.
+      vertexData.resize(MeshOptimizer::optimizeVertexFetch(indexData, vertexData.data(), vertexData.size(), sizeof(Mesh::Vertex)));
+      for (auto & [i, indices] : enumerate(subMeshIndexData)) {
+        memcpy(indices.data(), indexData.data() + subMeshes[i].elmOffset, sizeof(Mesh::Index) * indices.size());
+      }
+    }
+
+    Header header;
+    header.lodCount = (int32_t)lodCount;
+
+    // Calculate extents of each sub-mesh
+    for (auto & [i, indices] : enumerate(subMeshIndexData)) {
+      geometry::Boxf & bounds = subMeshes[i].bounds;
+      bounds = geometry::Boxf();
+      for (Mesh::Index const & vertIndex : indices) {
+        bounds.growToContain(vertexData[vertIndex].position);
+      }
+
+      header.bounds.growToContain(bounds);
+    }
+
+    Vector<float> lodErrorData;
+    for (MeshData::LevelOfDetail const & lod : data.lods) {
+      lodErrorData.pushBack((float)lod.error);
+    }
+
+    // Lay out the sections and copy them into the blob.
+    int64_t size   = alignOffset(sizeof(Header));
+    auto    layout = [&](Section * pSection, int64_t count, int64_t elementSize) {
+      pSection->offset = size;
+      pSection->count  = count;
+      size             = alignOffset(size + count * elementSize);
+    };
+
+    layout(&header.vertices, vertexData.size(), sizeof(Mesh::Vertex));
+    layout(&header.indices, indexData.size(), sizeof(Mesh::Index));
+    layout(&header.subMeshes, subMeshes.size(), sizeof(Mesh::SubMesh));
+    layout(&header.lodErrors, lodErrorData.size(), sizeof(float));
+    layout(&header.meshlets, meshletData.size(), sizeof(Meshlet));
+    header.size = size;
+
+    m_data.clear();
+    m_data.resize(size, 0);
+    memcpy(m_data.data() + header.vertices.offset, vertexData.data(), vertexData.size() * sizeof(Mesh::Vertex));
+    memcpy(m_data.data() + header.indices.offset, indexData.data(), indexData.size() * sizeof(Mesh::Index));
+    memcpy(m_data.data() + header.subMeshes.offset, subMeshes.data(), subMeshes.size() * sizeof(Mesh::SubMesh));
+    memcpy(m_data.data() + header.lodErrors.offset, lodErrorData.data(), lodErrorData.size() * sizeof(float));
+    memcpy(m_data.data() + header.meshlets.offset, meshletData.data(), meshletData.size() * sizeof(Meshlet));
+
+    header.checksum = hash128(m_data.data() + sizeof(Header), size - sizeof(Header)).low;
+    memcpy(m_data.data(), &header, sizeof(Header));
+  }
+
+  bool MeshBlob::assign(Vector<uint8_t> && bytes) {
+    clear();
+    if (bytes.size() < (int64_t)sizeof(Header)) {
+      return false;
+    }
+
+    Header header;
+    memcpy(&header, bytes.data(), sizeof(Header));
+    if (header.magic != Magic || header.version != Version || header.size != bytes.size() || header.vertexSize != sizeof(Mesh::Vertex) ||
+        header.subMeshSize != sizeof(Mesh::SubMesh) || header.meshletSize != sizeof(Meshlet) || header.lodCount < 1) {
+      return false;
+    }
+
+    auto isValid = [&](Section const & s, int64_t elementSize) {
+      return s.offset % Alignment == 0 && s.offset >= (int64_t)sizeof(Header) && s.count >= 0 && s.count <= (header.size - s.offset) / elementSize;
+    };
+
+    if (!isValid(header.vertices, sizeof(Mesh::Vertex)) || !isValid(header.indices, sizeof(Mesh::Index)) ||
+        !isValid(header.subMeshes, sizeof(Mesh::SubMesh)) || !isValid(header.lodErrors, sizeof(float)) || !isValid(header.meshlets, sizeof(Meshlet)) ||
+        header.subMeshes.count % header.lodCount != 0 || header.lodErrors.count != header.lodCount - 1) {
+      return false;
+    }
+
+    if (hash128(bytes.data() + sizeof(Header), bytes.size() - sizeof(Header)).low != header.checksum) {
+      return false;
+    }
+
+    m_data = std::move(bytes);
+    return true;
+  }
+
+  void MeshBlob::clear() {
+    m_data.clear();
+  }
+
+  bool MeshBlob::empty() const {
+    return m_data.empty();
+  }
+
+  MeshBlob::Header const & MeshBlob::header() const {
+    static const Header emptyHeader;
+    return empty() ? emptyHeader : *(Header const *)m_data.data();
+  }
+
+  Span<const uint8_t> MeshBlob::bytes() const {
+    return Span<const uint8_t>(m_data.data(), m_data.size());
+  }
+
+  Span<const Mesh::Vertex> MeshBlob::vertices() const {
+    return section<Mesh::Vertex>(header().vertices);
+  }
+
+  Span<const Mesh::Index> MeshBlob::indices() const {
+    return section<Mesh::Index>(header().indices);
+  }
+
+  Span<const Mesh::SubMesh> MeshBlob::subMeshes(int64_t lod) const {
+    Span<const Mesh::SubMesh> all   = section<Mesh::SubMesh>(header().subMeshes);
+    const int64_t             count = all.size() / getLodCount();
+    return Span<const Mesh::SubMesh>(all.data() + lod * count, count);
+  }
+
+  int64_t MeshBlob::getLodCount() const {
+    return header().lodCount;
+  }
+
+  Span<const float> MeshBlob::lodErrors() const {
+    return section<float>(header().lodErrors);
+  }
+
+  Span<const Meshlet> MeshBlob::meshlets() const {
+    return section<Meshlet>(header().meshlets);
+  }
+
+  int64_t write(Stream * pStream, MeshBlob const * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i) {
+      Span<const uint8_t> bytes = pValue[i].bytes();
+      if (bytes.size() == 0 || pStream->write((void const *)bytes.data(), bytes.size()) != bytes.size())
+        return i;
+    }
+    return count;
+  }
+
+  int64_t read(Stream * pStream, MeshBlob * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i) {
+      // Read the header to find the size of the blob, then the rest of it with a single read.
+      MeshBlob::Header header;
+      if (pStream->read((void *)&header, sizeof(header)) != sizeof(header) || header.magic != MeshBlob::Magic ||
+          header.version != MeshBlob::Version || header.size < (int64_t)sizeof(header))
+        return i;
+
+      const int64_t length = pStream->length();
+      if (length >= 0 && header.size - (int64_t)sizeof(header) > length - pStream->tell())
+        return i;
+
+      Vector<uint8_t> bytes;
+      bytes.resize(header.size);
+      memcpy(bytes.data(), &header, sizeof(header));
+      const int64_t remaining = header.size - sizeof(header);
+      if (pStream->read((void *)(bytes.data() + sizeof(header)), remaining) != remaining)
+        return i;
+
+      mem::construct(pValue + i);
+      if (!pValue[i].assign(std::move(bytes)))
+        return i;
+    }
+    return count;
+  }
+} // namespace bfc
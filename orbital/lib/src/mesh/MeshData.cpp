@@ -335,6 +335,9 @@ namespace bfc {
     triangles.pushBack(m.triangles.getView());
     materials.pushBack(m.materials.getView());
 
+    // Levels of detail no longer cover the merged triangles.
+    lods.clear();
+
     for (MeshData::Vertex & v : vertices.getView(vtxOffset)) {
       v.colour += (v.colour != -1) * colOffset;
       v.position += (v.position != -1) * posOffset;
@@ -387,12 +390,20 @@ namespace bfc {
     return count;
   }
 
+  namespace {
+    /// Written before each serialized MeshData. Meshes written by older versions start with their position
+    /// count, which is never negative, so the tag also tells the two formats apart.
+    constexpr int64_t MeshDataSerializeTag     = -1;
+    constexpr int64_t MeshDataSerializeVersion = 2; ///< Version 2 added levels of detail.
+  } // namespace
+
   int64_t write(Stream * pStream, MeshData const * pValue, int64_t count) {
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->write(pValue[i].positions) && pStream->write(pValue[i].uvs) && pStream->write(pValue[i].colours) &&
-            pStream->write(pValue[i].normals) && pStream->write(pValue[i].tangents) && pStream->write(pValue[i].vertices) &&
-            pStream->write(pValue[i].triangles) && pStream->write(pValue[i].skins) && pStream->write(pValue[i].materials) &&
-            pStream->write(pValue[i].sourceFile)))
+      if (!(pStream->write(MeshDataSerializeTag) && pStream->write(MeshDataSerializeVersion) && pStream->write(pValue[i].positions) &&
+            pStream->write(pValue[i].uvs) && pStream->write(pValue[i].colours) && pStream->write(pValue[i].normals) &&
+            pStream->write(pValue[i].tangents) && pStream->write(pValue[i].vertices) && pStream->write(pValue[i].triangles) &&
+            pStream->write(pValue[i].skins) && pStream->write(pValue[i].materials) && pStream->write(pValue[i].sourceFile) &&
+            pStream->write(pValue[i].lods)))
         return i;
     }
     return count;
@@ -400,11 +411,39 @@ namespace bfc {
 
   int64_t read(Stream * pStream, MeshData * pValue, int64_t count) {
     for (int64_t i = 0; i < count; ++i) {
-      if (!(pStream->read(&pValue[i].positions) && pStream->read(&pValue[i].uvs) && pStream->read(&pValue[i].colours) &&
-            pStream->read(&pValue[i].normals) && pStream->read(&pValue[i].tangents) && pStream->read(&pValue[i].vertices) &&
-            pStream->read(&pValue[i].triangles) && pStream->read(&pValue[i].skins) && pStream->read(&pValue[i].materials) &&
-            pStream->read(&pValue[i].sourceFile)))
+      int64_t tag = 0;
+      if (!pStream->read(&tag))
         return i;
+
+      int64_t version = 1;
+      if (tag == MeshDataSerializeTag) {
+        if (!pStream->read(&version) || version < 2 || version > MeshDataSerializeVersion)
+          return i;
+
+        if (!pStream->read(&pValue[i].positions))
+          return i;
+      } else {
+        // Version 1 had no header, so the tag was the position count.
+        if (tag < 0)
+          return i;
+
+        mem::construct(&pValue[i].positions);
+        pValue[i].positions.resize(tag);
+        if (pStream->read(pValue[i].positions.data(), tag) != tag)
+          return i;
+      }
+
+      if (!(pStream->read(&pValue[i].uvs) && pStream->read(&pValue[i].colours) && pStream->read(&pValue[i].normals) &&
+            pStream->read(&pValue[i].tangents) && pStream->read(&pValue[i].vertices) && pStream->read(&pValue[i].triangles) &&
+            pStream->read(&pValue[i].skins) && pStream->read(&pValue[i].materials) && pStream->read(&pValue[i].sourceFile)))
+        return i;
+
+      if (version >= 2) {
+        if (!pStream->read(&pValue[i].lods))
+          return i;
+      } else {
+        mem::construct(&pValue[i].lods);
+      }
     }
     return count;
   }
@@ -436,4 +475,18 @@ namespace bfc {
         return i;
     return count;
   }
+
+  int64_t write(Stream * pStream, MeshData::LevelOfDetail const * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i)
+      if (!(pStream->write(pValue[i].triangles) && pStream->write(pValue[i].error)))
+        return i;
+    return count;
+  }
+
+  int64_t read(Stream * pStream, MeshData::LevelOfDetail * pValue, int64_t count) {
+    for (int64_t i = 0; i < count; ++i)
+      if (!(pStream->read(&pValue[i].triangles) && pStream->read(&pValue[i].error)))
+        return i;
+    return count;
+  }
 } // namespace bfc
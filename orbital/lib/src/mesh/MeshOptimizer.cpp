@@ -0,0 +1,361 @@
+#include "mesh/MeshOptimizer.h"
+#include "util/Hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bfc {
+  namespace {
+    constexpr MeshOptimizer::Index InvalidIndex = ~MeshOptimizer::Index(0);
+
+    /// The triangles that reference each vertex.
+    struct Adjacency {
+      Vector<int64_t> offsets;   ///< First entry in triangles for each vertex. Has vertexCount + 1 entries.
+      Vector<int64_t> triangles; ///< Triangle indices, grouped by vertex.
+
+      Adjacency(Span<const MeshOptimizer::Index> const & indices, int64_t vertexCount) {
+        offsets.resize(vertexCount + 1, 0);
+        for (MeshOptimizer::Index index : indices)
+          ++offsets[index + 1];
+        for (int64_t v = 0; v < vertexCount; ++v)
+          offsets[v + 1] += offsets[v];
+
+        Vector<int64_t> next = offsets;
+        triangles.resize(indices.size());
+        for (int64_t i = 0; i < indices.size(); ++i)
+          triangles[next[indices[i]]++] = i / 3;
+      }
+
+      int64_t count(int64_t vertex) const {
+        return offsets[vertex + 1] - offsets[vertex];
+      }
+
+      Span<const int64_t> of(int64_t vertex) const {
+        return Span<const int64_t>(triangles.data() + offsets[vertex], count(vertex));
+      }
+    };
+
+    /// FIFO vertex cache simulation, as used by most GPUs.
+    class FIFOCache {
+    public:
+      FIFOCache(int64_t vertexCount, int64_t cacheSize)
+        : m_cacheSize(cacheSize) {
+        m_timestamps.resize(vertexCount, 0);
+      }
+
+      /// Add a vertex to the cache.
+      /// @returns true if the vertex missed the cache.
+      bool access(MeshOptimizer::Index vertex) {
+        if (m_time - m_timestamps[vertex] < m_cacheSize)
+          return false;
+        m_timestamps[vertex] = m_time++;
+        return true;
+      }
+
+      void clear() {
+        m_time += m_cacheSize;
+      }
+
+    private:
+      int64_t         m_cacheSize;
+      int64_t         m_time = 1 << 30; ///< Starts large so no vertex is initially cached.
+      Vector<int64_t> m_timestamps;
+    };
+
+    struct Float3 {
+      float x = 0, y = 0, z = 0;
+
+      Float3 operator-(Float3 const & o) const {
+        return {x - o.x, y - o.y, z - o.z};
+      }
+
+      Float3 operator+(Float3 const & o) const {
+        return {x + o.x, y + o.y, z + o.z};
+      }
+
+      Float3 operator*(float s) const {
+        return {x * s, y * s, z * s};
+      }
+
+      float dot(Float3 const & o) const {
+        return x * o.x + y * o.y + z * o.z;
+      }
+
+      Float3 cross(Float3 const & o) const {
+        return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+      }
+    };
+  } // namespace
+
+  int64_t MeshOptimizer::weldVertices(void const * pVertices, int64_t vertexCount, int64_t vertexStride, Vector<Index> * pRemap) {
+    uint8_t const * pBytes = (uint8_t const *)pVertices;
+    pRemap->clear();
+    pRemap->resize(vertexCount, InvalidIndex);
+
+    int64_t tableSize = 16;
+    while (tableSize < vertexCount * 2)
+      tableSize *= 2;
+
+    // Open addressing table of the first vertex with each value.
+    Vector<int64_t> table;
+    table.resize(tableSize, npos);
+
+    const int64_t mask        = tableSize - 1;
+    int64_t       uniqueCount = 0;
+    for (int64_t v = 0; v < vertexCount; ++v) {
+      uint8_t const * pVertex = pBytes + v * vertexStride;
+      for (int64_t slot = hash128(pVertex, vertexStride).low & mask;; slot = (slot + 1) & mask) {
+        int64_t & existing = table[slot];
+        if (existing == npos) {
+          existing      = v;
+          (*pRemap)[v] = Index(uniqueCount++);
+          break;
+        }
+
+        if (memcmp(pBytes + existing * vertexStride, pVertex, vertexStride) == 0) {
+          (*pRemap)[v] = (*pRemap)[existing];
+          break;
+        }
+      }
+    }
+
+    return uniqueCount;
+  }
+
+  void MeshOptimizer::remapVertices(void * pDst, void const * pSrc, int64_t vertexCount, int64_t vertexStride, Span<const Index> const & remap) {
+    Vector<bool> written;
+    written.resize(vertexCount, false);
+    for (int64_t v = 0; v < vertexCount; ++v) {
+      const Index target = remap[v];
+      if (target == InvalidIndex || written[target])
+        continue;
+
+      memcpy((uint8_t *)pDst + target * vertexStride, (uint8_t const *)pSrc + v * vertexStride, vertexStride);
+      written[target] = true;
+    }
+  }
+
+  void MeshOptimizer::remapIndices(Span<Index> const & indices, Span<const Index> const & remap) {
+    for (Index & index : indices)
+      index = remap[index];
+  }
+
+  void MeshOptimizer::optimizeVertexCache(Span<Index> const & indices, int64_t vertexCount, int64_t cacheSize) {
+    const int64_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+      return;
+
+    Adjacency       adjacency(Span<const Index>(indices.data(), indices.size()), vertexCount);
+    Vector<int64_t> liveTriangles;  // Triangles not yet emitted, per vertex.
+    Vector<int64_t> cacheTime;      // Time each vertex last entered the cache.
+    Vector<bool>    emitted;
+    Vector<Index>   deadEnds;       // Recently used vertices, to restart from when a fan runs out.
+    Vector<Index>   candidates;
+    Vector<Index>   output;
+
+    liveTriangles.resize(vertexCount);
+    for (int64_t v = 0; v < vertexCount; ++v)
+      liveTriangles[v] = adjacency.count(v);
+    cacheTime.resize(vertexCount, 0);
+    emitted.resize(triangleCount, false);
+    output.reserve(indices.size());
+
+    int64_t time   = cacheSize + 1;
+    int64_t cursor = 0;     // Next vertex to check when there are no dead ends left.
+    int64_t fan    = indices[0];
+    while (fan >= 0) {
+      candidates.clear();
+
+      // Emit every remaining triangle around the fanning vertex.
+      for (int64_t tri : adjacency.of(fan)) {
+        if (emitted[tri])
+          continue;
+
+        for (int64_t c = 0; c < 3; ++c) {
+          const Index v = indices[tri * 3 + c];
+          output.pushBack(v);
+          deadEnds.pushBack(v);
+          candidates.pushBack(v);
+          --liveTriangles[v];
+          if (time - cacheTime[v] > cacheSize)
+            cacheTime[v] = time++;
+        }
+        emitted[tri] = true;
+      }
+
+      // Pick the next fanning vertex: the candidate that will stay in the cache longest
+      // while all of its remaining triangles are emitted.
+      int64_t next     = -1;
+      int64_t bestTime = -1;
+      for (Index v : candidates) {
+        if (liveTriangles[v] == 0)
+          continue;
+
+        int64_t priority = 0;
+        if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+          priority = time - cacheTime[v];
+        if (priority > bestTime) {
+          bestTime = priority;
+          next     = v;
+        }
+      }
+
+      // Dead end. Fall back to a recently used vertex, then to any vertex with triangles left.
+      while (next == -1 && !deadEnds.empty()) {
+        const Index v = deadEnds.back();
+        deadEnds.popBack();
+        if (liveTriangles[v] > 0)
+          next = v;
+      }
+
+      while (next == -1 && cursor < vertexCount) {
+        if (liveTriangles[cursor] > 0)
+          next = cursor;
+        ++cursor;
+      }
+
+      fan = next;
+    }
+
+    memcpy(indices.data(), output.data(), output.size() * sizeof(Index));
+  }
+
+  void MeshOptimizer::optimizeOverdraw(Span<Index> const & indices, float const * pPositions, int64_t vertexCount, int64_t vertexStride, float threshold,
+                                       int64_t cacheSize) {
+    const int64_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+      return;
+
+    auto position = [&](Index v) {
+      float const * p = (float const *)((uint8_t const *)pPositions + v * vertexStride);
+      return Float3{p[0], p[1], p[2]};
+    };
+
+    // Hard boundaries: triangles where every vertex misses the cache, i.e. where the previous
+    // ordering jumped to a new part of the mesh.
+    Vector<int64_t> clusters;
+    Vector<int64_t> misses;
+    misses.resize(triangleCount);
+    {
+      FIFOCache cache(vertexCount, cacheSize);
+      for (int64_t t = 0; t < triangleCount; ++t) {
+        misses[t] = cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+        if (t == 0 || misses[t] == 3)
+          clusters.pushBack(t);
+      }
+    }
+
+    // Soft boundaries: split hard clusters further, as long as the cache miss ratio of
+    // the pieces stays within the threshold of the cluster's overall ratio.
+    Vector<int64_t> softClusters;
+    for (int64_t c = 0; c < clusters.size(); ++c) {
+      const int64_t begin = clusters[c];
+      const int64_t end   = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+      int64_t clusterMisses = 0;
+      for (int64_t t = begin; t < end; ++t)
+        clusterMisses += misses[t];
+      const float clusterACMR = float(clusterMisses) / float(end - begin);
+
+      FIFOCache cache(vertexCount, cacheSize);
+      int64_t   start       = begin;
+      int64_t   startMisses = 0;
+      softClusters.pushBack(begin);
+      for (int64_t t = begin; t < end; ++t) {
+        startMisses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+        if (t + 1 < end && t + 1 - start >= 3 && float(startMisses) / float(t + 1 - start) <= clusterACMR * threshold) {
+          softClusters.pushBack(t + 1);
+          start       = t + 1;
+          startMisses = 0;
+          cache.clear();
+        }
+      }
+    }
+
+    // Sort clusters by how much they are likely to occlude the rest of the mesh: clusters that
+    // face away from the mesh center are on the outside and drawn first.
+    Float3 meshCenter;
+    for (Index index : indices)
+      meshCenter = meshCenter + position(index);
+    meshCenter = meshCenter * (1.0f / float(indices.size()));
+
+    struct ClusterSort {
+      float   key;
+      int64_t cluster;
+    };
+
+    Vector<ClusterSort> order;
+    for (int64_t c = 0; c < softClusters.size(); ++c) {
+      const int64_t begin = softClusters[c];
+      const int64_t end   = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+      Float3 center;
+      Float3 normal;
+      float  area = 0;
+      for (int64_t t = begin; t < end; ++t) {
+        Float3 a = position(indices[t * 3 + 0]);
+        Float3 b = position(indices[t * 3 + 1]);
+        Float3 c = position(indices[t * 3 + 2]);
+
+        Float3 n           = (b - a).cross(c - a); // Length is twice the area
+        float  triangleArea = sqrtf(n.dot(n));
+        center             = center + (a + b + c) * (triangleArea / 3.0f);
+        normal             = normal + n;
+        area += triangleArea;
+      }
+
+      center = area > 0 ? center * (1.0f / area) : position(indices[begin * 3]);
+      order.pushBack({(center - meshCenter).dot(normal), c});
+    }
+
+    std::stable_sort(order.begin(), order.end(), [](ClusterSort const & a, ClusterSort const & b) { return a.key > b.key; });
+
+    Vector<Index> output;
+    output.reserve(indices.size());
+    for (ClusterSort const & item : order) {
+      const int64_t begin = softClusters[item.cluster];
+      const int64_t end   = item.cluster + 1 < softClusters.size() ? softClusters[item.cluster + 1] : triangleCount;
+      output.pushBack(Span<const Index>(indices.data() + begin * 3, (end - begin) * 3));
+    }
+
+    memcpy(indices.data(), output.data(), output.size() * sizeof(Index));
+  }
+
+  int64_t MeshOptimizer::optimizeVertexFetch(Span<Index> const & indices, void * pVertices, int64_t vertexCount, int64_t vertexStride) {
+    Vector<Index> remap;
+    remap.resize(vertexCount, InvalidIndex);
+
+    Index nextVertex = 0;
+    for (Index & index : indices) {
+      if (remap[index] == InvalidIndex)
+        remap[index] = nextVertex++;
+      index = remap[index];
+    }
+
+    Vector<uint8_t> original;
+    original.pushBack(Span<const uint8_t>((uint8_t const *)pVertices, vertexCount * vertexStride));
+    remapVertices(pVertices, original.data(), vertexCount, vertexStride, remap);
+    return nextVertex;
+  }
+
+  MeshCacheStatistics MeshOptimizer::analyzeVertexCache(Span<const Index> const & indices, int64_t vertexCount, int64_t cacheSize) {
+    MeshCacheStatistics stats;
+    FIFOCache           cache(vertexCount, cacheSize);
+    Vector<bool>        referenced;
+    referenced.resize(vertexCount, false);
+
+    int64_t referencedCount = 0;
+    for (Index index : indices) {
+      stats.vertexTransforms += cache.access(index);
+      if (!referenced[index]) {
+        referenced[index] = true;
+        ++referencedCount;
+      }
+    }
+
+    const int64_t triangleCount = indices.size() / 3;
+    stats.acmr                  = triangleCount > 0 ? float(stats.vertexTransforms) / float(triangleCount) : 0;
+    stats.atvr                  = referencedCount > 0 ? float(stats.vertexTransforms) / float(referencedCount) : 0;
+    return stats;
+  }
+} // namespace bfc
@@ -0,0 +1,655 @@
+#include "mesh/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace bfc {
+  namespace {
+    constexpr int64_t AttributeCount = 5;     ///< Texture coordinates (2) and normal (3).
+    constexpr float   BorderWeight   = 10.0f; ///< Weight of the planes that keep borders in place.
+    constexpr float   InvalidCost    = std::numeric_limits<float>::max();
+
+    struct Float3 {
+      float x = 0, y = 0, z = 0;
+
+      Float3 operator-(Float3 const & o) const {
+        return {x - o.x, y - o.y, z - o.z};
+      }
+
+      Float3 operator+(Float3 const & o) const {
+        return {x + o.x, y + o.y, z + o.z};
+      }
+
+      Float3 operator*(float s) const {
+        return {x * s, y * s, z * s};
+      }
+
+      float dot(Float3 const & o) const {
+        return x * o.x + y * o.y + z * o.z;
+      }
+
+      Float3 cross(Float3 const & o) const {
+        return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+      }
+
+      float length() const {
+        return sqrtf(dot(*this));
+      }
+    };
+
+    /// A symmetric quadric, evaluated as p'Ap + 2b'p + c.
+    struct Quadric {
+      float a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+      float b0 = 0, b1 = 0, b2 = 0;
+      float c = 0;
+      float w = 0; ///< Total weight of the planes.
+
+      /// The quadric w * (g.p + d)^2. For a unit normal g this is the squared distance to a plane.
+      static Quadric fromLinear(Float3 const & g, float d, float w) {
+        Quadric q;
+        q.a00 = w * g.x * g.x;
+        q.a11 = w * g.y * g.y;
+        q.a22 = w * g.z * g.z;
+        q.a10 = w * g.y * g.x;
+        q.a20 = w * g.z * g.x;
+        q.a21 = w * g.z * g.y;
+        q.b0  = w * g.x * d;
+        q.b1  = w * g.y * d;
+        q.b2  = w * g.z * d;
+        q.c   = w * d * d;
+        q.w   = w;
+        return q;
+      }
+
+      void add(Quadric const & o) {
+        a00 += o.a00, a11 += o.a11, a22 += o.a22, a10 += o.a10, a20 += o.a20, a21 += o.a21;
+        b0 += o.b0, b1 += o.b1, b2 += o.b2;
+        c += o.c;
+        w += o.w;
+      }
+
+      /// The weighted mean of the squared distances to the planes.
+      /// Unlike eval(), this doesn't grow with the area around a vertex, so its square root is a distance.
+      float error(Float3 const & p) const {
+        return w > 0 ? std::max(eval(p), 0.0f) / w : 0;
+      }
+
+      float eval(Float3 const & p) const {
+        const float rx = a00 * p.x + a10 * p.y + a20 * p.z;
+        const float ry = a10 * p.x + a11 * p.y + a21 * p.z;
+        const float rz = a20 * p.x + a21 * p.y + a22 * p.z;
+        return rx * p.x + ry * p.y + rz * p.z + 2 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+      }
+    };
+
+    /// Error of one attribute channel, w * (g.p + d - s)^2, summed over the triangles around a vertex.
+    /// g.p + d interpolates the attribute linearly over a triangle, and s is the value after a collapse.
+    struct AttributeQuadric {
+      Quadric q;
+      Float3  g; ///< Sum of w * g
+      float   d = 0; ///< Sum of w * d
+      float   w = 0;
+
+      void add(AttributeQuadric const & o) {
+        q.add(o.q);
+        g = g + o.g;
+        d += o.d;
+        w += o.w;
+      }
+
+      /// The weighted mean of the error, in the same units as Quadric::error().
+      float error(Float3 const & p, float s) const {
+        return w > 0 ? std::max(q.eval(p) - 2 * s * (g.dot(p) + d) + w * s * s, 0.0f) / w : 0;
+      }
+    };
+
+    struct Triangle {
+      int64_t v[3];
+    };
+
+    /// The triangles of one material, with vertices and positions renumbered to only those used.
+    struct Problem {
+      Vector<Float3>   positions;      ///< Normalized positions.
+      Vector<int64_t>  vertexPosition; ///< Position of each vertex.
+      Vector<float>    attributes;     ///< AttributeCount weighted attributes per vertex.
+      Vector<bool>     locked;         ///< Positions that must not move.
+      Vector<Triangle> triangles;
+    };
+
+    uint64_t edgeKey(int64_t a, int64_t b) {
+      return a < b ? (uint64_t(a) << 32) | uint64_t(b) : (uint64_t(b) << 32) | uint64_t(a);
+    }
+
+    int64_t edgeCount(Vector<uint64_t> const & sortedEdges, int64_t a, int64_t b) {
+      const uint64_t key   = edgeKey(a, b);
+      auto           range = std::equal_range(sortedEdges.begin(), sortedEdges.end(), key);
+      return range.second - range.first;
+    }
+
+    class EdgeCollapser {
+    public:
+      EdgeCollapser(Problem * pProblem)
+        : m_p(*pProblem) {
+        m_positionQuadrics.resize(m_p.positions.size());
+        m_attributeQuadrics.resize(m_p.vertexPosition.size() * AttributeCount);
+
+        for (Triangle const & tri : m_p.triangles)
+          addTriangleQuadrics(tri);
+
+        rebuildTopology();
+        addBorderQuadrics();
+      }
+
+      /// Collapse edges until the triangle count reaches the target, or the next collapse would exceed maxError.
+      /// @returns The largest error of an applied collapse.
+      float run(int64_t targetCount, float maxError, bool lockBorders) {
+        const float maxCost = maxError * maxError;
+        float       error   = 0;
+
+        while (m_p.triangles.size() > targetCount) {
+          rebuildTopology();
+
+          // Find the cheapest direction to collapse each edge.
+          Vector<Collapse> candidates;
+          for (int64_t i = 0; i < m_edges.size(); ++i) {
+            if (i > 0 && m_edges[i] == m_edges[i - 1])
+              continue;
+
+            const int64_t a = int64_t(m_edges[i] >> 32);
+            const int64_t b = int64_t(m_edges[i] & 0xFFFFFFFF);
+
+            Collapse ab{a, b, cost(a, b, lockBorders, nullptr)};
+            Collapse ba{b, a, cost(b, a, lockBorders, nullptr)};
+            Collapse best = ab.cost <= ba.cost ? ab : ba;
+            if (best.cost <= maxCost)
+              candidates.pushBack(best);
+          }
+
+          std::sort(candidates.begin(), candidates.end(), [](Collapse const & l, Collapse const & r) { return l.cost < r.cost; });
+
+          // Apply the cheapest collapses that don't overlap each other.
+          Vector<bool> touched;
+          touched.resize(m_p.positions.size(), false);
+          m_vertexRemap.resize(m_p.vertexPosition.size());
+          for (int64_t v = 0; v < m_vertexRemap.size(); ++v)
+            m_vertexRemap[v] = v;
+
+          int64_t removed = 0;
+          int64_t applied = 0;
+          for (Collapse const & collapse : candidates) {
+            if (m_p.triangles.size() - removed <= targetCount)
+              break;
+
+            if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to))
+              continue;
+
+            m_wedges.clear();
+            cost(collapse.from, collapse.to, lockBorders, &m_wedges);
+            m_positionQuadrics[collapse.to].add(m_positionQuadrics[collapse.from]);
+            for (Wedge const & wedge : m_wedges) {
+              for (int64_t k = 0; k < AttributeCount; ++k)
+                m_attributeQuadrics[wedge.target * AttributeCount + k].add(m_attributeQuadrics[wedge.vertex * AttributeCount + k]);
+              m_vertexRemap[wedge.vertex] = wedge.target;
+            }
+
+            // Triangles around the collapsed position change shape, so their positions
+            // can't be collapsed again until the next pass.
+            for (int64_t t : trianglesOf(collapse.from)) {
+              bool shared = false;
+              for (int64_t v : m_p.triangles[t].v) {
+                touched[m_p.vertexPosition[v]] = true;
+                shared |= m_p.vertexPosition[v] == collapse.to;
+              }
+              removed += shared;
+            }
+
+            error = std::max(error, collapse.cost);
+            ++applied;
+          }
+
+          if (applied == 0)
+            break;
+
+          // Remap the collapsed vertices and drop triangles that became degenerate.
+          int64_t count = 0;
+          for (Triangle tri : m_p.triangles) {
+            for (int64_t & v : tri.v)
+              v = m_vertexRemap[v];
+
+            const int64_t p0 = m_p.vertexPosition[tri.v[0]];
+            const int64_t p1 = m_p.vertexPosition[tri.v[1]];
+            const int64_t p2 = m_p.vertexPosition[tri.v[2]];
+            if (p0 != p1 && p1 != p2 && p2 != p0)
+              m_p.triangles[count++] = tri;
+          }
+          m_p.triangles.resize(count);
+        }
+
+        return sqrtf(error);
+      }
+
+    private:
+      struct Collapse {
+        int64_t from;
+        int64_t to;
+        float   cost;
+      };
+
+      /// A vertex at the collapsed position, and the vertex it is replaced with.
+      struct Wedge {
+        int64_t vertex;
+        int64_t target;
+      };
+
+      Float3 const & positionOf(int64_t vertex) const {
+        return m_p.positions[m_p.vertexPosition[vertex]];
+      }
+
+      float const * attributesOf(int64_t vertex) const {
+        return m_p.attributes.data() + vertex * AttributeCount;
+      }
+
+      Span<const int64_t> trianglesOf(int64_t position) const {
+        return Span<const int64_t>(m_adjacency.data() + m_adjacencyOffsets[position], m_adjacencyOffsets[position + 1] - m_adjacencyOffsets[position]);
+      }
+
+      void addTriangleQuadrics(Triangle const & tri) {
+        const Float3 p0 = positionOf(tri.v[0]);
+        const Float3 e1 = positionOf(tri.v[1]) - p0;
+        const Float3 e2 = positionOf(tri.v[2]) - p0;
+        const Float3 n  = e1.cross(e2);
+        const float  len = n.length();
+        if (len <= 0)
+          return;
+
+        const float  area   = len * 0.5f;
+        const Float3 normal = n * (1.0f / len);
+        Quadric      plane  = Quadric::fromLinear(normal, -normal.dot(p0), area);
+        for (int64_t v : tri.v)
+          m_positionQuadrics[m_p.vertexPosition[v]].add(plane);
+
+        // Find the gradient of each attribute over the triangle by solving for g in the
+        // basis of the triangle edges, such that g.e1 = s1 - s0 and g.e2 = s2 - s0.
+        const float a   = e1.dot(e1);
+        const float b   = e1.dot(e2);
+        const float c   = e2.dot(e2);
+        const float det = a * c - b * b;
+        if (det <= 0)
+          return;
+
+        float const * s0 = attributesOf(tri.v[0]);
+        float const * s1 = attributesOf(tri.v[1]);
+        float const * s2 = attributesOf(tri.v[2]);
+        for (int64_t k = 0; k < AttributeCount; ++k) {
+          const float ds1 = s1[k] - s0[k];
+          const float ds2 = s2[k] - s0[k];
+          const float u   = (c * ds1 - b * ds2) / det;
+          const float w   = (a * ds2 - b * ds1) / det;
+
+          AttributeQuadric q;
+          q.g         = e1 * u + e2 * w;
+          q.d         = s0[k] - q.g.dot(p0);
+          q.q         = Quadric::fromLinear(q.g, q.d, area);
+          q.g         = q.g * area;
+          q.d         = q.d * area;
+          q.w         = area;
+          for (int64_t v : tri.v)
+            m_attributeQuadrics[v * AttributeCount + k].add(q);
+        }
+      }
+
+      /// Add planes perpendicular to the border edges, so collapses along the border keep its shape.
+      void addBorderQuadrics() {
+        for (Triangle const & tri : m_p.triangles) {
+          for (int64_t e = 0; e < 3; ++e) {
+            const int64_t a = m_p.vertexPosition[tri.v[e]];
+            const int64_t b = m_p.vertexPosition[tri.v[(e + 1) % 3]];
+            if (edgeCount(m_edges, a, b) != 1)
+              continue;
+
+            const Float3 pa     = m_p.positions[a];
+            const Float3 edge   = m_p.positions[b] - pa;
+            const Float3 normal = edge.cross(m_p.positions[m_p.vertexPosition[tri.v[(e + 2) % 3]]] - pa).cross(edge);
+            const float  len    = normal.length();
+            if (len <= 0)
+              continue;
+
+            const Float3 n     = normal * (1.0f / len);
+            Quadric      plane = Quadric::fromLinear(n, -n.dot(pa), edge.dot(edge) * BorderWeight);
+            m_positionQuadrics[a].add(plane);
+            m_positionQuadrics[b].add(plane);
+          }
+        }
+      }
+
+      /// Rebuild the triangles around each position, and the edges of the mesh.
+      void rebuildTopology() {
+        const int64_t positionCount = m_p.positions.size();
+        m_adjacencyOffsets.clear();
+        m_adjacencyOffsets.resize(positionCount + 1, 0);
+        for (Triangle const & tri : m_p.triangles)
+          for (int64_t v : tri.v)
+            ++m_adjacencyOffsets[m_p.vertexPosition[v] + 1];
+        for (int64_t p = 0; p < positionCount; ++p)
+          m_adjacencyOffsets[p + 1] += m_adjacencyOffsets[p];
+
+        Vector<int64_t> next = m_adjacencyOffsets;
+        m_adjacency.resize(m_p.triangles.size() * 3);
+        m_edges.clear();
+        for (int64_t t = 0; t < m_p.triangles.size(); ++t) {
+          Triangle const & tri = m_p.triangles[t];
+          for (int64_t e = 0; e < 3; ++e) {
+            m_adjacency[next[m_p.vertexPosition[tri.v[e]]]++] = t;
+            m_edges.pushBack(edgeKey(m_p.vertexPosition[tri.v[e]], m_p.vertexPosition[tri.v[(e + 1) % 3]]));
+          }
+        }
+        std::sort(m_edges.begin(), m_edges.end());
+
+        // Positions on open edges are borders. Positions on non-manifold edges are locked.
+        m_border.clear();
+        m_border.resize(positionCount, false);
+        m_nonManifold.clear();
+        m_nonManifold.resize(positionCount, false);
+        for (int64_t i = 0; i < m_edges.size();) {
+          int64_t end = i + 1;
+          while (end < m_edges.size() && m_edges[end] == m_edges[i])
+            ++end;
+
+          const int64_t a = int64_t(m_edges[i] >> 32);
+          const int64_t b = int64_t(m_edges[i] & 0xFFFFFFFF);
+          if (end - i == 1) {
+            m_border[a] = m_border[b] = true;
+          } else if (end - i > 2) {
+            m_nonManifold[a] = m_nonManifold[b] = true;
+          }
+          i = end;
+        }
+      }
+
+      /// Calculate the error of moving position `from` onto position `to`.
+      /// @param pWedges If not null, receives the vertices that are replaced.
+      float cost(int64_t from, int64_t to, bool lockBorders, Vector<Wedge> * pWedges) const {
+        if (m_p.locked[from] || m_nonManifold[from] || (lockBorders && m_border[from]))
+          return InvalidCost;
+
+        // Borders may only move along the border.
+        if (m_border[from] && edgeCount(m_edges, from, to) != 1)
+          return InvalidCost;
+
+        const Float3 target = m_p.positions[to];
+        float        error  = m_positionQuadrics[from].error(target);
+
+        // Every vertex at `from` needs a vertex at `to` on the same side of any attribute seam.
+        // If one doesn't exist, the collapse would cross a seam.
+        int64_t wedgesSeen[8];
+        int64_t wedgeCount = 0;
+        for (int64_t t : trianglesOf(from)) {
+          for (int64_t vertex : m_p.triangles[t].v) {
+            if (m_p.vertexPosition[vertex] != from || std::find(wedgesSeen, wedgesSeen + wedgeCount, vertex) != wedgesSeen + wedgeCount)
+              continue;
+
+            if (wedgeCount == 8)
+              return InvalidCost; // Too many seams meet here
+
+            wedgesSeen[wedgeCount++] = vertex;
+
+            int64_t replacement = -1;
+            for (int64_t t2 : trianglesOf(from)) {
+              Triangle const & tri = m_p.triangles[t2];
+              if (tri.v[0] != vertex && tri.v[1] != vertex && tri.v[2] != vertex)
+                continue;
+
+              for (int64_t other : tri.v) {
+                if (m_p.vertexPosition[other] == to) {
+                  replacement = other;
+                  break;
+                }
+              }
+
+              if (replacement != -1)
+                break;
+            }
+
+            if (replacement == -1)
+              return InvalidCost;
+
+            float const * attributes = attributesOf(replacement);
+            for (int64_t k = 0; k < AttributeCount; ++k)
+              error += m_attributeQuadrics[vertex * AttributeCount + k].error(target, attributes[k]);
+
+            if (pWedges != nullptr)
+              pWedges->pushBack({vertex, replacement});
+          }
+        }
+
+        return std::max(error, 0.0f);
+      }
+
+      /// Test if moving `from` onto `to` would flip any of the remaining triangles.
+      bool flips(int64_t from, int64_t to) const {
+        const Float3 source = m_p.positions[from];
+        const Float3 target = m_p.positions[to];
+        for (int64_t t : trianglesOf(from)) {
+          Triangle const & tri = m_p.triangles[t];
+          int64_t          corner = 0;
+          bool             shared = false;
+          for (int64_t c = 0; c < 3; ++c) {
+            const int64_t p = m_p.vertexPosition[tri.v[c]];
+            corner          = p == from ? c : corner;
+            shared |= p == to;
+          }
+
+          if (shared)
+            continue; // Removed by the collapse
+
+          const Float3 p1     = positionOf(tri.v[(corner + 1) % 3]);
+          const Float3 p2     = positionOf(tri.v[(corner + 2) % 3]);
+          const Float3 before = (p1 - source).cross(p2 - source);
+          const Float3 after  = (p1 - target).cross(p2 - target);
+          if (before.dot(after) <= 0)
+            return true;
+        }
+        return false;
+      }
+
+      Problem & m_p;
+
+      Vector<Quadric>          m_positionQuadrics;
+      Vector<AttributeQuadric> m_attributeQuadrics;
+
+      Vector<int64_t>  m_adjacencyOffsets;
+      Vector<int64_t>  m_adjacency;
+      Vector<uint64_t> m_edges; ///< Sorted position edges, one entry per triangle edge.
+      Vector<bool>     m_border;
+      Vector<bool>     m_nonManifold;
+      Vector<int64_t>  m_vertexRemap;
+      Vector<Wedge>    m_wedges;
+    };
+
+    /// Attribute and position data shared by all materials of a mesh.
+    struct MeshContext {
+      Vector<Float3>  positions;      ///< Normalized positions, with duplicate positions removed.
+      Vector<int64_t> vertexPosition; ///< Index into positions for each mesh vertex.
+      Vector<float>   attributes;     ///< AttributeCount weighted attributes per mesh vertex.
+      double          extent = 1;     ///< Size of the mesh, used to normalize positions.
+
+      MeshContext(MeshData const & mesh, MeshSimplifyOptions const & options) {
+        Vec3d minPos(std::numeric_limits<double>::max());
+        Vec3d maxPos(-std::numeric_limits<double>::max());
+        for (Vec3d const & p : mesh.positions) {
+          for (int64_t i = 0; i < 3; ++i) {
+            minPos[i] = std::min(minPos[i], p[i]);
+            maxPos[i] = std::max(maxPos[i], p[i]);
+          }
+        }
+
+        extent = 0;
+        for (int64_t i = 0; i < 3; ++i)
+          extent = std::max(extent, maxPos[i] - minPos[i]);
+        extent = extent > 0 ? extent : 1;
+
+        // Positions that are split at seams are welded, so that seams are not treated as borders.
+        Vector<int64_t> order;
+        order.resize(mesh.positions.size());
+        for (int64_t i = 0; i < order.size(); ++i)
+          order[i] = i;
+        auto less = [&](int64_t a, int64_t b) {
+          Vec3d const & pa = mesh.positions[a];
+          Vec3d const & pb = mesh.positions[b];
+          return pa[0] != pb[0] ? pa[0] < pb[0] : pa[1] != pb[1] ? pa[1] < pb[1] : pa[2] < pb[2];
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        Vector<int64_t> canonical;
+        canonical.resize(mesh.positions.size());
+        for (int64_t i = 0; i < order.size(); ++i) {
+          if (i == 0 || less(order[i - 1], order[i])) {
+            Vec3d const & p = mesh.positions[order[i]];
+            positions.pushBack(Float3{float((p[0] - minPos[0]) / extent), float((p[1] - minPos[1]) / extent), float((p[2] - minPos[2]) / extent)});
+          }
+          canonical[order[i]] = positions.size() - 1;
+        }
+
+        vertexPosition.resize(mesh.vertices.size());
+        attributes.resize(mesh.vertices.size() * AttributeCount, 0.0f);
+        for (int64_t v = 0; v < mesh.vertices.size(); ++v) {
+          MeshData::Vertex const & vert = mesh.vertices[v];
+          vertexPosition[v]             = vert.position >= 0 ? canonical[vert.position] : 0;
+
+          float * pAttributes = attributes.data() + v * AttributeCount;
+          if (vert.uv >= 0) {
+            pAttributes[0] = float(mesh.uvs[vert.uv][0] * options.uvWeight);
+            pAttributes[1] = float(mesh.uvs[vert.uv][1] * options.uvWeight);
+          }
+
+          if (vert.normal >= 0) {
+            pAttributes[2] = float(mesh.normals[vert.normal][0] * options.normalWeight);
+            pAttributes[3] = float(mesh.normals[vert.normal][1] * options.normalWeight);
+            pAttributes[4] = float(mesh.normals[vert.normal][2] * options.normalWeight);
+          }
+        }
+      }
+    };
+  } // namespace
+
+  Vector<MeshData::Triangle> MeshSimplifier::simplify(MeshData const & mesh, Span<const MeshData::Triangle> const & triangles, MeshSimplifyOptions const & options,
+                                                      double * pError) {
+    if (pError != nullptr)
+      *pError = 0;
+
+    if (triangles.size() == 0 || mesh.positions.size() == 0)
+      return Vector<MeshData::Triangle>(triangles);
+
+    MeshContext context(mesh, options);
+
+    // Edges shared with other materials are locked, so the materials stay connected.
+    auto positionOf = [&](MeshData::Triangle const & tri, int64_t corner) { return context.vertexPosition[tri.vertex[corner]]; };
+
+    Vector<uint64_t> allEdges;
+    Vector<int64_t>  materials;
+    for (MeshData::Triangle const & tri : triangles) {
+      for (int64_t e = 0; e < 3; ++e)
+        allEdges.pushBack(edgeKey(positionOf(tri, e), positionOf(tri, (e + 1) % 3)));
+      materials.pushBack(tri.material);
+    }
+    std::sort(allEdges.begin(), allEdges.end());
+    std::sort(materials.begin(), materials.end());
+    materials.resize(std::unique(materials.begin(), materials.end()) - materials.begin());
+
+    Vector<MeshData::Triangle> result;
+    Vector<int64_t>            localVertex;
+    Vector<int64_t>            localPosition;
+    localVertex.resize(mesh.vertices.size(), -1);
+    localPosition.resize(context.positions.size(), -1);
+
+    double error = 0;
+    for (int64_t material : materials) {
+      Problem         problem;
+      Vector<int64_t> globalVertex;
+      Vector<int64_t> globalPosition;
+      for (MeshData::Triangle const & tri : triangles) {
+        if (tri.material != material)
+          continue;
+
+        Triangle local;
+        for (int64_t c = 0; c < 3; ++c) {
+          const int64_t v = tri.vertex[c];
+          if (localVertex[v] == -1) {
+            const int64_t p = context.vertexPosition[v];
+            if (localPosition[p] == -1) {
+              localPosition[p] = globalPosition.size();
+              globalPosition.pushBack(p);
+              problem.positions.pushBack(context.positions[p]);
+            }
+
+            localVertex[v] = globalVertex.size();
+            globalVertex.pushBack(v);
+            problem.vertexPosition.pushBack(localPosition[p]);
+            problem.attributes.pushBack(Span<const float>(context.attributes.data() + v * AttributeCount, AttributeCount));
+          }
+          local.v[c] = localVertex[v];
+        }
+        problem.triangles.pushBack(local);
+      }
+
+      Vector<uint64_t> edges;
+      for (Triangle const & tri : problem.triangles)
+        for (int64_t e = 0; e < 3; ++e)
+          edges.pushBack(edgeKey(globalPosition[problem.vertexPosition[tri.v[e]]], globalPosition[problem.vertexPosition[tri.v[(e + 1) % 3]]]));
+      std::sort(edges.begin(), edges.end());
+
+      problem.locked.resize(problem.positions.size(), false);
+      for (uint64_t edge : edges) {
+        const int64_t a = int64_t(edge >> 32);
+        const int64_t b = int64_t(edge & 0xFFFFFFFF);
+        if (edgeCount(allEdges, a, b) != edgeCount(edges, a, b))
+          problem.locked[localPosition[a]] = problem.locked[localPosition[b]] = true;
+      }
+
+      const int64_t target = options.targetTriangleCount * problem.triangles.size() / triangles.size();
+      EdgeCollapser collapser(&problem);
+      error = std::max(error, (double)collapser.run(target, (float)options.targetError, options.lockBorders));
+
+      for (Triangle const & tri : problem.triangles) {
+        MeshData::Triangle out;
+        for (int64_t c = 0; c < 3; ++c)
+          out.vertex[c] = globalVertex[tri.v[c]];
+        out.material = material;
+        result.pushBack(out);
+      }
+
+      for (int64_t v : globalVertex)
+        localVertex[v] = -1;
+      for (int64_t p : globalPosition)
+        localPosition[p] = -1;
+    }
+
+    if (pError != nullptr)
+      *pError = error * context.extent;
+    return result;
+  }
+
+  void MeshSimplifier::generateLODs(MeshData * pMesh, int64_t levelCount, double reduction, double maxError) {
+    pMesh->lods.clear();
+
+    int64_t previousCount = pMesh->triangles.size();
+    for (int64_t level = 1; level <= levelCount; ++level) {
+      // Each level is simplified from the full detail mesh so errors don't accumulate.
+      MeshSimplifyOptions options;
+      options.targetTriangleCount = int64_t(previousCount * reduction);
+      options.targetError         = maxError;
+
+      MeshData::LevelOfDetail lod;
+      lod.triangles = simplify(*pMesh, pMesh->triangles, options, &lod.error);
+
+      // Stop once the error bound prevents meaningful reduction.
+      if (lod.triangles.size() == 0 || lod.triangles.size() > previousCount - (previousCount - options.targetTriangleCount) / 2)
+        break;
+
+      previousCount = lod.triangles.size();
+      pMesh->lods.pushBack(std::move(lod));
+    }
+  }
+} // namespace bfc
@@ -0,0 +1,232 @@
+#include "mesh/Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace bfc {
+  namespace {
+    struct Float3 {
+      float x = 0, y = 0, z = 0;
+
+      Float3 operator-(Float3 const & o) const {
+        return {x - o.x, y - o.y, z - o.z};
+      }
+
+      Float3 operator+(Float3 const & o) const {
+        return {x + o.x, y + o.y, z + o.z};
+      }
+
+      Float3 operator*(float s) const {
+        return {x * s, y * s, z * s};
+      }
+
+      float dot(Float3 const & o) const {
+        return x * o.x + y * o.y + z * o.z;
+      }
+
+      Float3 cross(Float3 const & o) const {
+        return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+      }
+
+      float length() const {
+        return sqrtf(dot(*this));
+      }
+    };
+
+    Float3 positionOf(float const * pPositions, int64_t vertexStride, MeshletBuilder::Index index) {
+      float const * p = (float const *)((uint8_t const *)pPositions + index * vertexStride);
+      return {p[0], p[1], p[2]};
+    }
+  } // namespace
+
+  Vector<Meshlet> MeshletBuilder::build(Span<Index> const & indices, float const * pPositions, int64_t vertexCount, int64_t vertexStride,
+                                        int64_t maxVertices, int64_t maxTriangles) {
+    const int64_t triangleCount = indices.size() / 3;
+
+    // The triangles that reference each vertex.
+    Vector<int64_t> adjacencyOffsets;
+    Vector<int64_t> adjacency;
+    adjacencyOffsets.resize(vertexCount + 1, 0);
+    for (Index index : indices)
+      ++adjacencyOffsets[index + 1];
+    for (int64_t v = 0; v < vertexCount; ++v)
+      adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    Vector<int64_t> next = adjacencyOffsets;
+    adjacency.resize(triangleCount * 3);
+    for (int64_t i = 0; i < triangleCount * 3; ++i)
+      adjacency[next[indices[i]]++] = i / 3;
+
+    Vector<Float3> centroids;
+    centroids.resize(triangleCount);
+    for (int64_t t = 0; t < triangleCount; ++t) {
+      Float3 sum;
+      for (int64_t c = 0; c < 3; ++c)
+        sum = sum + positionOf(pPositions, vertexStride, indices[t * 3 + c]);
+      centroids[t] = sum * (1.0f / 3);
+    }
+
+    Vector<bool>    emitted;
+    Vector<int64_t> vertexMeshlet; // The last meshlet that used each vertex
+    Vector<int64_t> candidates;
+    Vector<Index>   ordered;
+    emitted.resize(triangleCount, false);
+    vertexMeshlet.resize(vertexCount, -1);
+    ordered.reserve(indices.size());
+
+    Vector<Meshlet> meshlets;
+    int64_t         seed = 0;
+    while (true) {
+      while (seed < triangleCount && emitted[seed])
+        ++seed;
+
+      if (seed == triangleCount)
+        break;
+
+      const int64_t id = meshlets.size();
+      Meshlet       meshlet;
+      meshlet.elmOffset = ordered.size();
+
+      int64_t uniqueVertices = 0;
+      int64_t triangles      = 0;
+      Float3  centroidSum;
+      candidates.clear();
+
+      int64_t triangle = seed;
+      while (triangle != -1) {
+        emitted[triangle] = true;
+        ++triangles;
+        centroidSum = centroidSum + centroids[triangle];
+        for (int64_t c = 0; c < 3; ++c) {
+          const Index v = indices[triangle * 3 + c];
+          ordered.pushBack(v);
+          if (vertexMeshlet[v] != id) {
+            vertexMeshlet[v] = id;
+            ++uniqueVertices;
+            candidates.pushBack(adjacency.data() + adjacencyOffsets[v], adjacency.data() + adjacencyOffsets[v + 1]);
+          }
+        }
+
+        if (triangles == maxTriangles)
+          break;
+
+        // Pick the neighbour that adds the fewest vertices, then the one closest to the meshlet.
+        const Float3 center       = centroidSum * (1.0f / triangles);
+        int64_t      bestNew      = 3;
+        float        bestDistance = std::numeric_limits<float>::max();
+        int64_t      count        = 0;
+        triangle                  = -1;
+        for (int64_t candidate : candidates) {
+          if (emitted[candidate])
+            continue;
+
+          candidates[count++] = candidate; // Drop emitted triangles as we go
+
+          int64_t newVertices = 0;
+          for (int64_t c = 0; c < 3; ++c)
+            newVertices += vertexMeshlet[indices[candidate * 3 + c]] != id;
+          if (uniqueVertices + newVertices > maxVertices || newVertices > bestNew)
+            continue;
+
+          const Float3 offset   = centroids[candidate] - center;
+          const float  distance = offset.dot(offset);
+          if (newVertices < bestNew || distance < bestDistance) {
+            bestNew      = newVertices;
+            bestDistance = distance;
+            triangle     = candidate;
+          }
+        }
+        candidates.resize(count);
+      }
+
+      meshlet.elmCount = ordered.size() - meshlet.elmOffset;
+      meshlets.pushBack(meshlet);
+    }
+
+    memcpy(indices.data(), ordered.data(), sizeof(Index) * ordered.size());
+
+    for (Meshlet & meshlet : meshlets)
+      calculateBounds(&meshlet, Span<const Index>(indices.data() + meshlet.elmOffset, meshlet.elmCount), pPositions, vertexStride);
+
+    return meshlets;
+  }
+
+  void MeshletBuilder::calculateBounds(Meshlet * pMeshlet, Span<const Index> const & indices, float const * pPositions, int64_t vertexStride) {
+    // Bounding sphere centered on the bounding box.
+    Float3 minPos{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    Float3 maxPos = minPos * -1.0f;
+    for (Index index : indices) {
+      const Float3 p = positionOf(pPositions, vertexStride, index);
+      minPos         = {std::min(minPos.x, p.x), std::min(minPos.y, p.y), std::min(minPos.z, p.z)};
+      maxPos         = {std::max(maxPos.x, p.x), std::max(maxPos.y, p.y), std::max(maxPos.z, p.z)};
+    }
+
+    const Float3 center = (minPos + maxPos) * 0.5f;
+    float        radius = 0;
+    for (Index index : indices)
+      radius = std::max(radius, (positionOf(pPositions, vertexStride, index) - center).length());
+
+    pMeshlet->bounds     = geometry::Spheref(Vec3(center.x, center.y, center.z), radius);
+    pMeshlet->coneApex   = Vec3(center.x, center.y, center.z);
+    pMeshlet->coneAxis   = Vec3(0);
+    pMeshlet->coneCutoff = 2;
+
+    // Normal cone. The axis is the average triangle normal, and the cone is wide enough to contain all of them.
+    struct Face {
+      Float3 origin;
+      Float3 normal;
+    };
+
+    Vector<Face> faces;
+    Float3       axis;
+    for (int64_t i = 0; i + 2 < indices.size(); i += 3) {
+      const Float3 p0     = positionOf(pPositions, vertexStride, indices[i]);
+      const Float3 normal = (positionOf(pPositions, vertexStride, indices[i + 1]) - p0).cross(positionOf(pPositions, vertexStride, indices[i + 2]) - p0);
+      const float  length = normal.length();
+      if (length > 0) {
+        faces.pushBack(Face{p0, normal * (1.0f / length)});
+        axis = axis + faces.back().normal;
+      }
+    }
+
+    const float axisLength = axis.length();
+    if (axisLength <= 0)
+      return;
+
+    axis = axis * (1.0f / axisLength);
+
+    float minDot = 1;
+    for (Face const & face : faces)
+      minDot = std::min(minDot, face.normal.dot(axis));
+
+    if (minDot <= 0)
+      return; // The normals cover more than a hemisphere, so some triangle always faces the viewer.
+
+    // Move the apex back along the axis until every triangle plane is in front of it. A viewer outside the
+    // cone around the apex is then behind every triangle.
+    float maxT = 0;
+    for (Face const & face : faces)
+      maxT = std::max(maxT, (center - face.origin).dot(face.normal) / axis.dot(face.normal));
+
+    const Float3 apex    = center - axis * maxT;
+    pMeshlet->coneApex   = Vec3(apex.x, apex.y, apex.z);
+    pMeshlet->coneAxis   = Vec3(axis.x, axis.y, axis.z);
+    pMeshlet->coneCutoff = sqrtf(1 - minDot * minDot);
+  }
+
+  bool MeshletBuilder::isVisible(Meshlet const & meshlet, geometry::Frustumf const & frustum, Vec3 const & viewer, bool useCone) {
+    if (!geometry::intersects(frustum, meshlet.bounds))
+      return false;
+
+    if (useCone && meshlet.coneCutoff <= 1) {
+      const Vec3  toApex   = meshlet.coneApex - viewer;
+      const float distance = glm::length(toApex);
+      if (distance > 0 && glm::dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * distance)
+        return false;
+    }
+
+    return true;
+  }
+} // namespace bfc
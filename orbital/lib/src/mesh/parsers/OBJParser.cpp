@@ -5,6 +5,9 @@
 #include "mesh/MeshData.h"
 #include "util/Iterators.h"
 #include "util/Scan.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
 
 namespace bfc {
   constexpr int64_t InvalidIndex = std::numeric_limits<int64_t>::max();
@@ -46,204 +49,440 @@ namespace bfc {
     return OBJKeyword_None;
   }
 
-  class BufferedReader : public Stream {
-  public:
-    BufferedReader(Stream * pStream, int64_t chunkSize = 32 * 1024 * 1024ll)
-      : m_pStream(pStream)
-      , m_bufferedSize(chunkSize)
-      , m_chunkStart(pStream->tell())
-      , m_chunkPos(0)
-    {}
+  namespace {
+    /// Files smaller than this are parsed as a single chunk.
+    constexpr int64_t MinChunkSize = 1024 * 1024ll;
 
-    virtual bool readable() const {
-      return true;
-    }
+    /// Number of chunks created per hardware thread, so uneven chunks balance out.
+    constexpr int64_t ChunksPerThread = 4;
+
+    /// Meshes with fewer face corners than this are deduplicated on a single thread.
+    constexpr int64_t MinCornersPerShard = 64 * 1024ll;
 
-    virtual bool writeable() const {
-      return false;
+    /// A face corner as written in the file, before the chunk offsets are applied.
+    /// Indices are zero based. Relative (negative) indices are stored as an index
+    /// into the chunk's own elements, and flagged so the chunk offset is added when merging.
+    struct Corner {
+      enum Flags : uint8_t {
+        Flags_RelativePosition = 1 << 0,
+        Flags_RelativeUV       = 1 << 1,
+        Flags_RelativeNormal   = 1 << 2,
+      };
+
+      int64_t position = -1;
+      int64_t uv       = -1;
+      int64_t normal   = -1;
+      uint8_t flags    = 0;
+    };
+
+    /// Elements parsed from a range of lines in the file.
+    struct Chunk {
+      StringView text;
+
+      Vector<Vec3d>              positions;
+      Vector<Vec2d>              uvs;
+      Vector<Vec3d>              normals;
+      Vector<Corner>             corners;
+      Vector<MeshData::Triangle> triangles; ///< Vertices index corners. Material indexes materials, or -1 for the material active when the chunk started.
+      Vector<StringView>         materials; ///< Material names in the order they were referenced.
+      StringView                 mtlFile;
+
+      // Offsets of this chunk's elements in the merged mesh.
+      int64_t positionOffset = 0;
+      int64_t uvOffset       = 0;
+      int64_t normalOffset   = 0;
+      int64_t cornerOffset   = 0;
+      int64_t triangleOffset = 0;
+
+      Vector<int64_t> materialIDs; ///< Mesh material index of each entry in materials.
+      int64_t         initialMaterial = 0;
+    };
+
+    bool isSpace(char c) {
+      return c == ' ' || c == '\t' || c == '\r';
     }
 
-    virtual bool seekable() const {
-      return false;
+    StringView skipSpace(StringView const & str) {
+      char const * it = str.begin();
+      while (it < str.end() && isSpace(*it))
+        ++it;
+      return StringView(it, str.end());
     }
 
-    virtual bool eof() const {
-      return m_chunkStart + m_chunkPos == m_pStream->tell() && m_pStream->eof();
+    StringView nextToken(StringView * pLine) {
+      StringView   str = skipSpace(*pLine);
+      char const * it  = str.begin();
+      while (it < str.end() && !isSpace(*it))
+        ++it;
+      *pLine = StringView(it, str.end());
+      return StringView(str.begin(), it);
     }
 
-    virtual int64_t write(void const* data, int64_t length) {
-      BFC_UNUSED(data, length);
-      return 0;
+    /// Read a vector of up to N components from the rest of a line. Missing components are 0.
+    template<typename VecT>
+    VecT readVector(StringView const & line) {
+      VecT ret(0);
+      Scan::readFloats(line, &ret[0], VecT::length());
+      return ret;
     }
 
-    virtual int64_t read(void* data, int64_t length) {
-      int64_t remaining = length;
+    /// Read a single face corner index. Returns false if there is no index.
+    bool readIndex(StringView * pStr, int64_t count, int64_t * pIndex, bool * pRelative) {
+      int64_t       len   = 0;
+      const int64_t value = Scan::readInt(*pStr, &len);
+      *pStr               = pStr->substr(len);
+      if (len == 0 || value == 0)
+        return false;
+
+      *pRelative = value < 0;
+      *pIndex    = value < 0 ? count + value : value - 1;
+      return true;
+    }
 
-      while (remaining > 0) {
-        const int64_t available = m_chunkSize - m_chunkPos;
-        const int64_t readSize  = math::min(length, available);
-        memcpy(data, m_chunk.begin() + m_chunkPos, readSize);
+    Corner readCorner(StringView token, Chunk const & chunk) {
+      Corner corner;
+      bool   relative = false;
+      if (readIndex(&token, chunk.positions.size(), &corner.position, &relative) && relative)
+        corner.flags |= Corner::Flags_RelativePosition;
 
-        remaining  -= readSize;
-        m_chunkPos += readSize;
+      if (token.length() > 0 && token[0] == '/') {
+        token = token.substr(1);
+        if (readIndex(&token, chunk.uvs.size(), &corner.uv, &relative) && relative)
+          corner.flags |= Corner::Flags_RelativeUV;
+      }
 
-        if (m_chunkPos == m_chunkSize) {
-          m_chunkStart = m_pStream->tell();
-          m_chunkPos   = 0;
+      if (token.length() > 0 && token[0] == '/') {
+        token = token.substr(1);
+        if (readIndex(&token, chunk.normals.size(), &corner.normal, &relative) && relative)
+          corner.flags |= Corner::Flags_RelativeNormal;
+      }
+      return corner;
+    }
 
-          m_chunk.reserve(m_bufferedSize);
-          m_chunkSize = m_pStream->read(m_chunk.begin(), m_bufferedSize);
+    void parseChunk(Chunk * pChunk) {
+      char const * it  = pChunk->text.begin();
+      char const * end = pChunk->text.end();
+
+      // Reserve memory based on the chunk size to reduce allocations
+      const int64_t len = end - it;
+      pChunk->positions.reserve(len / 60);
+      pChunk->corners.reserve(len / 60);
+      pChunk->triangles.reserve(len / 180);
+
+      int64_t material = -1;
+      while (it < end) {
+        char const * lineEnd = (char const *)memchr(it, '\n', end - it);
+        if (lineEnd == nullptr)
+          lineEnd = end;
+
+        StringView line(it, lineEnd);
+        it = lineEnd + 1;
+
+        StringView keyword = nextToken(&line);
+        if (keyword.length() == 0)
+          continue;
+
+        switch (ScanKeyword(keyword)) {
+        case OBJKeyword_Face: // Scan face definition and triangulate as a fan
+        {
+          const int64_t firstCorner = pChunk->corners.size();
+          for (StringView token = nextToken(&line); token.length() > 0; token = nextToken(&line)) {
+            pChunk->corners.pushBack(readCorner(token, *pChunk));
+          }
 
-          if (m_chunk.size() == 0) {
-            break;
+          for (int64_t c = firstCorner + 2; c < pChunk->corners.size(); ++c) {
+            MeshData::Triangle tri;
+            tri.vertex[0] = firstCorner;
+            tri.vertex[1] = c - 1;
+            tri.vertex[2] = c;
+            tri.material  = material;
+            pChunk->triangles.pushBack(tri);
           }
+        } break;
+        case OBJKeyword_Vertex: pChunk->positions.pushBack(readVector<Vec3d>(line)); break;
+        case OBJKeyword_Normal: pChunk->normals.pushBack(readVector<Vec3d>(line)); break;
+        case OBJKeyword_TexCoord: pChunk->uvs.pushBack(readVector<Vec2d>(line)); break;
+        case OBJKeyword_MatLib: pChunk->mtlFile = line.trim(); break;
+        case OBJKeyword_MatRef:
+          material = pChunk->materials.size();
+          pChunk->materials.pushBack(line.trim());
+          break;
+        case OBJKeyword_Object:
+        case OBJKeyword_Group:
+        case OBJKeyword_SmoothShading:
+        case OBJKeyword_Line:
+        case OBJKeyword_None:
+        case OBJKeyword_Comment: break;
         }
       }
-
-      return length - remaining;
     }
 
-    virtual int64_t tell() const {
-      return m_chunkStart + m_chunkPos;
+    /// Split text into roughly equal chunks that start and end on line boundaries.
+    Vector<Chunk> splitChunks(StringView const & text, int64_t chunkCount) {
+      Vector<Chunk> chunks;
+      char const *  it = text.begin();
+      for (int64_t i = 1; i <= chunkCount && it < text.end(); ++i) {
+        char const * chunkEnd = text.begin() + text.length() * i / chunkCount;
+        if (chunkEnd < it)
+          chunkEnd = it;
+        chunkEnd = (char const *)memchr(chunkEnd, '\n', text.end() - chunkEnd);
+        chunkEnd = chunkEnd == nullptr ? text.end() : chunkEnd + 1;
+
+        chunks.pushBack(Chunk{});
+        chunks.back().text = StringView(it, chunkEnd);
+        it                 = chunkEnd;
+      }
+      return chunks;
     }
 
-  private:
-    int64_t m_bufferedSize = 0;
-    int64_t m_chunkStart   = 0;
-    int64_t m_chunkPos     = 0;
-
-    Stream *        m_pStream = nullptr;
-    Vector<uint8_t> m_chunk;
-    int64_t         m_chunkSize = 0;
-  };
+    /// Offset a corner's indices into the merged mesh, and reject indices that are out of range.
+    Corner resolveCorner(Corner corner, Chunk const & chunk, MeshData const & mesh) {
+      auto resolve = [](int64_t index, bool relative, int64_t offset, int64_t count) -> int64_t {
+        if (index == -1 && !relative)
+          return -1;
+        index += relative ? offset : 0;
+        return index >= 0 && index < count ? index : -1;
+      };
 
-  bool OBJParser::read(Stream * pStream, MeshData * pMesh, StringView const & resourceDir) {
-    BufferedReader bufferedReader(pStream); // Buffered because we are often reading a large amount of data
-    TextReader     reader(&bufferedReader);
+      corner.position = resolve(corner.position, corner.flags & Corner::Flags_RelativePosition, chunk.positionOffset, mesh.positions.size());
+      corner.uv       = resolve(corner.uv, corner.flags & Corner::Flags_RelativeUV, chunk.uvOffset, mesh.uvs.size());
+      corner.normal   = resolve(corner.normal, corner.flags & Corner::Flags_RelativeNormal, chunk.normalOffset, mesh.normals.size());
+      corner.flags    = 0;
+      return corner;
+    }
 
-    {
-      const int64_t len = pStream->length();
-      // Reserve memory based on file size to reduce allocations
-      if (len != -1) {
-        pMesh->normals.reserve(len / 60);
-        pMesh->triangles.reserve(len / 180);
-        pMesh->positions.reserve(len / 60);
-        pMesh->uvs.reserve(len / 60);
-      }
+    uint64_t hashCorner(Corner const & corner) {
+      // Indices hash to themselves, so mix the result to spread them across shards and slots.
+      uint64_t h = hashCombine(hashCombine(hash(corner.position), hash(corner.uv)), hash(corner.normal));
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      return h;
     }
 
-    String               mtlFile = "";
-    String               curMat  = "";
-    Map<String, int64_t> matNames;
-    int64_t              matID = 0;
-
-    Vector<StringView> delims = {" ", "\t", "\n"};
-    StringSplitter     splitter;
-    StringSplitter     vertDefSplitter;
-    while (!bufferedReader.eof()) {
-      StringView line = reader.readLine();
-      splitter(line, delims, true);
-      if (splitter.tokens.size() == 0)
-        continue;
+    bool operator==(Corner const & a, Corner const & b) {
+      return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+    }
 
-      Vector<StringView> & tokens = splitter.tokens;
+    /// Open addressing hash set of corners, used to find the first corner with the same indices.
+    class CornerSet {
+    public:
+      CornerSet(Corner const * pCorners, int64_t capacity)
+        : m_pCorners(pCorners) {
+        int64_t size = 16;
+        while (size < capacity * 2)
+          size *= 2;
+        m_slots.resize(size, npos);
+      }
 
-      switch (ScanKeyword(tokens.front())) {
-      case OBJKeyword_Face: // Scan face definition and triangulate
-      {
-        int64_t firstVert  = -1;
-        int64_t lastVert   = -1;
-        bool    isFirstTri = true;
-        for (int64_t v = 1; v < tokens.size();) {
-          pMesh->triangles.pushBack(MeshData::Triangle{});
-          MeshData::Triangle & tri = pMesh->triangles.back();
-          tri.material             = matID;
-          if (!isFirstTri) {
-            tri.vertex[0] = firstVert;
-            tri.vertex[1] = lastVert;
+      /// Add a corner to the set.
+      /// @returns The index of the first corner that was added with the same indices.
+      int64_t add(int64_t corner, uint64_t hash) {
+        if ((m_count + 1) * 2 > m_slots.size())
+          grow();
+
+        const int64_t mask = m_slots.size() - 1;
+        for (int64_t slot = hash & mask;; slot = (slot + 1) & mask) {
+          int64_t & existing = m_slots[slot];
+          if (existing == npos) {
+            existing = corner;
+            ++m_count;
+            return corner;
           }
 
-          for (int64_t v2 = isFirstTri ? 0 : 2; v < tokens.size() && v2 < 3; ++v2, ++v) {
-            int64_t                    len        = 0;
-            int64_t                    slashIndex = 0;
-            MeshData::Vertex           vert;
-            int64_t *                  mapping[] = {&vert.position, &vert.uv, &vert.normal};
-            Vector<StringView> const & indices   = vertDefSplitter(tokens[v], "/", false);
-            for (int64_t i = 0; i < indices.size(); ++i) {
-              if (indices[i].length() > 0) {
-                *mapping[i] = Scan::readInt(indices[i]);
-              } else {
-                *mapping[i] = 0; // Will be mapped to -1 (invalid) later
-              }
-            }
-
-            tri.vertex[v2] = pMesh->vertices.size();
-            pMesh->vertices.pushBack(vert);
-          }
+          if (m_pCorners[existing] == m_pCorners[corner])
+            return existing;
+        }
+      }
 
-          if (isFirstTri)
-            firstVert = tri.vertex[0];
-          lastVert = tri.vertex[2];
+    private:
+      void grow() {
+        Vector<int64_t> old = std::move(m_slots);
+        m_slots.resize(old.size() * 2, npos);
 
-          isFirstTri = false;
-        }
-      } break;
-      case OBJKeyword_Vertex:
-        if (tokens.size() >= 4) {
-          pMesh->positions.pushBack({Scan::readFloat(tokens[1]), Scan::readFloat(tokens[2]), Scan::readFloat(tokens[3])});
-        } else {
-          pMesh->positions.pushBack(Vec3d(0));
+        const int64_t mask = m_slots.size() - 1;
+        for (int64_t corner : old) {
+          if (corner == npos)
+            continue;
+
+          int64_t slot = hashCorner(m_pCorners[corner]) & mask;
+          while (m_slots[slot] != npos)
+            slot = (slot + 1) & mask;
+          m_slots[slot] = corner;
         }
+      }
+
+      Corner const *  m_pCorners = nullptr;
+      Vector<int64_t> m_slots;
+      int64_t         m_count = 0;
+    };
+  } // namespace
+
+  bool OBJParser::read(Stream * pStream, MeshData * pMesh, StringView const & resourceDir, ThreadPool * pThreads) {
+    String const directory = resourceDir;
+    return read(
+      pStream, pMesh,
+      [&](StringView const & path) -> Ref<Stream> {
+        Ref<File> pFile = NewRef<File>();
+        if (!pFile->open(directory.concat("/").concat(path), FileMode_ReadBinary))
+          return nullptr;
+        return pFile;
+      },
+      pThreads);
+  }
 
-        break;
-      case OBJKeyword_Normal:
-        if (tokens.size() >= 4) {
-          pMesh->normals.pushBack({Scan::readFloat(tokens[1]), Scan::readFloat(tokens[2]), Scan::readFloat(tokens[3])});
-        } else {
-          pMesh->normals.pushBack(Vec3d(0));
+  bool OBJParser::read(Stream * pStream, MeshData * pMesh, OpenResourceFunc const & openResource, ThreadPool * pThreads) {
+    // Parse in place if the stream is already in memory (e.g. a mapped file), otherwise read it all up front.
+    Vector<uint8_t> buffer;
+    StringView      text;
+    if (uint8_t const * pData = pStream->data()) {
+      const int64_t offset = pStream->tell();
+      text                 = StringView((char const *)pData + offset, pStream->length() - offset);
+    } else {
+      const int64_t len = pStream->length();
+      if (len != -1) {
+        buffer.resize(len - pStream->tell());
+        buffer.resize(pStream->read(buffer.data(), buffer.size()));
+      } else {
+        while (!pStream->eof()) {
+          const int64_t size = buffer.size();
+          buffer.resize(size + MinChunkSize);
+          buffer.resize(size + pStream->read(buffer.data() + size, MinChunkSize));
         }
+      }
+      text = StringView((char const *)buffer.data(), buffer.size());
+    }
+
+    const int64_t threadCount = pThreads != nullptr ? std::max<int64_t>(1, std::thread::hardware_concurrency()) : 1;
+    const int64_t chunkCount  = std::clamp<int64_t>(text.length() / MinChunkSize, 1, threadCount * ChunksPerThread);
+    Vector<Chunk> chunks      = splitChunks(text, chunkCount);
+
+    parallelFor(pThreads, chunks.size(), 1, [&](int64_t first, int64_t last) {
+      for (int64_t i = first; i < last; ++i)
+        parseChunk(&chunks[i]);
+    });
 
-        break;
-      case OBJKeyword_TexCoord:
-        if (tokens.size() >= 3) {
-          pMesh->uvs.pushBack({Scan::readFloat(tokens[1]), Scan::readFloat(tokens[2])});
-        } else {
-          pMesh->uvs.pushBack(Vec3d(0));
+    // Calculate where each chunk's elements are placed in the mesh.
+    // Materials are numbered in the order they are first referenced.
+    String               mtlFile = "";
+    Map<String, int64_t> matNames;
+    int64_t              matID       = 0;
+    int64_t              cornerCount = 0;
+    int64_t              triCount    = 0;
+    for (Chunk & chunk : chunks) {
+      chunk.positionOffset  = pMesh->positions.size();
+      chunk.uvOffset        = pMesh->uvs.size();
+      chunk.normalOffset    = pMesh->normals.size();
+      chunk.cornerOffset    = cornerCount;
+      chunk.triangleOffset  = triCount;
+      chunk.initialMaterial = matID;
+
+      pMesh->positions.resize(chunk.positionOffset + chunk.positions.size());
+      pMesh->uvs.resize(chunk.uvOffset + chunk.uvs.size());
+      pMesh->normals.resize(chunk.normalOffset + chunk.normals.size());
+      cornerCount += chunk.corners.size();
+      triCount += chunk.triangles.size();
+
+      for (StringView const & name : chunk.materials) {
+        matID = matNames.size();
+        if (!matNames.tryAdd(name, matID))
+          matID = matNames[name];
+        chunk.materialIDs.pushBack(matID);
+      }
+
+      if (chunk.mtlFile.length() > 0)
+        mtlFile = chunk.mtlFile;
+    }
+
+    // Copy elements into the mesh and resolve corner indices.
+    Vector<Corner> corners;
+    corners.resize(cornerCount);
+    pMesh->triangles.resize(triCount);
+    parallelFor(pThreads, chunks.size(), 1, [&](int64_t first, int64_t last) {
+      for (int64_t i = first; i < last; ++i) {
+        Chunk & chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), pMesh->positions.begin() + chunk.positionOffset);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), pMesh->uvs.begin() + chunk.uvOffset);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), pMesh->normals.begin() + chunk.normalOffset);
+
+        for (int64_t c = 0; c < chunk.corners.size(); ++c)
+          corners[chunk.cornerOffset + c] = resolveCorner(chunk.corners[c], chunk, *pMesh);
+
+        for (int64_t t = 0; t < chunk.triangles.size(); ++t) {
+          MeshData::Triangle tri = chunk.triangles[t];
+          for (int64_t & vert : tri.vertex)
+            vert += chunk.cornerOffset;
+          tri.material = tri.material == -1 ? chunk.initialMaterial : chunk.materialIDs[tri.material];
+          pMesh->triangles[chunk.triangleOffset + t] = tri;
         }
 
-        break;
-      case OBJKeyword_MatLib: mtlFile = line.substr(tokens[1].begin() - line.begin()).trim(); break;
-      case OBJKeyword_MatRef:
-        curMat = line.substr(tokens[1].begin() - line.begin()).trim();
-        matID  = matNames.size();
-        if (!matNames.tryAdd(curMat, matID))
-          matID = matNames[curMat];
-        break;
-      case OBJKeyword_Object:
-      case OBJKeyword_Group:
-      case OBJKeyword_Line:
-      case OBJKeyword_None:
-      case OBJKeyword_Comment: break;
+        chunk = Chunk{}; // Release the chunk's memory early
+      }
+    });
+
+    // Find corners that share the same indices. Corners are partitioned by hash so each
+    // shard can be searched in parallel. firstCorner then holds the first corner with the same indices.
+    const int64_t    shardCount = cornerCount < MinCornersPerShard ? 1 : threadCount;
+    Vector<uint64_t> hashes;
+    hashes.resize(cornerCount);
+    parallelFor(pThreads, cornerCount, MinCornersPerShard, [&](int64_t first, int64_t last) {
+      for (int64_t c = first; c < last; ++c)
+        hashes[c] = hashCorner(corners[c]);
+    });
+
+    // Sort corners by shard. Each shard keeps its corners in order, so the first of each group is added first.
+    Vector<int64_t> shardStart;
+    shardStart.resize(shardCount + 1, 0);
+    for (uint64_t h : hashes)
+      ++shardStart[(h >> 48) % shardCount + 1];
+    for (int64_t shard = 0; shard < shardCount; ++shard)
+      shardStart[shard + 1] += shardStart[shard];
+
+    Vector<int64_t> shardCorners;
+    shardCorners.resize(cornerCount);
+    Vector<int64_t> shardEnd(shardStart.begin(), shardStart.end() - 1);
+    for (int64_t c = 0; c < cornerCount; ++c)
+      shardCorners[shardEnd[(hashes[c] >> 48) % shardCount]++] = c;
+
+    Vector<int64_t> firstCorner;
+    firstCorner.resize(cornerCount);
+    parallelFor(pThreads, shardCount, 1, [&](int64_t firstShard, int64_t lastShard) {
+      for (int64_t shard = firstShard; shard < lastShard; ++shard) {
+        CornerSet set(corners.data(), shardStart[shard + 1] - shardStart[shard]);
+        for (int64_t i = shardStart[shard]; i < shardStart[shard + 1]; ++i) {
+          const int64_t c = shardCorners[i];
+          firstCorner[c]  = set.add(c, hashes[c]);
+        }
+      }
+    });
+
+    // Assign vertices in the order their corners first appear.
+    pMesh->vertices.reserve(pMesh->vertices.size() + cornerCount / 2);
+    for (int64_t c = 0; c < cornerCount; ++c) {
+      if (firstCorner[c] == c) {
+        MeshData::Vertex vert;
+        vert.position  = corners[c].position;
+        vert.uv        = corners[c].uv;
+        vert.normal    = corners[c].normal;
+        firstCorner[c] = pMesh->vertices.size();
+        pMesh->vertices.pushBack(vert);
+      } else {
+        firstCorner[c] = firstCorner[firstCorner[c]];
       }
     }
 
-    // Parse negative indices
-    for (MeshData::Vertex & vert : pMesh->vertices) {
-      vert.position = vert.position >= 0 ? vert.position - 1 : pMesh->positions.size() + vert.position;
-      vert.uv       = vert.uv >= 0 ? vert.uv - 1 : pMesh->uvs.size() + vert.uv;
-      vert.normal   = vert.normal >= 0 ? vert.normal - 1 : pMesh->normals.size() + vert.normal;
-      vert.colour   = vert.colour >= 0 ? vert.colour - 1 : pMesh->colours.size() + vert.colour;
+    for (MeshData::Triangle & tri : pMesh->triangles) {
+      for (int64_t & vert : tri.vertex)
+        vert = firstCorner[vert];
     }
 
     Vector<String> materialOrder(matNames.size(), "");
     for (auto & [name, index] : matNames)
       materialOrder[index] = name;
 
-    File   f;
-    String fullPath = resourceDir;
-    fullPath        = fullPath.concat("/").concat(mtlFile);
-    if (f.open(fullPath)) {
-      pMesh->materials = MTLParser::read(&f, materialOrder);
+    Ref<Stream> pMaterials = mtlFile.length() > 0 ? openResource(mtlFile) : nullptr;
+    if (pMaterials != nullptr) {
+      pMesh->materials = MTLParser::read(pMaterials.get(), materialOrder);
     } else {
       pMesh->materials.resize(materialOrder.size());
       for (auto & [i, name] : enumerate(materialOrder)) {
@@ -182,6 +182,137 @@ namespace bfc {
       return _access(path.c_str(), (int)flags);
     }
 
+    FileMapping::FileMapping(FileMapping && o) {
+      *this = std::move(o);
+    }
+
+    FileMapping::~FileMapping() {
+      close();
+    }
+
+    FileMapping & FileMapping::operator=(FileMapping && o) {
+      if (this != &o) {
+        close();
+        std::swap(m_hFile, o.m_hFile);
+        std::swap(m_hMapping, o.m_hMapping);
+        std::swap(m_pData, o.m_pData);
+        std::swap(m_size, o.m_size);
+        std::swap(m_writable, o.m_writable);
+        std::swap(m_open, o.m_open);
+      }
+      return *this;
+    }
+
+    bool FileMapping::open(Filename const & path, bool writable, int64_t size) {
+      close();
+
+      // Other handles may only read the file while it is mapped. The mapped pages are read in place, so a
+      // writer could change data while it is being parsed. Opening fails if the file is already open for writing.
+      std::wstring widePath = toWide(path.getView());
+      HANDLE       hFile    = CreateFileW(widePath.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+                                          writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+      }
+
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(hFile, &fileSize)) {
+        CloseHandle(hFile);
+        return false;
+      }
+
+      int64_t mapSize = size == 0 ? fileSize.QuadPart : size;
+      if (!writable && mapSize > fileSize.QuadPart) {
+        CloseHandle(hFile);
+        return false;
+      }
+
+      m_hFile    = hFile;
+      m_size     = mapSize;
+      m_writable = writable;
+      m_open     = true;
+
+      // Windows cannot map an empty file.
+      if (mapSize == 0) {
+        return true;
+      }
+
+      // Creating a writable mapping larger than the file grows the file.
+      LARGE_INTEGER mappingSize;
+      mappingSize.QuadPart = writable ? math::max(mapSize, (int64_t)fileSize.QuadPart) : 0;
+      m_hMapping = CreateFileMappingW(hFile, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, mappingSize.HighPart, mappingSize.LowPart, NULL);
+      if (m_hMapping != nullptr) {
+        m_pData = (uint8_t *)MapViewOfFile(m_hMapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T)mapSize);
+      }
+
+      if (m_pData == nullptr) {
+        close();
+        return false;
+      }
+
+      return true;
+    }
+
+    void FileMapping::close() {
+      if (m_pData != nullptr) {
+        UnmapViewOfFile(m_pData);
+      }
+
+      if (m_hMapping != nullptr) {
+        CloseHandle(m_hMapping);
+      }
+
+      if (m_hFile != nullptr) {
+        CloseHandle(m_hFile);
+      }
+
+      m_hFile    = nullptr;
+      m_hMapping = nullptr;
+      m_pData    = nullptr;
+      m_size     = 0;
+      m_writable = false;
+      m_open     = false;
+    }
+
+    bool FileMapping::flush() {
+      if (!m_writable || m_pData == nullptr) {
+        return m_open;
+      }
+
+      return FlushViewOfFile(m_pData, (SIZE_T)m_size) && FlushFileBuffers(m_hFile);
+    }
+
+    void FileMapping::advise(MappingAccess access, int64_t offset, int64_t size) {
+      if (m_pData == nullptr || offset >= m_size) {
+        return;
+      }
+
+      // Windows has no equivalent of sequential or random access hints for mapped views.
+      // Prefetching the range covers the common case of reading a file front to back.
+      if (access == MappingAccess_Sequential || access == MappingAccess_WillNeed) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = m_pData + offset;
+        range.NumberOfBytes  = (SIZE_T)(size == 0 ? m_size - offset : math::min(size, m_size - offset));
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+      }
+    }
+
+    bool FileMapping::isOpen() const {
+      return m_open;
+    }
+
+    bool FileMapping::writable() const {
+      return m_writable;
+    }
+
+    uint8_t * FileMapping::data() const {
+      return m_pData;
+    }
+
+    int64_t FileMapping::size() const {
+      return m_size;
+    }
+
     struct SystemEvent::Impl {
       HANDLE hEvent = 0;
     };
@@ -140,6 +140,8 @@ namespace bfc {
     void CommandList::downloadTexture(TextureRef textureID, TextureDownloadRef pDownload) {
       if (textureID->isDepthTexture()) {
         downloadTexture(textureID, pDownload, textureID->getDepthStencilFormat());
+      } else if (isBlockCompressed(textureID->getColourFormat())) {
+        downloadTexture(textureID, pDownload, PixelFormat_RGBAu8);
       } else {
         downloadTexture(textureID, pDownload, textureID->getColourFormat());
       }
@@ -188,6 +190,12 @@ namespace bfc {
       pCmdList->uploadTexture(*pTexture, surface);
     }
 
+    void loadTextureMips(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, Span<const media::Surface> const & mips) {
+      if (*pTexture == nullptr || (*pTexture)->getType() != type)
+        *pTexture = pCmdList->createTexture(type);
+      pCmdList->uploadTextureMips(*pTexture, mips);
+    }
+
     void loadTexture(CommandList * pCmdList, TextureRef * pTexture, TextureType const & type, Vec3i const & size,
                      PixelFormat const & format, void const * pPixels, int64_t rowPitch) {
       media::Surface surface;
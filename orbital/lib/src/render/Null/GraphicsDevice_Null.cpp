@@ -0,0 +1,842 @@
+#include "GraphicsDevice_Null.h"
+
+#include "platform/Window.h"
+
+namespace bfc {
+  bool graphicsDevice_registerNull() {
+    return registerGraphicsDevice("null", []() -> Ref<GraphicsDevice> { return NewRef<GraphicsDevice_Null>(); });
+  }
+
+  static graphics::NullBuffer &          ToNull(graphics::BufferRef pBuffer);
+  static graphics::NullBufferDownload &  ToNull(graphics::BufferDownloadRef pBuffer);
+  static graphics::NullTexture &         ToNull(graphics::TextureRef pBuffer);
+  static graphics::NullTextureDownload & ToNull(graphics::TextureDownloadRef pBuffer);
+  static graphics::NullSampler &         ToNull(graphics::SamplerRef pBuffer);
+  static graphics::NullRenderTarget &    ToNull(graphics::RenderTargetRef pBuffer);
+  static graphics::NullProgram &         ToNull(graphics::ProgramRef pBuffer);
+  static graphics::NullVertexArray &     ToNull(graphics::VertexArrayRef pBuffer);
+
+  /// Size of the default render target when the device is initialised without a window.
+  static constexpr Vec2i HeadlessTargetSize = Vec2i(1280, 720);
+
+  namespace graphics {
+    int64_t NullBuffer::getSize() const {
+      return size;
+    }
+
+    void NullVertexArray::setLayout(VertexInputLayout const & layout) {
+      this->layout = layout;
+    }
+
+    bool NullVertexArray::setVertexBuffer(int64_t slot, BufferRef vertexBufferID) {
+      this->vertexBuffers[slot] = vertexBufferID;
+      return true;
+    }
+
+    bool NullVertexArray::setIndexBuffer(BufferRef indexBufferID, DataType indexType) {
+      this->indexBufferType = indexType;
+      this->indexBuffer     = indexBufferID;
+      return true;
+    }
+
+    VertexInputLayout NullVertexArray::getLayout() const {
+      return layout;
+    }
+
+    BufferRef NullVertexArray::getVertexBuffer(int64_t slot) const {
+      return vertexBuffers[slot];
+    }
+
+    BufferRef NullVertexArray::getIndexBuffer() const {
+      return indexBuffer;
+    }
+
+    DataType NullVertexArray::getIndexType() const {
+      return indexBufferType;
+    }
+
+    TextureType NullTexture::getType() const {
+      return type;
+    }
+
+    bool NullTexture::isDepthTexture() const {
+      return depthStencilFmt != DepthStencilFormat_Unknown;
+    }
+
+    DepthStencilFormat NullTexture::getDepthStencilFormat() const {
+      return depthStencilFmt;
+    }
+
+    PixelFormat NullTexture::getColourFormat() const {
+      return format;
+    }
+
+    Vec3i NullTexture::getSize(int64_t mipLevel) const {
+      Vec3i size = this->size;
+      size /= (1 << (int32_t)mipLevel);
+      return {std::max(1, size.x), std::max(1, size.y), std::max(1, size.z)};
+    }
+
+    int64_t NullTexture::getStride() const {
+      return isDepthTexture() ? getDepthStencilFormatStride(depthStencilFmt) : getPixelFormatStride(format);
+    }
+
+    void NullSampler::setSamplerMinFilter(FilterMode filter, FilterMode mipFilter) {
+      minFilter    = filter;
+      minMipFilter = mipFilter;
+    }
+
+    void NullSampler::setSamplerMagFilter(FilterMode filter, FilterMode mipFilter) {
+      magFilter    = filter;
+      magMipFilter = mipFilter;
+    }
+
+    void NullSampler::setSamplerMinLOD(float level) {
+      minLOD = level;
+    }
+
+    void NullSampler::setSamplerMaxLOD(float level) {
+      maxLOD = level;
+    }
+
+    void NullSampler::setSamplerWrapU(WrapMode mode) {
+      wrapMode.x = mode;
+    }
+
+    void NullSampler::setSamplerWrapV(WrapMode mode) {
+      wrapMode.y = mode;
+    }
+
+    void NullSampler::setSamplerWrapW(WrapMode mode) {
+      wrapMode.z = mode;
+    }
+
+    void NullProgram::setShader(ShaderType type, std::optional<ShaderDesc> desc) {
+      shaders[type] = desc;
+    }
+
+    std::optional<ShaderDesc> NullProgram::getShader(ShaderType type) const {
+      return shaders[type];
+    }
+
+    int64_t NullProgram::getAttributeCount() const {
+      return 0;
+    }
+
+    int64_t NullProgram::getUniformCount() const {
+      return 0;
+    }
+
+    int64_t NullProgram::getBufferCount() const {
+      return 0;
+    }
+
+    int64_t NullProgram::getTextureCount() const {
+      return 0;
+    }
+
+    void NullProgram::getAttributeDesc(int64_t attributeIndex, ProgramAttributeDesc * pDesc) const {
+      BFC_FAIL("NullProgram has no attributes (index: %lld)", attributeIndex);
+    }
+
+    void NullProgram::getUniformDesc(int64_t uniformIndex, ProgramUniformDesc * pDesc) const {
+      BFC_FAIL("NullProgram has no uniforms (index: %lld)", uniformIndex);
+    }
+
+    void NullProgram::getTextureDesc(int64_t textureIndex, ProgramTextureDesc * pDesc) const {
+      BFC_FAIL("NullProgram has no textures (index: %lld)", textureIndex);
+    }
+
+    void NullProgram::getBufferDesc(int64_t bufferIndex, ProgramBufferDesc * pDesc) const {
+      BFC_FAIL("NullProgram has no buffers (index: %lld)", bufferIndex);
+    }
+
+    RenderTargetType NullRenderTarget::getType() const {
+      return type;
+    }
+
+    Vec2i NullRenderTarget::getSize() const {
+      switch (type) {
+      case RenderTargetType_Texture: {
+        TextureRef tex = colour[0].texture != InvalidGraphicsResource ? colour[0].texture : depth.texture;
+        if (tex == InvalidGraphicsResource)
+          return Vec2i(0);
+        return Vec2i(tex->getSize());
+      }
+      case RenderTargetType_Window: return pWindow != nullptr ? pWindow->getSize() : windowSize;
+      }
+
+      return Vec2i(0);
+    }
+
+    bool NullRenderTarget::attachWindow(platform::Window * pWindow, DepthStencilFormat depthStencilFormat) {
+      this->pWindow     = pWindow;
+      this->depthFormat = depthStencilFormat;
+      return true;
+    }
+
+    void NullRenderTarget::attachColour(TextureRef textureID, int64_t slot, int64_t mipLevel, int64_t layer) {
+      attachColour(TextureAttachment{textureID, mipLevel, layer}, slot);
+    }
+
+    void NullRenderTarget::attachColour(TextureAttachment attachment, int64_t slot) {
+      colour[slot] = attachment;
+    }
+
+    void NullRenderTarget::setReadAttachment(int64_t slot) {
+      colourReadAttachment = slot;
+    }
+
+    void NullRenderTarget::attachDepth(TextureRef textureID, int64_t mipLevel, int64_t layer) {
+      attachDepth(TextureAttachment{textureID, mipLevel, layer});
+    }
+
+    void NullRenderTarget::attachDepth(TextureAttachment attachment) {
+      depth = attachment;
+    }
+
+    RenderTarget::TextureAttachment NullRenderTarget::getColour(int64_t slot) const {
+      return colour[slot];
+    }
+
+    RenderTarget::TextureAttachment NullRenderTarget::getDepth() const {
+      return depth;
+    }
+
+    void StateManager_Null::apply(State const & state) {
+      BFC_UNUSED(state);
+      if (pStats != nullptr)
+        ++pStats->stateChanges;
+    }
+
+    /// Copy `src` into a tightly packed buffer.
+    static Vector<uint8_t> packSurface(media::Surface const & src) {
+      if (src.pBuffer == nullptr)
+        return {};
+
+      media::Surface packedSurface = src;
+      packedSurface.pitch          = 0;
+
+      int64_t const   rowSize  = media::getSurfacePitch(packedSurface);
+      int64_t const   srcPitch = media::getSurfacePitch(src);
+      int64_t const   numRows  = media::getSurfaceRowCount(src) * std::max(src.size.z, 1);
+      Vector<uint8_t> packed(rowSize * numRows, 0);
+      for (int64_t row = 0; row < numRows; ++row)
+        std::memcpy(packed.data() + row * rowSize, (uint8_t const *)src.pBuffer + row * srcPitch, rowSize);
+      return packed;
+    }
+
+    CommandList_Null::CommandList_Null(GraphicsDevice_Null * pDevice, RenderTargetRef defaultTarget)
+      : m_pDevice(pDevice)
+      , m_defaultTarget(defaultTarget) {}
+
+    void CommandList_Null::execute() const {
+      for (Command const & cmd : m_commands)
+        cmd(m_pDevice);
+    }
+
+    void CommandList_Null::setDebugName(StringView const & name) {
+      m_debugName = name;
+    }
+
+    void CommandList_Null::addDebugTag(StringView const & tag) {
+      BFC_UNUSED(tag);
+    }
+
+    void CommandList_Null::bindProgram(ProgramRef programID) {
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().programBinds; });
+      track(programID);
+
+      m_boundProgram = programID;
+    }
+
+    void CommandList_Null::bindVertexArray(VertexArrayRef vertexArrayID) {
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().vertexArrayBinds; });
+      track(vertexArrayID);
+
+      m_vertexCount = -1;
+      m_indexCount  = -1;
+      m_vaIndexType = DataType_Unknown;
+      if (vertexArrayID == InvalidGraphicsResource)
+        return;
+
+      NullVertexArray & va          = ToNull(vertexArrayID);
+      int64_t           numElements = va.layout.getAttributeCount();
+      m_vertexCount                 = std::numeric_limits<int64_t>::max();
+      for (int64_t i = 0; i < numElements; ++i) {
+        auto const & elm          = va.layout.getAttributeLayout(i);
+        BufferRef    vertexBuffer = va.vertexBuffers[elm.slot];
+        m_vertexCount             = std::min(m_vertexCount, vertexBuffer == nullptr ? 0 : ToNull(vertexBuffer).size / elm.stride);
+      }
+
+      if (va.indexBuffer != InvalidGraphicsResource) {
+        m_vaIndexType = va.indexBufferType;
+        m_indexCount  = ToNull(va.indexBuffer).size / getDataTypeSize(m_vaIndexType);
+      }
+    }
+
+    void CommandList_Null::bindTexture(TextureRef textureID, int64_t textureUnit) {
+      BFC_UNUSED(textureUnit);
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().textureBinds; });
+      track(textureID);
+    }
+
+    void CommandList_Null::bindSampler(SamplerRef samplerID, int64_t textureUnit) {
+      BFC_UNUSED(textureUnit);
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().samplerBinds; });
+      track(samplerID);
+    }
+
+    void CommandList_Null::bindUniformBuffer(BufferRef bufferID, int64_t bindPoint, int64_t offset, int64_t size) {
+      BFC_UNUSED(bindPoint, offset, size);
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().bufferBinds; });
+      track(bufferID);
+    }
+
+    void CommandList_Null::bindShaderStorageBuffer(BufferRef bufferID, int64_t bindPoint, int64_t offset, int64_t size) {
+      BFC_UNUSED(bindPoint, offset, size);
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().bufferBinds; });
+      track(bufferID);
+    }
+
+    void CommandList_Null::bindRenderTarget(RenderTargetRef renderTargetID, MapAccess renderTargetAccess) {
+      if (renderTargetID == InvalidGraphicsResource) {
+        return bindRenderTarget(m_defaultTarget, renderTargetAccess);
+      }
+
+      add([](GraphicsDevice_Null * pDevice) { ++pDevice->stats().renderTargetBinds; });
+      track(renderTargetID);
+    }
+
+    void CommandList_Null::bindScreen(MapAccess renderTargetAccess) {
+      bindRenderTarget(m_defaultTarget, renderTargetAccess);
+    }
+
+    void CommandList_Null::setState(Span<const State> const & state) {
+      if (state.size() == 0)
+        return;
+
+      add([states = Vector<State>(state)](GraphicsDevice_Null * pDevice) {
+        for (State const & s : states)
+          pDevice->getStateManager()->set(s);
+      });
+    }
+
+    void CommandList_Null::pushState(Span<const State> const & state) {
+      if (state.size() == 0)
+        return;
+
+      add([states = Vector<State>(state)](GraphicsDevice_Null * pDevice) {
+        auto pStateManager = pDevice->getStateManager();
+        pStateManager->beginGroup();
+        for (State const & s : states)
+          pStateManager->set(s);
+        pStateManager->endGroup();
+      });
+    }
+
+    void CommandList_Null::popState() {
+      add([](GraphicsDevice_Null * pDevice) { pDevice->getStateManager()->pop(); });
+    }
+
+    void CommandList_Null::upload(BufferRef bufferID, int64_t size, void const * pData) {
+      BFC_ASSERT(bufferID != nullptr, "bufferID is nullptr");
+
+      Vector<uint8_t> data;
+      if (pData != nullptr)
+        data = Vector<uint8_t>((uint8_t const *)pData, (uint8_t const *)pData + size);
+
+      add([pBuffer = &ToNull(bufferID), size, data = std::move(data)](GraphicsDevice_Null * pDevice) {
+        pBuffer->storage.resize(size, 0);
+        if (data.size() > 0) {
+          std::memcpy(pBuffer->storage.data(), data.data(), size);
+          pDevice->stats().bytesUploaded += size;
+        }
+      });
+      track(bufferID);
+
+      ToNull(bufferID).size = size;
+    }
+
+    std::future<void *> CommandList_Null::map(BufferRef bufferID, MapAccess access) {
+      return map(bufferID, 0, ToNull(bufferID).size, access);
+    }
+
+    std::future<void *> CommandList_Null::map(BufferRef bufferID, int64_t offset, int64_t size, MapAccess access) {
+      BFC_ASSERT(bufferID != nullptr, "bufferID is nullptr");
+
+      auto pPromise = NewRef<std::promise<void *>>();
+      add([pBuffer = &ToNull(bufferID), pPromise, offset, size, access](GraphicsDevice_Null * pDevice) {
+        if (offset < 0 || offset + size > pBuffer->storage.size()) {
+          pPromise->set_value(nullptr);
+          return;
+        }
+
+        // Writes through a mapping are the equivalent of an upload.
+        if ((access & MapAccess_Write) != 0)
+          pDevice->stats().bytesUploaded += size;
+        if ((access & MapAccess_Read) != 0)
+          pDevice->stats().bytesDownloaded += size;
+        pPromise->set_value(pBuffer->storage.data() + offset);
+      });
+      track(bufferID);
+
+      return pPromise->get_future();
+    }
+
+    void CommandList_Null::unmap(BufferRef bufferID) {
+      BFC_ASSERT(bufferID != nullptr, "bufferID is nullptr");
+      track(bufferID);
+    }
+
+    void CommandList_Null::download(BufferRef bufferID, BufferDownloadRef pDownload, int64_t offset, int64_t size) {
+      BFC_ASSERT(bufferID != nullptr, "bufferID is nullptr");
+
+      if (size == 0)
+        size = std::max((int64_t)0, ToNull(bufferID).size - offset);
+
+      auto pPromise = NewRef<std::promise<void>>();
+
+      NullBufferDownload & dst = ToNull(pDownload);
+      dst.complete             = pPromise->get_future().share();
+      dst.storage.resize(size, 0);
+
+      add([pBuffer = &ToNull(bufferID), pDst = &dst, pPromise, offset, size](GraphicsDevice_Null * pDevice) {
+        int64_t available = std::max((int64_t)0, std::min(size, pBuffer->storage.size() - offset));
+        if (available > 0)
+          std::memcpy(pDst->storage.data(), pBuffer->storage.data() + offset, available);
+        pDevice->stats().bytesDownloaded += size;
+        pPromise->set_value();
+      });
+      track(bufferID);
+      track(pDownload);
+    }
+
+    bool CommandList_Null::uploadTexture(TextureRef textureID, DepthStencilFormat format, Vec3i size) {
+      BFC_ASSERT(textureID != nullptr, "textureID is nullptr");
+
+      NullTexture & tex   = ToNull(textureID);
+      tex.depthStencilFmt = format;
+      tex.format          = PixelFormat_Unknown;
+      tex.size            = size;
+
+      int64_t const dataSize = getDepthStencilFormatStride(format) * size.x * size.y * std::max(size.z, 1);
+      add([pTexture = &tex, dataSize](GraphicsDevice_Null *) { pTexture->storage.resize(dataSize, 0); });
+      track(textureID);
+
+      return true;
+    }
+
+    bool CommandList_Null::uploadTexture(TextureRef textureID, media::Surface const & src) {
+      BFC_ASSERT(textureID != nullptr, "textureID is nullptr");
+
+      NullTexture & tex   = ToNull(textureID);
+      tex.depthStencilFmt = DepthStencilFormat_Unknown;
+      tex.format          = src.format;
+      tex.size            = src.size;
+
+      media::Surface packedSurface = src;
+      packedSurface.pitch          = 0;
+      packedSurface.size.z         = std::max(src.size.z, 1);
+
+      int64_t const dataSize = media::calculateSurfaceSize(packedSurface);
+      add([pTexture = &tex, dataSize, data = packSurface(src)](GraphicsDevice_Null * pDevice) {
+        if (data.size() > 0) {
+          pTexture->storage = data;
+          pDevice->stats().bytesUploaded += data.size();
+        } else {
+          pTexture->storage.clear();
+          pTexture->storage.resize(dataSize, 0);
+        }
+      });
+      track(textureID);
+
+      if (src.pBuffer != nullptr && !isBlockCompressed(src.format)) {
+        generateMipMaps(textureID);
+      }
+
+      return true;
+    }
+
+    bool CommandList_Null::uploadTextureMips(TextureRef textureID, Span<const media::Surface> const & mips) {
+      if (mips.size() == 0 || !uploadTexture(textureID, mips[0]))
+        return false;
+
+      // Only the base level is stored, but every level counts as uploaded.
+      int64_t mipBytes = 0;
+      for (int64_t level = 1; level < mips.size(); ++level)
+        mipBytes += mips[level].pBuffer != nullptr ? media::calculateSurfaceSize(mips[level]) : 0;
+      add([mipBytes](GraphicsDevice_Null * pDevice) { pDevice->stats().bytesUploaded += mipBytes; });
+
+      return true;
+    }
+
+    bool CommandList_Null::uploadTextureSubData(TextureRef textureID, media::Surface const & src, Vec3i offset) {
+      BFC_ASSERT(textureID != nullptr, "textureID is nullptr");
+
+      add([pTexture = &ToNull(textureID), format = src.format, size = src.size, offset, data = packSurface(src)](GraphicsDevice_Null * pDevice) {
+        pDevice->stats().bytesUploaded += data.size();
+
+        NullTexture & tex = *pTexture;
+        if (data.size() == 0 || format != tex.format)
+          return; // Format conversion on upload is not emulated.
+
+        int64_t const stride  = tex.getStride();
+        int64_t const rowSize = stride * std::min(size.x, tex.size.x - offset.x);
+        if (rowSize <= 0)
+          return;
+
+        for (int64_t z = 0; z < std::max(size.z, 1) && z + offset.z < std::max(tex.size.z, 1); ++z) {
+          for (int64_t y = 0; y < size.y && y + offset.y < tex.size.y; ++y) {
+            uint8_t const * pSrcRow = data.data() + (y + z * size.y) * size.x * stride;
+            uint8_t *       pDstRow = tex.storage.data() + media::calculatePixelOffset(offset + Vec3i(0, (int32_t)y, (int32_t)z), tex.size, stride, tex.size.x * stride);
+            std::memcpy(pDstRow, pSrcRow, rowSize);
+          }
+        }
+      });
+      track(textureID);
+
+      return true;
+    }
+
+    void CommandList_Null::generateMipMaps(TextureRef textureID) {
+      // Only the base level is stored.
+      track(textureID);
+    }
+
+    void CommandList_Null::downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, PixelFormat format) {
+      auto pPromise = NewRef<std::promise<void>>();
+
+      NullTextureDownload & dst = ToNull(pDownload);
+      dst.complete              = pPromise->get_future().share();
+
+      add([pTexture = &ToNull(textureID), pDst = &dst, pPromise, format](GraphicsDevice_Null * pDevice) {
+        NullTexture const & tex = *pTexture;
+
+        media::Surface src;
+        src.pBuffer = (void *)tex.storage.data();
+        src.format  = tex.isDepthTexture() ? PixelFormat_Rf32 : tex.format;
+        src.size    = tex.size;
+
+        pDst->surface        = src;
+        pDst->surface.format = format;
+        pDst->surface.pitch  = 0;
+        pDst->storage.clear();
+        pDst->storage.resize(media::calculateSurfaceSize(pDst->surface), 0);
+        pDst->surface.pBuffer = pDst->storage.data();
+
+        if (tex.storage.size() > 0) {
+          if (src.format == format)
+            std::memcpy(pDst->storage.data(), tex.storage.data(), std::min(tex.storage.size(), pDst->storage.size()));
+          else
+            media::convertSurface(&pDst->surface, src);
+        }
+
+        pDevice->stats().bytesDownloaded += pDst->storage.size();
+        pPromise->set_value();
+      });
+      track(textureID);
+      track(pDownload);
+    }
+
+    void CommandList_Null::downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, DepthStencilFormat format) {
+      BFC_ASSERT(format == DepthStencilFormat_D32, "Only DepthStencilFormat_D32  is supported");
+      downloadTexture(textureID, pDownload, PixelFormat_Rf32);
+    }
+
+    void CommandList_Null::setUniform(int64_t uniformIndex, void const * pBuffer, int64_t size) {
+      BFC_UNUSED(uniformIndex, pBuffer);
+      if (m_boundProgram == nullptr) {
+        return;
+      }
+
+      add([size](GraphicsDevice_Null * pDevice) {
+        ++pDevice->stats().uniformUpdates;
+        pDevice->stats().bytesUploaded += size;
+      });
+    }
+
+    void CommandList_Null::setUniform(StringView const & name, void const * pBuffer, int64_t size) {
+      BFC_UNUSED(name);
+      setUniform(-1, pBuffer, size);
+    }
+
+    void CommandList_Null::setBufferBinding(int64_t bufferIndex, int64_t bindPoint) {
+      BFC_UNUSED(bufferIndex, bindPoint);
+    }
+
+    void CommandList_Null::setBufferBinding(StringView const & name, int64_t bindPoint) {
+      BFC_UNUSED(name, bindPoint);
+    }
+
+    void CommandList_Null::setTextureBinding(int64_t textureIndex, int64_t bindPoint) {
+      BFC_UNUSED(textureIndex, bindPoint);
+    }
+
+    void CommandList_Null::setTextureBinding(StringView const & name, int64_t bindPoint) {
+      BFC_UNUSED(name, bindPoint);
+    }
+
+    void CommandList_Null::clear(RGBAu8 colour, float depth, uint8_t stencil) {
+      BFC_UNUSED(colour, depth, stencil);
+      add([](GraphicsDevice_Null * pDevice) {
+        pDevice->getStateManager()->apply();
+        ++pDevice->stats().clears;
+      });
+    }
+
+    void CommandList_Null::clearDepth(float depth) {
+      clear({0, 0, 0, 0}, depth, 0);
+    }
+
+    void CommandList_Null::clearColour(RGBAu8 colour) {
+      clear(colour, 1.0f, 0);
+    }
+
+    void CommandList_Null::clearStencil(uint8_t value) {
+      clear({0, 0, 0, 0}, 1.0f, value);
+    }
+
+    void CommandList_Null::clearColourAttachment(int64_t slot, PixelFormat format, void const * rgba) {
+      BFC_UNUSED(slot, format, rgba);
+      clear({0, 0, 0, 0}, 1.0f, 0);
+    }
+
+    void CommandList_Null::swap() {
+      add([](GraphicsDevice_Null * pDevice) { pDevice->endFrame(); });
+    }
+
+    void CommandList_Null::draw(int64_t elementCount, int64_t elementOffset, PrimitiveType primType, int64_t instanceCount) {
+      BFC_UNUSED(primType);
+
+      // Match the OpenGL backend's validation so draw counts are comparable.
+      if (m_vertexCount >= 0) {
+        elementCount = std::min(elementCount, m_vertexCount - elementOffset);
+        if (elementCount < 0)
+          return;
+      }
+
+      add([elementCount, instanceCount](GraphicsDevice_Null * pDevice) {
+        pDevice->getStateManager()->apply();
+
+        FrameStatistics & stats = pDevice->stats();
+        ++stats.drawCalls;
+        stats.instances += instanceCount;
+        stats.elements += elementCount;
+      });
+    }
+
+    void CommandList_Null::drawIndexed(int64_t elementCount, int64_t elementOffset, PrimitiveType primType, int64_t instanceCount) {
+      BFC_UNUSED(primType);
+
+      if (m_indexCount >= 0) {
+        elementCount = std::min(elementCount, m_indexCount - elementOffset);
+        if (elementCount < 0)
+          return;
+      }
+
+      add([elementCount, instanceCount](GraphicsDevice_Null * pDevice) {
+        pDevice->getStateManager()->apply();
+
+        FrameStatistics & stats = pDevice->stats();
+        ++stats.drawCalls;
+        ++stats.indexedDrawCalls;
+        stats.instances += instanceCount;
+        stats.elements += elementCount;
+      });
+    }
+
+    void CommandList_Null::track(bfc::Ref<void> pPtr) {
+      if (pPtr != nullptr) {
+        m_trackedResources.pushBack(pPtr);
+      }
+    }
+
+    GraphicsDevice * CommandList_Null::getDevice() const {
+      return m_pDevice;
+    }
+  } // namespace graphics
+
+  GraphicsDevice_Null::~GraphicsDevice_Null() {
+    m_queueLock.lock();
+    m_running = false;
+    m_queueLock.unlock();
+    m_queueNotifier.notify_one();
+    if (m_executeThread.joinable())
+      m_executeThread.join();
+  }
+
+  bool GraphicsDevice_Null::init(platform::Window * pWindow) {
+    m_stateManager.pStats = &m_frameStats;
+
+    auto pTarget               = createRenderTarget(RenderTargetType_Window);
+    ToNull(pTarget).windowSize = HeadlessTargetSize;
+    if (pWindow != nullptr)
+      pTarget->attachWindow(pWindow, DepthStencilFormat_D24S8);
+    m_defaultTarget = pTarget;
+
+    m_executeThread = std::thread(&GraphicsDevice_Null::ExecuteThread, this);
+    return true;
+  }
+
+  void GraphicsDevice_Null::destroy() {
+    delete this;
+  }
+
+  graphics::RenderTargetRef GraphicsDevice_Null::getDefaultRenderTarget() {
+    return m_defaultTarget;
+  }
+
+  std::unique_ptr<graphics::CommandList> GraphicsDevice_Null::createCommandList() {
+    return std::make_unique<graphics::CommandList_Null>(this, m_defaultTarget);
+  }
+
+  graphics::BufferRef GraphicsDevice_Null::createBuffer(BufferUsageHint usageHint) {
+    auto newBuffer       = NewRef<graphics::NullBuffer>();
+    newBuffer->usageHint = usageHint;
+    return newBuffer;
+  }
+
+  graphics::VertexArrayRef GraphicsDevice_Null::createVertexArray() {
+    return NewRef<graphics::NullVertexArray>();
+  }
+
+  graphics::ProgramRef GraphicsDevice_Null::createProgram() {
+    return NewRef<graphics::NullProgram>();
+  }
+
+  graphics::TextureRef GraphicsDevice_Null::createTexture(TextureType type) {
+    auto newTexture  = NewRef<graphics::NullTexture>();
+    newTexture->type = type;
+    return newTexture;
+  }
+
+  graphics::TextureDownloadRef GraphicsDevice_Null::createTextureDownload() {
+    return NewRef<graphics::NullTextureDownload>();
+  }
+
+  graphics::SamplerRef GraphicsDevice_Null::createSampler() {
+    return NewRef<graphics::NullSampler>();
+  }
+
+  graphics::RenderTargetRef GraphicsDevice_Null::createRenderTarget(RenderTargetType type) {
+    auto target  = NewRef<graphics::NullRenderTarget>();
+    target->type = type;
+    return target;
+  }
+
+  graphics::StateManager * GraphicsDevice_Null::getStateManager() {
+    return &m_stateManager;
+  }
+
+  std::shared_future<bool> GraphicsDevice_Null::compile(graphics::ProgramRef pProgram) {
+    BFC_UNUSED(pProgram);
+
+    std::promise<bool> promise;
+    promise.set_value(true);
+    return promise.get_future().share();
+  }
+
+  uint64_t GraphicsDevice_Null::submit(std::unique_ptr<graphics::CommandList> && pCommandList) {
+    if (pCommandList == nullptr)
+      return 0;
+
+    BFC_ASSERT(m_executeThread.joinable(), "init() must be called before submitting command lists");
+
+    m_queueLock.lock();
+    uint64_t commandList = ++m_nextCommandListID;
+    m_commandListQueue.pushBack(std::move(pCommandList));
+    m_queueLock.unlock();
+    m_queueNotifier.notify_one();
+    return commandList;
+  }
+
+  bool GraphicsDevice_Null::wait(uint64_t handle, std::optional<Timestamp> const & timeout) {
+    std::unique_lock guard{m_fenceLock};
+    if (timeout.has_value())
+      return m_fenceNotifier.wait_for(guard, (std::chrono::microseconds)timeout.value(), [=]() { return m_commandListFence >= handle; });
+
+    m_fenceNotifier.wait(guard, [=]() { return m_commandListFence >= handle; });
+    return true;
+  }
+
+  bool GraphicsDevice_Null::getFrameStatistics(graphics::FrameStatistics * pStats) const {
+    std::scoped_lock guard{m_statsLock};
+    if (!m_hasCompletedFrame)
+      return false;
+
+    *pStats = m_lastFrameStats;
+    return true;
+  }
+
+  void GraphicsDevice_Null::endFrame() {
+    m_statsLock.lock();
+    m_lastFrameStats    = m_frameStats;
+    m_hasCompletedFrame = true;
+    m_statsLock.unlock();
+
+    int64_t nextFrame  = m_frameStats.frame + 1;
+    m_frameStats       = {};
+    m_frameStats.frame = nextFrame;
+  }
+
+  void GraphicsDevice_Null::ExecuteThread() {
+    bool                                           running = m_running;
+    Vector<std::unique_ptr<graphics::CommandList>> lists;
+    while (running) {
+      std::unique_lock guard{m_queueLock};
+      m_queueNotifier.wait(guard, [&]() {
+        running = m_running || m_commandListQueue.size() > 0;
+        lists   = std::move(m_commandListQueue);
+        return !running || lists.size() > 0;
+      });
+      guard.unlock();
+
+      for (auto & list : lists) {
+        ++m_frameStats.commandLists;
+        list->execute();
+
+        // Release resources held by the list before signalling the fence.
+        list = nullptr;
+
+        m_fenceLock.lock();
+        ++m_commandListFence;
+        m_fenceLock.unlock();
+        m_fenceNotifier.notify_all();
+      }
+      lists.clear();
+    }
+  }
+
+  static graphics::NullBuffer & ToNull(graphics::BufferRef pBuffer) {
+    return *(graphics::NullBuffer *)pBuffer.get();
+  }
+
+  static graphics::NullBufferDownload & ToNull(graphics::BufferDownloadRef pBuffer) {
+    return *(graphics::NullBufferDownload *)pBuffer.get();
+  }
+
+  static graphics::NullTexture & ToNull(graphics::TextureRef pBuffer) {
+    return *(graphics::NullTexture *)pBuffer.get();
+  }
+
+  static graphics::NullTextureDownload & ToNull(graphics::TextureDownloadRef pBuffer) {
+    return *(graphics::NullTextureDownload *)pBuffer.get();
+  }
+
+  static graphics::NullSampler & ToNull(graphics::SamplerRef pBuffer) {
+    return *(graphics::NullSampler *)pBuffer.get();
+  }
+
+  static graphics::NullRenderTarget & ToNull(graphics::RenderTargetRef pBuffer) {
+    return *(graphics::NullRenderTarget *)pBuffer.get();
+  }
+
+  static graphics::NullProgram & ToNull(graphics::ProgramRef pBuffer) {
+    return *(graphics::NullProgram *)pBuffer.get();
+  }
+
+  static graphics::NullVertexArray & ToNull(graphics::VertexArrayRef pBuffer) {
+    return *(graphics::NullVertexArray *)pBuffer.get();
+  }
+} // namespace bfc
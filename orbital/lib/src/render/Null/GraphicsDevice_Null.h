@@ -0,0 +1,338 @@
+#pragma once
+
+#include "core/String.h"
+#include "math/MathTypes.h"
+#include "media/Pixel.h"
+#include "render/GraphicsDevice.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace bfc {
+  class GraphicsDevice_Null;
+
+  namespace graphics {
+    class NullBuffer : public Buffer {
+    public:
+      virtual int64_t getSize() const override;
+
+      int64_t         size      = 0; // Size as seen by the recording thread.
+      Vector<uint8_t> storage;         // Contents as seen by the execution thread.
+      BufferUsageHint usageHint = BufferUsageHint_Unknown;
+    };
+
+    class NullVertexArray : public VertexArray {
+    public:
+      virtual void              setLayout(VertexInputLayout const & layout) override;
+      virtual bool              setVertexBuffer(int64_t slot, BufferRef vertexBufferID) override;
+      virtual bool              setIndexBuffer(BufferRef indexBufferID, DataType indexType) override;
+      virtual VertexInputLayout getLayout() const override;
+      virtual BufferRef         getVertexBuffer(int64_t slot) const override;
+      virtual BufferRef         getIndexBuffer() const override;
+      virtual DataType          getIndexType() const override;
+
+      DataType  indexBufferType = DataType_Unknown;
+      BufferRef indexBuffer     = InvalidGraphicsResource;
+
+      VertexInputLayout layout;
+      BufferRef         vertexBuffers[MaxVertexBuffers];
+    };
+
+    class NullTexture : public Texture {
+    public:
+      virtual TextureType        getType() const override;
+      virtual Vec3i              getSize(int64_t mipLevel) const override;
+      virtual bool               isDepthTexture() const override;
+      virtual DepthStencilFormat getDepthStencilFormat() const override;
+      virtual PixelFormat        getColourFormat() const override;
+
+      /// Get the size of a single pixel in `storage`.
+      int64_t getStride() const;
+
+      TextureType        type            = TextureType_Unknown;
+      Vec3i              size            = Vec3i(0);
+      PixelFormat        format          = PixelFormat_Unknown;
+      DepthStencilFormat depthStencilFmt = DepthStencilFormat_Unknown;
+
+      Vector<uint8_t> storage; // Pixels for the base mip level. Tightly packed.
+    };
+
+    class NullSampler : public Sampler {
+    public:
+      virtual void setSamplerMinFilter(FilterMode filter, FilterMode mipFilter) override;
+      virtual void setSamplerMagFilter(FilterMode filter, FilterMode mipFilter) override;
+
+      virtual void setSamplerMinLOD(float level) override;
+      virtual void setSamplerMaxLOD(float level) override;
+
+      virtual void setSamplerWrapU(WrapMode mode) override;
+      virtual void setSamplerWrapV(WrapMode mode) override;
+      virtual void setSamplerWrapW(WrapMode mode) override;
+
+      FilterMode minFilter    = FilterMode_Linear;
+      FilterMode magFilter    = FilterMode_Linear;
+      FilterMode minMipFilter = FilterMode_None;
+      FilterMode magMipFilter = FilterMode_None;
+
+      float minLOD = -1000.0f;
+      float maxLOD = 1000.0f;
+
+      Vector3<WrapMode> wrapMode = {WrapMode_Repeat, WrapMode_Repeat, WrapMode_Repeat};
+    };
+
+    /// A program that is never compiled.
+    /// Shader descriptions are stored so they can be queried, but no reflection data is produced.
+    class NullProgram : public Program {
+    public:
+      virtual void                      setShader(ShaderType type, std::optional<ShaderDesc> desc) override;
+      virtual std::optional<ShaderDesc> getShader(ShaderType type) const override;
+
+      virtual int64_t getAttributeCount() const override;
+      virtual int64_t getUniformCount() const override;
+      virtual int64_t getBufferCount() const override;
+      virtual int64_t getTextureCount() const override;
+
+      virtual void getAttributeDesc(int64_t uniformIndex, ProgramAttributeDesc * pDesc) const override;
+      virtual void getUniformDesc(int64_t uniformIndex, ProgramUniformDesc * pDesc) const override;
+      virtual void getTextureDesc(int64_t textureIndex, ProgramTextureDesc * pDesc) const override;
+      virtual void getBufferDesc(int64_t bufferIndex, ProgramBufferDesc * pDesc) const override;
+
+      std::optional<ShaderDesc> shaders[ShaderType_Count];
+    };
+
+    class NullRenderTarget : public RenderTarget {
+    public:
+      virtual RenderTargetType getType() const override;
+      virtual Vec2i            getSize() const override;
+      virtual bool             attachWindow(platform::Window * pWindow, DepthStencilFormat depthStencilFormat) override;
+      virtual void             attachColour(TextureRef textureID, int64_t slot, int64_t mipLevel, int64_t layer) override;
+      virtual void             attachColour(TextureAttachment attachment, int64_t slot) override;
+      virtual void             setReadAttachment(int64_t slot) override;
+      virtual void             attachDepth(TextureRef textureID, int64_t mipLevel, int64_t layer) override;
+      virtual void             attachDepth(TextureAttachment attachment) override;
+
+      virtual TextureAttachment getColour(int64_t slot) const override;
+      virtual TextureAttachment getDepth() const override;
+
+      RenderTargetType type = RenderTargetType_Unknown;
+
+      TextureAttachment depth;
+      TextureAttachment colour[MaxColourAttachments];
+      int64_t           colourReadAttachment = 0;
+
+      platform::Window * pWindow     = nullptr;
+      Vec2i              windowSize  = Vec2i(0); // Used when no window is attached.
+      DepthStencilFormat depthFormat = DepthStencilFormat_Unknown;
+    };
+
+    class BFC_API StateManager_Null : public StateManager {
+    public:
+      virtual void apply(State const & state) override;
+
+      FrameStatistics * pStats = nullptr;
+    };
+
+    class BFC_API NullBufferDownload : public BufferDownload {
+    public:
+      virtual bool wait(std::optional<Timestamp> const & timeout) override {
+        if (timeout.has_value())
+          return complete.wait_for((std::chrono::microseconds)timeout.value()) == std::future_status::ready;
+
+        complete.wait();
+        return true;
+      }
+
+      virtual Vector<uint8_t> take() override {
+        return std::move(storage);
+      }
+
+      virtual Span<const uint8_t> view() const override {
+        return storage;
+      }
+
+      Vector<uint8_t>          storage;
+      std::shared_future<void> complete;
+    };
+
+    class BFC_API NullTextureDownload : public TextureDownload {
+    public:
+      virtual bool wait(std::optional<Timestamp> const & timeout) override {
+        if (timeout.has_value())
+          return complete.wait_for((std::chrono::microseconds)timeout.value()) == std::future_status::ready;
+
+        complete.wait();
+        return true;
+      }
+
+      virtual media::Surface view() const override {
+        return surface;
+      }
+
+      virtual std::tuple<media::Surface, Vector<uint8_t>> take() override {
+        return std::make_tuple(std::move(surface), std::move(storage));
+      }
+
+      media::Surface           surface;
+      Vector<uint8_t>          storage;
+      std::shared_future<void> complete;
+    };
+
+    /// Records commands as closures that are replayed on the null device's execution thread.
+    /// Resources referenced by a command are captured by the command, so they are kept alive
+    /// for as long as the command list exists.
+    class BFC_API CommandList_Null : public CommandList {
+    public:
+      CommandList_Null(GraphicsDevice_Null * pDevice, RenderTargetRef defaultTarget);
+
+      virtual void execute() const override;
+      virtual void setDebugName(StringView const & name) override;
+      virtual void addDebugTag(StringView const & tag) override;
+
+      // Pipeline state
+      virtual void bindProgram(ProgramRef programID) override;
+      virtual void bindVertexArray(VertexArrayRef vertexArrayID) override;
+      virtual void bindTexture(TextureRef textureID, int64_t textureUnit) override;
+      virtual void bindSampler(SamplerRef samplerID, int64_t textureUnit) override;
+      virtual void bindUniformBuffer(BufferRef bufferID, int64_t bindPoint, int64_t offset = 0, int64_t size = 0) override;
+      virtual void bindShaderStorageBuffer(BufferRef bufferID, int64_t bindPoint, int64_t offset = 0, int64_t size = 0) override;
+      virtual void bindRenderTarget(RenderTargetRef renderTargetID, MapAccess renderTargetAccess = MapAccess_ReadWrite) override;
+      virtual void bindScreen(MapAccess renderTargetAccess = MapAccess_ReadWrite) override;
+
+      virtual void setState(Span<const State> const & state) override;
+      virtual void pushState(Span<const State> const & state) override;
+      virtual void popState() override;
+
+      // Buffers
+      virtual void                upload(BufferRef bufferID, int64_t size, void const * pData = nullptr) override;
+      virtual std::future<void *> map(BufferRef bufferID, MapAccess access = MapAccess_ReadWrite) override;
+      virtual std::future<void *> map(BufferRef bufferID, int64_t offset, int64_t size, MapAccess access = MapAccess_ReadWrite) override;
+      virtual void                unmap(BufferRef bufferID) override;
+      virtual void                download(BufferRef bufferID, BufferDownloadRef pDownload, int64_t offset, int64_t size) override;
+
+      // Textures
+      virtual bool uploadTexture(TextureRef textureID, DepthStencilFormat format, Vec3i size) override;
+      virtual bool uploadTexture(TextureRef textureID, media::Surface const & src) override;
+      virtual bool uploadTextureMips(TextureRef textureID, Span<const media::Surface> const & mips) override;
+      virtual bool uploadTextureSubData(TextureRef textureID, media::Surface const & src, Vec3i offset) override;
+      virtual void generateMipMaps(TextureRef textureID) override;
+      virtual void downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, PixelFormat format) override;
+      virtual void downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, DepthStencilFormat format) override;
+
+      // Shaders
+      virtual void setUniform(int64_t uniformIndex, void const * pBuffer, int64_t size) override;
+      virtual void setUniform(StringView const & name, void const * pBuffer, int64_t size) override;
+      virtual void setBufferBinding(int64_t bufferIndex, int64_t bindPoint) override;
+      virtual void setBufferBinding(StringView const & name, int64_t bindPoint) override;
+      virtual void setTextureBinding(int64_t textureIndex, int64_t bindPoint) override;
+      virtual void setTextureBinding(StringView const & name, int64_t bindPoint) override;
+
+      // Rendering commands
+      virtual void clear(RGBAu8 colour, float depth, uint8_t stencil) override;
+      virtual void clearDepth(float depth) override;
+      virtual void clearColour(RGBAu8 colour) override;
+      virtual void clearStencil(uint8_t value) override;
+      virtual void clearColourAttachment(int64_t slot, PixelFormat format, void const * rgba) override;
+
+      virtual void swap() override;
+
+      virtual void draw(int64_t elementCount = std::numeric_limits<int64_t>::max(), int64_t elementOffset = 0, PrimitiveType primType = PrimitiveType_Triangle,
+                        int64_t instanceCount = 1) override;
+      virtual void drawIndexed(int64_t elementCount = std::numeric_limits<int64_t>::max(), int64_t elementOffset = 0,
+                               PrimitiveType primType = PrimitiveType_Triangle, int64_t instanceCount = 1) override;
+
+      /// Track a pointer to keep it alive while this command list exists.
+      virtual void track(bfc::Ref<void> pPtr) override;
+
+      /// Get the graphics device that created this command list.
+      virtual GraphicsDevice * getDevice() const override;
+
+    private:
+      using Command = std::function<void(GraphicsDevice_Null * pDevice)>;
+
+      void add(Command && cmd) {
+        m_commands.pushBack(std::move(cmd));
+      }
+
+      String m_debugName;
+
+      int64_t  m_indexCount  = -1;
+      int64_t  m_vertexCount = -1;
+      DataType m_vaIndexType = DataType_Unknown;
+
+      RenderTargetRef m_defaultTarget = InvalidGraphicsResource;
+      ProgramRef      m_boundProgram  = nullptr;
+
+      Vector<Command>       m_commands;
+      Vector<Ref<void>>     m_trackedResources;
+      GraphicsDevice_Null * m_pDevice;
+    };
+  } // namespace graphics
+
+  /// A graphics device that does not talk to a GPU.
+  /// Resources are plain CPU-side objects and command lists are executed on a dedicated thread,
+  /// so fences behave as they do for a real device. Useful for measuring the CPU cost of
+  /// rendering and for running renderers on machines without a graphics driver.
+  class GraphicsDevice_Null : public GraphicsDevice {
+  public:
+    ~GraphicsDevice_Null();
+
+    virtual bool init(platform::Window * pWindow) override;
+    virtual void destroy() override;
+
+    virtual graphics::RenderTargetRef getDefaultRenderTarget() override;
+
+    virtual std::unique_ptr<graphics::CommandList> createCommandList() override;
+    virtual graphics::BufferRef                    createBuffer(BufferUsageHint usageHint) override;
+    virtual graphics::VertexArrayRef               createVertexArray() override;
+    virtual graphics::ProgramRef                   createProgram() override;
+    virtual graphics::TextureRef                   createTexture(TextureType type) override;
+    virtual graphics::TextureDownloadRef           createTextureDownload() override;
+    virtual graphics::SamplerRef                   createSampler() override;
+    virtual graphics::RenderTargetRef              createRenderTarget(RenderTargetType type) override;
+    virtual graphics::StateManager *               getStateManager() override;
+
+    virtual std::shared_future<bool> compile(graphics::ProgramRef pProgram) override;
+
+    virtual uint64_t submit(std::unique_ptr<graphics::CommandList> && pCommandList) override;
+
+    virtual bool wait(uint64_t handle, std::optional<Timestamp> const & timeout = std::nullopt) override;
+
+    virtual bool getFrameStatistics(graphics::FrameStatistics * pStats) const override;
+
+    /// Statistics for the frame currently being executed.
+    /// Only valid on the execution thread.
+    graphics::FrameStatistics & stats() {
+      return m_frameStats;
+    }
+
+    /// Finish the current frame and publish its statistics.
+    /// Only valid on the execution thread.
+    void endFrame();
+
+  private:
+    void ExecuteThread();
+
+    std::thread m_executeThread;
+    bool        m_running = true;
+
+    uint64_t                m_nextCommandListID = 0;
+    uint64_t                m_commandListFence  = 0;
+    std::mutex              m_fenceLock;
+    std::condition_variable m_fenceNotifier;
+
+    std::mutex                                     m_queueLock;
+    std::condition_variable                        m_queueNotifier;
+    Vector<std::unique_ptr<graphics::CommandList>> m_commandListQueue;
+
+    graphics::StateManager_Null m_stateManager;
+    graphics::FrameStatistics   m_frameStats;
+
+    mutable std::mutex        m_statsLock;
+    graphics::FrameStatistics m_lastFrameStats;
+    bool                      m_hasCompletedFrame = false;
+
+    graphics::RenderTargetRef m_defaultTarget = InvalidGraphicsResource;
+  };
+} // namespace bfc
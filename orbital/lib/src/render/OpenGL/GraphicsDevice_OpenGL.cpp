@@ -1123,11 +1123,14 @@ namespace bfc {
       cmd.surface.pBuffer = nullptr;
       cmd.dataSize        = media::calculateSurfaceSize(src);
       cmd.dataHandle      = m_commandBuffer.write({(const uint8_t *)src.pBuffer, cmd.dataSize});
+      cmd.mipLevel        = 0;
+      cmd.mipCount        = 1;
 
       add(cmd);
       track(textureID);
 
-      if (cmd.dataHandle != -1) {
+      // Mips can't be generated for compressed formats. They must be uploaded with uploadTextureMips.
+      if (cmd.dataHandle != -1 && !isBlockCompressed(src.format)) {
         generateMipMaps(textureID);
       }
 
@@ -1138,6 +1141,39 @@ namespace bfc {
       return true;
     }
 
+    bool CommandList_OpenGL::uploadTextureMips(TextureRef textureID, Span<const media::Surface> const & mips) {
+      BFC_ASSERT(textureID != nullptr, "textureID is nullptr");
+      if (mips.size() == 0)
+        return false;
+
+      auto & tex = ToGL(textureID);
+      for (int64_t level = 0; level < mips.size(); ++level) {
+        media::Surface const & src = mips[level];
+
+        impl::OpenGL::UploadTexture cmd;
+        cmd.pTexture        = &tex;
+        cmd.format          = ToGLFormat(src.format);
+        cmd.type            = ToGLType(src.format);
+        cmd.internalFormat  = ToGLInternalFormat(src.format);
+        cmd.target          = ToGLTextureType(tex.type);
+        cmd.surface         = src;
+        cmd.surface.pBuffer = nullptr;
+        cmd.dataSize        = media::calculateSurfaceSize(src);
+        cmd.dataHandle      = m_commandBuffer.write({(const uint8_t *)src.pBuffer, cmd.dataSize});
+        cmd.mipLevel        = (int32_t)level;
+        cmd.mipCount        = (int32_t)mips.size();
+
+        add(cmd);
+      }
+      track(textureID);
+
+      tex.depthStencilFmt = DepthStencilFormat_Unknown;
+      tex.format          = mips[0].format;
+      tex.size            = mips[0].size;
+
+      return true;
+    }
+
     bool CommandList_OpenGL::uploadTextureSubData(TextureRef textureID, media::Surface const & src, Vec3i offset) {
       BFC_ASSERT(textureID != nullptr, "textureID is nullptr");
 
@@ -1723,6 +1759,11 @@ namespace bfc {
     case PixelFormat_RGBAf16: return GL_RGBA16F;
     case PixelFormat_RGBAf32: return GL_RGBA32F;
     case PixelFormat_Rf32: return GL_R32F;
+    case PixelFormat_BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case PixelFormat_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case PixelFormat_BC4: return GL_COMPRESSED_RED_RGTC1;
+    case PixelFormat_BC5: return GL_COMPRESSED_RG_RGTC2;
+    case PixelFormat_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
     }
     return GL_NONE;
   }
@@ -365,6 +365,7 @@ namespace bfc {
       // Textures
       virtual bool uploadTexture(TextureRef textureID, DepthStencilFormat format, Vec3i size) override;
       virtual bool uploadTexture(TextureRef textureID, media::Surface const & src) override;
+      virtual bool uploadTextureMips(TextureRef textureID, Span<const media::Surface> const & mips) override;
       virtual bool uploadTextureSubData(TextureRef textureID, media::Surface const & src, Vec3i offset) override;
       virtual void generateMipMaps(TextureRef textureID) override;
       virtual void downloadTexture(TextureRef textureID, TextureDownloadRef pDownload, PixelFormat format) override;
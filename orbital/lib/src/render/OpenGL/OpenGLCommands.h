@@ -472,6 +472,8 @@ namespace bfc {
           GLenum      type;
           GLenum      internalFormat;
           GLenum      target;
+          int32_t     mipLevel;
+          int32_t     mipCount;
 
           int64_t        dataHandle;
           int64_t        dataSize;
@@ -484,9 +486,11 @@ namespace bfc {
             GLenum const &      glType           = pCmd->type;
             GLenum const &      glInternalFormat = pCmd->internalFormat;
             GLenum const &      glTarget         = pCmd->target;
+            GLint const         level            = pCmd->mipLevel;
             media::Surface      src              = pCmd->surface;
             Span<const uint8_t> data             = pBuffer->read(pCmd->dataHandle, pCmd->dataSize);
             src.pBuffer                          = (void *)data.begin();
+            bool const          compressed       = isBlockCompressed(src.format) && src.pBuffer != nullptr;
 
             if (tex.glID == 0) {
               glGenTextures(1, &tex.glID);
@@ -500,15 +504,41 @@ namespace bfc {
               glBindTexture(glTarget, tex.glID);
             }
 
+            if (pCmd->mipCount > 1 && level == 0) {
+              glTexParameteri(glTarget, GL_TEXTURE_BASE_LEVEL, 0);
+              glTexParameteri(glTarget, GL_TEXTURE_MAX_LEVEL, pCmd->mipCount - 1);
+              glTexParameteri(glTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            }
+
+            if (compressed) {
+              BFC_ASSERT(tex.type != TextureType_3D, "Block compressed formats do not support 3D textures.");
+              GLsizei const sliceSize = (GLsizei)calculateSurfaceSize(src.slice(0));
+              switch (tex.type) {
+              case TextureType_2D: glCompressedTexImage2D(glTarget, level, glInternalFormat, src.size.x, src.size.y, 0, sliceSize, src.pBuffer); break;
+              case TextureType_2DArray:
+                glCompressedTexImage3D(glTarget, level, glInternalFormat, src.size.x, src.size.y, src.size.z, 0, sliceSize * src.size.z, src.pBuffer);
+                break;
+              case TextureType_CubeMap:
+                BFC_ASSERT(src.size.z == 6, "A cubemap must have a depth of 6.");
+                for (int64_t i = 0; i < src.size.z; ++i) {
+                  void * pBlocks = getSurfacePixel(src, {0, 0, i});
+                  glCompressedTexImage2D(ToGLCubeMapFace((CubeMapFace)i), level, glInternalFormat, src.size.x, src.size.y, 0, sliceSize, pBlocks);
+                }
+                break;
+              }
+              glBindTexture(glTarget, 0);
+              return;
+            }
+
             switch (tex.type) {
-            case TextureType_2D: glTexImage2D(glTarget, 0, glInternalFormat, src.size.x, src.size.y, GL_NONE, glFormat, glType, src.pBuffer); break;
+            case TextureType_2D: glTexImage2D(glTarget, level, glInternalFormat, src.size.x, src.size.y, GL_NONE, glFormat, glType, src.pBuffer); break;
             case TextureType_2DArray: // Fall-through
-            case TextureType_3D: glTexImage3D(glTarget, 0, glInternalFormat, src.size.x, src.size.y, src.size.z, GL_NONE, glFormat, glType, src.pBuffer); break;
+            case TextureType_3D: glTexImage3D(glTarget, level, glInternalFormat, src.size.x, src.size.y, src.size.z, GL_NONE, glFormat, glType, src.pBuffer); break;
             case TextureType_CubeMap:
               BFC_ASSERT(src.size.z == 6, "A cubemap must have a depth of 6.");
               for (int64_t i = 0; i < src.size.z; ++i) {
                 void * pPixels = getSurfacePixel(src, {0, 0, i});
-                glTexImage2D(ToGLCubeMapFace((CubeMapFace)i), 0, glInternalFormat, src.size.x, src.size.y, GL_NONE, glFormat, glType, pPixels);
+                glTexImage2D(ToGLCubeMapFace((CubeMapFace)i), level, glInternalFormat, src.size.x, src.size.y, GL_NONE, glFormat, glType, pPixels);
               }
               break;
             }
@@ -1,12 +1,19 @@
 #include "util/Cache.h"
+#include "util/Compression.h"
 #include "core/File.h"
+#include "PackedCache.h"
 
 #include <filesystem>
 
 namespace bfc {
-  Cache::Cache(Filename const & path)
+  Cache::Cache(Filename const & path, CacheOptions const & options)
     : m_path(path)
     , m_pLock(new std::mutex) {
+    if (options.storage == CacheStorage_Packed) {
+      m_pPacked = new impl::PackedCache(path, options);
+      return;
+    }
+
     Filename headerPath = path / "header";
 
     // Read the cache header
@@ -28,6 +35,7 @@ namespace bfc {
     }
 
     // Write the pruned header to disk
+    std::filesystem::create_directories(m_path.c_str());
     m_header.open(headerPath, FileMode_WriteBinary);
     m_header.write(Version);
     for (auto& [id, item] : m_entries) {
@@ -35,7 +43,6 @@ namespace bfc {
     }
     m_header.flush();
 
-    std::filesystem::create_directories(m_path.c_str());
     // Delete any previously staged items
     std::filesystem::remove_all((m_path / "staged").c_str());
     // Make sure the data directory exists
@@ -59,17 +66,39 @@ namespace bfc {
   }
 
   Cache::~Cache() {
+    if (m_pPacked != nullptr) {
+      delete m_pPacked;
+      delete m_pLock;
+      return;
+    }
+
     m_header.close();
     std::filesystem::remove_all((m_path / "staged").c_str());
     delete m_pLock;
   }
 
+  Stream * Cache::Entry::stream() const {
+    return pCodec != nullptr ? pCodec.get() : pStream.get();
+  }
+
+  void Cache::Entry::close() {
+    // Finish the compressed stream before the stream it writes to is closed.
+    pCodec  = nullptr;
+    pStream = nullptr;
+  }
+
   bool Cache::contains(StringView const & identifier) const {
+    if (m_pPacked != nullptr)
+      return m_pPacked->contains(identifier);
+
     std::scoped_lock lock(*m_pLock);
     return m_entries.contains(identifier);
   }
 
   bool Cache::checkout(StringView const & identifier, Entry * pEntry) const {
+    if (m_pPacked != nullptr)
+      return m_pPacked->checkout(identifier, pEntry);
+
     {
       std::scoped_lock lock(*m_pLock);
       HeaderItem const * pHeader = m_entries.tryGet(identifier);
@@ -81,26 +110,50 @@ namespace bfc {
       pEntry->timestamp = pHeader->timestamp;
       pEntry->uuid      = pHeader->uuid;
       pEntry->version   = pHeader->version;
+      pEntry->flags     = pHeader->flags;
     }
 
-    return pEntry->stream.open(m_path / "data" / pEntry->uuid.toString(), FileMode_ReadBinary);
+    Ref<File> pFile = NewRef<File>();
+    pEntry->pCodec  = nullptr;
+    pEntry->pStream = nullptr;
+    if (!pFile->open(m_path / "data" / pEntry->uuid.toString(), FileMode_ReadBinary))
+      return false;
+
+    pEntry->pStream = pFile;
+    if ((pEntry->flags & CacheEntryFlags_Compressed) != 0)
+      pEntry->pCodec = NewRef<DecompressingReader>(pFile.get());
+    return true;
   }
 
-  Cache::Entry Cache::create() const {
+  Cache::Entry Cache::create(int64_t flags) const {
+    if (m_pPacked != nullptr)
+      return m_pPacked->create(flags);
+
+    Ref<File> pFile = NewRef<File>();
     Entry entry;
     entry.uuid       = UUID::New();
-    bool opened = entry.stream.open(m_path / "staged" / entry.uuid.toString(), FileMode_WriteBinary);
+    entry.flags      = flags;
+    bool opened = pFile->open(m_path / "staged" / entry.uuid.toString(), FileMode_WriteBinary);
     BFC_ASSERT(opened, "Failed to open stream");
+    entry.pStream = pFile;
+    if ((flags & CacheEntryFlags_Compressed) != 0)
+      entry.pCodec = NewRef<CompressedWriter>(pFile.get());
     return entry;
   }
 
   void Cache::commit(StringView const & identifier, Entry *pEntry) {
+    if (m_pPacked != nullptr) {
+      m_pPacked->commit(identifier, pEntry);
+      return;
+    }
+
     HeaderItem item;
     item.id        = identifier;
     item.timestamp = pEntry->timestamp;
     item.uuid      = pEntry->uuid;
     item.version   = pEntry->version;
-    pEntry->stream.close();
+    item.flags     = pEntry->flags;
+    pEntry->close();
 
     String uuidStr = item.uuid.toString();
 
@@ -125,6 +178,11 @@ namespace bfc {
   }
 
   void Cache::remove(StringView const & identifier) {
+    if (m_pPacked != nullptr) {
+      m_pPacked->remove(identifier);
+      return;
+    }
+
     UUID id;
     {
       std::scoped_lock   lock(*m_pLock);
@@ -138,10 +196,20 @@ namespace bfc {
     std::filesystem::remove((m_path / "data" / id.toString()).c_str());
   }
 
+  int64_t Cache::size() const {
+    return m_pPacked != nullptr ? m_pPacked->size() : -1;
+  }
+
+  void Cache::compact() {
+    if (m_pPacked != nullptr)
+      m_pPacked->compact();
+  }
+
   bool Cache::readHeaderItem(HeaderItem *pItem) {
     return m_header.read(&pItem->id)
       && m_header.read(&pItem->timestamp)
       && m_header.read(&pItem->version)
+      && m_header.read(&pItem->flags)
       && m_header.read(&pItem->uuid);
   }
 
@@ -150,6 +218,7 @@ namespace bfc {
     if (m_header.write(item.id)
       && m_header.write(item.timestamp)
       && m_header.write(item.version)
+      && m_header.write(item.flags)
       && m_header.write(item.uuid)) {
       m_header.flush();
       return true;
@@ -0,0 +1,482 @@
+#include "util/Compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef BFC_MSVC
+#include <intrin.h>
+#endif
+
+// The block format follows LZ4. Each sequence is a token, literals, and a match:
+//   token:    high nibble is the literal count, low nibble is the match length - MinMatch.
+//             A nibble of 15 is followed by bytes that are added to it until one is less than 255.
+//   literals: copied to the output as is.
+//   offset:   16-bit little endian distance back to the start of the match.
+// The last sequence only has literals. Its end is the end of the input.
+
+namespace bfc {
+  namespace {
+    constexpr int64_t MinMatch     = 4;
+    constexpr int64_t LastLiterals = 5;  ///< The last bytes are always literals, so matches can be copied past their end.
+    constexpr int64_t MatchLimit   = 12; ///< Matches do not start in the last bytes, so literals can be copied past their end.
+    constexpr int64_t MaxOffset    = 65535;
+    constexpr int64_t HashBits     = 13;
+
+    constexpr uint32_t StreamMagic = 0x315A4642; // "BFZ1"
+    constexpr uint32_t StoredBlock = 0x80000000; ///< Set in the packed size of blocks that did not compress.
+
+    inline uint32_t load32(uint8_t const * p) {
+      uint32_t value;
+      memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline uint64_t load64(uint8_t const * p) {
+      uint64_t value;
+      memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline uint32_t hashSequence(uint32_t sequence) {
+      return (sequence * 2654435761u) >> (32 - HashBits);
+    }
+
+    inline uint32_t countTrailingZeros(uint64_t bits) {
+      uint32_t const low  = uint32_t(bits);
+      uint32_t const word = low != 0 ? low : uint32_t(bits >> 32);
+#ifdef BFC_MSVC
+      unsigned long index = 0;
+      _BitScanForward(&index, word);
+#else
+      uint32_t const index = (uint32_t)__builtin_ctz(word);
+#endif
+      return (uint32_t)index + (low != 0 ? 0 : 32);
+    }
+
+    /// Count the bytes that match at `pIn` and `pMatch`, stopping at `pLimit`.
+    inline int64_t countMatch(uint8_t const * pIn, uint8_t const * pMatch, uint8_t const * pLimit) {
+      uint8_t const * pStart = pIn;
+      while (pIn + 8 <= pLimit) {
+        uint64_t const diff = load64(pIn) ^ load64(pMatch);
+        if (diff != 0) // Assumes little endian
+          return (pIn - pStart) + countTrailingZeros(diff) / 8;
+        pIn += 8;
+        pMatch += 8;
+      }
+
+      while (pIn < pLimit && *pIn == *pMatch) {
+        ++pIn;
+        ++pMatch;
+      }
+      return pIn - pStart;
+    }
+
+    inline uint8_t * writeLength(uint8_t * pOut, int64_t length) {
+      for (; length >= 255; length -= 255)
+        *(pOut++) = 255;
+      *(pOut++) = uint8_t(length);
+      return pOut;
+    }
+
+    inline bool readLength(uint8_t const ** ppIn, uint8_t const * pEnd, int64_t * pLength) {
+      uint8_t const * pIn = *ppIn;
+      uint8_t         byte = 255;
+      while (byte == 255) {
+        if (pIn >= pEnd || *pLength > (INT64_MAX >> 1))
+          return false;
+        byte = *(pIn++);
+        *pLength += byte;
+      }
+      *ppIn = pIn;
+      return true;
+    }
+
+    /// Write a sequence of literals from `pLiterals` followed by a match.
+    /// If `matchLength` is 0 only the literals are written.
+    /// @returns The end of the sequence, or nullptr if it does not fit.
+    uint8_t * writeSequence(uint8_t * pOut, uint8_t * pEnd, uint8_t const * pLiterals, int64_t literalCount, int64_t offset, int64_t matchLength) {
+      int64_t const worstCase = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+      if (worstCase > pEnd - pOut)
+        return nullptr;
+
+      uint8_t * pToken = pOut++;
+      *pToken          = uint8_t(std::min<int64_t>(literalCount, 15) << 4);
+      if (literalCount >= 15)
+        pOut = writeLength(pOut, literalCount - 15);
+      if (literalCount > 0)
+        memcpy(pOut, pLiterals, literalCount);
+      pOut += literalCount;
+
+      if (matchLength == 0)
+        return pOut;
+
+      *(pOut++) = uint8_t(offset);
+      *(pOut++) = uint8_t(offset >> 8);
+
+      int64_t const length = matchLength - MinMatch;
+      *pToken |= uint8_t(std::min<int64_t>(length, 15));
+      if (length >= 15)
+        pOut = writeLength(pOut, length - 15);
+      return pOut;
+    }
+
+    /// Copy `count` bytes in 16 byte chunks. Up to 15 bytes past the end of each buffer are accessed.
+    inline void wildCopy16(uint8_t * pDst, uint8_t const * pSrc, int64_t count) {
+      uint8_t * pEnd = pDst + count;
+      do {
+        memcpy(pDst, pSrc, 16);
+        pDst += 16;
+        pSrc += 16;
+      } while (pDst < pEnd);
+    }
+
+    /// Copy a match that may overlap the output.
+    /// @param pEnd The end of the output buffer. Chunks are only copied past the match if they fit.
+    inline void copyMatch(uint8_t * pOut, int64_t offset, int64_t length, uint8_t * pEnd) {
+      uint8_t const * pMatch    = pOut - offset;
+      uint8_t *       pMatchEnd = pOut + length;
+      if (pEnd - pMatchEnd < 8) {
+        while (pOut < pMatchEnd)
+          *(pOut++) = *(pMatch++);
+        return;
+      }
+
+      if (offset < 8) {
+        // Repeat the pattern bytewise until a multiple of the offset is far enough back to copy in chunks.
+        for (int64_t i = 0; i < 8; ++i)
+          pOut[i] = pMatch[i];
+        pOut += 8;
+        pMatch = pOut - offset * ((8 + offset - 1) / offset);
+      }
+
+      while (pOut < pMatchEnd) {
+        memcpy(pOut, pMatch, 8);
+        pOut += 8;
+        pMatch += 8;
+      }
+    }
+  } // namespace
+
+  int64_t compressBlockBound(int64_t size) {
+    return size + size / 255 + 16;
+  }
+
+  int64_t compressBlock(uint8_t * pDst, int64_t dstCapacity, uint8_t const * pSrc, int64_t srcSize) {
+    uint8_t *       pOut    = pDst;
+    uint8_t *       pOutEnd = pDst + dstCapacity;
+    uint8_t const * pIn     = pSrc;
+    uint8_t const * pAnchor = pSrc;
+    uint8_t const * pInEnd  = pSrc + srcSize;
+
+    if (srcSize > MatchLimit) {
+      uint8_t const * pSearchEnd = pInEnd - MatchLimit;
+      uint8_t const * pMatchEnd  = pInEnd - LastLiterals;
+
+      // Positions are relative to `pSrc`. Stale or wrapped entries are rejected by the checks below.
+      uint32_t table[1 << HashBits] = {0};
+      int64_t  misses               = 0;
+      ++pIn;
+      while (pIn < pSearchEnd) {
+        uint32_t const  sequence = load32(pIn);
+        uint32_t const  hash     = hashSequence(sequence);
+        uint8_t const * pMatch   = pSrc + table[hash];
+        table[hash]              = uint32_t(pIn - pSrc);
+
+        if (pMatch >= pIn || pIn - pMatch > MaxOffset || load32(pMatch) != sequence) {
+          // Skip through incompressible data faster the longer no match is found.
+          pIn += 1 + (misses++ >> 6);
+          continue;
+        }
+        misses = 0;
+
+        while (pIn > pAnchor && pMatch > pSrc && pIn[-1] == pMatch[-1]) {
+          --pIn;
+          --pMatch;
+        }
+
+        int64_t const length = MinMatch + countMatch(pIn + MinMatch, pMatch + MinMatch, pMatchEnd);
+        pOut                 = writeSequence(pOut, pOutEnd, pAnchor, pIn - pAnchor, pIn - pMatch, length);
+        if (pOut == nullptr)
+          return -1;
+
+        pIn += length;
+        pAnchor = pIn;
+        if (pIn < pSearchEnd)
+          table[hashSequence(load32(pIn - 2))] = uint32_t(pIn - 2 - pSrc);
+      }
+    }
+
+    pOut = writeSequence(pOut, pOutEnd, pAnchor, pInEnd - pAnchor, 0, 0);
+    if (pOut == nullptr)
+      return -1;
+    return pOut - pDst;
+  }
+
+  int64_t decompressBlock(uint8_t * pDst, int64_t dstCapacity, uint8_t const * pSrc, int64_t srcSize) {
+    uint8_t *       pOut    = pDst;
+    uint8_t *       pOutEnd = pDst + dstCapacity;
+    uint8_t const * pIn     = pSrc;
+    uint8_t const * pInEnd  = pSrc + srcSize;
+
+    while (true) {
+      if (pIn >= pInEnd)
+        return -1;
+
+      uint32_t const token        = *(pIn++);
+      int64_t        literalCount = token >> 4;
+      int64_t        length       = token & 15;
+
+      // Short sequences away from the ends of the buffers copy a fixed 16 literals and 18 bytes of match.
+      if (literalCount != 15 && length != 15 && pInEnd - pIn >= 32 && pOutEnd - pOut >= 32) {
+        memcpy(pOut, pIn, 16);
+        pOut += literalCount;
+        pIn += literalCount;
+
+        int64_t const offset = int64_t(pIn[0]) | (int64_t(pIn[1]) << 8);
+        pIn += 2;
+        length += MinMatch;
+        if (offset >= 8 && offset <= pOut - pDst) {
+          uint8_t const * pMatch = pOut - offset;
+          memcpy(pOut, pMatch, 8);
+          memcpy(pOut + 8, pMatch + 8, 8);
+          memcpy(pOut + 16, pMatch + 16, 2);
+        } else if (offset == 0 || offset > pOut - pDst) {
+          return -1;
+        } else {
+          copyMatch(pOut, offset, length, pOutEnd);
+        }
+        pOut += length;
+        continue;
+      }
+
+      if (literalCount == 15 && !readLength(&pIn, pInEnd, &literalCount))
+        return -1;
+      if (literalCount > pInEnd - pIn || literalCount > pOutEnd - pOut)
+        return -1;
+
+      if (literalCount + 16 <= pInEnd - pIn && literalCount + 16 <= pOutEnd - pOut)
+        wildCopy16(pOut, pIn, literalCount);
+      else if (literalCount > 0)
+        memcpy(pOut, pIn, literalCount);
+      pOut += literalCount;
+      pIn += literalCount;
+
+      if (pIn == pInEnd)
+        break;
+
+      if (pInEnd - pIn < 2)
+        return -1;
+      int64_t const offset = int64_t(pIn[0]) | (int64_t(pIn[1]) << 8);
+      pIn += 2;
+      if (offset == 0 || offset > pOut - pDst)
+        return -1;
+
+      if (length == 15 && !readLength(&pIn, pInEnd, &length))
+        return -1;
+      length += MinMatch;
+      if (length > pOutEnd - pOut)
+        return -1;
+
+      copyMatch(pOut, offset, length, pOutEnd);
+      pOut += length;
+    }
+
+    return pOut - pDst;
+  }
+
+  CompressedWriter::CompressedWriter(Stream * pStream)
+    : m_pStream(pStream) {}
+
+  CompressedWriter::~CompressedWriter() {
+    finish();
+  }
+
+  bool CompressedWriter::finish() {
+    if (m_finished)
+      return true;
+    m_finished = true;
+
+    bool success = m_block.empty() || writeBlock(m_block.data(), m_block.size());
+    m_block.clear();
+    if (!m_started) {
+      success &= m_pStream->write(StreamMagic);
+      m_started = true;
+    }
+
+    success &= m_pStream->write(uint32_t(0)) && m_pStream->write(uint32_t(0));
+    return success;
+  }
+
+  bool CompressedWriter::readable() const {
+    return false;
+  }
+
+  bool CompressedWriter::writeable() const {
+    return !m_finished;
+  }
+
+  bool CompressedWriter::seekable() const {
+    return false;
+  }
+
+  bool CompressedWriter::eof() const {
+    return m_finished;
+  }
+
+  int64_t CompressedWriter::tell() const {
+    return m_written;
+  }
+
+  int64_t CompressedWriter::write(void const * data, int64_t length) {
+    if (m_finished)
+      return 0;
+
+    uint8_t const * pBytes    = (uint8_t const *)data;
+    int64_t         remaining = length;
+    while (remaining > 0) {
+      // Whole blocks are compressed straight from the caller's buffer.
+      if (m_block.empty() && remaining >= CompressionBlockSize) {
+        if (!writeBlock(pBytes, CompressionBlockSize))
+          break;
+        pBytes += CompressionBlockSize;
+        remaining -= CompressionBlockSize;
+        continue;
+      }
+
+      int64_t const start = m_block.size();
+      int64_t const count = std::min(remaining, CompressionBlockSize - start);
+      m_block.resize(start + count);
+      memcpy(m_block.data() + start, pBytes, count);
+      pBytes += count;
+      remaining -= count;
+
+      if (m_block.size() == CompressionBlockSize) {
+        bool const written = writeBlock(m_block.data(), m_block.size());
+        m_block.clear();
+        if (!written)
+          break;
+      }
+    }
+
+    m_written += length - remaining;
+    return length - remaining;
+  }
+
+  bool CompressedWriter::flush() {
+    if (!m_finished && !m_block.empty()) {
+      bool const written = writeBlock(m_block.data(), m_block.size());
+      m_block.clear();
+      if (!written)
+        return false;
+    }
+    return m_pStream->flush();
+  }
+
+  bool CompressedWriter::writeBlock(uint8_t const * pData, int64_t size) {
+    if (!m_started) {
+      if (!m_pStream->write(StreamMagic))
+        return false;
+      m_started = true;
+    }
+
+    m_compressed.resize(compressBlockBound(size));
+    int64_t const packedSize = compressBlock(m_compressed.data(), m_compressed.size(), pData, size);
+    bool const    stored     = packedSize < 0 || packedSize >= size;
+
+    uint32_t const header[2] = {uint32_t(size), stored ? uint32_t(size) | StoredBlock : uint32_t(packedSize)};
+    int64_t const  bytes     = stored ? size : packedSize;
+    return m_pStream->write(header, 2) == 2 && m_pStream->write(stored ? pData : m_compressed.data(), bytes) == bytes;
+  }
+
+  DecompressingReader::DecompressingReader(Stream * pStream)
+    : m_pStream(pStream) {}
+
+  bool DecompressingReader::readable() const {
+    return true;
+  }
+
+  bool DecompressingReader::writeable() const {
+    return false;
+  }
+
+  bool DecompressingReader::seekable() const {
+    return false;
+  }
+
+  bool DecompressingReader::eof() const {
+    return m_end && m_blockPos == m_block.size();
+  }
+
+  int64_t DecompressingReader::tell() const {
+    return m_read;
+  }
+
+  int64_t DecompressingReader::read(void * data, int64_t length) {
+    uint8_t * pBytes = (uint8_t *)data;
+    int64_t   total  = 0;
+    while (total < length) {
+      if (m_blockPos < m_block.size()) {
+        int64_t const count = std::min(length - total, m_block.size() - m_blockPos);
+        memcpy(pBytes + total, m_block.data() + m_blockPos, count);
+        m_blockPos += count;
+        total += count;
+        continue;
+      }
+
+      if (m_end)
+        break;
+      total += readBlock(pBytes + total, length - total);
+    }
+
+    m_read += total;
+    return total;
+  }
+
+  int64_t DecompressingReader::readBlock(uint8_t * pDst, int64_t capacity) {
+    m_block.clear();
+    m_blockPos = 0;
+
+    uint32_t magic = 0;
+    if (!m_started && (m_pStream->read(&magic) != 1 || magic != StreamMagic)) {
+      m_end = true;
+      return 0;
+    }
+    m_started = true;
+
+    uint32_t header[2] = {0};
+    if (m_pStream->read(header, 2) != 2 || header[0] == 0) {
+      m_end = true;
+      return 0;
+    }
+
+    int64_t const rawSize    = header[0];
+    int64_t const packedSize = header[1] & ~StoredBlock;
+    bool const    stored     = (header[1] & StoredBlock) != 0;
+    if (rawSize > CompressionBlockSize || packedSize > compressBlockBound(CompressionBlockSize) || (stored && packedSize != rawSize)) {
+      m_end = true;
+      return 0;
+    }
+
+    // Decompress straight into the caller's buffer if the whole block fits.
+    bool const direct = rawSize <= capacity;
+    if (!direct)
+      m_block.resize(rawSize);
+    uint8_t * pOut = direct ? pDst : m_block.data();
+
+    bool success = false;
+    if (stored) {
+      success = m_pStream->read(pOut, rawSize) == rawSize;
+    } else {
+      m_compressed.resize(packedSize);
+      success = m_pStream->read(m_compressed.data(), packedSize) == packedSize
+             && decompressBlock(pOut, rawSize, m_compressed.data(), packedSize) == rawSize;
+    }
+
+    if (!success) {
+      m_end = true;
+      m_block.clear();
+      return 0;
+    }
+    return direct ? rawSize : 0;
+  }
+} // namespace bfc
@@ -0,0 +1,451 @@
+#include "util/Hash.h"
+
+#include <cstring>
+
+#ifdef BFC_MSVC
+#include <intrin.h>
+#endif
+
+// The hash is XXH3-128 (https://github.com/Cyan4973/xxHash), using the scalar code path.
+// Inputs of up to 240 bytes are mixed with the secret directly. Longer inputs are accumulated 64 byte
+// stripes at a time into 8 lanes, and the lanes are scrambled after every block of 16 stripes.
+// Values are read as little endian.
+
+namespace bfc {
+  namespace {
+    constexpr uint64_t Prime32_1 = 0x9E3779B1u;
+    constexpr uint64_t Prime32_2 = 0x85EBCA77u;
+    constexpr uint64_t Prime32_3 = 0xC2B2AE3Du;
+    constexpr uint64_t Prime64_1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t Prime64_3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t Prime64_4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t Prime64_5 = 0x27D4EB2F165667C5ull;
+    constexpr uint64_t PrimeMx1  = 0x165667919E3779F9ull;
+    constexpr uint64_t PrimeMx2  = 0x9FB21C651E98DF25ull;
+
+    constexpr int64_t SecretSize        = 192;
+    constexpr int64_t StripeSize        = 64;
+    constexpr int64_t SecretConsumeRate = 8; ///< Bytes of the secret to advance by for each stripe.
+    constexpr int64_t StripesPerBlock   = (SecretSize - StripeSize) / SecretConsumeRate;
+    constexpr int64_t BlockSize         = StripeSize * StripesPerBlock;
+    constexpr int64_t MidSizeMax        = 240;
+    constexpr int64_t MidSizeStart      = 3;
+    constexpr int64_t MidSizeLast       = 17;
+    constexpr int64_t SecretSizeMin     = 136;
+    constexpr int64_t LastStripeStart   = 7;  ///< Offset of the last stripe's secret from the end of the scramble secret.
+    constexpr int64_t MergeStart        = 11; ///< Offset of the secret used to merge the lanes.
+
+    constexpr uint8_t DefaultSecret[SecretSize] = {
+      0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+      0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+      0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+      0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+      0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+      0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+      0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+      0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+      0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+      0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+      0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+      0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    inline uint32_t load32(uint8_t const * p) {
+      uint32_t value;
+      memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline uint64_t load64(uint8_t const * p) {
+      uint64_t value;
+      memcpy(&value, p, sizeof(value));
+      return value;
+    }
+
+    inline void store64(uint8_t * p, uint64_t value) {
+      memcpy(p, &value, sizeof(value));
+    }
+
+    inline uint32_t swap32(uint32_t value) {
+#ifdef BFC_MSVC
+      return _byteswap_ulong(value);
+#else
+      return __builtin_bswap32(value);
+#endif
+    }
+
+    inline uint64_t swap64(uint64_t value) {
+#ifdef BFC_MSVC
+      return _byteswap_uint64(value);
+#else
+      return __builtin_bswap64(value);
+#endif
+    }
+
+    inline uint32_t rotl32(uint32_t value, int bits) {
+      return (value << bits) | (value >> (32 - bits));
+    }
+
+    inline uint64_t rotl64(uint64_t value, int bits) {
+      return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline Hash128 multiply128(uint64_t lhs, uint64_t rhs) {
+      Hash128 product;
+#ifdef BFC_MSVC
+      product.low = _umul128(lhs, rhs, &product.high);
+#else
+      unsigned __int128 const full = (unsigned __int128)lhs * rhs;
+      product.low  = uint64_t(full);
+      product.high = uint64_t(full >> 64);
+#endif
+      return product;
+    }
+
+    inline uint64_t multiplyFold64(uint64_t lhs, uint64_t rhs) {
+      Hash128 const product = multiply128(lhs, rhs);
+      return product.low ^ product.high;
+    }
+
+    inline uint64_t xorShift(uint64_t value, int bits) {
+      return value ^ (value >> bits);
+    }
+
+    /// A fast avalanche, for values that are already partially mixed.
+    inline uint64_t avalanche(uint64_t value) {
+      value = xorShift(value, 37);
+      value *= PrimeMx1;
+      return xorShift(value, 32);
+    }
+
+    /// The XXH64 avalanche.
+    inline uint64_t avalanche64(uint64_t value) {
+      value ^= value >> 33;
+      value *= Prime64_2;
+      value ^= value >> 29;
+      value *= Prime64_3;
+      value ^= value >> 32;
+      return value;
+    }
+
+    inline uint64_t mix16(uint8_t const * pInput, uint8_t const * pSecret, uint64_t seed) {
+      return multiplyFold64(load64(pInput) ^ (load64(pSecret) + seed), load64(pInput + 8) ^ (load64(pSecret + 8) - seed));
+    }
+
+    inline Hash128 mix32(Hash128 acc, uint8_t const * pInput1, uint8_t const * pInput2, uint8_t const * pSecret, uint64_t seed) {
+      acc.low += mix16(pInput1, pSecret, seed);
+      acc.low ^= load64(pInput2) + load64(pInput2 + 8);
+      acc.high += mix16(pInput2, pSecret + 16, seed);
+      acc.high ^= load64(pInput1) + load64(pInput1 + 8);
+      return acc;
+    }
+
+    Hash128 hash1To3(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      uint32_t const combinedLow  = (uint32_t(pInput[0]) << 16) | (uint32_t(pInput[size >> 1]) << 24) | uint32_t(pInput[size - 1]) | (uint32_t(size) << 8);
+      uint32_t const combinedHigh = rotl32(swap32(combinedLow), 13);
+      uint64_t const flipLow      = (load32(pSecret) ^ load32(pSecret + 4)) + seed;
+      uint64_t const flipHigh     = (load32(pSecret + 8) ^ load32(pSecret + 12)) - seed;
+      return {avalanche64(combinedLow ^ flipLow), avalanche64(combinedHigh ^ flipHigh)};
+    }
+
+    Hash128 hash4To8(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      seed ^= uint64_t(swap32(uint32_t(seed))) << 32;
+      uint64_t const input = load32(pInput) + (uint64_t(load32(pInput + size - 4)) << 32);
+      uint64_t const flip  = (load64(pSecret + 16) ^ load64(pSecret + 24)) + seed;
+
+      // The size is shifted so the multiplier stays odd.
+      Hash128 result = multiply128(input ^ flip, Prime64_1 + (uint64_t(size) << 2));
+      result.high += result.low << 1;
+      result.low ^= result.high >> 3;
+      result.low = xorShift(result.low, 35);
+      result.low *= PrimeMx2;
+      result.low  = xorShift(result.low, 28);
+      result.high = avalanche(result.high);
+      return result;
+    }
+
+    Hash128 hash9To16(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      uint64_t const flipLow   = (load64(pSecret + 32) ^ load64(pSecret + 40)) - seed;
+      uint64_t const flipHigh  = (load64(pSecret + 48) ^ load64(pSecret + 56)) + seed;
+      uint64_t const inputLow  = load64(pInput);
+      uint64_t const inputHigh = load64(pInput + size - 8) ^ flipHigh;
+
+      Hash128 mixed = multiply128(inputLow ^ load64(pInput + size - 8) ^ flipLow, Prime64_1);
+      mixed.low += uint64_t(size - 1) << 54;
+      mixed.high += inputHigh + uint64_t(uint32_t(inputHigh)) * (Prime32_2 - 1);
+      mixed.low ^= swap64(mixed.high);
+
+      Hash128 result = multiply128(mixed.low, Prime64_2);
+      result.high += mixed.high * Prime64_2;
+      return {avalanche(result.low), avalanche(result.high)};
+    }
+
+    Hash128 hash0To16(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      if (size > 8)
+        return hash9To16(pInput, size, pSecret, seed);
+      if (size >= 4)
+        return hash4To8(pInput, size, pSecret, seed);
+      if (size > 0)
+        return hash1To3(pInput, size, pSecret, seed);
+      return {avalanche64(seed ^ load64(pSecret + 64) ^ load64(pSecret + 72)), avalanche64(seed ^ load64(pSecret + 80) ^ load64(pSecret + 88))};
+    }
+
+    Hash128 finishMid(Hash128 acc, int64_t size, uint64_t seed) {
+      Hash128 result;
+      result.low  = avalanche(acc.low + acc.high);
+      result.high = 0 - avalanche(acc.low * Prime64_1 + acc.high * Prime64_4 + (uint64_t(size) - seed) * Prime64_2);
+      return result;
+    }
+
+    Hash128 hash17To128(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      Hash128 acc = {uint64_t(size) * Prime64_1, 0};
+      if (size > 32) {
+        if (size > 64) {
+          if (size > 96)
+            acc = mix32(acc, pInput + 48, pInput + size - 64, pSecret + 96, seed);
+          acc = mix32(acc, pInput + 32, pInput + size - 48, pSecret + 64, seed);
+        }
+        acc = mix32(acc, pInput + 16, pInput + size - 32, pSecret + 32, seed);
+      }
+      acc = mix32(acc, pInput, pInput + size - 16, pSecret, seed);
+      return finishMid(acc, size, seed);
+    }
+
+    Hash128 hash129To240(uint8_t const * pInput, int64_t size, uint8_t const * pSecret, uint64_t seed) {
+      Hash128 acc = {uint64_t(size) * Prime64_1, 0};
+      for (int64_t i = 32; i < 160; i += 32)
+        acc = mix32(acc, pInput + i - 32, pInput + i - 16, pSecret + i - 32, seed);
+      acc.low  = avalanche(acc.low);
+      acc.high = avalanche(acc.high);
+      for (int64_t i = 160; i <= size; i += 32)
+        acc = mix32(acc, pInput + i - 32, pInput + i - 16, pSecret + MidSizeStart + i - 160, seed);
+      acc = mix32(acc, pInput + size - 16, pInput + size - 32, pSecret + SecretSizeMin - MidSizeLast - 16, 0 - seed);
+      return finishMid(acc, size, seed);
+    }
+
+    inline void accumulateStripe(uint64_t * pAcc, uint8_t const * pInput, uint8_t const * pSecret) {
+      for (int64_t lane = 0; lane < 8; ++lane) {
+        uint64_t const value = load64(pInput + lane * 8);
+        uint64_t const keyed = value ^ load64(pSecret + lane * 8);
+        pAcc[lane ^ 1] += value;
+        pAcc[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+      }
+    }
+
+    inline void accumulate(uint64_t * pAcc, uint8_t const * pInput, uint8_t const * pSecret, int64_t stripes) {
+      for (int64_t i = 0; i < stripes; ++i)
+        accumulateStripe(pAcc, pInput + i * StripeSize, pSecret + i * SecretConsumeRate);
+    }
+
+    inline void scramble(uint64_t * pAcc, uint8_t const * pSecret) {
+      for (int64_t lane = 0; lane < 8; ++lane)
+        pAcc[lane] = (xorShift(pAcc[lane], 47) ^ load64(pSecret + lane * 8)) * Prime32_1;
+    }
+
+    inline void initAccumulators(uint64_t * pAcc) {
+      uint64_t const initial[8] = {Prime32_3, Prime64_1, Prime64_2, Prime64_3, Prime64_4, Prime32_2, Prime64_5, Prime32_1};
+      memcpy(pAcc, initial, sizeof(initial));
+    }
+
+    uint64_t mergeAccumulators(uint64_t const * pAcc, uint8_t const * pSecret, uint64_t start) {
+      uint64_t result = start;
+      for (int64_t i = 0; i < 4; ++i)
+        result += multiplyFold64(pAcc[2 * i] ^ load64(pSecret + 16 * i), pAcc[2 * i + 1] ^ load64(pSecret + 16 * i + 8));
+      return avalanche(result);
+    }
+
+    Hash128 mergeLong(uint64_t const * pAcc, uint8_t const * pSecret, int64_t size) {
+      Hash128 result;
+      result.low  = mergeAccumulators(pAcc, pSecret + MergeStart, uint64_t(size) * Prime64_1);
+      result.high = mergeAccumulators(pAcc, pSecret + SecretSize - 64 - MergeStart, ~(uint64_t(size) * Prime64_2));
+      return result;
+    }
+
+    /// Derive the secret used to hash long inputs with a seed.
+    void initSecret(uint8_t * pSecret, uint64_t seed) {
+      for (int64_t i = 0; i < SecretSize; i += 16) {
+        store64(pSecret + i, load64(DefaultSecret + i) + seed);
+        store64(pSecret + i + 8, load64(DefaultSecret + i + 8) - seed);
+      }
+    }
+
+    Hash128 hashLong(uint8_t const * pInput, int64_t size, uint8_t const * pSecret) {
+      uint64_t acc[8];
+      initAccumulators(acc);
+
+      int64_t const blocks = (size - 1) / BlockSize;
+      for (int64_t i = 0; i < blocks; ++i) {
+        accumulate(acc, pInput + i * BlockSize, pSecret, StripesPerBlock);
+        scramble(acc, pSecret + SecretSize - StripeSize);
+      }
+
+      int64_t const stripes = ((size - 1) - BlockSize * blocks) / StripeSize;
+      accumulate(acc, pInput + blocks * BlockSize, pSecret, stripes);
+      accumulateStripe(acc, pInput + size - StripeSize, pSecret + SecretSize - StripeSize - LastStripeStart);
+      return mergeLong(acc, pSecret, size);
+    }
+
+    /// Accumulate `stripes` stripes, scrambling at the end of each block.
+    /// @param pStripesSoFar The number of stripes accumulated in the current block. Updated to include the new stripes.
+    uint8_t const * consumeStripes(uint64_t * pAcc, int64_t * pStripesSoFar, uint8_t const * pInput, int64_t stripes, uint8_t const * pSecret) {
+      uint8_t const * pBlockSecret = pSecret + *pStripesSoFar * SecretConsumeRate;
+      if (stripes >= StripesPerBlock - *pStripesSoFar) {
+        int64_t count = StripesPerBlock - *pStripesSoFar;
+        do {
+          accumulate(pAcc, pInput, pBlockSecret, count);
+          scramble(pAcc, pSecret + SecretSize - StripeSize);
+          pInput += count * StripeSize;
+          stripes -= count;
+          count          = StripesPerBlock;
+          pBlockSecret   = pSecret;
+          *pStripesSoFar = 0;
+        } while (stripes >= StripesPerBlock);
+      }
+
+      if (stripes > 0) {
+        accumulate(pAcc, pInput, pBlockSecret, stripes);
+        pInput += stripes * StripeSize;
+        *pStripesSoFar += stripes;
+      }
+      return pInput;
+    }
+  } // namespace
+
+  String Hash128::toString() const {
+    char const digits[] = "0123456789abcdef";
+    String     result;
+    result.resize(32);
+    for (int64_t i = 0; i < 16; ++i) {
+      result[i]      = digits[(high >> (60 - i * 4)) & 15];
+      result[16 + i] = digits[(low >> (60 - i * 4)) & 15];
+    }
+    return result;
+  }
+
+  Hash128 hash128(void const * pData, int64_t size, uint64_t seed) {
+    uint8_t const * pInput = (uint8_t const *)pData;
+    if (size <= 16)
+      return hash0To16(pInput, size, DefaultSecret, seed);
+    if (size <= 128)
+      return hash17To128(pInput, size, DefaultSecret, seed);
+    if (size <= MidSizeMax)
+      return hash129To240(pInput, size, DefaultSecret, seed);
+    if (seed == 0)
+      return hashLong(pInput, size, DefaultSecret);
+
+    uint8_t secret[SecretSize];
+    initSecret(secret, seed);
+    return hashLong(pInput, size, secret);
+  }
+
+  Hash128 hashStream(Stream * pStream, uint64_t seed) {
+    // Hash streams that are in memory in place.
+    uint8_t const * pData  = pStream->data();
+    int64_t const   length = pStream->length();
+    int64_t const   offset = pStream->tell();
+    if (pData != nullptr && length >= offset && offset >= 0) {
+      pStream->seek(length, SeekOrigin_Start);
+      return hash128(pData + offset, length - offset, seed);
+    }
+
+    HashWriter      writer(seed);
+    Vector<uint8_t> buffer;
+    buffer.resize(64 * 1024);
+    for (int64_t read = pStream->read(buffer.data(), buffer.size()); read > 0; read = pStream->read(buffer.data(), buffer.size()))
+      writer.write(buffer.data(), read);
+    return writer.digest();
+  }
+
+  HashWriter::HashWriter(uint64_t seed) {
+    reset(seed);
+  }
+
+  void HashWriter::reset(uint64_t seed) {
+    initAccumulators(m_acc);
+    initSecret(m_secret, seed);
+    m_buffered = 0;
+    m_stripes  = 0;
+    m_length   = 0;
+    m_seed     = seed;
+  }
+
+  Hash128 HashWriter::digest() const {
+    if (m_length <= MidSizeMax)
+      return hash128(m_buffer, m_length, m_seed);
+
+    uint64_t acc[8];
+    memcpy(acc, m_acc, sizeof(acc));
+
+    // The last stripe overlaps the previous one if fewer than a stripe is buffered.
+    // The buffer always ends with the last stripe consumed.
+    uint8_t         lastStripe[StripeSize];
+    uint8_t const * pLastStripe = lastStripe;
+    if (m_buffered >= StripeSize) {
+      int64_t stripes = m_stripes;
+      consumeStripes(acc, &stripes, m_buffer, (m_buffered - 1) / StripeSize, m_secret);
+      pLastStripe = m_buffer + m_buffered - StripeSize;
+    } else {
+      int64_t const catchUp = StripeSize - m_buffered;
+      memcpy(lastStripe, m_buffer + BufferSize - catchUp, catchUp);
+      memcpy(lastStripe + catchUp, m_buffer, m_buffered);
+    }
+
+    accumulateStripe(acc, pLastStripe, m_secret + SecretSize - StripeSize - LastStripeStart);
+    return mergeLong(acc, m_secret, m_length);
+  }
+
+  bool HashWriter::readable() const {
+    return false;
+  }
+
+  bool HashWriter::writeable() const {
+    return true;
+  }
+
+  bool HashWriter::seekable() const {
+    return false;
+  }
+
+  bool HashWriter::eof() const {
+    return false;
+  }
+
+  int64_t HashWriter::tell() const {
+    return m_length;
+  }
+
+  int64_t HashWriter::write(void const * data, int64_t length) {
+    if (length <= 0)
+      return 0;
+
+    uint8_t const *       pInput = (uint8_t const *)data;
+    uint8_t const * const pEnd   = pInput + length;
+    m_length += length;
+
+    if (length <= BufferSize - m_buffered) {
+      memcpy(m_buffer + m_buffered, pInput, length);
+      m_buffered += length;
+      return length;
+    }
+
+    // Keep at least one byte buffered, so the last stripe is always consumed by digest().
+    constexpr int64_t BufferStripes = BufferSize / StripeSize;
+    if (m_buffered > 0) {
+      int64_t const fill = BufferSize - m_buffered;
+      memcpy(m_buffer + m_buffered, pInput, fill);
+      pInput += fill;
+      consumeStripes(m_acc, &m_stripes, m_buffer, BufferStripes, m_secret);
+      m_buffered = 0;
+    }
+
+    if (pEnd - pInput > BufferSize) {
+      pInput = consumeStripes(m_acc, &m_stripes, pInput, (pEnd - 1 - pInput) / StripeSize, m_secret);
+      memcpy(m_buffer + BufferSize - StripeSize, pInput - StripeSize, StripeSize);
+    }
+
+    memcpy(m_buffer, pInput, pEnd - pInput);
+    m_buffered = pEnd - pInput;
+    return length;
+  }
+} // namespace bfc
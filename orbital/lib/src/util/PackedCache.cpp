@@ -0,0 +1,507 @@
+#include "PackedCache.h"
+#include "util/Compression.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace bfc {
+  namespace impl {
+    namespace {
+      constexpr uint32_t JournalMagic   = 0x4A434642; // "BFCJ"
+      constexpr int64_t  JournalVersion = 3;
+
+      /// Records larger than this are treated as corrupt.
+      constexpr uint32_t MaxRecordSize = 64 * 1024;
+
+      enum JournalOp : uint8_t {
+        JournalOp_Put    = 1,
+        JournalOp_Remove = 2,
+        JournalOp_Blob   = 3,
+      };
+
+      int64_t currentTime() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      }
+
+      bool writeRecord(Stream * pJournal, MemoryStream const & record) {
+        Vector<uint8_t> const & payload = record.storage();
+        return pJournal->write(uint32_t(payload.size()))
+          && pJournal->write(hash128(payload.data(), payload.size()).low)
+          && pJournal->write(payload.data(), payload.size()) == payload.size();
+      }
+
+      constexpr FileMode AppendMode = FileMode(FileMode_Append | FileMode_Read | FileMode_Binary);
+    } // namespace
+
+    PackedCache::PackedCache(Filename const & path, CacheOptions const & options)
+      : m_path(path)
+      , m_options(options) {
+      std::filesystem::create_directories((m_path / "segments").c_str());
+
+      File journal;
+      if (journal.open(m_path / "index", FileMode_ReadBinary))
+        replay(&journal);
+      journal.close();
+
+      // Measure the segments on disk.
+      int64_t lastSegment = -1;
+      for (auto & file : std::filesystem::directory_iterator((m_path / "segments").c_str())) {
+        std::filesystem::path const name = file.path();
+        std::string const           stem = name.stem().string();
+        char *                      pEnd = nullptr;
+        int64_t const               id   = std::strtoll(stem.c_str(), &pEnd, 10);
+        if (name.extension() != ".seg" || pEnd == stem.c_str() || *pEnd != 0)
+          continue;
+
+        Segment segment;
+        segment.size = (int64_t)file.file_size();
+        m_segments.addOrSet(id, segment);
+        lastSegment = std::max(lastSegment, id);
+      }
+
+      // Drop entries whose data was lost.
+      Vector<String> lost;
+      for (auto & [id, item] : m_items) {
+        Blob *          pBlob    = m_blobs.tryGet(item.content);
+        Segment const * pSegment = pBlob != nullptr ? m_segments.tryGet(pBlob->segment) : nullptr;
+        if (pSegment == nullptr || pBlob->offset < 0 || pBlob->size < 0 || pBlob->offset + pBlob->size > pSegment->size) {
+          lost.pushBack(id);
+        } else {
+          ++pBlob->refs;
+          m_lastAccess = std::max(m_lastAccess, item.lastAccess);
+        }
+      }
+      for (String const & id : lost)
+        m_items.erase(id);
+
+      // Data that no entry refers to is dead space.
+      Vector<Hash128> unused;
+      for (auto & [content, blob] : m_blobs) {
+        if (blob.refs == 0) {
+          unused.pushBack(content);
+        } else {
+          m_segments.tryGet(blob.segment)->liveBytes += blob.size;
+          m_liveBytes += blob.size;
+        }
+      }
+      for (Hash128 const & content : unused)
+        m_blobs.erase(content);
+
+      // Continue appending to the last segment if it has space.
+      m_activeSegment = lastSegment;
+      if (lastSegment < 0 || m_segments.tryGet(lastSegment)->size >= m_options.segmentBytes)
+        startSegment_unlocked();
+      else
+        m_active.open(segmentPath(lastSegment), AppendMode);
+
+      std::scoped_lock lock(m_lock);
+      writeSnapshot_unlocked();
+      evict_unlocked();
+      scheduleCompaction_unlocked();
+    }
+
+    PackedCache::~PackedCache() {
+      if (m_compaction.valid())
+        m_compaction.wait();
+
+      // Rewrite the index so the access times used for eviction are kept.
+      std::scoped_lock lock(m_lock);
+      writeSnapshot_unlocked();
+      m_journal.close();
+      m_active.close();
+    }
+
+    bool PackedCache::contains(StringView const & identifier) const {
+      std::scoped_lock lock(m_lock);
+      return m_items.contains(identifier);
+    }
+
+    bool PackedCache::checkout(StringView const & identifier, Cache::Entry * pEntry) {
+      Item item;
+      Blob blob;
+      {
+        std::scoped_lock lock(m_lock);
+        Item * pItem = m_items.tryGet(identifier);
+        if (pItem == nullptr)
+          return false;
+
+        pItem->lastAccess = accessTime_unlocked();
+        item              = *pItem;
+        blob              = *m_blobs.tryGet(item.content);
+        ++m_segments.tryGet(blob.segment)->readers;
+      }
+
+      // Read the entry into memory, so the segment can be compacted while the entry is in use.
+      Vector<uint8_t> data;
+      data.resize(blob.size);
+      File       file;
+      bool const success = file.open(segmentPath(blob.segment), FileMode_ReadBinary)
+        && file.seek(blob.offset, SeekOrigin_Start)
+        && file.read(data.data(), blob.size) == blob.size;
+      file.close();
+
+      {
+        std::scoped_lock lock(m_lock);
+        release_unlocked(blob.segment);
+      }
+
+      if (!success)
+        return false;
+
+      pEntry->timestamp = item.timestamp;
+      pEntry->version   = item.version;
+      pEntry->flags     = item.flags;
+      pEntry->pStream   = NewRef<MemoryStream>(std::move(data));
+      pEntry->pCodec    = nullptr;
+      if ((item.flags & CacheEntryFlags_Compressed) != 0)
+        pEntry->pCodec = NewRef<DecompressingReader>(pEntry->pStream.get());
+      return true;
+    }
+
+    Cache::Entry PackedCache::create(int64_t flags) const {
+      Cache::Entry entry;
+      entry.uuid    = UUID::New();
+      entry.flags   = flags;
+      entry.pStream = NewRef<MemoryStream>();
+      if ((flags & CacheEntryFlags_Compressed) != 0)
+        entry.pCodec = NewRef<CompressedWriter>(entry.pStream.get());
+      return entry;
+    }
+
+    void PackedCache::commit(StringView const & identifier, Cache::Entry * pEntry) {
+      // Entries are created by create(), so the data is in a MemoryStream.
+      pEntry->pCodec                = nullptr;
+      Ref<MemoryStream> const pData = std::static_pointer_cast<MemoryStream>(pEntry->pStream);
+      pEntry->close();
+      if (pData == nullptr)
+        return;
+
+      Item item;
+      item.timestamp  = pEntry->timestamp;
+      item.version    = pEntry->version;
+      item.flags      = pEntry->flags;
+
+      String const            id    = identifier;
+      Vector<uint8_t> const & bytes = pData->storage();
+      item.content                  = hash128(bytes.data(), bytes.size());
+
+      std::scoped_lock lock(m_lock);
+      if (!m_blobs.contains(item.content)) {
+        Blob blob;
+        if (!append_unlocked(bytes.data(), bytes.size(), &blob))
+          return;
+        m_blobs.add(item.content, blob);
+        writeBlob(&m_journal, item.content, blob);
+      }
+
+      // Reference the data before the replaced entry is erased, in case they have the same content.
+      ++m_blobs.tryGet(item.content)->refs;
+      item.lastAccess = accessTime_unlocked();
+      if (m_items.contains(id))
+        erase_unlocked(id);
+      m_items.addOrSet(id, item);
+      writePut(&m_journal, id, item);
+      m_journal.flush();
+
+      evict_unlocked();
+      scheduleCompaction_unlocked();
+    }
+
+    void PackedCache::remove(StringView const & identifier) {
+      String const     id = identifier;
+      std::scoped_lock lock(m_lock);
+      if (!m_items.contains(id))
+        return;
+
+      erase_unlocked(id);
+      writeRemove(&m_journal, id);
+      m_journal.flush();
+      scheduleCompaction_unlocked();
+    }
+
+    int64_t PackedCache::size() const {
+      std::scoped_lock lock(m_lock);
+      return m_liveBytes;
+    }
+
+    void PackedCache::compact() {
+      while (true) {
+        std::shared_future<void> pending;
+        {
+          std::scoped_lock lock(m_lock);
+          if (!m_compacting) {
+            m_compacting = true;
+            break;
+          }
+          pending = m_compaction;
+        }
+        pending.wait();
+      }
+
+      runCompaction();
+    }
+
+    void PackedCache::runCompaction() {
+      Vector<int64_t> victims;
+      {
+        std::scoped_lock lock(m_lock);
+        for (auto & [id, segment] : m_segments)
+          if (needsCompaction_unlocked(id))
+            victims.pushBack(id);
+      }
+
+      Vector<uint8_t> data;
+      for (int64_t segment : victims) {
+        Vector<Pair<Hash128, Blob>> moving;
+        {
+          std::scoped_lock lock(m_lock);
+          for (auto & [content, blob] : m_blobs)
+            if (blob.segment == segment)
+              moving.pushBack({content, blob});
+          ++m_segments.tryGet(segment)->readers;
+        }
+
+        File source;
+        source.open(segmentPath(segment), FileMode_ReadBinary);
+        for (Pair<Hash128, Blob> const & entry : moving) {
+          Blob const & blob = entry.second;
+          data.resize(blob.size);
+          if (!source.seek(blob.offset, SeekOrigin_Start) || source.read(data.data(), blob.size) != blob.size)
+            continue;
+
+          std::scoped_lock lock(m_lock);
+          Blob * pCurrent = m_blobs.tryGet(entry.first);
+          if (pCurrent == nullptr || pCurrent->segment != segment || pCurrent->offset != blob.offset)
+            continue; // The data was removed while it was read
+
+          Blob moved = *pCurrent;
+          if (!append_unlocked(data.data(), data.size(), &moved))
+            continue;
+
+          m_segments.tryGet(segment)->liveBytes -= blob.size;
+          m_liveBytes -= blob.size;
+          *pCurrent = moved;
+          writeBlob(&m_journal, entry.first, moved);
+        }
+        source.close();
+
+        std::scoped_lock lock(m_lock);
+        m_journal.flush();
+        Segment * pSegment = m_segments.tryGet(segment);
+        pSegment->retired  = pSegment->liveBytes == 0;
+        release_unlocked(segment);
+      }
+
+      std::scoped_lock lock(m_lock);
+      writeSnapshot_unlocked();
+      m_compacting = false;
+    }
+
+    void PackedCache::scheduleCompaction_unlocked() {
+      if (m_compacting)
+        return;
+
+      bool needed = false;
+      for (auto & [id, segment] : m_segments)
+        needed |= needsCompaction_unlocked(id);
+      if (!needed)
+        return;
+
+      m_compacting = true;
+      m_compaction = async([this]() { runCompaction(); }).share();
+
+      // The task can't finish while the lock is held, unless it was never queued.
+      if (m_compaction.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        m_compacting = false;
+    }
+
+    int64_t PackedCache::accessTime_unlocked() {
+      // Keep access times unique so the eviction order is well defined.
+      m_lastAccess = std::max(m_lastAccess + 1, currentTime());
+      return m_lastAccess;
+    }
+
+    bool PackedCache::needsCompaction_unlocked(int64_t segment) const {
+      Segment const * pSegment = m_segments.tryGet(segment);
+      if (pSegment == nullptr || pSegment->retired || segment == m_activeSegment)
+        return false;
+      return double(pSegment->size - pSegment->liveBytes) >= double(pSegment->size) * m_options.compactThreshold;
+    }
+
+    bool PackedCache::append_unlocked(uint8_t const * pData, int64_t size, Blob * pBlob) {
+      Segment * pSegment = m_segments.tryGet(m_activeSegment);
+      if (pSegment->size > 0 && pSegment->size + size > m_options.segmentBytes) {
+        startSegment_unlocked();
+        pSegment = m_segments.tryGet(m_activeSegment);
+      }
+
+      int64_t const written = m_active.write(pData, size);
+      bool const    flushed = m_active.flush();
+      pBlob->segment        = m_activeSegment;
+      pBlob->offset         = pSegment->size;
+      pBlob->size           = size;
+      pSegment->size += written;
+      if (written != size || !flushed)
+        return false;
+
+      pSegment->liveBytes += size;
+      m_liveBytes += size;
+      return true;
+    }
+
+    void PackedCache::startSegment_unlocked() {
+      m_active.close();
+      ++m_activeSegment;
+      m_segments.addOrSet(m_activeSegment, Segment{});
+      m_active.open(segmentPath(m_activeSegment), AppendMode);
+    }
+
+    void PackedCache::release_unlocked(int64_t segment) {
+      Segment * pSegment = m_segments.tryGet(segment);
+      if (--pSegment->readers > 0 || !pSegment->retired)
+        return;
+
+      std::error_code err;
+      std::filesystem::remove(segmentPath(segment).c_str(), err);
+      m_segments.erase(segment);
+    }
+
+    void PackedCache::erase_unlocked(String const & identifier) {
+      Hash128 const content = m_items.tryGet(identifier)->content;
+      Blob *        pBlob   = m_blobs.tryGet(content);
+      m_items.erase(identifier);
+      if (--pBlob->refs > 0)
+        return;
+
+      m_segments.tryGet(pBlob->segment)->liveBytes -= pBlob->size;
+      m_liveBytes -= pBlob->size;
+      m_blobs.erase(content);
+    }
+
+    void PackedCache::evict_unlocked() {
+      bool const overLimit = m_options.maxBytes > 0 && m_liveBytes > m_options.maxBytes;
+      if (!overLimit && m_options.maxAge.length <= 0)
+        return;
+
+      // Evict the least recently used entries first.
+      Vector<Pair<int64_t, String>> candidates;
+      for (auto & [id, item] : m_items)
+        candidates.pushBack({item.lastAccess, id});
+      std::sort(candidates.begin(), candidates.end(), [](auto const & a, auto const & b) { return a.first < b.first; });
+
+      int64_t const now = currentTime();
+      for (Pair<int64_t, String> const & candidate : candidates) {
+        bool const expired = m_options.maxAge.length > 0 && now - candidate.first > m_options.maxAge.length;
+        if (!expired && (m_options.maxBytes <= 0 || m_liveBytes <= m_options.maxBytes))
+          break;
+
+        erase_unlocked(candidate.second);
+        writeRemove(&m_journal, candidate.second);
+      }
+      m_journal.flush();
+    }
+
+    bool PackedCache::writePut(Stream * pJournal, String const & identifier, Item const & item) {
+      MemoryStream record;
+      record.write(uint8_t(JournalOp_Put));
+      record.write(identifier);
+      record.write(item);
+      return writeRecord(pJournal, record);
+    }
+
+    bool PackedCache::writeRemove(Stream * pJournal, String const & identifier) {
+      MemoryStream record;
+      record.write(uint8_t(JournalOp_Remove));
+      record.write(identifier);
+      return writeRecord(pJournal, record);
+    }
+
+    bool PackedCache::writeBlob(Stream * pJournal, Hash128 const & content, Blob const & blob) {
+      MemoryStream record;
+      record.write(uint8_t(JournalOp_Blob));
+      record.write(content);
+      record.write(blob);
+      return writeRecord(pJournal, record);
+    }
+
+    bool PackedCache::writeSnapshot_unlocked() {
+      // Write the snapshot next to the index, then replace it, so a crash leaves one or the other intact.
+      Filename const snapshotPath = m_path / "index.tmp";
+      File           snapshot;
+      if (!snapshot.open(snapshotPath, FileMode_WriteBinary))
+        return false;
+
+      bool success = snapshot.write(JournalMagic) && snapshot.write(JournalVersion);
+      for (auto & [content, blob] : m_blobs)
+        success &= writeBlob(&snapshot, content, blob);
+      for (auto & [id, item] : m_items)
+        success &= writePut(&snapshot, id, item);
+      success &= snapshot.flush();
+      snapshot.close();
+      if (!success)
+        return false;
+
+      std::error_code err;
+      m_journal.close();
+      std::filesystem::rename(snapshotPath.c_str(), (m_path / "index").c_str(), err);
+      m_journal.open(m_path / "index", AppendMode);
+      return !err;
+    }
+
+    void PackedCache::replay(File * pJournal) {
+      uint32_t magic   = 0;
+      int64_t  version = 0;
+      if (pJournal->read(&magic) != 1 || magic != JournalMagic || pJournal->read(&version) != 1 || version != JournalVersion)
+        return;
+
+      // Stop at the first record that is incomplete or corrupt. Anything after it was written after a crash.
+      Vector<uint8_t> payload;
+      while (true) {
+        uint32_t size = 0;
+        uint64_t hash = 0;
+        if (pJournal->read(&size) != 1 || pJournal->read(&hash) != 1 || size > MaxRecordSize)
+          return;
+
+        payload.resize(size);
+        if (pJournal->read(payload.data(), size) != size || hash128(payload.data(), size).low != hash)
+          return;
+
+        MemoryStream record(payload);
+        uint8_t      op = 0;
+        if (record.read(&op) != 1)
+          return;
+
+        if (op == JournalOp_Blob) {
+          Hash128 content;
+          Blob    blob;
+          if (record.read(&content) != 1 || record.read(&blob) != 1)
+            return;
+          blob.refs = 0;
+          m_blobs.addOrSet(content, blob);
+          continue;
+        }
+
+        String id;
+        if (record.read(&id) != 1)
+          return;
+
+        if (op == JournalOp_Put) {
+          Item item;
+          if (record.read(&item) != 1)
+            return;
+          m_items.addOrSet(id, item);
+        } else if (op == JournalOp_Remove) {
+          m_items.erase(id);
+        } else {
+          return;
+        }
+      }
+    }
+
+    Filename PackedCache::segmentPath(int64_t segment) const {
+      return m_path / "segments" / (toString(segment) + ".seg");
+    }
+  } // namespace impl
+} // namespace bfc
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "util/Cache.h"
+#include "util/Hash.h"
+
+#include <future>
+
+namespace bfc {
+  namespace impl {
+    /// Cache storage that appends entries to segment files.
+    /// Entry data is stored once per distinct content. Entries with identical data share the stored copy.
+    /// The location of each entry is recorded in an index journal. Records are checksummed, so a record
+    /// torn by a crash is discarded when the journal is replayed. The journal is rewritten as a snapshot
+    /// of the live entries when the cache is opened, compacted, or closed.
+    class PackedCache {
+    public:
+      PackedCache(Filename const & path, CacheOptions const & options);
+      ~PackedCache();
+
+      bool contains(StringView const & identifier) const;
+
+      /// Read an entry into memory. Marks the entry as used for eviction.
+      bool checkout(StringView const & identifier, Cache::Entry * pEntry);
+
+      /// Create an entry that is written to memory until it is committed.
+      Cache::Entry create(int64_t flags) const;
+
+      /// Append the entry to the active segment, unless the same data is already stored.
+      /// Then evict entries if the cache is over its limits.
+      void commit(StringView const & identifier, Cache::Entry * pEntry);
+
+      void remove(StringView const & identifier);
+
+      int64_t size() const;
+
+      /// Move the live entries out of segments that are mostly dead space, and delete the segments.
+      /// Waits for any compaction running in the background first.
+      void compact();
+
+    private:
+      struct Item {
+        Hash128 content;        ///< Hash of the stored data.
+        int64_t timestamp  = 0;
+        int64_t version    = 0;
+        int64_t flags      = 0;
+        int64_t lastAccess = 0; ///< Microseconds since the system clock epoch.
+      };
+
+      /// Data stored in a segment, shared by the items with the same content.
+      struct Blob {
+        int64_t segment = 0;
+        int64_t offset  = 0;
+        int64_t size    = 0;
+        int64_t refs    = 0; ///< Number of items that store this data. Counted when the journal is replayed.
+      };
+
+      struct Segment {
+        int64_t size      = 0;
+        int64_t liveBytes = 0;
+        int64_t readers   = 0;     ///< Number of threads reading from the segment.
+        bool    retired   = false; ///< The segment is deleted once there are no readers.
+      };
+
+      void runCompaction();
+      void scheduleCompaction_unlocked();
+      bool needsCompaction_unlocked(int64_t segment) const;
+      int64_t accessTime_unlocked();
+
+      bool append_unlocked(uint8_t const * pData, int64_t size, Blob * pBlob);
+      void startSegment_unlocked();
+      void release_unlocked(int64_t segment);
+      void erase_unlocked(String const & identifier);
+      void evict_unlocked();
+
+      static bool writePut(Stream * pJournal, String const & identifier, Item const & item);
+      static bool writeRemove(Stream * pJournal, String const & identifier);
+      static bool writeBlob(Stream * pJournal, Hash128 const & content, Blob const & blob);
+      bool        writeSnapshot_unlocked();
+      void replay(File * pJournal);
+
+      Filename segmentPath(int64_t segment) const;
+
+      Filename     m_path;
+      CacheOptions m_options;
+
+      mutable std::mutex m_lock;
+
+      Map<String, Item>     m_items;
+      Map<Hash128, Blob>    m_blobs;
+      Map<int64_t, Segment> m_segments;
+      int64_t               m_liveBytes     = 0;
+      int64_t               m_activeSegment = 0;
+      int64_t               m_lastAccess    = 0;
+      File                  m_active;  ///< Appends to the active segment.
+      File                  m_journal; ///< Appends to the index.
+
+      std::shared_future<void> m_compaction;
+      bool                     m_compacting = false;
+    };
+  } // namespace impl
+} // namespace bfc
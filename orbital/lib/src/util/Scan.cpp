@@ -1,108 +1,504 @@
 #include "util/Scan.h"
+#include "ScanPowers.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace bfc {
-  constexpr double powerOf5Table[20] = {0.000000512, 0.00000256, 0.0000128, 0.000064, 0.00032, 0.0016,  0.008,   0.04,     0.2,       1.0,
-                                        5.0,         25.0,       125.0,     625.0,    3125.0,  15625.0, 78125.0, 390625.0, 1953125.0, 9765625.0};
+  namespace {
+    constexpr int64_t MaxMantissaDigits = 19; ///< Digits that always fit in a uint64_t.
 
-  int64_t ScanIntegerFast(const char * begin, const char * end, int64_t * pLen) {
-    const char * start = begin;
-    int64_t      val   = 0;
-    int          neg   = 0;
+    bool isSpace(char c) {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
 
-    while (begin < end && whitespace.find(*begin) != npos) // Skip whitespace
-      ++begin;
+    bool isDigit(char c) {
+      return c >= '0' && c <= '9';
+    }
 
-    if (begin >= end || ((begin[0] < 48 || begin[0] > 57) && begin[0] != '-')) {
-      if (pLen != nullptr) {
-        *pLen = 0;
+    char const * skipSpace(char const * it, char const * end) {
+      while (it < end && isSpace(*it))
+        ++it;
+      return it;
+    }
+
+    // SWAR digit parsing. Loads are little endian, which holds for every platform we target.
+    uint64_t loadEight(char const * it) {
+      uint64_t val;
+      memcpy(&val, it, sizeof(val));
+      return val;
+    }
+
+    bool isEightDigits(uint64_t val) {
+      return !(((val + 0x4646464646464646ull) | (val - 0x3030303030303030ull)) & 0x8080808080808080ull);
+    }
+
+    uint32_t parseEightDigits(uint64_t val) {
+      constexpr uint64_t mask = 0x000000FF000000FFull;
+      constexpr uint64_t mul1 = 0x000F424000000064ull; // 100 + (1000000ULL << 32)
+      constexpr uint64_t mul2 = 0x0000271000000001ull; // 1 + (10000ULL << 32)
+      val -= 0x3030303030303030ull;
+      val = (val * 10) + (val >> 8);
+      val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+      return uint32_t(val);
+    }
+
+    /// Accumulate digits into value, 8 at a time where possible. Overflow wraps.
+    char const * parseDigits(char const * it, char const * end, uint64_t * pValue) {
+      uint64_t value = *pValue;
+      while (end - it >= 8) {
+        const uint64_t eight = loadEight(it);
+        if (!isEightDigits(eight))
+          break;
+        value = value * 100000000 + parseEightDigits(eight);
+        it += 8;
       }
-      return 0;
+
+      for (; it < end && isDigit(*it); ++it)
+        value = value * 10 + uint64_t(*it - '0');
+
+      *pValue = value;
+      return it;
     }
 
-    if (begin[0] == '-') {
-      neg = 1;
-      ++begin;
+    struct UInt128 {
+      uint64_t low;
+      uint64_t high;
+    };
+
+    UInt128 multiply(uint64_t a, uint64_t b) {
+      const uint64_t aLo = uint32_t(a), aHi = a >> 32;
+      const uint64_t bLo = uint32_t(b), bHi = b >> 32;
+
+      const uint64_t lolo = aLo * bLo;
+      const uint64_t hilo = aHi * bLo;
+      const uint64_t lohi = aLo * bHi;
+      const uint64_t hihi = aHi * bHi;
+      const uint64_t mid  = (lolo >> 32) + uint32_t(hilo) + uint32_t(lohi);
+
+      UInt128 ret;
+      ret.low  = (mid << 32) | uint32_t(lolo);
+      ret.high = hihi + (hilo >> 32) + (lohi >> 32) + (mid >> 32);
+      return ret;
     }
 
-    for (; begin < end && begin[0] > 47 && begin[0] < 58; ++begin)
-      val = (val << 1) + (val << 3) + begin[0] - 48;
+    int32_t leadingZeros(uint64_t value) {
+      int32_t count = 0;
+      for (uint64_t bit = 1ull << 63; bit != 0 && (value & bit) == 0; bit >>= 1)
+        ++count;
+      return count;
+    }
 
-    if (pLen)
-      *pLen = begin - start;
+    // IEEE 754 binary64 layout.
+    constexpr int32_t MantissaBits    = 52;
+    constexpr int32_t MinimumExponent = -1023;
+    constexpr int32_t InfinitePower   = 0x7FF;
+
+    /// A binary floating point value with a biased exponent and an explicit mantissa.
+    struct BinaryFloat {
+      uint64_t mantissa = 0;
+      int32_t  power2   = 0;
+    };
+
+    double toDouble(BinaryFloat const & f, bool negative) {
+      uint64_t bits = f.mantissa | (uint64_t(f.power2) << MantissaBits) | (uint64_t(negative) << 63);
+      double   ret;
+      memcpy(&ret, &bits, sizeof(ret));
+      return ret;
+    }
 
-    return neg ? -val : val;
-  }
+    /// Convert w * 10^q to the nearest double using the Eisel-Lemire algorithm.
+    /// w must hold all significant digits of the number.
+    BinaryFloat eiselLemire(int64_t q, uint64_t w) {
+      BinaryFloat answer;
+      if (w == 0 || q < impl::PowersOfFiveMinExponent) {
+        return answer;
+      }
 
-  double ScanDoubleFast(const char * begin, const char * end, int64_t * pLen) {
-    const char * start = begin;
+      if (q > impl::PowersOfFiveMaxExponent) {
+        answer.power2 = InfinitePower;
+        return answer;
+      }
+
+      const int32_t lz = leadingZeros(w);
+      w <<= lz;
+
+      // Multiply by the 128 bit approximation of 5^q. The second word is only needed
+      // when the bits beyond the 55 we need could carry into them.
+      uint64_t const * pPower    = impl::PowersOfFive128[q - impl::PowersOfFiveMinExponent];
+      UInt128          product   = multiply(w, pPower[0]);
+      constexpr uint64_t precisionMask = ~0ull >> (MantissaBits + 3);
+      if ((product.high & precisionMask) == precisionMask) {
+        UInt128 second = multiply(w, pPower[1]);
+        product.low += second.high;
+        if (second.high > product.low)
+          ++product.high;
+      }
+
+      const int32_t upperBit = int32_t(product.high >> 63);
+      const int32_t shift    = upperBit + 64 - MantissaBits - 3;
+      answer.mantissa        = product.high >> shift;
+
+      // floor(log2(10^q)) + 63, without floating point.
+      const int32_t power = int32_t((((152170 + 65536) * q) >> 16) + 63);
+      answer.power2       = power + upperBit - lz - MinimumExponent;
+
+      if (answer.power2 <= 0) { // Subnormal
+        if (-answer.power2 + 1 >= 64) {
+          return BinaryFloat{};
+        }
+
+        answer.mantissa >>= -answer.power2 + 1;
+        answer.mantissa += (answer.mantissa & 1);
+        answer.mantissa >>= 1;
+        answer.power2 = answer.mantissa < (1ull << MantissaBits) ? 0 : 1;
+        return answer;
+      }
+
+      // Exactly halfway between two doubles. Round to even. This can only happen for small exponents.
+      if (product.low <= 1 && q >= -4 && q <= 23 && (answer.mantissa & 3) == 1) {
+        if ((answer.mantissa << shift) == product.high) {
+          answer.mantissa &= ~1ull;
+        }
+      }
+
+      answer.mantissa += (answer.mantissa & 1);
+      answer.mantissa >>= 1;
+      if (answer.mantissa >= (2ull << MantissaBits)) {
+        answer.mantissa = 1ull << MantissaBits;
+        ++answer.power2;
+      }
+
+      answer.mantissa &= ~(1ull << MantissaBits);
+      if (answer.power2 >= InfinitePower) {
+        answer.power2   = InfinitePower;
+        answer.mantissa = 0;
+      }
+      return answer;
+    }
+
+    /// Arbitrary precision decimal used when a number has too many digits for Eisel-Lemire.
+    /// The value is 0.digits * 10^decimalPoint.
+    struct BigDecimal {
+      static constexpr int32_t MaxDigits         = 768; ///< Enough digits to round any double exactly.
+      static constexpr int32_t DecimalPointRange = 2047;
+      static constexpr int32_t MaxShift          = 60;
+
+      int32_t numDigits    = 0;
+      int32_t decimalPoint = 0;
+      bool    truncated    = false;
+      uint8_t digits[MaxDigits + MaxShift]; ///< Extra space for the digits added by leftShift().
+
+      void pushDigit(char c) {
+        if (numDigits < MaxDigits)
+          digits[numDigits++] = uint8_t(c - '0');
+        else if (c != '0')
+          truncated = true;
+      }
 
-    while (begin < end && whitespace.find(*begin) != npos) // Skip whitespace
-      ++begin;
+      void trim() {
+        while (numDigits > 0 && digits[numDigits - 1] == 0)
+          --numDigits;
+      }
+
+      void clear() {
+        numDigits    = 0;
+        decimalPoint = 0;
+        truncated    = false;
+      }
+
+      /// Divide by 2^shift.
+      void rightShift(int32_t shift) {
+        int32_t  readIndex  = 0;
+        int32_t  writeIndex = 0;
+        uint64_t n          = 0;
+        while ((n >> shift) == 0) {
+          if (readIndex < numDigits) {
+            n = 10 * n + digits[readIndex++];
+          } else if (n == 0) {
+            return;
+          } else {
+            while ((n >> shift) == 0) {
+              n = 10 * n;
+              ++readIndex;
+            }
+            break;
+          }
+        }
+
+        decimalPoint -= readIndex - 1;
+        if (decimalPoint < -DecimalPointRange) {
+          clear();
+          return;
+        }
+
+        const uint64_t mask = (1ull << shift) - 1;
+        while (readIndex < numDigits) {
+          uint8_t newDigit      = uint8_t(n >> shift);
+          n                     = 10 * (n & mask) + digits[readIndex++];
+          digits[writeIndex++] = newDigit;
+        }
+
+        while (n > 0) {
+          uint8_t newDigit = uint8_t(n >> shift);
+          n                = 10 * (n & mask);
+          if (writeIndex < MaxDigits)
+            digits[writeIndex++] = newDigit;
+          else if (newDigit > 0)
+            truncated = true;
+        }
+
+        numDigits = writeIndex;
+        trim();
+      }
 
-    if (begin >= end || ((begin[0] < 48 || begin[0] > 57) && begin[0] != '-' && begin[0] != '.')) {
+      /// Multiply by 2^shift.
+      void leftShift(int32_t shift) {
+        if (numDigits == 0)
+          return;
+
+        // Write the result right aligned, leaving room for at most maxNewDigits new digits.
+        // floor(shift * log10(2)) + 1 is an upper bound on the number of digits added.
+        const int32_t maxNewDigits = shift * 1233 / 4096 + 1;
+        const int32_t end          = numDigits + maxNewDigits;
+        int32_t       writeIndex   = end - 1;
+        uint64_t      n            = 0;
+        for (int32_t readIndex = numDigits - 1; readIndex >= 0; --readIndex) {
+          n += uint64_t(digits[readIndex]) << shift;
+          const uint64_t quotient = n / 10;
+          digits[writeIndex--]    = uint8_t(n - 10 * quotient);
+          n                       = quotient;
+        }
+
+        while (n > 0) {
+          const uint64_t quotient = n / 10;
+          digits[writeIndex--]    = uint8_t(n - 10 * quotient);
+          n                       = quotient;
+        }
+
+        int32_t first = writeIndex + 1;
+        while (first < end && digits[first] == 0)
+          ++first;
+
+        decimalPoint += (end - first) - numDigits;
+        numDigits = end - first;
+        memmove(digits, digits + first, numDigits);
+
+        if (numDigits > MaxDigits) {
+          for (int32_t i = MaxDigits; i < numDigits; ++i)
+            truncated |= digits[i] != 0;
+          numDigits = MaxDigits;
+        }
+        trim();
+      }
+
+      /// Round the integer part to the nearest integer, ties to even.
+      uint64_t round() const {
+        if (numDigits == 0 || decimalPoint < 0)
+          return 0;
+        if (decimalPoint > 18)
+          return ~0ull;
+
+        uint64_t n = 0;
+        for (int32_t i = 0; i < decimalPoint; ++i)
+          n = 10 * n + (i < numDigits ? digits[i] : 0);
+
+        bool roundUp = false;
+        if (decimalPoint < numDigits) {
+          roundUp = digits[decimalPoint] >= 5;
+          if (digits[decimalPoint] == 5 && decimalPoint + 1 == numDigits)
+            roundUp = truncated || (decimalPoint > 0 && (digits[decimalPoint - 1] & 1));
+        }
+        return n + roundUp;
+      }
+
+      /// Convert to the nearest double by scaling into [1/2, 1) with exact binary shifts.
+      BinaryFloat toBinary() {
+        // Shift amounts that keep the decimal point moving quickly without overflowing 64 bits.
+        constexpr uint8_t powers[19] = {0, 3, 6, 9, 13, 16, 19, 23, 26, 29, 33, 36, 39, 43, 46, 49, 53, 56, 59};
+        constexpr int32_t numPowers  = 19;
+
+        if (numDigits == 0 || decimalPoint < -324)
+          return BinaryFloat{};
+        if (decimalPoint >= 310)
+          return BinaryFloat{0, InfinitePower};
+
+        int32_t exp2 = 0;
+        while (decimalPoint > 0) {
+          const int32_t shift = decimalPoint < numPowers ? powers[decimalPoint] : MaxShift;
+          rightShift(shift);
+          if (decimalPoint < -DecimalPointRange)
+            return BinaryFloat{};
+          exp2 += shift;
+        }
+
+        while (decimalPoint <= 0) {
+          int32_t shift;
+          if (decimalPoint == 0) {
+            if (digits[0] >= 5)
+              break;
+            shift = digits[0] < 2 ? 2 : 1;
+          } else {
+            shift = -decimalPoint < numPowers ? powers[-decimalPoint] : MaxShift;
+          }
+
+          leftShift(shift);
+          if (decimalPoint > DecimalPointRange)
+            return BinaryFloat{0, InfinitePower};
+          exp2 -= shift;
+        }
+
+        // The value is in [1/2, 1), but doubles are normalized to [1, 2).
+        --exp2;
+        while (MinimumExponent + 1 > exp2) {
+          const int32_t shift = std::min(MinimumExponent + 1 - exp2, MaxShift);
+          rightShift(shift);
+          exp2 += shift;
+        }
+
+        if (exp2 - MinimumExponent >= InfinitePower)
+          return BinaryFloat{0, InfinitePower};
+
+        leftShift(MantissaBits + 1);
+        uint64_t mantissa = round();
+        if (mantissa >= (1ull << (MantissaBits + 1))) { // Rounding overflowed
+          rightShift(1);
+          exp2 += 1;
+          mantissa = round();
+          if (exp2 - MinimumExponent >= InfinitePower)
+            return BinaryFloat{0, InfinitePower};
+        }
+
+        BinaryFloat answer;
+        answer.power2 = exp2 - MinimumExponent;
+        if (mantissa < (1ull << MantissaBits))
+          --answer.power2;
+        answer.mantissa = mantissa & ((1ull << MantissaBits) - 1);
+        return answer;
+      }
+    };
+
+    /// Parse the digits of a number into a BigDecimal. The text has already been validated.
+    BinaryFloat parseSlow(char const * it, char const * end, int64_t exponent) {
+      BigDecimal decimal;
+      for (; it < end && isDigit(*it); ++it) {
+        if (decimal.numDigits == 0 && *it == '0')
+          continue;
+        decimal.pushDigit(*it);
+        ++decimal.decimalPoint;
+      }
+
+      if (it < end && *it == '.') {
+        for (++it; it < end && isDigit(*it); ++it) {
+          if (decimal.numDigits == 0 && *it == '0') {
+            --decimal.decimalPoint;
+            continue;
+          }
+          decimal.pushDigit(*it);
+        }
+      }
+
+      decimal.trim();
+      decimal.decimalPoint = int32_t(std::clamp<int64_t>(decimal.decimalPoint + exponent, -100000, 100000));
+      return decimal.toBinary();
+    }
+
+    constexpr double exactPowersOf10[23] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  } // namespace
+
+  int64_t ScanIntegerFast(const char * begin, const char * end, int64_t * pLen) {
+    const char * it = skipSpace(begin, end);
+    if (it >= end || (!isDigit(*it) && *it != '-')) {
       if (pLen != nullptr) {
         *pLen = 0;
       }
       return 0;
     }
 
-    int32_t sign = begin[0];
-    begin += sign == '-' || sign == '+';
+    const bool negative = *it == '-';
+    it += negative;
 
-    int64_t sum        = 0;
-    int32_t digitCount = 0;
-    int32_t dpOffset   = -1;
-    int32_t power10    = 0;
-    int32_t dp         = '.';
-    while (true) {
-      while (begin < end && begin[0] >= '0' && begin[0] <= '9') {
-        digitCount++;
-        if (sum < LLONG_MAX / 10)
-          sum = sum * 10 + begin[0] - '0';
-        else
-          ++power10;
-        ++begin;
-      }
+    uint64_t val = 0;
+    it           = parseDigits(it, end, &val);
 
-      if (begin < end && begin[0] == dp) {
-        dp       = '0';
-        dpOffset = digitCount;
-        ++begin;
-      } else {
-        break;
-      }
+    if (pLen)
+      *pLen = it - begin;
+
+    return negative ? -int64_t(val) : int64_t(val);
+  }
+
+  double ScanDoubleFast(const char * begin, const char * end, int64_t * pLen) {
+    if (pLen != nullptr) {
+      *pLen = 0;
+    }
+
+    char const * it = skipSpace(begin, end);
+    if (it >= end) {
+      return 0;
+    }
+
+    const bool negative = *it == '-';
+    it += negative || *it == '+';
+
+    // Parse the mantissa. Digits beyond the 19th overflow, and are handled by the slow path.
+    char const * digitsBegin = it;
+    uint64_t     mantissa    = 0;
+    it                       = parseDigits(it, end, &mantissa);
+    int64_t digitCount       = it - digitsBegin;
+    int64_t fractionDigits   = 0;
+    if (it < end && *it == '.') {
+      char const * fractionBegin = ++it;
+      it                         = parseDigits(it, end, &mantissa);
+      fractionDigits             = it - fractionBegin;
+      digitCount += fractionDigits;
     }
 
-    if (dpOffset >= 0)
-      power10 -= digitCount - dpOffset;
+    if (digitCount == 0) {
+      return 0;
+    }
 
-    if (begin[0] == 'e' || begin[0] == 'E') {
-      ++begin;
-      int32_t esign = begin[0];
-      begin += esign == '-' || esign == '+';
-      int32_t expo = 0;
-      while (begin[0] >= '0' && begin[0] <= '9') {
-        expo = expo * 10 + begin[0] - '0';
-        ++begin;
+    int64_t explicitExponent = 0;
+    if (it < end && (*it == 'e' || *it == 'E')) {
+      char const * expIt       = it + 1;
+      const bool   negativeExp = expIt < end && *expIt == '-';
+      expIt += expIt < end && (*expIt == '-' || *expIt == '+');
+      if (expIt < end && isDigit(*expIt)) {
+        for (; expIt < end && isDigit(*expIt); ++expIt) {
+          if (explicitExponent < 0x10000000)
+            explicitExponent = explicitExponent * 10 + (*expIt - '0');
+        }
+        explicitExponent = negativeExp ? -explicitExponent : explicitExponent;
+        it               = expIt;
       }
+    }
 
-      if (esign == '-')
-        expo = -expo;
-      power10 += expo;
+    if (pLen != nullptr) {
+      *pLen = it - begin;
     }
 
-    double value = (double)sum;
-    if (power10) {
-      // static lookup of 5^-9 to 5^10 to avoid calling pow()
-      int32_t idx = power10 + 9;
-      value *= idx >= 0 && idx < 20 ? powerOf5Table[idx] : pow(5, power10);
-      value = ldexp(value, power10);
+    // Leading zeros are not significant.
+    if (digitCount > MaxMantissaDigits) {
+      for (char const * lead = digitsBegin; lead < it && (*lead == '0' || *lead == '.'); ++lead)
+        digitCount -= *lead == '0';
     }
 
-    if (pLen)
-      *pLen = begin - start;
+    BinaryFloat result;
+    if (digitCount > MaxMantissaDigits) {
+      result = parseSlow(digitsBegin, it, explicitExponent);
+    } else {
+      // Fast path when the mantissa and power of ten are both exact doubles.
+      const int64_t exponent = explicitExponent - fractionDigits;
+      if (exponent >= -22 && exponent <= 22 && mantissa <= (1ull << 53)) {
+        double value = double(mantissa);
+        value        = exponent < 0 ? value / exactPowersOf10[-exponent] : value * exactPowersOf10[exponent];
+        return negative ? -value : value;
+      }
+
+      result = eiselLemire(exponent, mantissa);
+    }
 
-    return sign == '-' ? -value : value;
+    return toDouble(result, negative);
   }
 
   StringView Scan::readString(const StringView & str, int64_t * pLen) {
@@ -124,6 +520,38 @@ namespace bfc {
     return ScanDoubleFast(str.begin(), str.end(), pLen);
   }
 
+  namespace {
+    template<typename T, typename ScanFunc>
+    int64_t readMany(const StringView & str, T * pValues, int64_t count, int64_t * pLen, ScanFunc const & scan) {
+      char const * it   = str.begin();
+      int64_t      read = 0;
+      for (; read < count; ++read) {
+        int64_t len = 0;
+        T       val = (T)scan(it, str.end(), &len);
+        if (len == 0)
+          break;
+        pValues[read] = val;
+        it += len;
+      }
+
+      if (pLen)
+        *pLen = it - str.begin();
+      return read;
+    }
+  } // namespace
+
+  int64_t Scan::readFloats(const StringView & str, double * pValues, int64_t count, int64_t * pLen) {
+    return readMany(str, pValues, count, pLen, ScanDoubleFast);
+  }
+
+  int64_t Scan::readFloats(const StringView & str, float * pValues, int64_t count, int64_t * pLen) {
+    return readMany(str, pValues, count, pLen, ScanDoubleFast);
+  }
+
+  int64_t Scan::readInts(const StringView & str, int64_t * pValues, int64_t count, int64_t * pLen) {
+    return readMany(str, pValues, count, pLen, ScanIntegerFast);
+  }
+
   bool Scan::readBool(const StringView & str, int64_t * pLen) {
     if (pLen)
       *pLen = 0;
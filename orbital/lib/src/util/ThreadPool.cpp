@@ -5,81 +5,297 @@ namespace bfc {
   namespace impl {
     static thread_local bool isPooledThread = false;
 
-    class PooledRunner {
+    /// Chase-Lev work stealing deque.
+    /// The owning worker pushes and pops tasks at the bottom, other workers steal from the top.
+    class TaskDeque {
+      class Buffer {
+      public:
+        Buffer(int64_t capacity)
+          : m_mask(capacity - 1)
+          , m_pItems(new std::atomic<ThreadPool::Task *>[capacity]) {}
+
+        int64_t capacity() const {
+          return m_mask + 1;
+        }
+
+        ThreadPool::Task * get(int64_t index) const {
+          return m_pItems[index & m_mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, ThreadPool::Task * pTask) {
+          m_pItems[index & m_mask].store(pTask, std::memory_order_relaxed);
+        }
+
+        Buffer * grow(int64_t bottom, int64_t top) const {
+          Buffer * pNew = new Buffer(capacity() * 2);
+          for (int64_t i = top; i < bottom; ++i)
+            pNew->put(i, get(i));
+          return pNew;
+        }
+
+      private:
+        int64_t                                          m_mask = 0;
+        std::unique_ptr<std::atomic<ThreadPool::Task *>[]> m_pItems;
+      };
+
     public:
-      PooledRunner(int64_t numThreads)
-      {
-        for (int64_t i = 0; i < numThreads; ++i)
-          m_threads.pushBack(std::thread(&PooledRunner::worker, this));
+      TaskDeque(int64_t initialCapacity = 256)
+        : m_pBuffer(new Buffer(initialCapacity)) {}
+
+      ~TaskDeque() {
+        delete m_pBuffer.load(std::memory_order_relaxed);
+        for (Buffer * pBuffer : m_retired)
+          delete pBuffer;
       }
 
-      ~PooledRunner() {
-        m_lock.lock();
-        m_running = false;
-        m_lock.unlock();
+      /// Push a task. Must only be called by the owning worker.
+      void push(ThreadPool::Task * pTask) {
+        int64_t  bottom  = m_bottom.load(std::memory_order_relaxed);
+        int64_t  top     = m_top.load(std::memory_order_acquire);
+        Buffer * pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+        if (bottom - top > pBuffer->capacity() - 1) {
+          // Stealers may still be reading the old buffer, so keep it alive until the deque is destroyed.
+          m_retired.pushBack(pBuffer);
+          pBuffer = pBuffer->grow(bottom, top);
+          m_pBuffer.store(pBuffer, std::memory_order_release);
+        }
 
-        m_notifier.notify_all();
+        pBuffer->put(bottom, pTask);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+      }
+
+      /// Pop the most recently pushed task. Must only be called by the owning worker.
+      ThreadPool::Task * pop() {
+        int64_t  bottom  = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer * pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+          m_bottom.store(bottom + 1, std::memory_order_relaxed);
+          return nullptr;
+        }
 
-        for (auto & th : m_threads)
-          th.join();
+        ThreadPool::Task * pTask = pBuffer->get(bottom);
+        if (top == bottom) {
+          // Last task. Race any stealers for it.
+          if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            pTask = nullptr;
+          m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return pTask;
       }
 
-      void add(Vector<ThreadPool::Task> &&tasks) {
-        m_lock.lock();
-        for (auto & task : tasks) {
-          m_queue.pushBack(std::move(task));
+      /// Steal the oldest task. Can be called from any thread.
+      ThreadPool::Task * steal() {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+          return nullptr;
+
+        ThreadPool::Task * pTask = m_pBuffer.load(std::memory_order_acquire)->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          return nullptr;
+
+        return pTask;
+      }
+
+    private:
+      alignas(64) std::atomic_int64_t m_top    = 0;
+      alignas(64) std::atomic_int64_t m_bottom = 0;
+      std::atomic<Buffer *>           m_pBuffer;
+      Vector<Buffer *>                m_retired;
+    };
+
+    /// Runs tasks on a fixed set of workers.
+    /// Tasks queued from a worker go to that worker's deque. Tasks queued from any other thread go to a
+    /// shared injection queue. Idle workers steal from each other before parking.
+    class WorkStealingRunner {
+      struct Worker {
+        TaskDeque   deque;
+        std::thread thread;
+        uint64_t    rngState = 0;
+      };
+
+      static inline thread_local WorkStealingRunner * tls_pRunner = nullptr;
+      static inline thread_local Worker *             tls_pWorker = nullptr;
+
+      static constexpr int64_t SpinRounds  = 64;
+      static constexpr int64_t YieldRounds = 16;
+
+    public:
+      WorkStealingRunner(int64_t numThreads)
+        : m_numWorkers(std::max(numThreads, 1ll))
+        , m_pWorkers(new Worker[m_numWorkers]) {
+        for (int64_t i = 0; i < m_numWorkers; ++i) {
+          m_pWorkers[i].rngState = 0x9E3779B97F4A7C15ull * (i + 1);
+          m_pWorkers[i].thread   = std::thread(&WorkStealingRunner::worker, this, i);
         }
-        m_lock.unlock();
+      }
+
+      ~WorkStealingRunner() {
+        m_sleepLock.lock();
+        m_running = false;
+        m_sleepLock.unlock();
 
-        for (int64_t i = 0; i < tasks.size(); ++i) {
-          m_notifier.notify_one();
+        m_sleepNotifier.notify_all();
+
+        for (int64_t i = 0; i < m_numWorkers; ++i)
+          m_pWorkers[i].thread.join();
+      }
+
+      void add(ThreadPool::Task && task) {
+        ThreadPool::Task * pTask = new ThreadPool::Task(std::move(task));
+        m_numQueued.fetch_add(1, std::memory_order_seq_cst);
+
+        if (tls_pRunner == this) {
+          tls_pWorker->deque.push(pTask);
+        } else {
+          std::scoped_lock guard{m_injectLock};
+          m_injected.pushBack(pTask);
         }
 
-        tasks.clear();
+        wakeOne();
       }
 
       int64_t availableToRun() const {
-        std::unique_lock guard{m_lock};
-        return m_threads.size() - m_queue.size() - m_numBusy;
+        return m_numWorkers - m_numBusy.load(std::memory_order_relaxed) - m_numQueued.load(std::memory_order_relaxed);
       }
 
     private:
-      void worker() {
+      void worker(int64_t index) {
         isPooledThread = true;
+        tls_pRunner    = this;
+        tls_pWorker    = &m_pWorkers[index];
+
+        int64_t idleRounds = 0;
+        while (true) {
+          ThreadPool::Task * pTask = findTask(index);
+          if (pTask != nullptr) {
+            m_numBusy.fetch_add(1, std::memory_order_relaxed);
+            m_numQueued.fetch_sub(1, std::memory_order_relaxed);
+            pTask->callback();
+            delete pTask;
+            m_numBusy.fetch_sub(1, std::memory_order_relaxed);
+            idleRounds = 0;
+            continue;
+          }
 
-        std::optional<ThreadPool::Task> task;
-
-        bool running = true;
-        while (running) {
-          {
-            std::unique_lock ul{m_lock};
-            m_notifier.wait(ul, [&]() {
-              running = m_running || m_queue.size() > 0;
-
-              if (m_queue.size() == 0)
-                return !m_running;
-
-              task = m_queue.popFront();
-              m_numBusy++;
-              return true;
-            });
+          // Back off before parking. Work often arrives in bursts.
+          ++idleRounds;
+          if (idleRounds < SpinRounds) {
+            continue;
+          } else if (idleRounds < SpinRounds + YieldRounds) {
+            std::this_thread::yield();
+            continue;
           }
 
-          if (!task.has_value())
+          idleRounds = 0;
+          if (!park())
+            break;
+        }
+
+        tls_pWorker = nullptr;
+        tls_pRunner = nullptr;
+      }
+
+      ThreadPool::Task * findTask(int64_t index) {
+        Worker & self = m_pWorkers[index];
+        if (ThreadPool::Task * pTask = self.deque.pop())
+          return pTask;
+
+        if (ThreadPool::Task * pTask = popInjected())
+          return pTask;
+
+        if (m_numWorkers == 1)
+          return nullptr;
+
+        // Visit the other workers starting from a random victim.
+        self.rngState ^= self.rngState << 13;
+        self.rngState ^= self.rngState >> 7;
+        self.rngState ^= self.rngState << 17;
+        int64_t start = self.rngState % m_numWorkers;
+        for (int64_t i = 0; i < m_numWorkers; ++i) {
+          int64_t victim = (start + i) % m_numWorkers;
+          if (victim == index)
             continue;
 
-          task->callback();
-          task.reset();
-          --m_numBusy;
+          if (ThreadPool::Task * pTask = m_pWorkers[victim].deque.steal())
+            return pTask;
         }
+
+        return nullptr;
       }
 
-      bool                     m_running = true;
-      Vector<std::thread>      m_threads;
-      Vector<ThreadPool::Task> m_queue;
-      mutable std::mutex       m_lock;
-      std::condition_variable  m_notifier;
-      std::atomic_int64_t      m_numBusy = 0;
+      ThreadPool::Task * popInjected() {
+        if (m_numQueued.load(std::memory_order_relaxed) == 0)
+          return nullptr;
+
+        std::scoped_lock guard{m_injectLock};
+        if (m_injectHead >= m_injected.size())
+          return nullptr;
+
+        ThreadPool::Task * pTask = m_injected[m_injectHead++];
+        if (m_injectHead == m_injected.size()) {
+          m_injected.clear();
+          m_injectHead = 0;
+        }
+
+        return pTask;
+      }
+
+      /// Sleep until more work is queued.
+      /// @retval false The runner is shutting down and there is no work left.
+      bool park() {
+        std::unique_lock guard{m_sleepLock};
+        m_numSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+        bool keepRunning = true;
+        if (m_numQueued.load(std::memory_order_seq_cst) == 0) {
+          if (!m_running) {
+            keepRunning = false;
+          } else {
+            uint64_t epoch = m_wakeEpoch;
+            m_sleepNotifier.wait(guard, [&]() { return m_wakeEpoch != epoch || !m_running; });
+          }
+        }
+
+        m_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+        return keepRunning;
+      }
+
+      void wakeOne() {
+        // Pairs with the increment in park(). Either the parking worker sees the queued
+        // task, or we see the parking worker.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_numSleeping.load(std::memory_order_relaxed) == 0)
+          return;
+
+        m_sleepLock.lock();
+        ++m_wakeEpoch;
+        m_sleepLock.unlock();
+
+        m_sleepNotifier.notify_one();
+      }
+
+      int64_t                   m_numWorkers = 0;
+      std::unique_ptr<Worker[]> m_pWorkers;
+
+      std::mutex               m_injectLock;
+      Vector<ThreadPool::Task *> m_injected;
+      int64_t                  m_injectHead = 0;
+
+      std::mutex              m_sleepLock;
+      std::condition_variable m_sleepNotifier;
+      uint64_t                m_wakeEpoch = 0;
+      bool                    m_running   = true;
+
+      std::atomic_int64_t m_numQueued   = 0;
+      std::atomic_int64_t m_numBusy     = 0;
+      std::atomic_int64_t m_numSleeping = 0;
     };
 
     class ThreadedRunner {
@@ -148,21 +364,20 @@ namespace bfc {
     };
   } // namespace impl
 
-  ThreadPool::ThreadPool(int64_t targetConcurrency) {
-    m_dispatcher = std::thread(&ThreadPool::dispatchTasks, this, targetConcurrency);
-  }
+  ThreadPool::ThreadPool(int64_t targetConcurrency)
+    : m_pWorkers(std::make_unique<impl::WorkStealingRunner>(targetConcurrency))
+    , m_pThreads(std::make_unique<impl::ThreadedRunner>()) {}
 
   ThreadPool::~ThreadPool() {
-    m_lock.lock();
     m_running = false;
-    m_lock.unlock();
 
-    m_dispatchNotifier.notify_one();
-    m_dispatcher.join();
+    // Tasks already queued are still run before the runners are destroyed.
+    m_pThreads.reset();
+    m_pWorkers.reset();
   }
 
   bool ThreadPool::IsPoolThread() {
-    return false;
+    return impl::isPooledThread;
   }
 
   ThreadPool & ThreadPool::Global() {
@@ -170,59 +385,24 @@ namespace bfc {
     return instance;
   }
 
-  void ThreadPool::dispatchTasks(int64_t targetConcurrency) {
-    impl::ThreadedRunner runner;
-    impl::PooledRunner   workers(targetConcurrency);
-
-    Vector<Task>     toWorkers;
-    Vector<Task>     alwaysRun;
-    Vector<Task>     newThreads;
-    bool             running = true;
-
-    while (running) {
-      {
-        std::unique_lock ul{m_lock};
-        m_dispatchNotifier.wait(ul, [&]() {
-          running = m_running || m_dispatchQueue.size() > 0;
-
-          if (m_dispatchQueue.empty())
-            return !m_running;
-
-          for (auto & task : m_dispatchQueue) {
-            if (task.flags & AsyncFlags_AlwaysRun)
-              alwaysRun.pushBack(std::move(task));
-            else if (task.flags & AsyncFlags_NewThread)
-              newThreads.pushBack(std::move(task));
-            else
-              toWorkers.pushBack(std::move(task));
-          }
-          m_dispatchQueue.clear();
-          return true;
-        });
-      }
+  bool ThreadPool::submit(Task && task) {
+    if (!m_running)
+      return false;
 
-      int64_t freeWorkers = workers.availableToRun() - toWorkers.size();
-
-      // Distribute always run tasks  to workers or to the threaded runner.
-      for (auto & task : alwaysRun) {
-        if (freeWorkers <= 0) {
-          newThreads.pushBack(std::move(task));
-        } else {
-          toWorkers.pushBack(std::move(task));
-          --freeWorkers;
-        }
+    if (task.flags & AsyncFlags_AlwaysRun) {
+      // Use a worker if one is free, otherwise start a new thread so the task is never left waiting.
+      if (m_pWorkers->availableToRun() > 0) {
+        m_pWorkers->add(std::move(task));
+        return true;
       }
 
-      // Dispatch to workers
-      workers.add(std::move(toWorkers));
+      return m_pThreads->run(std::move(task));
+    }
 
-      // Dispatch to new thread
-      for (auto & task : newThreads)
-        runner.run(std::move(task));
+    if (task.flags & AsyncFlags_NewThread)
+      return m_pThreads->run(std::move(task));
 
-      toWorkers.clear();
-      alwaysRun.clear();
-      newThreads.clear();
-    }
+    m_pWorkers->add(std::move(task));
+    return true;
   }
 } // namespace bfc
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "geometry/Box.h"
+#include "mesh/MeshData.h"
+
+namespace bfc {
+  namespace test {
+    /// A grid of `dim` x `dim` quads covering [0, 1] in the XY plane, facing +Z.
+    /// Each grid point has one position, uv and vertex, numbered row by row. Each quad is split into two
+    /// triangles, added row by row, so quad (x, y) owns triangles (y * dim + x) * 2 and the one after it.
+    /// Triangles in the top half of the grid use material 1, the rest use material 0.
+    inline MeshData makeGrid(int64_t dim) {
+      MeshData mesh;
+      mesh.materials.resize(2);
+      for (int64_t y = 0; y <= dim; ++y) {
+        for (int64_t x = 0; x <= dim; ++x) {
+          MeshData::Vertex vert;
+          vert.position = mesh.positions.size();
+          vert.uv       = mesh.uvs.size();
+          mesh.positions.pushBack(Vec3d(double(x) / dim, double(y) / dim, 0));
+          mesh.uvs.pushBack(Vec2d(double(x) / dim, double(y) / dim));
+          mesh.vertices.pushBack(vert);
+        }
+      }
+
+      for (int64_t y = 0; y < dim; ++y) {
+        for (int64_t x = 0; x < dim; ++x) {
+          const int64_t material = y >= dim / 2;
+          const int64_t i0       = y * (dim + 1) + x;
+          const int64_t i1       = i0 + 1;
+          const int64_t i2       = i0 + dim + 1;
+          const int64_t i3       = i2 + 1;
+          mesh.triangles.pushBack(MeshData::Triangle{{i0, i1, i3}, material});
+          mesh.triangles.pushBack(MeshData::Triangle{{i0, i3, i2}, material});
+        }
+      }
+
+      return mesh;
+    }
+
+    /// The vertices of each triangle of `mesh`, three indices per triangle.
+    /// In a grid from makeGrid() these are also the indices of the positions.
+    template<typename Index>
+    Vector<Index> triangleIndices(MeshData const & mesh) {
+      Vector<Index> indices;
+      for (MeshData::Triangle const & tri : mesh.triangles)
+        for (int64_t vertex : tri.vertex)
+          indices.pushBack(Index(vertex));
+      return indices;
+    }
+
+    /// A `dim` x `dim` x `dim` grid of unit boxes, spaced 10 units apart, numbered along X, then Y, then Z.
+    inline Vector<geometry::Boxf> makeBoxGrid(int64_t dim) {
+      Vector<geometry::Boxf> boxes;
+      for (int64_t z = 0; z < dim; ++z)
+        for (int64_t y = 0; y < dim; ++y)
+          for (int64_t x = 0; x < dim; ++x)
+            boxes.pushBack(geometry::Boxf(Vec3(x, y, z) * 10.0f, Vec3(x, y, z) * 10.0f + Vec3(1)));
+      return boxes;
+    }
+  } // namespace test
+} // namespace bfc
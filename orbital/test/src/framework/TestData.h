@@ -0,0 +1,47 @@
+#pragma once
+
+#include "core/Vector.h"
+
+#include <filesystem>
+#include <string>
+
+namespace bfc {
+  namespace test {
+    /// A file in the temp directory that is deleted when the test finishes.
+    struct TempFile {
+      TempFile(char const * name)
+        : path((std::filesystem::temp_directory_path() / name).string()) {
+        std::filesystem::remove(path);
+      }
+
+      ~TempFile() {
+        std::filesystem::remove(path);
+      }
+
+      std::string path;
+    };
+
+    /// A directory in the temp directory that is deleted, with its contents, when the test finishes.
+    struct TempDirectory {
+      TempDirectory(char const * name)
+        : path((std::filesystem::temp_directory_path() / name).string()) {
+        std::filesystem::remove_all(path);
+      }
+
+      ~TempDirectory() {
+        std::filesystem::remove_all(path);
+      }
+
+      std::string path;
+    };
+
+    /// `size` bytes of a repeating pattern that does not align with powers of two.
+    inline Vector<uint8_t> makePattern(int64_t size) {
+      Vector<uint8_t> data;
+      data.resize(size);
+      for (int64_t i = 0; i < size; ++i)
+        data[i] = uint8_t(i * 7 + 3);
+      return data;
+    }
+  } // namespace test
+} // namespace bfc
@@ -14,6 +14,7 @@ namespace bfc
       std::string name;
       std::string failureMessage;
       bool failed = false;
+      bool benchmark = false;
     };
 
     std::vector<Test>& GetTests()
@@ -23,11 +24,12 @@ namespace bfc
     }
     thread_local Test * g_pRunningTest = nullptr;
 
-    TestRegister::TestRegister(char const *name, TestFunction func)
+    TestRegister::TestRegister(char const *name, TestFunction func, bool benchmark)
     {
       Test newTest;
       newTest.name = name;
       newTest.func = func;
+      newTest.benchmark = benchmark;
       GetTests().push_back(newTest);
     }
 
@@ -44,19 +46,27 @@ namespace bfc
       return condition;
     }
 
-    bool run()
+    bool run(bool runBenchmarks)
     {
       bool anyFailed = false;
       int64_t maxNameLength = 0;
+      int64_t numTests = 0;
       for (Test &test : GetTests())
+      {
+        if (test.benchmark && !runBenchmarks)
+          continue;
         maxNameLength = std::max<int64_t>(maxNameLength, test.name.length());
+        ++numTests;
+      }
 
-      int64_t numTests = GetTests().size();
       int numSize = (int)floor(log10(numTests)) + 1;
 
       int64_t i = 0;
       for (Test &test : GetTests())
       {
+        if (test.benchmark && !runBenchmarks)
+          continue;
+
         g_pRunningTest = &test;
         printf("[%*lld/%*lld] Running %s", numSize, ++i, numSize, numTests, g_pRunningTest->name.c_str());
         printf("%*s ", (int)(maxNameLength - g_pRunningTest->name.length()), "");
@@ -6,13 +6,15 @@ namespace bfc {
 
     class TestRegister {
     public:
-      TestRegister(char const * testName, TestFunction testFunc);
+      TestRegister(char const * testName, TestFunction testFunc, bool benchmark = false);
     };
 
     void failTest(char const * message);
     bool assertTest(bool condition, char const * message);
 
-    bool run();
+    /// Run the registered tests.
+    /// @param runBenchmarks Also run the tests registered with BFC_BENCHMARK.
+    bool run(bool runBenchmarks = false);
   } // namespace test
 } // namespace bfc
 
@@ -55,3 +57,9 @@ namespace bfc {
   void                                           __bfc_testfunc_##Name();                                                                                      \
   __declspec(dllexport)::bfc::test::TestRegister __bfc_test_##Name(#Name, __bfc_testfunc_##Name);                                                              \
   void                                           __bfc_testfunc_##Name()
+
+// A test that measures performance. Benchmarks are only run when the tests are started with --benchmark.
+#define BFC_BENCHMARK(Name)                                                                                                                                    \
+  void                                           __bfc_testfunc_##Name();                                                                                      \
+  __declspec(dllexport)::bfc::test::TestRegister __bfc_test_##Name(#Name, __bfc_testfunc_##Name, true);                                                        \
+  void                                           __bfc_testfunc_##Name()
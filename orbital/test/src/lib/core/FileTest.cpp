@@ -0,0 +1,132 @@
+#include "framework/test.h"
+#include "framework/TestData.h"
+#include "core/File.h"
+#include "core/URI.h"
+
+#include <cstring>
+
+using namespace bfc;
+
+namespace {
+  bool writeBytes(std::string const & path, Vector<uint8_t> const & data) {
+    File file;
+    if (!file.open(path.c_str(), FileMode_WriteBinary))
+      return false;
+    return data.size() == 0 || file.write(data.data(), data.size()) == data.size();
+  }
+} // namespace
+
+BFC_TEST(File_MappedRead) {
+  test::TempFile        file("bfc_file_mapped_read.bin");
+  Vector<uint8_t> const content = test::makePattern(1000);
+  BFC_TEST_ASSERT_TRUE(writeBytes(file.path, content));
+
+  MappedFileStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.open(file.path.c_str()));
+  BFC_TEST_ASSERT_TRUE(stream.readable());
+  BFC_TEST_ASSERT_FALSE(stream.writeable());
+  BFC_TEST_ASSERT_EQUAL(stream.length(), 1000);
+
+  // The contents can be read in place...
+  BFC_TEST_ASSERT_TRUE(stream.data() != nullptr);
+  BFC_TEST_ASSERT_TRUE(memcmp(stream.data(), content.data(), content.size()) == 0);
+
+  // ... or copied out with read().
+  uint8_t buffer[100];
+  BFC_TEST_ASSERT_EQUAL(stream.read(buffer, 100), 100);
+  BFC_TEST_ASSERT_TRUE(memcmp(buffer, content.data(), 100) == 0);
+  BFC_TEST_ASSERT_EQUAL(stream.tell(), 100);
+  BFC_TEST_ASSERT_FALSE(stream.eof());
+}
+
+BFC_TEST(File_MappedSeek) {
+  test::TempFile        file("bfc_file_mapped_seek.bin");
+  Vector<uint8_t> const content = test::makePattern(1000);
+  BFC_TEST_ASSERT_TRUE(writeBytes(file.path, content));
+
+  MappedFileStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.open(file.path.c_str()));
+
+  uint8_t buffer[100];
+  BFC_TEST_ASSERT_TRUE(stream.seek(500, SeekOrigin_Start));
+  BFC_TEST_ASSERT_TRUE(stream.seek(-50, SeekOrigin_Current));
+  BFC_TEST_ASSERT_EQUAL(stream.tell(), 450);
+  BFC_TEST_ASSERT_EQUAL(stream.read(buffer, 10), 10);
+  BFC_TEST_ASSERT_TRUE(memcmp(buffer, content.data() + 450, 10) == 0);
+
+  // Reads stop at the end of the file.
+  BFC_TEST_ASSERT_TRUE(stream.seek(10, SeekOrigin_End));
+  BFC_TEST_ASSERT_EQUAL(stream.tell(), 990);
+  BFC_TEST_ASSERT_EQUAL(stream.read(buffer, 100), 10);
+  BFC_TEST_ASSERT_TRUE(memcmp(buffer, content.data() + 990, 10) == 0);
+  BFC_TEST_ASSERT_TRUE(stream.eof());
+  BFC_TEST_ASSERT_EQUAL(stream.read(buffer, 100), 0);
+
+  // Seeking outside of the file fails, and leaves the stream at the nearest end.
+  BFC_TEST_ASSERT_FALSE(stream.seek(2000, SeekOrigin_Start));
+  BFC_TEST_ASSERT_EQUAL(stream.tell(), 1000);
+  BFC_TEST_ASSERT_FALSE(stream.seek(-5, SeekOrigin_Start));
+  BFC_TEST_ASSERT_EQUAL(stream.tell(), 0);
+  BFC_TEST_ASSERT_FALSE(stream.eof());
+}
+
+BFC_TEST(File_MappedEmpty) {
+  test::TempFile file("bfc_file_mapped_empty.bin");
+  BFC_TEST_ASSERT_TRUE(writeBytes(file.path, {}));
+
+  // An empty file can be mapped, but has nothing to read.
+  MappedFileStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.open(file.path.c_str()));
+  BFC_TEST_ASSERT_EQUAL(stream.length(), 0);
+  BFC_TEST_ASSERT_TRUE(stream.eof());
+
+  uint8_t buffer[10];
+  BFC_TEST_ASSERT_EQUAL(stream.read(buffer, 10), 0);
+  BFC_TEST_ASSERT_TRUE(stream.seek(0, SeekOrigin_Start));
+  BFC_TEST_ASSERT_FALSE(stream.seek(1, SeekOrigin_Start));
+}
+
+BFC_TEST(File_MappedWrite) {
+  test::TempFile        file("bfc_file_mapped_write.bin");
+  Vector<uint8_t> const content = test::makePattern(100);
+
+  // A file mapped for writing is created and grown to the mapped size. Writes past the end are truncated.
+  MappedFileStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.open(file.path.c_str(), FileMode_WriteBinary, 64));
+  BFC_TEST_ASSERT_TRUE(stream.writeable());
+  BFC_TEST_ASSERT_EQUAL(stream.write(content.data(), content.size()), 64);
+  BFC_TEST_ASSERT_TRUE(stream.eof());
+  BFC_TEST_ASSERT_TRUE(stream.flush());
+  stream.close();
+
+  Vector<uint8_t> written;
+  BFC_TEST_ASSERT_TRUE(readFile(Filename(file.path.c_str()), &written));
+  BFC_TEST_ASSERT_EQUAL(written.size(), 64);
+  BFC_TEST_ASSERT_TRUE(memcmp(written.data(), content.data(), 64) == 0);
+}
+
+BFC_TEST(File_StreamData) {
+  test::TempFile        small("bfc_file_stream_small.bin");
+  test::TempFile        large("bfc_file_stream_large.bin");
+  Vector<uint8_t> const content = test::makePattern(256 * 1024);
+  BFC_TEST_ASSERT_TRUE(writeBytes(small.path, test::makePattern(100)));
+  BFC_TEST_ASSERT_TRUE(writeBytes(large.path, content));
+
+  // Small files are read into a buffer, so their contents can't be addressed in place.
+  Ref<Stream> pSmall = openURI(URI::File(small.path.c_str()), FileMode_ReadBinary);
+  BFC_TEST_ASSERT_TRUE(pSmall != nullptr);
+  BFC_TEST_ASSERT_TRUE(pSmall->data() == nullptr);
+
+  // Large files are mapped, so their contents are available without reading them.
+  Ref<Stream> pLarge = openURI(URI::File(large.path.c_str()), FileMode_ReadBinary);
+  BFC_TEST_ASSERT_TRUE(pLarge != nullptr);
+  BFC_TEST_ASSERT_TRUE(pLarge->data() != nullptr);
+  BFC_TEST_ASSERT_EQUAL(pLarge->length(), content.size());
+  BFC_TEST_ASSERT_TRUE(memcmp(pLarge->data(), content.data(), content.size()) == 0);
+
+  // Reading still works through the stream interface.
+  uint8_t buffer[16];
+  BFC_TEST_ASSERT_TRUE(pLarge->seek(1000, SeekOrigin_Start));
+  BFC_TEST_ASSERT_EQUAL(pLarge->read(buffer, 16), 16);
+  BFC_TEST_ASSERT_TRUE(memcmp(buffer, content.data() + 1000, 16) == 0);
+}
@@ -0,0 +1,154 @@
+#include "core/Map.h"
+#include "core/Stream.h"
+#include "framework/test.h"
+
+BFC_TEST(Map_DefaultConstruct)
+{
+  bfc::Map<int, int> a;
+  BFC_TEST_ASSERT_TRUE(a.size() == 0);
+  BFC_TEST_ASSERT_TRUE(a.begin() == a.end());
+  BFC_TEST_ASSERT_FALSE(a.contains(0));
+  BFC_TEST_ASSERT_FALSE(a.erase(0));
+}
+
+BFC_TEST(Map_AddGet)
+{
+  bfc::Map<int64_t, int64_t> a;
+  for (int64_t i = 0; i < 1000; ++i)
+    a.add(i, i * 2);
+
+  BFC_TEST_ASSERT_TRUE(a.size() == 1000);
+  for (int64_t i = 0; i < 1000; ++i)
+    BFC_TEST_ASSERT_TRUE(a.get(i) == i * 2);
+
+  BFC_TEST_ASSERT_TRUE(a.tryGet(1000) == nullptr);
+  BFC_TEST_ASSERT_FALSE(a.tryAdd(10, 0));
+  BFC_TEST_ASSERT_TRUE(a.get(10) == 20);
+}
+
+BFC_TEST(Map_Erase)
+{
+  bfc::Map<int64_t, int64_t> a;
+  for (int64_t i = 0; i < 1000; ++i)
+    a.add(i, i);
+
+  for (int64_t i = 0; i < 1000; i += 2)
+    BFC_TEST_ASSERT_TRUE(a.erase(i));
+
+  BFC_TEST_ASSERT_TRUE(a.size() == 500);
+  for (int64_t i = 0; i < 1000; ++i)
+    BFC_TEST_ASSERT_TRUE(a.contains(i) == (i % 2 == 1));
+
+  int64_t value = 0;
+  BFC_TEST_ASSERT_TRUE(a.erase(1, &value));
+  BFC_TEST_ASSERT_TRUE(value == 1);
+  BFC_TEST_ASSERT_FALSE(a.erase(1, &value));
+}
+
+BFC_TEST(Map_EraseChurn)
+{
+  // Repeated add/erase should reuse deleted slots rather than grow the table.
+  bfc::Map<int64_t, int64_t> a;
+  for (int64_t i = 0; i < 100000; ++i) {
+    a.add(i, i);
+    if (i >= 8)
+      a.erase(i - 8);
+  }
+
+  BFC_TEST_ASSERT_TRUE(a.size() == 8);
+  BFC_TEST_ASSERT_TRUE(a.capacity() < 64);
+  for (int64_t i = 100000 - 8; i < 100000; ++i)
+    BFC_TEST_ASSERT_TRUE(a.get(i) == i);
+}
+
+BFC_TEST(Map_ArrayOperator)
+{
+  bfc::Map<int, int> a;
+  a[5] += 2;
+  a[5] += 3;
+  BFC_TEST_ASSERT_TRUE(a.size() == 1);
+  BFC_TEST_ASSERT_TRUE(a[5] == 5);
+
+  a.addOrSet(5, 1);
+  BFC_TEST_ASSERT_TRUE(a.get(5) == 1);
+  BFC_TEST_ASSERT_TRUE(a.getOr(6, 7) == 7);
+}
+
+BFC_TEST(Map_Iterator)
+{
+  bfc::Map<int64_t, int64_t> a;
+  for (int64_t i = 0; i < 100; ++i)
+    a.add(i, i);
+
+  int64_t count = 0;
+  int64_t sum   = 0;
+  for (auto & [key, value] : a) {
+    BFC_TEST_ASSERT_TRUE(key == value);
+    sum += value;
+    ++count;
+  }
+
+  BFC_TEST_ASSERT_TRUE(count == 100);
+  BFC_TEST_ASSERT_TRUE(sum == 4950);
+}
+
+BFC_TEST(Map_CopyMove)
+{
+  bfc::Map<int, bfc::Vector<int>> a;
+  for (int i = 0; i < 100; ++i)
+    a.add(i, bfc::Vector<int>(i, i));
+
+  bfc::Map<int, bfc::Vector<int>> b = a;
+  BFC_TEST_ASSERT_TRUE(a == b);
+
+  bfc::Map<int, bfc::Vector<int>> c = std::move(a);
+  BFC_TEST_ASSERT_TRUE(a.size() == 0);
+  BFC_TEST_ASSERT_TRUE(b == c);
+
+  c.clear();
+  BFC_TEST_ASSERT_TRUE(c.size() == 0);
+  BFC_TEST_ASSERT_TRUE(b != c);
+}
+
+BFC_TEST(Map_Serialize)
+{
+  bfc::Map<int64_t, int64_t> a;
+  for (int64_t i = 0; i < 100; ++i)
+    a.add(i, i * 3);
+
+  bfc::MemoryStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.write(a));
+  stream.seek(0, bfc::SeekOrigin_Start);
+
+  bfc::Map<int64_t, int64_t> b;
+  BFC_TEST_ASSERT_TRUE(stream.read(&b) == 1);
+  BFC_TEST_ASSERT_TRUE(a == b);
+}
+
+BFC_TEST(Map_SerializeVersion1)
+{
+  // Maps written before the version tag was added store their buckets, then the size and bucket order.
+  bfc::Vector<bfc::Pair<int64_t, int64_t>> first;
+  first.pushBack(bfc::makePair<int64_t, int64_t>(1, 10));
+  first.pushBack(bfc::makePair<int64_t, int64_t>(3, 30));
+  bfc::Vector<bfc::Pair<int64_t, int64_t>> second;
+  second.pushBack(bfc::makePair<int64_t, int64_t>(2, 20));
+
+  bfc::MemoryStream stream;
+  stream.write(int64_t(2));
+  stream.write(first);
+  stream.write(second);
+  stream.write(int64_t(3));
+  stream.write(int64_t(0));
+  stream.write(int64_t(42));
+  stream.seek(0, bfc::SeekOrigin_Start);
+
+  bfc::Map<int64_t, int64_t> map;
+  BFC_TEST_ASSERT_TRUE(stream.read(&map) == 1);
+  BFC_TEST_ASSERT_TRUE(map.size() == 3);
+  BFC_TEST_ASSERT_TRUE(map.get(1) == 10 && map.get(2) == 20 && map.get(3) == 30);
+
+  // Data after the map is left in the stream.
+  int64_t next = 0;
+  BFC_TEST_ASSERT_TRUE(stream.read(&next) == 1 && next == 42);
+}
@@ -0,0 +1,120 @@
+#include "framework/test.h"
+#include "framework/GridMesh.h"
+#include "geometry/BVH.h"
+
+#include <random>
+
+using namespace bfc;
+using namespace bfc::geometry;
+
+static Vector<int64_t> queryAll(BVHf const & bvh, Boxf const & box) {
+  Vector<int64_t> found;
+  bvh.query(box, [&](int64_t value) { found.pushBack(value); });
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+static Vector<int64_t> bruteForce(Vector<Boxf> const & boxes, Vector<bool> const & alive, Boxf const & box) {
+  Vector<int64_t> found;
+  for (int64_t i = 0; i < boxes.size(); ++i)
+    if (alive[i] && box.overlaps(boxes[i]))
+      found.pushBack(i);
+  return found;
+}
+
+BFC_TEST(BVH_Build) {
+  Vector<Boxf>    boxes = test::makeBoxGrid(8);
+  Vector<int64_t> proxies;
+  BVHf            bvh;
+  bvh.build(boxes, &proxies);
+
+  BFC_TEST_ASSERT_EQUAL(bvh.size(), boxes.size());
+  BFC_TEST_ASSERT_EQUAL(proxies.size(), boxes.size());
+  BFC_TEST_ASSERT_TRUE(bvh.depth() < 16);
+
+  for (int64_t i = 0; i < boxes.size(); ++i)
+    BFC_TEST_ASSERT_EQUAL(bvh.value(proxies[i]), i);
+
+  // A box covering one cell of the grid should only find that cell.
+  Vector<int64_t> found = queryAll(bvh, Boxf(Vec3(19, 29, 39), Vec3(20, 30, 40)));
+  BFC_TEST_ASSERT_EQUAL(found.size(), 1);
+  BFC_TEST_ASSERT_EQUAL(found[0], 2 + 3 * 8 + 4 * 64);
+}
+
+BFC_TEST(BVH_BuildParallel) {
+  Vector<Boxf> boxes = test::makeBoxGrid(24);
+  BVHf         serial;
+  BVHf         parallel;
+  ThreadPool   pool(4);
+  serial.build(boxes);
+  parallel.build(boxes, nullptr, &pool);
+
+  BFC_TEST_ASSERT_EQUAL(parallel.size(), boxes.size());
+  Boxf query(Vec3(35), Vec3(95));
+  BFC_TEST_ASSERT_TRUE(queryAll(serial, query) == queryAll(parallel, query));
+}
+
+BFC_TEST(BVH_Sphere) {
+  Vector<Boxf> boxes = test::makeBoxGrid(8);
+  BVHf         bvh;
+  bvh.build(boxes);
+
+  int64_t count = 0;
+  bvh.query(Spheref(Vec3(0.5f), 2.0f), [&](int64_t value) {
+    BFC_TEST_ASSERT_EQUAL(value, 0);
+    ++count;
+  });
+  BFC_TEST_ASSERT_EQUAL(count, 1);
+}
+
+BFC_TEST(BVH_InsertRemoveUpdate) {
+  std::mt19937                          rng(7);
+  std::uniform_real_distribution<float> position(0.0f, 500.0f);
+  std::uniform_real_distribution<float> extent(0.5f, 5.0f);
+
+  auto randomBox = [&]() {
+    Vec3 center(position(rng), position(rng), position(rng));
+    return Boxf(center - Vec3(extent(rng)), center + Vec3(extent(rng)));
+  };
+
+  Vector<Boxf>    boxes;
+  Vector<bool>    alive;
+  Vector<int64_t> proxies;
+  BVHf            bvh;
+  for (int64_t i = 0; i < 1000; ++i) {
+    boxes.pushBack(randomBox());
+    alive.pushBack(true);
+    proxies.pushBack(bvh.insert(boxes.back(), i));
+  }
+
+  for (int64_t step = 0; step < 5000; ++step) {
+    int64_t i = rng() % boxes.size();
+    switch (rng() % 3) {
+    case 0:
+      if (alive[i]) {
+        BFC_TEST_ASSERT_TRUE(bvh.remove(proxies[i]));
+        alive[i] = false;
+      } else {
+        boxes[i]   = randomBox();
+        proxies[i] = bvh.insert(boxes[i], i);
+        alive[i]   = true;
+      }
+      break;
+    case 1:
+      if (alive[i]) {
+        boxes[i].translate(Vec3(extent(rng), -extent(rng), extent(rng)));
+        bvh.update(proxies[i], boxes[i]);
+      }
+      break;
+    default: {
+      Boxf query = randomBox();
+      query.max += Vec3(50);
+      BFC_TEST_ASSERT_TRUE(queryAll(bvh, query) == bruteForce(boxes, alive, query));
+    } break;
+    }
+  }
+
+  bvh.refit();
+  Boxf everything(Vec3(-1000), Vec3(1000));
+  BFC_TEST_ASSERT_TRUE(queryAll(bvh, everything) == bruteForce(boxes, alive, everything));
+}
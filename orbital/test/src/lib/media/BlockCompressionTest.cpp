@@ -0,0 +1,156 @@
+#include "framework/test.h"
+#include "media/BlockCompression.h"
+#include "util/ThreadPool.h"
+
+#include <cstring>
+#include <random>
+
+using namespace bfc;
+using namespace bfc::media;
+
+namespace {
+  constexpr PixelFormat Formats[] = {PixelFormat_BC1, PixelFormat_BC3, PixelFormat_BC4, PixelFormat_BC5, PixelFormat_BC7};
+
+  Surface makeSurface(PixelFormat format, int32_t width, int32_t height) {
+    Surface surface;
+    surface.format  = format;
+    surface.size    = {width, height, 1};
+    surface.pBuffer = allocateSurface(surface);
+    return surface;
+  }
+
+  /// Smooth colour and alpha gradients with some noise, similar to a photograph.
+  Surface makeImage(int32_t width, int32_t height, uint32_t seed, bool opaque = false) {
+    Surface      image = makeSurface(PixelFormat_RGBAu8, width, height);
+    std::mt19937 rng(seed);
+    for (int32_t y = 0; y < height; ++y) {
+      uint8_t * pRow = (uint8_t *)image.pBuffer + y * getSurfacePitch(image);
+      for (int32_t x = 0; x < width; ++x) {
+        int32_t const noise = int32_t(rng() % 9) - 4;
+        pRow[x * 4 + 0]     = uint8_t(std::clamp(x * 255 / width + noise, 0, 255));
+        pRow[x * 4 + 1]     = uint8_t(std::clamp(y * 255 / height + noise, 0, 255));
+        pRow[x * 4 + 2]     = uint8_t(std::clamp((x + y) * 127 / (width + height) + 64, 0, 255));
+        pRow[x * 4 + 3]     = opaque ? 255 : uint8_t(255 - y * 255 / height);
+      }
+    }
+    return image;
+  }
+} // namespace
+
+BFC_TEST(BlockCompression_SurfaceLayout) {
+  // Sizes are rounded up to whole 4x4 blocks.
+  Surface bc1;
+  bc1.format = PixelFormat_BC1;
+  bc1.size   = {10, 6, 1};
+  BFC_TEST_ASSERT_TRUE(isBlockCompressed(bc1.format));
+  BFC_TEST_ASSERT_EQUAL(getPixelFormatStride(bc1.format), 0);
+  BFC_TEST_ASSERT_EQUAL(getSurfacePitch(bc1), 3 * 8);
+  BFC_TEST_ASSERT_EQUAL(getSurfaceRowCount(bc1), 2);
+  BFC_TEST_ASSERT_EQUAL(calculateSurfaceSize(bc1), 6 * 8);
+
+  Surface bc7;
+  bc7.format = PixelFormat_BC7;
+  bc7.size   = {1, 1, 6};
+  BFC_TEST_ASSERT_EQUAL(getSurfacePitch(bc7), 16);
+  BFC_TEST_ASSERT_EQUAL(calculateSurfaceSize(bc7), 6 * 16);
+
+  BFC_TEST_ASSERT_FALSE(isBlockCompressed(PixelFormat_RGBAu8));
+  BFC_TEST_ASSERT_EQUAL(getPixelFormatBlockSize(PixelFormat_RGBAu8), 0);
+}
+
+BFC_TEST(BlockCompression_Quality) {
+  // Odd sizes exercise the padding of partial blocks.
+  // BC1 only has 1-bit alpha, so it is measured on an opaque image.
+  Surface image  = makeImage(37, 21, 1);
+  Surface opaque = makeImage(37, 21, 1, true);
+  for (PixelFormat format : Formats) {
+    Surface const & source   = format == PixelFormat_BC1 ? opaque : image;
+    double          lastPSNR = 0;
+    for (BlockCompressionQuality quality : {BlockCompressionQuality_Fast, BlockCompressionQuality_Normal, BlockCompressionQuality_High}) {
+      BlockCompressionOptions options;
+      options.quality = quality;
+
+      SurfaceError error;
+      Surface      compressed;
+      compressed.format = format;
+      BFC_TEST_ASSERT_TRUE(compressSurface(&compressed, source, options, &error));
+      BFC_TEST_ASSERT_TRUE(compressed.size == image.size);
+      BFC_TEST_ASSERT_TRUE(error.psnr > 30);
+      BFC_TEST_ASSERT_TRUE(error.psnr >= lastPSNR);
+      lastPSNR = error.psnr;
+
+      // The reported error is the error of the decoded surface.
+      Surface decoded;
+      decoded.format = PixelFormat_RGBAu8;
+      BFC_TEST_ASSERT_TRUE(decompressSurface(&decoded, compressed));
+      SurfaceError measured = measureSurfaceError(source, decoded);
+      if (format == PixelFormat_BC1 || format == PixelFormat_BC3 || format == PixelFormat_BC7)
+        BFC_TEST_ASSERT_TRUE(std::abs(measured.rmse - error.rmse) < 1e-6);
+
+      decoded.free();
+      compressed.free();
+    }
+  }
+  image.free();
+  opaque.free();
+}
+
+BFC_TEST(BlockCompression_SolidColour) {
+  // A solid block is stored without error.
+  Surface   image  = makeSurface(PixelFormat_RGBAu8, 8, 8);
+  uint8_t * pBytes = (uint8_t *)image.pBuffer;
+  for (int64_t i = 0; i < 8 * 8; ++i) {
+    pBytes[i * 4 + 0] = 12;
+    pBytes[i * 4 + 1] = 200;
+    pBytes[i * 4 + 2] = 99;
+    pBytes[i * 4 + 3] = 77;
+  }
+
+  for (PixelFormat format : {PixelFormat_BC4, PixelFormat_BC5, PixelFormat_BC7}) {
+    SurfaceError error;
+    Surface      compressed;
+    compressed.format = format;
+    BFC_TEST_ASSERT_TRUE(compressSurface(&compressed, image, {}, &error));
+    BFC_TEST_ASSERT_EQUAL(error.rmse, 0);
+    compressed.free();
+  }
+  image.free();
+}
+
+BFC_TEST(BlockCompression_Threaded) {
+  ThreadPool pool(4);
+  Surface    image = makeImage(256, 130, 2);
+  for (PixelFormat format : Formats) {
+    Surface serial;
+    serial.format = format;
+    compressSurface(&serial, image);
+
+    BlockCompressionOptions options;
+    options.pThreads = &pool;
+    Surface threaded;
+    threaded.format = format;
+    compressSurface(&threaded, image, options);
+    BFC_TEST_ASSERT_TRUE(memcmp(serial.pBuffer, threaded.pBuffer, calculateSurfaceSize(serial)) == 0);
+
+    Surface decodedSerial   = makeSurface(PixelFormat_RGBAu8, 256, 130);
+    Surface decodedThreaded = makeSurface(PixelFormat_RGBAu8, 256, 130);
+    decompressSurface(&decodedSerial, serial);
+    decompressSurface(&decodedThreaded, serial, &pool);
+    BFC_TEST_ASSERT_TRUE(memcmp(decodedSerial.pBuffer, decodedThreaded.pBuffer, calculateSurfaceSize(decodedSerial)) == 0);
+
+    decodedSerial.free();
+    decodedThreaded.free();
+    serial.free();
+    threaded.free();
+  }
+  image.free();
+}
+
+BFC_TEST(BlockCompression_RejectsInvalid) {
+  Surface image = makeSurface(PixelFormat_RGBAu8, 4, 4);
+  Surface dst;
+  dst.format = PixelFormat_RGBAu8;
+  BFC_TEST_ASSERT_FALSE(compressSurface(&dst, image));
+  BFC_TEST_ASSERT_FALSE(decompressSurface(&dst, image));
+  image.free();
+}
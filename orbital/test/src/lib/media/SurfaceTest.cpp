@@ -0,0 +1,278 @@
+#include "framework/test.h"
+#include "media/Surface.h"
+#include "util/ThreadPool.h"
+
+#include <cstring>
+#include <random>
+
+using namespace bfc;
+using namespace bfc::media;
+
+namespace {
+  Surface makeSurface(PixelFormat format, int32_t width, int32_t height, int32_t depth = 1) {
+    Surface surface;
+    surface.format  = format;
+    surface.size    = {width, height, depth};
+    surface.pBuffer = allocateSurface(surface);
+    return surface;
+  }
+
+  void fillRandom(Surface const & surface, uint32_t seed) {
+    std::mt19937 rng(seed);
+    uint8_t *    pBytes = (uint8_t *)surface.pBuffer;
+    for (int64_t i = 0; i < calculateSurfaceSize(surface); ++i)
+      pBytes[i] = uint8_t(rng());
+  }
+} // namespace
+
+BFC_TEST(Surface_ConvertFormat) {
+  // Odd widths exercise the scalar tails of the vector kernels.
+  for (int32_t width : {1, 5, 37, 64}) {
+    Surface rgb = makeSurface(PixelFormat_RGBu8, width, 3);
+    fillRandom(rgb, width);
+
+    Surface rgba = makeSurface(PixelFormat_RGBAu8, width, 3);
+    convertSurface(&rgba, rgb);
+    uint8_t const * pRGB  = (uint8_t const *)rgb.pBuffer;
+    uint8_t const * pRGBA = (uint8_t const *)rgba.pBuffer;
+    for (int64_t i = 0; i < width * 3; ++i) {
+      BFC_TEST_ASSERT_EQUAL(pRGBA[i * 4 + 0], pRGB[i * 3 + 0]);
+      BFC_TEST_ASSERT_EQUAL(pRGBA[i * 4 + 1], pRGB[i * 3 + 1]);
+      BFC_TEST_ASSERT_EQUAL(pRGBA[i * 4 + 2], pRGB[i * 3 + 2]);
+      BFC_TEST_ASSERT_EQUAL(pRGBA[i * 4 + 3], 255);
+    }
+
+    // 8-bit channels survive a round trip through floats.
+    Surface floats = makeSurface(PixelFormat_RGBAf32, width, 3);
+    Surface result = makeSurface(PixelFormat_RGBu8, width, 3);
+    convertSurface(&floats, rgba);
+    convertSurface(&result, floats);
+    BFC_TEST_ASSERT_TRUE(memcmp(result.pBuffer, rgb.pBuffer, calculateSurfaceSize(rgb)) == 0);
+
+    // And through linear space.
+    ConvertSurfaceOptions decode;
+    decode.srcSpace = ColourSpace_SRGB;
+    ConvertSurfaceOptions encode;
+    encode.dstSpace = ColourSpace_SRGB;
+    convertSurface(&floats, rgba, decode);
+    convertSurface(&result, floats, encode);
+    BFC_TEST_ASSERT_TRUE(memcmp(result.pBuffer, rgb.pBuffer, calculateSurfaceSize(rgb)) == 0);
+
+    rgb.free();
+    rgba.free();
+    floats.free();
+    result.free();
+  }
+}
+
+BFC_TEST(Surface_ConvertPitch) {
+  Surface src = makeSurface(PixelFormat_RGBu8, 13, 4);
+  fillRandom(src, 3);
+
+  Surface dst;
+  dst.format = PixelFormat_RGBu8;
+  dst.size   = src.size;
+  dst.pitch  = 13 * 3 + 7;
+  convertSurface(&dst, src);
+  for (int64_t y = 0; y < 4; ++y) {
+    BFC_TEST_ASSERT_TRUE(memcmp((uint8_t *)dst.pBuffer + y * dst.pitch, (uint8_t *)src.pBuffer + y * 13 * 3, 13 * 3) == 0);
+  }
+
+  src.free();
+  dst.free();
+}
+
+BFC_TEST(Surface_Resample) {
+  // A constant colour is preserved by every filter.
+  Surface src = makeSurface(PixelFormat_RGBAu8, 33, 20);
+  for (int64_t i = 0; i < 33 * 20; ++i)
+    ((uint32_t *)src.pBuffer)[i] = 0x80402010;
+
+  for (ResampleFilter filter : {ResampleFilter_Nearest, ResampleFilter_Box, ResampleFilter_Bilinear, ResampleFilter_Lanczos, ResampleFilter_Kaiser}) {
+    for (ColourSpace space : {ColourSpace_Linear, ColourSpace_SRGB}) {
+      ConvertSurfaceOptions options;
+      options.filter   = filter;
+      options.srcSpace = space;
+      options.dstSpace = space;
+
+      Surface dst = makeSurface(PixelFormat_RGBAu8, 70, 7);
+      convertSurface(&dst, src, options);
+      for (int64_t i = 0; i < 70 * 7; ++i)
+        BFC_TEST_ASSERT_EQUAL(((uint32_t *)dst.pBuffer)[i], 0x80402010);
+      dst.free();
+    }
+  }
+  src.free();
+
+  // Halving with a box filter averages each 2x2 block.
+  Surface ramp = makeSurface(PixelFormat_Rf32, 8, 8);
+  for (int64_t i = 0; i < 64; ++i)
+    ((float *)ramp.pBuffer)[i] = float(i);
+
+  ConvertSurfaceOptions options;
+  options.filter = ResampleFilter_Box;
+  Surface half   = makeSurface(PixelFormat_Rf32, 4, 4);
+  convertSurface(&half, ramp, options);
+  for (int64_t y = 0; y < 4; ++y) {
+    for (int64_t x = 0; x < 4; ++x) {
+      const float expected = (y * 2 + 0.5f) * 8 + x * 2 + 0.5f;
+      BFC_TEST_ASSERT_TRUE(std::abs(((float *)half.pBuffer)[y * 4 + x] - expected) < 1e-4f);
+    }
+  }
+
+  ramp.free();
+  half.free();
+}
+
+BFC_TEST(Surface_ResampleParallel) {
+  Surface src = makeSurface(PixelFormat_RGBAu8, 300, 200, 2);
+  fillRandom(src, 7);
+
+  ThreadPool            pool(4);
+  ConvertSurfaceOptions options;
+  options.filter = ResampleFilter_Lanczos;
+
+  Surface serial   = makeSurface(PixelFormat_RGBu8, 123, 77, 2);
+  Surface parallel = makeSurface(PixelFormat_RGBu8, 123, 77, 2);
+  convertSurface(&serial, src, options);
+  options.pThreads = &pool;
+  convertSurface(&parallel, src, options);
+  BFC_TEST_ASSERT_TRUE(memcmp(serial.pBuffer, parallel.pBuffer, calculateSurfaceSize(serial)) == 0);
+
+  src.free();
+  serial.free();
+  parallel.free();
+}
+
+BFC_TEST(Surface_MipChain) {
+  BFC_TEST_ASSERT_EQUAL(calculateMipCount({1, 1, 1}), 1);
+  BFC_TEST_ASSERT_EQUAL(calculateMipCount({256, 256, 1}), 9);
+  BFC_TEST_ASSERT_EQUAL(calculateMipCount({300, 17, 1}), 9);
+
+  // Non-power-of-two sizes are rounded down.
+  Surface base = makeSurface(PixelFormat_RGBAu8, 37, 10, 2);
+  fillRandom(base, 11);
+
+  for (ResampleFilter filter : {ResampleFilter_Box, ResampleFilter_Kaiser, ResampleFilter_Lanczos}) {
+    MipChainOptions options;
+    options.filter = filter;
+
+    Vector<Surface> mips;
+    BFC_TEST_ASSERT_EQUAL(generateMipChain(&mips, base, options), 5);
+    BFC_TEST_ASSERT_EQUAL(mips.size(), calculateMipCount(base.size) - 1);
+    const Vec3i sizes[] = {{18, 5, 2}, {9, 2, 2}, {4, 1, 2}, {2, 1, 2}, {1, 1, 2}};
+    for (int64_t level = 0; level < mips.size(); ++level) {
+      BFC_TEST_ASSERT_TRUE(mips[level].size == sizes[level]);
+      BFC_TEST_ASSERT_EQUAL(mips[level].format, PixelFormat_RGBAu8);
+    }
+
+    // Levels are the same when filtered in parallel.
+    ThreadPool      pool(4);
+    Vector<Surface> parallel;
+    options.pThreads = &pool;
+    generateMipChain(&parallel, base, options);
+    for (int64_t level = 0; level < mips.size(); ++level)
+      BFC_TEST_ASSERT_TRUE(memcmp(mips[level].pBuffer, parallel[level].pBuffer, calculateSurfaceSize(mips[level])) == 0);
+
+    for (int64_t level = 0; level < mips.size(); ++level) {
+      mips[level].free();
+      parallel[level].free();
+    }
+  }
+  base.free();
+}
+
+BFC_TEST(Surface_MipChainLinear) {
+  // Black and white pixels average to half intensity in linear space, which is brighter in sRGB.
+  Surface base = makeSurface(PixelFormat_RGBAu8, 2, 2);
+  for (int64_t i = 0; i < 4; ++i)
+    ((uint32_t *)base.pBuffer)[i] = i % 3 == 0 ? 0xFFFFFFFF : 0xFF000000;
+
+  MipChainOptions options;
+  options.space = ColourSpace_SRGB;
+  Vector<Surface> mips;
+  generateMipChain(&mips, base, options);
+  BFC_TEST_ASSERT_EQUAL(mips.size(), 1);
+  uint8_t const * pPixel = (uint8_t const *)mips[0].pBuffer;
+  BFC_TEST_ASSERT_EQUAL(pPixel[0], 188);
+  BFC_TEST_ASSERT_EQUAL(pPixel[3], 255);
+  mips[0].free();
+
+  options.space = ColourSpace_Linear;
+  mips.clear();
+  generateMipChain(&mips, base, options);
+  pPixel = (uint8_t const *)mips[0].pBuffer;
+  BFC_TEST_ASSERT_TRUE(pPixel[0] == 127 || pPixel[0] == 128);
+  mips[0].free();
+
+  base.free();
+}
+
+BFC_TEST(Surface_MipChainAlphaCoverage) {
+  // A thin ring of opaque pixels, as in a cutout texture, keeps its coverage in every level.
+  Surface base    = makeSurface(PixelFormat_RGBAf32, 64, 64);
+  float * pPixels = (float *)base.pBuffer;
+  for (int64_t y = 0; y < 64; ++y) {
+    for (int64_t x = 0; x < 64; ++x) {
+      const float radius = std::sqrt(float((x - 32) * (x - 32) + (y - 32) * (y - 32)));
+      for (int64_t c = 0; c < 3; ++c)
+        pPixels[(y * 64 + x) * 4 + c] = 1.0f;
+      pPixels[(y * 64 + x) * 4 + 3] = std::abs(radius - 20) < 1.5f ? 1.0f : 0.0f;
+    }
+  }
+
+  const auto coverage = [](Surface const & surface) {
+    float const * pPixels = (float const *)surface.pBuffer;
+    int64_t       covered = 0;
+    for (int64_t i = 0; i < surface.size.x * surface.size.y; ++i)
+      covered += pPixels[i * 4 + 3] >= 0.5f;
+    return float(covered) / float(surface.size.x * surface.size.y);
+  };
+
+  MipChainOptions options;
+  options.alphaCoverageThreshold = 0.5f;
+  Vector<Surface> mips;
+  generateMipChain(&mips, base, options);
+  const float expected = coverage(base);
+  for (int64_t level = 0; level < 3; ++level)
+    BFC_TEST_ASSERT_TRUE(std::abs(coverage(mips[level]) - expected) < 0.05f);
+
+  for (Surface & mip : mips)
+    mip.free();
+  base.free();
+}
+
+BFC_TEST(Surface_MipChainNormals) {
+  // Averaged normals are shorter than 1 unless they are renormalized.
+  Surface base    = makeSurface(PixelFormat_RGBAf32, 16, 16);
+  float * pPixels = (float *)base.pBuffer;
+
+  std::mt19937                          rng(5);
+  std::uniform_real_distribution<float> tilt(-0.8f, 0.8f);
+  for (int64_t i = 0; i < 16 * 16; ++i) {
+    const float x   = tilt(rng);
+    const float y   = tilt(rng);
+    const float len = std::sqrt(x * x + y * y + 1.0f);
+
+    pPixels[i * 4 + 0] = x / len * 0.5f + 0.5f;
+    pPixels[i * 4 + 1] = y / len * 0.5f + 0.5f;
+    pPixels[i * 4 + 2] = 1.0f / len * 0.5f + 0.5f;
+    pPixels[i * 4 + 3] = 1.0f;
+  }
+
+  MipChainOptions options;
+  options.normalMap = true;
+  Vector<Surface> mips;
+  generateMipChain(&mips, base, options);
+  for (Surface & mip : mips) {
+    float const * pMip = (float const *)mip.pBuffer;
+    for (int64_t i = 0; i < mip.size.x * mip.size.y; ++i) {
+      const float x = pMip[i * 4 + 0] * 2 - 1;
+      const float y = pMip[i * 4 + 1] * 2 - 1;
+      const float z = pMip[i * 4 + 2] * 2 - 1;
+      BFC_TEST_ASSERT_TRUE(std::abs(std::sqrt(x * x + y * y + z * z) - 1.0f) < 1e-4f);
+    }
+    mip.free();
+  }
+  base.free();
+}
@@ -0,0 +1,78 @@
+#include "framework/test.h"
+#include "framework/GridMesh.h"
+#include "mesh/MeshBlob.h"
+#include "mesh/MeshSimplifier.h"
+#include "core/Stream.h"
+
+using namespace bfc;
+
+BFC_TEST(MeshBlob_Build) {
+  MeshData data = test::makeGrid(32);
+  data.addDefaults();
+  MeshSimplifier::generateLODs(&data, 2);
+
+  MeshBlob blob(data, MeshOptimizeFlags_All);
+  BFC_TEST_ASSERT_TRUE(!blob.empty());
+  BFC_TEST_ASSERT_EQUAL(blob.getLodCount(), data.lods.size() + 1);
+  BFC_TEST_ASSERT_EQUAL(blob.lodErrors().size(), data.lods.size());
+  BFC_TEST_ASSERT_EQUAL(blob.subMeshes().size(), 2);
+  BFC_TEST_ASSERT_TRUE(blob.meshlets().size() > 0);
+
+  // Every section is aligned and indexes valid vertices.
+  MeshBlob::Header const & header = blob.header();
+  BFC_TEST_ASSERT_EQUAL(header.size, blob.bytes().size());
+  BFC_TEST_ASSERT_EQUAL(header.vertices.offset % MeshBlob::Alignment, 0);
+  BFC_TEST_ASSERT_EQUAL(header.indices.offset % MeshBlob::Alignment, 0);
+  BFC_TEST_ASSERT_EQUAL(header.subMeshes.offset % MeshBlob::Alignment, 0);
+  BFC_TEST_ASSERT_EQUAL(header.meshlets.offset % MeshBlob::Alignment, 0);
+  for (Mesh::Index index : blob.indices())
+    BFC_TEST_ASSERT_TRUE(index < blob.vertices().size());
+
+  int64_t triangleCount = 0;
+  for (Mesh::SubMesh const & subMesh : blob.subMeshes())
+    triangleCount += subMesh.elmCount / 3;
+  BFC_TEST_ASSERT_EQUAL(triangleCount, data.triangles.size());
+}
+
+BFC_TEST(MeshBlob_ReadWrite) {
+  MeshData data = test::makeGrid(16);
+  data.addDefaults();
+
+  MeshBlob     blob(data, MeshOptimizeFlags_All);
+  MemoryStream stream;
+  BFC_TEST_ASSERT_TRUE(stream.write(blob));
+
+  stream.seek(0, SeekOrigin_Start);
+  std::optional<MeshBlob> loaded = read<MeshBlob>(&stream);
+  BFC_TEST_ASSERT_TRUE(loaded.has_value());
+  BFC_TEST_ASSERT_EQUAL(loaded->bytes().size(), blob.bytes().size());
+  BFC_TEST_ASSERT_TRUE(memcmp(loaded->bytes().data(), blob.bytes().data(), blob.bytes().size()) == 0);
+}
+
+BFC_TEST(MeshBlob_Validate) {
+  MeshData data = test::makeGrid(16);
+  data.addDefaults();
+
+  MeshBlob        blob(data);
+  Vector<uint8_t> bytes(blob.bytes());
+
+  // A valid blob is accepted.
+  MeshBlob copy;
+  BFC_TEST_ASSERT_TRUE(copy.assign(Vector<uint8_t>(bytes)));
+
+  // Changing a single byte of the contents fails the checksum.
+  Vector<uint8_t> corrupt = bytes;
+  corrupt[blob.header().indices.offset] ^= 1;
+  BFC_TEST_ASSERT_TRUE(!copy.assign(std::move(corrupt)));
+  BFC_TEST_ASSERT_TRUE(copy.empty());
+
+  // Blobs from other versions are rejected.
+  Vector<uint8_t>  outdated = bytes;
+  MeshBlob::Header header   = blob.header();
+  header.version += 1;
+  memcpy(outdated.data(), &header, sizeof(header));
+  BFC_TEST_ASSERT_TRUE(!copy.assign(std::move(outdated)));
+
+  // Truncated blobs are rejected.
+  BFC_TEST_ASSERT_TRUE(!copy.assign(Vector<uint8_t>(bytes.getView(0, bytes.size() - 1))));
+}
@@ -0,0 +1,124 @@
+#include "framework/test.h"
+#include "framework/GridMesh.h"
+#include "mesh/MeshOptimizer.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace bfc;
+
+namespace {
+  struct TestVertex {
+    float position[3];
+    float uv[2];
+  };
+
+  /// The vertices of a `dim` x `dim` grid, with positions scaled to one unit per quad.
+  Vector<TestVertex> gridVertices(MeshData const & grid, int64_t dim) {
+    Vector<TestVertex> vertices;
+    for (Vec3d const & position : grid.positions)
+      vertices.pushBack(TestVertex{{float(position.x * dim), float(position.y * dim), 0}, {float(position.x), float(position.y)}});
+    return vertices;
+  }
+
+  /// The triangles of `indices` in a random order.
+  Vector<MeshOptimizer::Index> shuffleTriangles(Vector<MeshOptimizer::Index> const & indices) {
+    Vector<Vector<MeshOptimizer::Index>> triangles;
+    for (int64_t i = 0; i < indices.size(); i += 3)
+      triangles.pushBack({indices[i], indices[i + 1], indices[i + 2]});
+
+    std::mt19937 rng(3);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+
+    Vector<MeshOptimizer::Index> shuffled;
+    for (auto & tri : triangles)
+      shuffled.pushBack(tri);
+    return shuffled;
+  }
+
+  /// Triangles with their vertices rotated so the smallest index is first, sorted.
+  Vector<Vector<MeshOptimizer::Index>> canonicalTriangles(Vector<MeshOptimizer::Index> const & indices) {
+    Vector<Vector<MeshOptimizer::Index>> triangles;
+    for (int64_t i = 0; i < indices.size(); i += 3) {
+      MeshOptimizer::Index tri[3] = {indices[i], indices[i + 1], indices[i + 2]};
+      std::rotate(tri, std::min_element(tri, tri + 3), tri + 3);
+      triangles.pushBack(tri);
+    }
+    std::sort(triangles.begin(), triangles.end(), [](auto const & a, auto const & b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); });
+    return triangles;
+  }
+
+  bool sameTriangles(Vector<MeshOptimizer::Index> const & a, Vector<MeshOptimizer::Index> const & b) {
+    auto ta = canonicalTriangles(a);
+    auto tb = canonicalTriangles(b);
+    if (ta.size() != tb.size())
+      return false;
+    for (int64_t i = 0; i < ta.size(); ++i)
+      if (!std::equal(ta[i].begin(), ta[i].end(), tb[i].begin()))
+        return false;
+    return true;
+  }
+}
+
+BFC_TEST(MeshOptimizer_WeldVertices) {
+  Vector<TestVertex> vertices = {
+    {{0, 0, 0}, {0, 0}},
+    {{1, 0, 0}, {1, 0}},
+    {{0, 0, 0}, {0, 0}},
+    {{1, 0, 0}, {0, 1}},
+  };
+
+  Vector<MeshOptimizer::Index> remap;
+  BFC_TEST_ASSERT_EQUAL(MeshOptimizer::weldVertices(vertices.data(), vertices.size(), sizeof(TestVertex), &remap), 3);
+  BFC_TEST_ASSERT_EQUAL(remap[0], 0);
+  BFC_TEST_ASSERT_EQUAL(remap[1], 1);
+  BFC_TEST_ASSERT_EQUAL(remap[2], 0);
+  BFC_TEST_ASSERT_EQUAL(remap[3], 2);
+
+  Vector<TestVertex> welded;
+  welded.resize(3);
+  MeshOptimizer::remapVertices(welded.data(), vertices.data(), vertices.size(), sizeof(TestVertex), remap);
+  BFC_TEST_ASSERT_EQUAL(welded[2].uv[1], 1.0f);
+}
+
+BFC_TEST(MeshOptimizer_VertexCache) {
+  MeshData const               grid     = test::makeGrid(64);
+  Vector<TestVertex>           vertices = gridVertices(grid, 64);
+  Vector<MeshOptimizer::Index> indices  = shuffleTriangles(test::triangleIndices<MeshOptimizer::Index>(grid));
+
+  Vector<MeshOptimizer::Index> optimized = indices;
+  MeshOptimizer::optimizeVertexCache(optimized, vertices.size());
+  BFC_TEST_ASSERT_TRUE(sameTriangles(indices, optimized));
+
+  MeshCacheStatistics before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+  MeshCacheStatistics after  = MeshOptimizer::analyzeVertexCache(optimized, vertices.size());
+  BFC_TEST_ASSERT_TRUE(after.acmr < 1.0f);
+  BFC_TEST_ASSERT_TRUE(after.acmr < before.acmr);
+  BFC_TEST_ASSERT_TRUE(after.atvr < 2.0f);
+
+  // Overdraw ordering must keep the triangles, and stay close to the cache efficiency.
+  MeshOptimizer::optimizeOverdraw(optimized, vertices[0].position, vertices.size(), sizeof(TestVertex), 1.05f);
+  BFC_TEST_ASSERT_TRUE(sameTriangles(indices, optimized));
+  BFC_TEST_ASSERT_TRUE(MeshOptimizer::analyzeVertexCache(optimized, vertices.size()).acmr < before.acmr);
+}
+
+BFC_TEST(MeshOptimizer_VertexFetch) {
+  MeshData const               grid     = test::makeGrid(8);
+  Vector<TestVertex>           vertices = gridVertices(grid, 8);
+  Vector<MeshOptimizer::Index> indices  = shuffleTriangles(test::triangleIndices<MeshOptimizer::Index>(grid));
+  vertices.pushBack(TestVertex{{-1, -1, -1}, {0, 0}}); // Unreferenced
+
+  Vector<TestVertex>           original  = vertices;
+  Vector<MeshOptimizer::Index> reordered = indices;
+  int64_t count = MeshOptimizer::optimizeVertexFetch(reordered, vertices.data(), vertices.size(), sizeof(TestVertex));
+  BFC_TEST_ASSERT_EQUAL(count, original.size() - 1);
+
+  // Indices are first referenced in increasing order, and still reference the same data.
+  MeshOptimizer::Index next = 0;
+  for (int64_t i = 0; i < reordered.size(); ++i) {
+    BFC_TEST_ASSERT_TRUE(reordered[i] <= next);
+    next = std::max(next, reordered[i] + 1);
+    BFC_TEST_ASSERT_EQUAL(vertices[reordered[i]].position[0], original[indices[i]].position[0]);
+    BFC_TEST_ASSERT_EQUAL(vertices[reordered[i]].position[1], original[indices[i]].position[1]);
+  }
+}
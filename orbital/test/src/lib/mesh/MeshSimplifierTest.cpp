@@ -0,0 +1,148 @@
+#include "framework/test.h"
+#include "framework/GridMesh.h"
+#include "mesh/MeshSimplifier.h"
+
+#include <cmath>
+
+using namespace bfc;
+
+namespace {
+  /// Displace a grid from test::makeGrid() in Z by `height`, and split its UVs into two islands
+  /// down the middle of the grid.
+  void displaceAndSplitUVs(MeshData * pGrid, int64_t dim, double height) {
+    MeshData & mesh = *pGrid;
+    for (int64_t i = 0; i < mesh.positions.size(); ++i)
+      mesh.positions[i].z = height * sin(i % (dim + 1) * 0.3) * cos(i / (dim + 1) * 0.2);
+
+    // The right half of the grid uses a copy of the vertices with their UVs moved to a second island.
+    const int64_t gridSize = mesh.vertices.size();
+    for (int64_t i = 0; i < gridSize; ++i) {
+      MeshData::Vertex vert = mesh.vertices[i];
+      const Vec2d      uv   = mesh.uvs[vert.uv] + Vec2d(2, 0);
+      vert.uv               = mesh.uvs.size();
+      mesh.uvs.pushBack(uv);
+      mesh.vertices.pushBack(vert);
+    }
+
+    for (int64_t t = 0; t < mesh.triangles.size(); ++t)
+      if ((t / 2) % dim >= dim / 2)
+        for (int64_t & vertex : mesh.triangles[t].vertex)
+          vertex += gridSize;
+  }
+
+  double projectedArea(MeshData const & mesh, Vector<MeshData::Triangle> const & triangles) {
+    double area = 0;
+    for (MeshData::Triangle const & tri : triangles) {
+      Vec3d a = mesh.positions[mesh.vertices[tri.vertex[0]].position];
+      Vec3d b = mesh.positions[mesh.vertices[tri.vertex[1]].position];
+      Vec3d c = mesh.positions[mesh.vertices[tri.vertex[2]].position];
+      area += 0.5 * ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+    }
+    return area;
+  }
+
+  /// The largest vertical distance from a point of `mesh` to the heightfield formed by `triangles`.
+  double maxDeviation(MeshData const & mesh, Vector<MeshData::Triangle> const & triangles) {
+    double deviation = 0;
+    for (Vec3d const & p : mesh.positions) {
+      for (MeshData::Triangle const & tri : triangles) {
+        Vec3d        a   = mesh.positions[mesh.vertices[tri.vertex[0]].position];
+        Vec3d        b   = mesh.positions[mesh.vertices[tri.vertex[1]].position];
+        Vec3d        c   = mesh.positions[mesh.vertices[tri.vertex[2]].position];
+        const double det = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+        const double u   = ((p.x - a.x) * (c.y - a.y) - (c.x - a.x) * (p.y - a.y)) / det;
+        const double v   = ((b.x - a.x) * (p.y - a.y) - (p.x - a.x) * (b.y - a.y)) / det;
+        if (u < -1e-9 || v < -1e-9 || u + v > 1 + 1e-9)
+          continue;
+        deviation = std::max(deviation, std::abs(a.z + u * (b.z - a.z) + v * (c.z - a.z) - p.z));
+        break;
+      }
+    }
+    return deviation;
+  }
+} // namespace
+
+BFC_TEST(MeshSimplifier_Flat) {
+  MeshData mesh = test::makeGrid(32);
+  displaceAndSplitUVs(&mesh, 32, 0);
+
+  MeshSimplifyOptions options;
+  options.targetTriangleCount = mesh.triangles.size() / 4;
+
+  double                     error     = -1;
+  Vector<MeshData::Triangle> triangles = MeshSimplifier::simplify(mesh, mesh.triangles, options, &error);
+
+  // A plane can be simplified without any error, and without changing its outline.
+  BFC_TEST_ASSERT_TRUE(triangles.size() <= options.targetTriangleCount);
+  BFC_TEST_ASSERT_TRUE(triangles.size() > 0);
+  BFC_TEST_ASSERT_TRUE(error >= 0 && error < 1e-5);
+  BFC_TEST_ASSERT_TRUE(std::abs(projectedArea(mesh, triangles) - 1) < 1e-9);
+}
+
+BFC_TEST(MeshSimplifier_Seams) {
+  MeshData mesh = test::makeGrid(32);
+  displaceAndSplitUVs(&mesh, 32, 0.1);
+
+  const int64_t gridSize = 33 * 33;
+
+  MeshSimplifyOptions options;
+  options.targetTriangleCount = mesh.triangles.size() / 8;
+
+  Vector<MeshData::Triangle> triangles = MeshSimplifier::simplify(mesh, mesh.triangles, options);
+  BFC_TEST_ASSERT_TRUE(triangles.size() < mesh.triangles.size() / 2);
+
+  int64_t perMaterial[2] = {0, 0};
+  for (MeshData::Triangle const & tri : triangles) {
+    // Triangles must not cross the UV seam...
+    const bool island = tri.vertex[0] >= gridSize;
+    BFC_TEST_ASSERT_EQUAL(tri.vertex[1] >= gridSize, island);
+    BFC_TEST_ASSERT_EQUAL(tri.vertex[2] >= gridSize, island);
+    ++perMaterial[tri.material];
+  }
+
+  // ... and both materials are kept.
+  BFC_TEST_ASSERT_TRUE(perMaterial[0] > 0);
+  BFC_TEST_ASSERT_TRUE(perMaterial[1] > 0);
+  BFC_TEST_ASSERT_TRUE(std::abs(projectedArea(mesh, triangles) - 1) < 1e-9);
+}
+
+BFC_TEST(MeshSimplifier_ErrorIsDistance) {
+  MeshSimplifyOptions options;
+  options.targetTriangleCount = 0;
+  options.targetError         = 0.01;
+
+  // The error is a distance, so it scales with the mesh.
+  for (double scale : {1.0, 10.0}) {
+    MeshData mesh = test::makeGrid(32);
+    displaceAndSplitUVs(&mesh, 32, 0.1);
+    for (Vec3d & position : mesh.positions)
+      position = position * scale;
+
+    double                     error     = -1;
+    Vector<MeshData::Triangle> triangles = MeshSimplifier::simplify(mesh, mesh.triangles, options, &error);
+    BFC_TEST_ASSERT_TRUE(triangles.size() < mesh.triangles.size() / 4);
+    BFC_TEST_ASSERT_TRUE(error <= options.targetError * scale);
+
+    // The error is an estimate, but it should be close to how far the simplified surface actually moved.
+    const double deviation = maxDeviation(mesh, triangles);
+    BFC_TEST_ASSERT_TRUE(error < deviation);
+    BFC_TEST_ASSERT_TRUE(deviation < error * 4);
+  }
+}
+
+BFC_TEST(MeshSimplifier_GenerateLODs) {
+  MeshData mesh = test::makeGrid(32);
+  displaceAndSplitUVs(&mesh, 32, 0.1);
+  MeshSimplifier::generateLODs(&mesh, 3);
+
+  BFC_TEST_ASSERT_EQUAL(mesh.lods.size(), 3);
+
+  int64_t previousCount = mesh.triangles.size();
+  double  previousError = 0;
+  for (MeshData::LevelOfDetail const & lod : mesh.lods) {
+    BFC_TEST_ASSERT_TRUE(lod.triangles.size() < previousCount);
+    BFC_TEST_ASSERT_TRUE(lod.error >= previousError);
+    previousCount = lod.triangles.size();
+    previousError = lod.error;
+  }
+}
@@ -0,0 +1,86 @@
+#include "framework/test.h"
+#include "framework/GridMesh.h"
+#include "mesh/Meshlet.h"
+
+#include <algorithm>
+
+using namespace bfc;
+
+namespace {
+  /// The positions of a grid, moved to lie between -0.9 and 0.9 in the XY plane.
+  Vector<Vec3> centredPositions(MeshData const & grid) {
+    Vector<Vec3> positions;
+    for (Vec3d const & position : grid.positions)
+      positions.pushBack(Vec3(position.x * 1.8 - 0.9, position.y * 1.8 - 0.9, 0));
+    return positions;
+  }
+} // namespace
+
+BFC_TEST(Meshlet_Build) {
+  MeshData const                grid      = test::makeGrid(32);
+  Vector<Vec3>                  positions = centredPositions(grid);
+  Vector<MeshletBuilder::Index> indices   = test::triangleIndices<MeshletBuilder::Index>(grid);
+
+  Vector<MeshletBuilder::Index> original = indices;
+  Vector<Meshlet>               meshlets = MeshletBuilder::build(indices, &positions[0].x, positions.size(), sizeof(Vec3));
+  BFC_TEST_ASSERT_TRUE(meshlets.size() > 1);
+
+  int64_t offset = 0;
+  for (Meshlet const & meshlet : meshlets) {
+    // Meshlets cover the indices in order, within the vertex and triangle limits.
+    BFC_TEST_ASSERT_EQUAL(meshlet.elmOffset, offset);
+    BFC_TEST_ASSERT_TRUE(meshlet.elmCount / 3 <= MeshletBuilder::DefaultMaxTriangles);
+    offset += meshlet.elmCount;
+
+    Vector<MeshletBuilder::Index> vertices(indices.begin() + meshlet.elmOffset, indices.begin() + meshlet.elmOffset + meshlet.elmCount);
+    std::sort(vertices.begin(), vertices.end());
+    BFC_TEST_ASSERT_TRUE(std::unique(vertices.begin(), vertices.end()) - vertices.begin() <= MeshletBuilder::DefaultMaxVertices);
+
+    for (MeshletBuilder::Index index : vertices)
+      BFC_TEST_ASSERT_TRUE(glm::length(positions[index] - meshlet.bounds.center) <= meshlet.bounds.radius * 1.0001f);
+
+    // A flat grid has a zero width normal cone.
+    BFC_TEST_ASSERT_TRUE(meshlet.coneCutoff < 1e-3f);
+    BFC_TEST_ASSERT_TRUE(meshlet.coneAxis.z > 0.999f);
+  }
+  BFC_TEST_ASSERT_EQUAL(offset, indices.size());
+
+  // The same triangles are kept.
+  auto sortedTriangles = [](Vector<MeshletBuilder::Index> const & list) {
+    Vector<Vector<MeshletBuilder::Index>> triangles;
+    for (int64_t i = 0; i < list.size(); i += 3) {
+      MeshletBuilder::Index tri[3] = {list[i], list[i + 1], list[i + 2]};
+      std::rotate(tri, std::min_element(tri, tri + 3), tri + 3);
+      triangles.pushBack(tri);
+    }
+    std::sort(triangles.begin(), triangles.end(), [](auto const & a, auto const & b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); });
+    return triangles;
+  };
+
+  auto before = sortedTriangles(original);
+  auto after  = sortedTriangles(indices);
+  BFC_TEST_ASSERT_EQUAL(before.size(), after.size());
+  for (int64_t i = 0; i < before.size(); ++i)
+    BFC_TEST_ASSERT_TRUE(std::equal(before[i].begin(), before[i].end(), after[i].begin()));
+}
+
+BFC_TEST(Meshlet_Culling) {
+  MeshData const                grid      = test::makeGrid(32);
+  Vector<Vec3>                  positions = centredPositions(grid);
+  Vector<MeshletBuilder::Index> indices   = test::triangleIndices<MeshletBuilder::Index>(grid);
+
+  Vector<Meshlet>    meshlets = MeshletBuilder::build(indices, &positions[0].x, positions.size(), sizeof(Vec3));
+  geometry::Frustumf clipSpace;
+
+  for (Meshlet const & meshlet : meshlets) {
+    // Visible from the front, culled from behind, and visible from behind without the cone test.
+    BFC_TEST_ASSERT_TRUE(MeshletBuilder::isVisible(meshlet, clipSpace, Vec3(0, 0, 5)));
+    BFC_TEST_ASSERT_TRUE(!MeshletBuilder::isVisible(meshlet, clipSpace, Vec3(0, 0, -5)));
+    BFC_TEST_ASSERT_TRUE(MeshletBuilder::isVisible(meshlet, clipSpace, Vec3(0, 0, -5), false));
+  }
+
+  // Meshlets outside of the frustum are culled.
+  geometry::Frustumf shifted(glm::translate(Mat4(1), Vec3(-10, 0, 0)));
+  for (Meshlet const & meshlet : meshlets)
+    BFC_TEST_ASSERT_TRUE(!MeshletBuilder::isVisible(meshlet, shifted, Vec3(0, 0, 5)));
+}
@@ -0,0 +1,104 @@
+#include "framework/test.h"
+#include "core/Stream.h"
+#include "mesh/parsers/OBJParser.h"
+
+#include <string>
+
+using namespace bfc;
+
+static bool parseOBJ(std::string const & text, MeshData * pMesh, ThreadPool * pThreads) {
+  MemoryReader reader(Span<uint8_t>((uint8_t *)text.data(), (int64_t)text.size()));
+  return OBJParser::read(&reader, pMesh, "", pThreads);
+}
+
+BFC_TEST(OBJParser_Quad) {
+  std::string text = "v 0 0 0\n"
+                     "v 1 0 0\n"
+                     "v 1 1 0\n"
+                     "v 0 1 0\n"
+                     "vt 0 0\n"
+                     "vt 1 1\n"
+                     "vn 0 0 1\n"
+                     "f 1/1/1 2/2/1 3/1/1 4/2/1\n"
+                     "usemtl red\n"
+                     "f -4/-2/-1 -3/-1/-1 -2/-2/-1\r\n";
+
+  MeshData mesh;
+  BFC_TEST_ASSERT_TRUE(parseOBJ(text, &mesh, nullptr));
+  BFC_TEST_ASSERT_EQUAL(mesh.positions.size(), 4);
+  BFC_TEST_ASSERT_EQUAL(mesh.uvs.size(), 2);
+  BFC_TEST_ASSERT_EQUAL(mesh.normals.size(), 1);
+  BFC_TEST_ASSERT_EQUAL(mesh.triangles.size(), 3);
+  BFC_TEST_ASSERT_TRUE(mesh.positions[2] == Vec3d(1, 1, 0));
+
+  // The last face reuses the corners of the first triangle, so no vertices are added for it.
+  BFC_TEST_ASSERT_EQUAL(mesh.vertices.size(), 4);
+  BFC_TEST_ASSERT_EQUAL(mesh.triangles[1].vertex[0], 0);
+  BFC_TEST_ASSERT_EQUAL(mesh.triangles[1].vertex[1], 2);
+  BFC_TEST_ASSERT_EQUAL(mesh.triangles[1].vertex[2], 3);
+  for (int64_t i = 0; i < 3; ++i)
+    BFC_TEST_ASSERT_EQUAL(mesh.triangles[2].vertex[i], mesh.triangles[0].vertex[i]);
+
+  BFC_TEST_ASSERT_EQUAL(mesh.vertices[3].position, 3);
+  BFC_TEST_ASSERT_EQUAL(mesh.vertices[3].uv, 1);
+  BFC_TEST_ASSERT_EQUAL(mesh.vertices[3].normal, 0);
+  BFC_TEST_ASSERT_EQUAL(mesh.materials.size(), 1);
+}
+
+BFC_TEST(OBJParser_Parallel) {
+  // Large enough to be split into several chunks. Relative indices cross chunk boundaries.
+  std::string text;
+  const int64_t count = 200000;
+  for (int64_t i = 0; i < count; ++i)
+    text += "v " + std::to_string(i) + " 2 3\n";
+  for (int64_t i = 1; i + 1 < count; ++i)
+    text += "f " + std::to_string(i) + " " + std::to_string(i + 1) + " -1\n";
+
+  MeshData   serial;
+  MeshData   parallel;
+  ThreadPool pool(4);
+  BFC_TEST_ASSERT_TRUE(parseOBJ(text, &serial, nullptr));
+  BFC_TEST_ASSERT_TRUE(parseOBJ(text, &parallel, &pool));
+
+  BFC_TEST_ASSERT_EQUAL(serial.positions.size(), count);
+  BFC_TEST_ASSERT_EQUAL(serial.vertices.size(), count);
+  BFC_TEST_ASSERT_EQUAL(serial.triangles.size(), count - 2);
+  BFC_TEST_ASSERT_EQUAL(parallel.vertices.size(), serial.vertices.size());
+  BFC_TEST_ASSERT_EQUAL(parallel.triangles.size(), serial.triangles.size());
+  for (int64_t i = 0; i < serial.vertices.size(); ++i)
+    BFC_TEST_ASSERT_EQUAL(parallel.vertices[i].position, serial.vertices[i].position);
+  for (int64_t i = 0; i < serial.triangles.size(); ++i)
+    for (int64_t v = 0; v < 3; ++v)
+      BFC_TEST_ASSERT_EQUAL(parallel.triangles[i].vertex[v], serial.triangles[i].vertex[v]);
+
+  // Every triangle references the last position through its relative index.
+  BFC_TEST_ASSERT_EQUAL(serial.vertices[serial.triangles.back().vertex[2]].position, count - 1);
+}
+
+BFC_TEST(OBJParser_MaterialLibrary) {
+  std::string const text = "mtllib materials/box.mtl\n"
+                           "v 0 0 0\n"
+                           "v 1 0 0\n"
+                           "v 1 1 0\n"
+                           "usemtl red\n"
+                           "f 1 2 3\n";
+  std::string const library = "newmtl red\n"
+                              "Kd 1 0 0\n";
+
+  // Referenced files are opened through the callback, by the path written in the OBJ file.
+  String       opened;
+  MeshData     mesh;
+  MemoryReader reader(Span<uint8_t>((uint8_t *)text.data(), (int64_t)text.size()));
+  BFC_TEST_ASSERT_TRUE(OBJParser::read(
+    &reader, &mesh,
+    [&](StringView const & path) -> Ref<Stream> {
+      opened = path;
+      return NewRef<MemoryReader>(Span<uint8_t>((uint8_t *)library.data(), (int64_t)library.size()));
+    },
+    nullptr));
+
+  BFC_TEST_ASSERT_EQUAL(opened, "materials/box.mtl");
+  BFC_TEST_ASSERT_EQUAL(mesh.materials.size(), 1);
+  BFC_TEST_ASSERT_EQUAL(mesh.materials[0].getName(), "red");
+  BFC_TEST_ASSERT_TRUE(mesh.materials[0].getColour(MeshData::Material::Phong::diffuse) == Vec4(1, 0, 0, 1));
+}
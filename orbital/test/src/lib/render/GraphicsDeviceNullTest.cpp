@@ -0,0 +1,93 @@
+#include "framework/test.h"
+#include "render/GraphicsDevice.h"
+#include <chrono>
+
+using namespace bfc;
+using namespace std::chrono_literals;
+
+static Ref<GraphicsDevice> createNullDevice() {
+  graphicsDevice_registerNull();
+  Ref<GraphicsDevice> pDevice = createGraphicsDevice("null");
+  if (pDevice != nullptr && !pDevice->init(nullptr))
+    return nullptr;
+  return pDevice;
+}
+
+BFC_TEST(GraphicsDeviceNull_Create) {
+  Ref<GraphicsDevice> pDevice = createNullDevice();
+  BFC_TEST_ASSERT_TRUE(pDevice != nullptr);
+  BFC_TEST_ASSERT_TRUE(pDevice->getDefaultRenderTarget() != nullptr);
+
+  graphics::FrameStatistics stats;
+  BFC_TEST_ASSERT_FALSE(pDevice->getFrameStatistics(&stats));
+}
+
+BFC_TEST(GraphicsDeviceNull_Fence) {
+  Ref<GraphicsDevice> pDevice = createNullDevice();
+  BFC_TEST_ASSERT_TRUE(pDevice != nullptr);
+
+  uint64_t first  = pDevice->submit(pDevice->createCommandList());
+  uint64_t second = pDevice->submit(pDevice->createCommandList());
+  BFC_TEST_ASSERT_TRUE(second > first);
+  BFC_TEST_ASSERT_TRUE(pDevice->wait(second, Timestamp::fromSecs(1)));
+  BFC_TEST_ASSERT_TRUE(pDevice->wait(first, Timestamp::fromSecs(1)));
+}
+
+BFC_TEST(GraphicsDeviceNull_FrameStatistics) {
+  Ref<GraphicsDevice> pDevice = createNullDevice();
+  BFC_TEST_ASSERT_TRUE(pDevice != nullptr);
+
+  uint8_t data[64] = {0};
+
+  auto pCmdList = pDevice->createCommandList();
+  auto pBuffer  = pCmdList->createBuffer(BufferUsageHint_Uniform);
+  pCmdList->bindScreen();
+  pCmdList->bindProgram(pCmdList->createProgram());
+  pCmdList->bindUniformBuffer(pBuffer, 0);
+  pCmdList->upload(pBuffer, sizeof(data), data);
+  pCmdList->pushState(graphics::State::EnableBlend{false}, graphics::State::EnableDepthRead{false});
+  pCmdList->draw(3);
+  pCmdList->draw(6, 0, PrimitiveType_Triangle, 4);
+  pCmdList->popState();
+  pCmdList->swap();
+  pDevice->wait(pDevice->submit(std::move(pCmdList)));
+
+  graphics::FrameStatistics stats;
+  BFC_TEST_ASSERT_TRUE(pDevice->getFrameStatistics(&stats));
+  BFC_TEST_ASSERT_EQUAL(stats.frame, 0);
+  BFC_TEST_ASSERT_EQUAL(stats.commandLists, 1);
+  BFC_TEST_ASSERT_EQUAL(stats.drawCalls, 2);
+  BFC_TEST_ASSERT_EQUAL(stats.instances, 5);
+  BFC_TEST_ASSERT_EQUAL(stats.elements, 9);
+  BFC_TEST_ASSERT_EQUAL(stats.binds(), 3);
+  BFC_TEST_ASSERT_EQUAL(stats.bytesUploaded, (int64_t)sizeof(data));
+  BFC_TEST_ASSERT_TRUE(stats.stateChanges >= 2);
+
+  // Counters reset at the start of each frame.
+  pCmdList = pDevice->createCommandList();
+  pCmdList->swap();
+  pDevice->wait(pDevice->submit(std::move(pCmdList)));
+  BFC_TEST_ASSERT_TRUE(pDevice->getFrameStatistics(&stats));
+  BFC_TEST_ASSERT_EQUAL(stats.frame, 1);
+  BFC_TEST_ASSERT_EQUAL(stats.drawCalls, 0);
+  BFC_TEST_ASSERT_EQUAL(stats.bytesUploaded, 0);
+}
+
+BFC_TEST(GraphicsDeviceNull_Map) {
+  Ref<GraphicsDevice> pDevice = createNullDevice();
+  BFC_TEST_ASSERT_TRUE(pDevice != nullptr);
+
+  int32_t values[4] = {1, 2, 3, 4};
+
+  auto pCmdList = pDevice->createCommandList();
+  auto pBuffer  = pCmdList->createBuffer();
+  pCmdList->upload(pBuffer, sizeof(values), values);
+  std::future<void *> mapped = pCmdList->map(pBuffer, MapAccess_Read);
+  pDevice->submit(std::move(pCmdList));
+
+  BFC_TEST_ASSERT_EQUAL(mapped.wait_for(1s), std::future_status::ready);
+  int32_t const * pMapped = (int32_t const *)mapped.get();
+  BFC_TEST_ASSERT_TRUE(pMapped != nullptr);
+  for (int64_t i = 0; i < 4; ++i)
+    BFC_TEST_ASSERT_EQUAL(pMapped[i], values[i]);
+}
@@ -0,0 +1,185 @@
+#include "framework/test.h"
+#include "framework/TestData.h"
+#include "util/Cache.h"
+
+#include <filesystem>
+
+using namespace bfc;
+
+namespace {
+  CacheOptions packedOptions() {
+    CacheOptions options;
+    options.storage = CacheStorage_Packed;
+    return options;
+  }
+
+  /// Store `size` bytes with the value `value`.
+  void store(Cache * pCache, StringView const & identifier, int64_t value, int64_t size, int64_t flags = CacheEntryFlags_None) {
+    Cache::Entry    entry = pCache->create(flags);
+    Vector<uint8_t> data(size, uint8_t(value));
+    entry.version = value;
+    entry.stream()->write(data.data(), size);
+    pCache->commit(identifier, &entry);
+  }
+
+  /// Check an entry holds the data written by store().
+  bool check(Cache const & cache, StringView const & identifier, int64_t value, int64_t size) {
+    Cache::Entry entry;
+    if (!cache.checkout(identifier, &entry) || entry.version != value)
+      return false;
+
+    Vector<uint8_t> data(size + 1, 0);
+    if (entry.stream()->read(data.data(), size + 1) != size)
+      return false;
+    for (int64_t i = 0; i < size; ++i)
+      if (data[i] != uint8_t(value))
+        return false;
+    return true;
+  }
+
+  int64_t countSegments(std::string const & path) {
+    int64_t count = 0;
+    for (auto & file : std::filesystem::directory_iterator(std::filesystem::path(path) / "segments"))
+      count += file.path().extension() == ".seg";
+    return count;
+  }
+} // namespace
+
+BFC_TEST(Cache_Files) {
+  test::TempDirectory directory("bfc_cache_files");
+  {
+    Cache cache(directory.path.c_str());
+    store(&cache, "plain", 1, 1000);
+    store(&cache, "compressed", 2, 100000, CacheEntryFlags_Compressed);
+    BFC_TEST_ASSERT_TRUE(check(cache, "plain", 1, 1000));
+    BFC_TEST_ASSERT_TRUE(check(cache, "compressed", 2, 100000));
+    BFC_TEST_ASSERT_EQUAL(cache.size(), -1);
+  }
+
+  Cache cache(directory.path.c_str());
+  BFC_TEST_ASSERT_TRUE(check(cache, "compressed", 2, 100000));
+  cache.remove("compressed");
+  BFC_TEST_ASSERT_FALSE(cache.contains("compressed"));
+}
+
+BFC_TEST(Cache_Packed) {
+  test::TempDirectory directory("bfc_cache_packed");
+  {
+    Cache cache(directory.path.c_str(), packedOptions());
+    store(&cache, "a", 1, 1000);
+    store(&cache, "b", 2, 2000);
+    store(&cache, "c", 3, 100000);
+    BFC_TEST_ASSERT_EQUAL(cache.size(), 3000 + 100000);
+
+    // Replacing an entry replaces its size. Compressed entries are stored compressed.
+    store(&cache, "c", 3, 100000, CacheEntryFlags_Compressed);
+    BFC_TEST_ASSERT_TRUE(cache.size() < 3000 + 1000);
+
+    store(&cache, "a", 4, 500);
+    cache.remove("b");
+    BFC_TEST_ASSERT_TRUE(check(cache, "a", 4, 500));
+    BFC_TEST_ASSERT_TRUE(check(cache, "c", 3, 100000));
+    BFC_TEST_ASSERT_FALSE(cache.contains("b"));
+  }
+
+  // Entries are kept when the cache is reopened.
+  Cache cache(directory.path.c_str(), packedOptions());
+  BFC_TEST_ASSERT_TRUE(check(cache, "a", 4, 500));
+  BFC_TEST_ASSERT_TRUE(check(cache, "c", 3, 100000));
+  BFC_TEST_ASSERT_FALSE(cache.contains("b"));
+}
+
+BFC_TEST(Cache_PackedDeduplication) {
+  test::TempDirectory directory("bfc_cache_dedup");
+  {
+    Cache cache(directory.path.c_str(), packedOptions());
+    store(&cache, "a", 1, 1000);
+    store(&cache, "b", 1, 1000);
+    store(&cache, "c", 2, 1000);
+    BFC_TEST_ASSERT_EQUAL(cache.size(), 2000);
+
+    // Shared data is kept until the last entry that stores it is removed.
+    cache.remove("a");
+    BFC_TEST_ASSERT_EQUAL(cache.size(), 2000);
+    BFC_TEST_ASSERT_TRUE(check(cache, "b", 1, 1000));
+
+    // Replacing an entry with the same data keeps the data.
+    store(&cache, "b", 1, 1000);
+    BFC_TEST_ASSERT_EQUAL(cache.size(), 2000);
+    BFC_TEST_ASSERT_TRUE(check(cache, "b", 1, 1000));
+  }
+
+  Cache cache(directory.path.c_str(), packedOptions());
+  store(&cache, "d", 2, 1000);
+  BFC_TEST_ASSERT_EQUAL(cache.size(), 2000);
+  cache.remove("c");
+  BFC_TEST_ASSERT_TRUE(check(cache, "d", 2, 1000));
+  cache.remove("b");
+  BFC_TEST_ASSERT_EQUAL(cache.size(), 1000);
+}
+
+BFC_TEST(Cache_PackedEviction) {
+  test::TempDirectory directory("bfc_cache_eviction");
+  CacheOptions  options = packedOptions();
+  options.maxBytes      = 3000;
+
+  Cache cache(directory.path.c_str(), options);
+  store(&cache, "0", 0, 1000);
+  store(&cache, "1", 1, 1000);
+  store(&cache, "2", 2, 1000);
+  BFC_TEST_ASSERT_TRUE(check(cache, "0", 0, 1000));
+
+  // The least recently used entries are evicted first.
+  store(&cache, "3", 3, 1000);
+  store(&cache, "4", 4, 1000);
+  BFC_TEST_ASSERT_TRUE(cache.size() <= 3000);
+  BFC_TEST_ASSERT_TRUE(cache.contains("0"));
+  BFC_TEST_ASSERT_FALSE(cache.contains("1"));
+  BFC_TEST_ASSERT_FALSE(cache.contains("2"));
+  BFC_TEST_ASSERT_TRUE(check(cache, "3", 3, 1000));
+  BFC_TEST_ASSERT_TRUE(check(cache, "4", 4, 1000));
+}
+
+BFC_TEST(Cache_PackedCompaction) {
+  test::TempDirectory directory("bfc_cache_compaction");
+  CacheOptions  options = packedOptions();
+  options.segmentBytes  = 4096;
+
+  Cache cache(directory.path.c_str(), options);
+  for (int64_t i = 0; i < 20; ++i)
+    store(&cache, toString(i), i, 1000);
+  int64_t const segments = countSegments(directory.path);
+
+  for (int64_t i = 0; i < 20; ++i)
+    if (i % 4 != 0)
+      cache.remove(toString(i));
+  cache.compact();
+
+  BFC_TEST_ASSERT_TRUE(countSegments(directory.path) < segments);
+  BFC_TEST_ASSERT_EQUAL(cache.size(), 5 * 1000);
+  for (int64_t i = 0; i < 20; i += 4)
+    BFC_TEST_ASSERT_TRUE(check(cache, toString(i), i, 1000));
+}
+
+BFC_TEST(Cache_PackedTornJournal) {
+  test::TempDirectory directory("bfc_cache_journal");
+  {
+    Cache cache(directory.path.c_str(), packedOptions());
+    store(&cache, "a", 1, 1000);
+    store(&cache, "b", 2, 1000);
+  }
+
+  // Simulate a crash while the last record was written.
+  std::filesystem::path const index = std::filesystem::path(directory.path) / "index";
+  std::filesystem::resize_file(index, std::filesystem::file_size(index) - 3);
+
+  {
+    Cache cache(directory.path.c_str(), packedOptions());
+    BFC_TEST_ASSERT_EQUAL(cache.contains("a") + cache.contains("b"), 1);
+    store(&cache, "c", 3, 1000);
+  }
+
+  Cache cache(directory.path.c_str(), packedOptions());
+  BFC_TEST_ASSERT_TRUE(check(cache, "c", 3, 1000));
+  BFC_TEST_ASSERT_EQUAL(cache.size(), 2000);
+}
@@ -0,0 +1,189 @@
+#include "framework/test.h"
+#include "util/Compression.h"
+#include "util/Log.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+using namespace bfc;
+
+namespace {
+  Vector<uint8_t> makeRandom(int64_t size, uint32_t seed) {
+    Vector<uint8_t> data;
+    data.resize(size);
+    std::mt19937 rng(seed);
+    for (uint8_t & byte : data)
+      byte = uint8_t(rng());
+    return data;
+  }
+
+  /// Words drawn from a small vocabulary with some noise, similar to serialized asset data.
+  Vector<uint8_t> makeStructured(int64_t size, uint32_t seed) {
+    char const *    words[] = {"vertex ", "normal ", "texcoord ", "index ", "material ", "0.000 ", "1.000 ", "-0.5 "};
+    Vector<uint8_t> data;
+    data.resize(size);
+    std::mt19937 rng(seed);
+    for (int64_t i = 0; i < size;) {
+      char const * word = words[rng() % 8];
+      for (int64_t c = 0; word[c] != 0 && i < size; ++c)
+        data[i++] = rng() % 64 == 0 ? uint8_t(rng()) : uint8_t(word[c]);
+    }
+    return data;
+  }
+
+  bool roundTrip(Vector<uint8_t> const & data, int64_t * pCompressedSize = nullptr) {
+    Vector<uint8_t> compressed;
+    compressed.resize(compressBlockBound(data.size()));
+    int64_t const compressedSize = compressBlock(compressed.data(), compressed.size(), data.data(), data.size());
+    if (compressedSize <= 0)
+      return false;
+
+    Vector<uint8_t> decompressed;
+    decompressed.resize(data.size());
+    if (decompressBlock(decompressed.data(), decompressed.size(), compressed.data(), compressedSize) != data.size())
+      return false;
+
+    if (pCompressedSize != nullptr)
+      *pCompressedSize = compressedSize;
+    return data.empty() || memcmp(data.data(), decompressed.data(), data.size()) == 0;
+  }
+} // namespace
+
+BFC_TEST(Compression_RoundTrip) {
+  for (int64_t size : {0, 1, 5, 12, 13, 17, 100, 4096, 100000}) {
+    BFC_TEST_ASSERT_TRUE(roundTrip(makeRandom(size, uint32_t(size))));
+    BFC_TEST_ASSERT_TRUE(roundTrip(makeStructured(size, uint32_t(size))));
+  }
+
+  // Repeating patterns produce overlapping matches with short offsets.
+  for (int64_t period = 1; period <= 20; ++period) {
+    Vector<uint8_t> data;
+    data.resize(1000 + period);
+    for (int64_t i = 0; i < data.size(); ++i)
+      data[i] = uint8_t(i % period * 37);
+
+    int64_t compressedSize = 0;
+    BFC_TEST_ASSERT_TRUE(roundTrip(data, &compressedSize));
+    BFC_TEST_ASSERT_TRUE(compressedSize < 64);
+  }
+
+  // Incompressible data expands by no more than the bound.
+  int64_t compressedSize = 0;
+  BFC_TEST_ASSERT_TRUE(roundTrip(makeRandom(70000, 3), &compressedSize));
+  BFC_TEST_ASSERT_TRUE(compressedSize <= compressBlockBound(70000));
+
+  BFC_TEST_ASSERT_TRUE(roundTrip(makeStructured(200000, 4), &compressedSize));
+  BFC_TEST_ASSERT_TRUE(compressedSize < 200000 / 2);
+}
+
+BFC_TEST(Compression_RejectsMalformed) {
+  Vector<uint8_t> data = makeStructured(10000, 5);
+  Vector<uint8_t> compressed;
+  compressed.resize(compressBlockBound(data.size()));
+  int64_t const compressedSize = compressBlock(compressed.data(), compressed.size(), data.data(), data.size());
+
+  // The output buffer is too small.
+  Vector<uint8_t> decompressed;
+  decompressed.resize(data.size());
+  BFC_TEST_ASSERT_EQUAL(decompressBlock(decompressed.data(), data.size() - 1, compressed.data(), compressedSize), -1);
+  BFC_TEST_ASSERT_EQUAL(compressBlock(compressed.data(), 100, data.data(), data.size()), -1);
+
+  // Truncated input either fails or decodes to less than the original.
+  for (int64_t size = 0; size < compressedSize; size += 7)
+    BFC_TEST_ASSERT_TRUE(decompressBlock(decompressed.data(), decompressed.size(), compressed.data(), size) < data.size());
+
+  // A match that refers to before the start of the output.
+  uint8_t const badOffset[] = {0x10, 'a', 0x08, 0x00, 0x00};
+  BFC_TEST_ASSERT_EQUAL(decompressBlock(decompressed.data(), decompressed.size(), badOffset, sizeof(badOffset)), -1);
+
+  // Corrupt input never reads or writes outside the buffers.
+  std::mt19937 rng(6);
+  for (int64_t i = 0; i < 1000; ++i) {
+    Vector<uint8_t> corrupt = compressed;
+    corrupt.resize(compressedSize);
+    corrupt[rng() % compressedSize] = uint8_t(rng());
+    decompressBlock(decompressed.data(), decompressed.size(), corrupt.data(), corrupt.size());
+  }
+}
+
+BFC_TEST(Compression_Streams) {
+  Vector<uint8_t> data = makeStructured(300000, 7);
+  Vector<uint8_t> tail = makeRandom(100000, 8);
+  data.pushBack(tail.begin(), tail.end());
+
+  MemoryStream stream;
+  {
+    CompressedWriter writer(&stream);
+    for (int64_t offset = 0, size = 1; offset < data.size(); offset += size, size = size * 3 + 1)
+      BFC_TEST_ASSERT_EQUAL(writer.write(data.data() + offset, std::min(size, data.size() - offset)), std::min(size, data.size() - offset));
+    BFC_TEST_ASSERT_EQUAL(writer.tell(), data.size());
+  }
+  BFC_TEST_ASSERT_TRUE(stream.length() < data.size());
+
+  stream.seek(0, SeekOrigin_Start);
+  DecompressingReader reader(&stream);
+  Vector<uint8_t>     decompressed;
+  decompressed.resize(data.size());
+  for (int64_t offset = 0, size = 1; offset < data.size(); offset += size, size = size * 2 + 3)
+    BFC_TEST_ASSERT_EQUAL(reader.read(decompressed.data() + offset, std::min(size, data.size() - offset)), std::min(size, data.size() - offset));
+  BFC_TEST_ASSERT_TRUE(memcmp(data.data(), decompressed.data(), data.size()) == 0);
+
+  uint8_t extra = 0;
+  BFC_TEST_ASSERT_EQUAL(reader.read(&extra, 1), 0);
+  BFC_TEST_ASSERT_TRUE(reader.eof());
+  BFC_TEST_ASSERT_EQUAL(reader.tell(), data.size());
+
+  // An empty stream is still a valid frame.
+  MemoryStream empty;
+  CompressedWriter(&empty).finish();
+  empty.seek(0, SeekOrigin_Start);
+  DecompressingReader emptyReader(&empty);
+  BFC_TEST_ASSERT_EQUAL(emptyReader.read(&extra, 1), 0);
+  BFC_TEST_ASSERT_TRUE(emptyReader.eof());
+
+  // A truncated stream ends early.
+  Vector<uint8_t> truncated = stream.storage();
+  truncated.resize(truncated.size() / 2);
+  MemoryStream        truncatedStream(truncated);
+  DecompressingReader truncatedReader(&truncatedStream);
+  BFC_TEST_ASSERT_TRUE(truncatedReader.read(decompressed.data(), decompressed.size()) < data.size());
+  BFC_TEST_ASSERT_TRUE(truncatedReader.eof());
+}
+
+BFC_BENCHMARK(Compression_Throughput) {
+  // Timings are reported rather than asserted, as they depend on the machine running the benchmark.
+  Vector<uint8_t> data = makeStructured(16 * CompressionBlockSize, 9);
+  Vector<uint8_t> compressed;
+  compressed.resize(compressBlockBound(CompressionBlockSize) * 16);
+  Vector<uint8_t> decompressed;
+  decompressed.resize(data.size());
+
+  int64_t const repeats   = 8;
+  int64_t       sizes[16] = {0};
+
+  auto start  = std::chrono::high_resolution_clock::now();
+  for (int64_t r = 0; r < repeats; ++r)
+    for (int64_t b = 0; b < 16; ++b)
+      sizes[b] = compressBlock(compressed.data() + b * compressBlockBound(CompressionBlockSize), compressBlockBound(CompressionBlockSize),
+                               data.data() + b * CompressionBlockSize, CompressionBlockSize);
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  for (int64_t r = 0; r < repeats; ++r)
+    for (int64_t b = 0; b < 16; ++b)
+      BFC_TEST_ASSERT_EQUAL(decompressBlock(decompressed.data() + b * CompressionBlockSize, CompressionBlockSize,
+                                            compressed.data() + b * compressBlockBound(CompressionBlockSize), sizes[b]),
+                            CompressionBlockSize);
+  auto end    = std::chrono::high_resolution_clock::now();
+  BFC_TEST_ASSERT_TRUE(memcmp(data.data(), decompressed.data(), data.size()) == 0);
+
+  int64_t totalCompressed = 0;
+  for (int64_t size : sizes)
+    totalCompressed += size;
+
+  double const megabytes         = double(data.size() * repeats) / (1024 * 1024);
+  double const compressSeconds   = std::chrono::duration<double>(middle - start).count();
+  double const decompressSeconds = std::chrono::duration<double>(end - middle).count();
+  BFC_LOG_INFO("CompressionTest", "Ratio: %.2f, compress: %.0f MB/s, decompress: %.0f MB/s", double(data.size()) / totalCompressed,
+               megabytes / compressSeconds, megabytes / decompressSeconds);
+}
@@ -0,0 +1,86 @@
+#include "framework/test.h"
+#include "framework/TestData.h"
+#include "util/Compression.h"
+#include "util/Hash.h"
+
+#include <random>
+
+using namespace bfc;
+
+BFC_TEST(Hash_KnownAnswers) {
+  // Values from the reference XXH3-128 implementation. Each size is handled by a different code path.
+  Vector<uint8_t> data = test::makePattern(5000);
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 0).toString(), "99aa06d3014798d86001c324468d497f");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 3).toString(), "ce31763cbf8245a5a9088dda485b481c");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 8).toString(), "e3bc8a5f461715553cd024e3d63a1588");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 16).toString(), "ce0b9647ab24f88460d75c5e47d40a24");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 100).toString(), "2207ed96998d91f20cc97f05750182b2");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 200).toString(), "32200a52a918beaf380142cdd5843bbd");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 1000).toString(), "6bcc7eff62da44c26c4f14bd97bd9e82");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 5000).toString(), "c98ae385d09887cc799aaddd7339581d");
+  BFC_TEST_ASSERT_EQUAL(hash128("abc", 3).toString(), "06b05ab6733a618578af5f94892f3950");
+
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 100, 42).toString(), "5e8e7ced7c51485bbe8dc3486451d9b5");
+  BFC_TEST_ASSERT_EQUAL(hash128(data.data(), 1000, 42).toString(), "c281146f104d47f7f0f163846cbf0c33");
+}
+
+BFC_TEST(Hash_Incremental) {
+  Vector<uint8_t> data = test::makePattern(5000);
+  std::mt19937    rng(1);
+
+  // Writing in pieces gives the same hash as hashing everything at once.
+  for (uint64_t seed : {0ull, 42ull}) {
+    for (int64_t size : {0, 1, 17, 240, 241, 256, 257, 1024, 1025, 4096, 5000}) {
+      HashWriter writer(seed);
+      for (int64_t offset = 0; offset < size;) {
+        int64_t const piece = std::min<int64_t>(size - offset, rng() % 600);
+        BFC_TEST_ASSERT_EQUAL(writer.write(data.data() + offset, piece), piece);
+        offset += piece;
+      }
+      BFC_TEST_ASSERT_EQUAL(writer.tell(), size);
+      BFC_TEST_ASSERT_TRUE(writer.digest() == hash128(data.data(), size, seed));
+    }
+  }
+
+  // Digesting does not end the hash.
+  HashWriter writer;
+  writer.write(data.data(), 300);
+  Hash128 const partial = writer.digest();
+  writer.write(data.data() + 300, 700);
+  BFC_TEST_ASSERT_TRUE(partial == hash128(data.data(), 300));
+  BFC_TEST_ASSERT_TRUE(writer.digest() == hash128(data.data(), 1000));
+
+  writer.reset();
+  BFC_TEST_ASSERT_TRUE(writer.digest() == hash128(nullptr, 0));
+}
+
+BFC_TEST(Hash_Streams) {
+  Vector<uint8_t> data = test::makePattern(200000);
+
+  // Streams in memory are hashed from the current position.
+  MemoryStream memory(data);
+  memory.seek(1000, SeekOrigin_Start);
+  BFC_TEST_ASSERT_TRUE(hashStream(&memory) == hash128(data.data() + 1000, data.size() - 1000));
+  BFC_TEST_ASSERT_EQUAL(memory.tell(), data.size());
+
+  // Other streams are read to the end.
+  MemoryStream compressed;
+  CompressedWriter(&compressed).write(data.data(), data.size());
+  compressed.seek(0, SeekOrigin_Start);
+  DecompressingReader reader(&compressed);
+  BFC_TEST_ASSERT_TRUE(hashStream(&reader, 7) == hash128(data.data(), data.size(), 7));
+}
+
+BFC_TEST(Hash_Sensitivity) {
+  // Changing any bit, or the length, changes the hash.
+  for (int64_t size : {1, 4, 9, 17, 129, 241, 2000}) {
+    Vector<uint8_t> data     = test::makePattern(size);
+    Hash128 const   original = hash128(data.data(), size);
+    BFC_TEST_ASSERT_TRUE(original != hash128(data.data(), size - 1));
+    for (int64_t bit = 0; bit < size * 8; bit += 3) {
+      data[bit / 8] ^= uint8_t(1 << (bit % 8));
+      BFC_TEST_ASSERT_TRUE(hash128(data.data(), size) != original);
+      data[bit / 8] ^= uint8_t(1 << (bit % 8));
+    }
+  }
+}
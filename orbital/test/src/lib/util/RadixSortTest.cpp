@@ -0,0 +1,53 @@
+#include "framework/test.h"
+#include "util/RadixSort.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace bfc;
+
+BFC_TEST(RadixSort_Keys) {
+  std::mt19937_64 rng(11);
+
+  Vector<uint64_t> keys;
+  for (int64_t i = 0; i < 10000; ++i)
+    keys.pushBack(rng());
+
+  Vector<uint64_t> expected = keys;
+  std::sort(expected.begin(), expected.end());
+
+  radixSort(keys.getView(), [](uint64_t key) { return key; });
+  BFC_TEST_ASSERT_TRUE(keys == expected);
+}
+
+BFC_TEST(RadixSort_Stable) {
+  struct Item {
+    uint32_t key;
+    int64_t  order;
+  };
+
+  std::mt19937 rng(5);
+
+  Vector<Item> items;
+  for (int64_t i = 0; i < 5000; ++i)
+    items.pushBack({uint32_t(rng() % 16), i});
+
+  Vector<Item> scratch;
+  radixSort(items.getView(), [](Item const & item) { return item.key; }, &scratch);
+
+  for (int64_t i = 1; i < items.size(); ++i) {
+    BFC_TEST_ASSERT_TRUE(items[i - 1].key <= items[i].key);
+    if (items[i - 1].key == items[i].key)
+      BFC_TEST_ASSERT_TRUE(items[i - 1].order < items[i].order);
+  }
+}
+
+BFC_TEST(RadixSort_Small) {
+  Vector<uint16_t> keys = {3, 1, 2};
+  radixSort(keys.getView(), [](uint16_t key) { return key; });
+  BFC_TEST_ASSERT_TRUE(keys == Vector<uint16_t>({1, 2, 3}));
+
+  Vector<uint16_t> empty;
+  radixSort(empty.getView(), [](uint16_t key) { return key; });
+  BFC_TEST_ASSERT_EQUAL(empty.size(), 0);
+}
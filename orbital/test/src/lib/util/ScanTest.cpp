@@ -1,6 +1,10 @@
 #include "util/Scan.h"
 #include "framework/test.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
 using namespace bfc;
 
 BFC_TEST(Scan_readInt) {
@@ -45,6 +49,49 @@ BFC_TEST(Scan_readFloat) {
   BFC_TEST_ASSERT_TRUE(len == 0);
 }
 
+BFC_TEST(Scan_readFloatRounding) {
+  // Values that need the Eisel-Lemire path, the arbitrary precision fallback,
+  // or that sit exactly halfway between two doubles.
+  char const * values[] = {
+    "1e23",
+    "8.98846567431158e307",
+    "1.7976931348623157e308",
+    "2.2250738585072011e-308",
+    "4.9e-324",
+    "9007199254740993",
+    "3.14159265358979323846264338327950288",
+    "1.00000000000000011102230246251565404236316680908203125",
+    "1.00000000000000011102230246251565404236316680908203126",
+    "0.000000000000000000000000000000000000000001234567890123456789012",
+    "-12.5e-3",
+  };
+
+  for (char const * value : values) {
+    int64_t len = 0;
+    BFC_TEST_ASSERT_TRUE(Scan::readFloat(value, &len) == strtod(value, nullptr));
+    BFC_TEST_ASSERT_TRUE(len == (int64_t)strlen(value));
+  }
+
+  int64_t len = 0;
+  BFC_TEST_ASSERT_TRUE(Scan::readFloat("1e400", &len) == std::numeric_limits<double>::infinity());
+  BFC_TEST_ASSERT_TRUE(Scan::readFloat("1e-400", &len) == 0);
+  BFC_TEST_ASSERT_TRUE(Scan::readFloat("2e", &len) == 2);
+  BFC_TEST_ASSERT_TRUE(len == 1);
+}
+
+BFC_TEST(Scan_readMany) {
+  double  floats[4] = {};
+  int64_t len       = 0;
+  BFC_TEST_ASSERT_TRUE(Scan::readFloats(" 1.5 -2\t3e2 x", floats, 4, &len) == 3);
+  BFC_TEST_ASSERT_TRUE(floats[0] == 1.5 && floats[1] == -2 && floats[2] == 300);
+  BFC_TEST_ASSERT_TRUE(len == 11);
+
+  int64_t ints[2] = {};
+  BFC_TEST_ASSERT_TRUE(Scan::readInts("123456789012 -42 7", ints, 2, &len) == 2);
+  BFC_TEST_ASSERT_TRUE(ints[0] == 123456789012 && ints[1] == -42);
+  BFC_TEST_ASSERT_TRUE(len == 16);
+}
+
 BFC_TEST(Scan_readBool) {}
 
 BFC_TEST(Scan_readString) {}
@@ -74,3 +74,59 @@ BFC_TEST(ThreadPool_NewThread) {
 
   BFC_TEST_ASSERT_EQUAL(status.get(), std::cv_status::no_timeout);
 }
+
+BFC_TEST(ThreadPool_NestedTasks) {
+  ThreadPool           threads(4);
+  std::atomic_int64_t  sum   = 0;
+  std::atomic_int64_t  count = 0;
+  std::promise<void>   done;
+
+  // Tasks queued from a worker go to its own deque and are stolen by the others.
+  for (int64_t i = 0; i < 100; ++i) {
+    threads.run([&, i]() {
+      for (int64_t j = 0; j < 100; ++j) {
+        threads.run([&, i, j]() {
+          sum += i * j;
+          if (++count == 10000)
+            done.set_value();
+        });
+      }
+    });
+  }
+
+  std::future<void> finished = done.get_future();
+  BFC_TEST_ASSERT_EQUAL(finished.wait_for(5s), std::future_status::ready);
+  BFC_TEST_ASSERT_EQUAL(sum.load(), 4950ll * 4950ll);
+}
+
+BFC_TEST(ThreadPool_ParallelFor) {
+  ThreadPool threads(4);
+
+  // Every item is visited exactly once, in ranges of at least minRange items.
+  for (int64_t count : {0, 1, 7, 100, 1000}) {
+    Vector<int64_t> visits;
+    visits.resize(count, 0);
+    parallelFor(&threads, count, 8, [&](int64_t first, int64_t last) {
+      BFC_TEST_ASSERT_TRUE(first < last && last <= count);
+      BFC_TEST_ASSERT_TRUE(last - first >= 8 || last - first == count);
+      for (int64_t i = first; i < last; ++i)
+        ++visits[i];
+    });
+
+    for (int64_t i = 0; i < count; ++i)
+      BFC_TEST_ASSERT_EQUAL(visits[i], 1);
+  }
+
+  // Called from a worker, the loop runs inline rather than waiting on the pool it is running in.
+  ThreadPool          single(1);
+  std::atomic_int64_t sum   = 0;
+  std::future<void>   outer = single.run([&]() {
+    parallelFor(&single, 1000, 1, [&](int64_t first, int64_t last) {
+      for (int64_t i = first; i < last; ++i)
+        sum += i;
+    });
+  });
+
+  BFC_TEST_ASSERT_EQUAL(outer.wait_for(5s), std::future_status::ready);
+  BFC_TEST_ASSERT_EQUAL(sum.load(), 499500);
+}
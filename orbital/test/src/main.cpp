@@ -2,11 +2,16 @@
 #include "framework/test.h"
 #include <typeindex>
 #include <cstdio>
+#include <cstring>
 
 
 int main(int argc, char **argv)
 {
-  if (!bfc::test::run())
+  bool runBenchmarks = false;
+  for (int i = 1; i < argc; ++i)
+    runBenchmarks |= strcmp(argv[i], "--benchmark") == 0;
+
+  if (!bfc::test::run(runBenchmarks))
   {
     printf("Press any enter to continue...\n");
     getchar();